@@ -30,6 +30,7 @@
 #include "SAX2Print.hpp"
 #include <xercesc/util/OutOfMemoryException.hpp>
 #include "SAX2FilterHandlers.hpp"
+#include <xercesc/parsers/SAX2XPathFilter.hpp>
 
 // ---------------------------------------------------------------------------
 //  Local data
@@ -48,6 +49,10 @@
 //	expandNamespaces
 //		Indicates if the output should expand the namespaces Alias with
 //		their URI's, defaults to false, can be set via the command line -e
+//
+//  xpathExpression
+//      If set via the -xpath= command, only the subtrees matching this
+//      streaming XPath expression are printed.
 // ---------------------------------------------------------------------------
 static const char*              encodingName    = "LATIN1";
 static XMLFormatter::UnRepFlags unRepFlags      = XMLFormatter::UnRep_CharRef;
@@ -59,6 +64,7 @@ static bool                     doSchema        = true;
 static bool                     schemaFullChecking = false;
 static bool                     namespacePrefixes = false;
 static bool                     sortAttributes  = false;
+static const char*              xpathExpression = 0;
 
 
 // ---------------------------------------------------------------------------
@@ -83,6 +89,7 @@ static void usage()
              "    -s          Disable schema processing. Defaults to on.\n"
              "                NOTE: THIS IS OPPOSITE FROM OTHER SAMPLES.\n"
              "    -sa         Print the attributes in alphabetic order. Defaults to off.\n"
+             "    -xpath=xxx  Print only the subtrees matching the streaming XPath xxx.\n"
              "    -?          Show this help.\n\n"
              "  * = Default if not provided explicitly.\n\n"
              "The parser has intrinsic support for the following encodings:\n"
@@ -203,6 +210,10 @@ int main(int argC, char* argV[])
          else if (!strcmp(argV[parmInd], "-sa"))
         {
             sortAttributes = true;
+        }
+         else if (!strncmp(argV[parmInd], "-xpath=", 7))
+        {
+            xpathExpression = &argV[parmInd][7];
         }
          else
         {
@@ -238,6 +249,37 @@ int main(int argC, char* argV[])
     else
         parser=reader;
 
+    SAX2XPathFilter* xpathFilter = NULL;
+    if(xpathExpression)
+    {
+        xpathFilter=new SAX2XPathFilter(parser);
+        parser=xpathFilter;
+
+        bool badExpression = false;
+        try
+        {
+            XMLCh* expression = XMLString::transcode(xpathExpression);
+            ArrayJanitor<XMLCh> janExpression(expression, XMLPlatformUtils::fgMemoryManager);
+            xpathFilter->addExpression(expression);
+        }
+        catch (const XMLException& toCatch)
+        {
+            std::cerr << "\nInvalid XPath expression\n  Error: "
+                 << StrX(toCatch.getMessage())
+                 << "\n" << std::endl;
+            badExpression = true;
+        }
+
+        if (badExpression)
+        {
+            delete xpathFilter;
+            delete filter;
+            delete reader;
+            XMLPlatformUtils::Terminate();
+            return 2;
+        }
+    }
+
     //
     //  Then, according to what we were told on
     //  the command line, set it to validate or not.
@@ -305,6 +347,8 @@ int main(int argC, char* argV[])
     delete reader;
     if(filter)
         delete filter;
+    if(xpathFilter)
+        delete xpathFilter;
 
     // And call the termination method
     XMLPlatformUtils::Terminate();
@@ -83,5 +83,8 @@
 #include <xercesc/dom/DOMXPathResult.hpp>
 #include <xercesc/dom/DOMXPathNamespace.hpp>
 
+// Non-standard extensions
+#include <xercesc/dom/DOMRecordHandler.hpp>
+
 
 #endif
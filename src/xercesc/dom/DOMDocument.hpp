@@ -810,6 +810,43 @@ public:
                                         const XMLCh *qualifiedName,
                                         const XMLFileLoc lineNum,
                                         const XMLFileLoc columnNum) = 0;
+
+    /**
+     * Non-standard extension.
+     *
+     * Freezes the document so that any number of threads can read it at the
+     * same time, without locking. The state that read operations otherwise
+     * build lazily is computed up front: the node lists returned by
+     * <code>getElementsByTagName</code> and <code>getElementsByTagNameNS</code>
+     * so far are filled in, attribute values made of several nodes are
+     * computed and the <code>DOMConfiguration</code> is created.
+     *
+     * After this call, every node of the document is read only, so methods
+     * that would change the tree raise a <code>DOMException</code> with the
+     * code NO_MODIFICATION_ALLOWED_ERR, and so do <code>renameNode</code>,
+     * <code>normalizeDocument</code> and <code>setUserData</code> on any
+     * node of the document, as user data is kept by the document. The
+     * properties of the document itself, such as its URI, must not be set.
+     * Node lists requested later are filled in when they are created and no
+     * longer follow changes. Results that read operations allocate, such as
+     * <code>getTextContent</code> on an element, come from memory that is
+     * safe to allocate from several threads; it is released with the document.
+     * Nodes can still be created, cloned or imported, but they are not part
+     * of the frozen tree and must not be shared between threads while they
+     * are changed.
+     *
+     * A document cannot be unfrozen. The call must complete before other
+     * threads get hold of the document, for example by handing the document
+     * over through a mutex or a thread start.
+     */
+    virtual void freeze() = 0;
+
+    /**
+     * Non-standard extension.
+     *
+     * Returns whether <code>freeze</code> was called on this document.
+     */
+    virtual bool isFrozen() const = 0;
     //@}
 
 };
@@ -39,6 +39,7 @@
 
 namespace XERCES_CPP_NAMESPACE {
 
+class Attributes;
 class DOMElement;
 class DOMNode;
 
@@ -157,8 +158,61 @@ public:
     virtual DOMNodeFilter::ShowType getWhatToShow() const = 0;
 
     //@}
+
+    /** @name Non-standard Extension */
+    //@{
+    /**
+     * The parser will call this method after each start tag has been scanned,
+     * before any node is created for it, and before <code>startElement</code>.
+     * It lets an element be dropped without the parser allocating the element,
+     * its attributes or any of its content.
+     *
+     * <p><code>FILTER_ACCEPT:</code>
+     * Build the element, which is then passed to <code>startElement</code>
+     * as usual.</p>
+     *
+     * <p><code>FILTER_REJECT:</code>
+     * Build neither the element nor anything in its content.</p>
+     *
+     * <p><code>FILTER_SKIP:</code>
+     * Do not build the element. Its content is built in its place, as a
+     * part of the content of its parent.</p>
+     *
+     * <p><code>FILTER_INTERRUPT:</code>
+     * Interrupt the normal processing of the document.</p>
+     *
+     * The content of a rejected or skipped element is still scanned, so the
+     * document must be well-formed, and it is still validated if validation
+     * is on. Namespace declarations are listed among the attributes.
+     * Elements that are not built are never passed to <code>startElement</code>
+     * or <code>acceptNode</code>, and neither is anything in the content of
+     * a rejected element. The default implementation accepts every element.
+     *
+     * @param namespaceURI The namespace URI of the element, or an empty
+     *                     string if it has none or namespaces are off.
+     * @param localName    The local name of the element, or its qualified
+     *                     name if namespaces are off.
+     * @param qName        The qualified name of the element.
+     * @param attributes   The attributes of the start tag. They are only
+     *                     valid during the call.
+     * @return One of the FilterAction enum
+     */
+    virtual FilterAction acceptStartTag(const XMLCh* const    namespaceURI
+                                      , const XMLCh* const    localName
+                                      , const XMLCh* const    qName
+                                      , const Attributes&     attributes);
+    //@}
 };
 
+inline DOMLSParserFilter::FilterAction
+DOMLSParserFilter::acceptStartTag(const XMLCh* const
+                                , const XMLCh* const
+                                , const XMLCh* const
+                                , const Attributes&)
+{
+    return FILTER_ACCEPT;
+}
+
 }
 
 #endif
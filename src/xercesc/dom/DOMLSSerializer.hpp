@@ -256,6 +256,37 @@
  * <dd>[required]
  * Don't add the extra line feed. </dd>
  * </dl></dd>
+ * <dt><code>"http://apache.org/xml/features/dom/parallel-serialization"</code></dt>
+ * <dd>
+ * <dl>
+ * <dt><code>true</code></dt>
+ * <dd>[optional]
+ * Serialize the children of the document element on several threads. The
+ * children are split into contiguous runs, each run is written into a buffer
+ * of its own and the buffers are written to the output in document order,
+ * so the output is the same as with this feature set to false. If the
+ * document element has a single child element, the children of that element
+ * are split instead, and so on down. Only UTF-8 output which is neither
+ * filtered nor pretty-printed is serialized in parallel. The document must
+ * not be modified while it is written and the memory manager of the
+ * serializer must be thread-safe. Runs which report an error or a warning
+ * are written again sequentially, so the error handler is only called from
+ * the thread calling write().
+ * <p>The runs of a round are buffered in memory until all of them are
+ * written. Runs are sized to hold around 256KB of output each, based on the
+ * output of the previous rounds, so memory use is about that much per
+ * thread for children of similar size. A single child is never split,
+ * though, so a round holding very large children buffers all of their
+ * output. </p></dd>
+ * <dt><code>false</code></dt>
+ * <dd>[required]
+ * (default) Serialize the document on the calling thread only. </dd>
+ * </dl></dd>
+ * <dt><code>"http://apache.org/xml/properties/dom/parallel-serialization-threads"</code></dt>
+ * <dd>
+ * A pointer to an <code>XMLSize_t</code> holding the number of threads used
+ * for parallel serialization, counting the calling thread. The default, 0,
+ * uses one thread per hardware thread. </dd>
  * </dl>
  * <p>See also the <a href='http://www.w3.org/TR/2004/REC-DOM-Level-3-LS-20040407'>Document Object Model (DOM) Level 3 Load and Save Specification</a>.
  *
@@ -80,7 +80,41 @@ public:
         ENTITY_REFERENCE_OBJECT       = 9,
         NOTATION_OBJECT               = 10,
         PROCESSING_INSTRUCTION_OBJECT = 11,
-        TEXT_OBJECT                   = 12
+        TEXT_OBJECT                   = 12,
+
+        // Special values, don't use directly
+        NodeObjectType_Count
+    };
+
+    /**
+     * The memory held by a document, as reported by <code>getMemoryUsage</code>.
+     * All sizes are in bytes.
+     */
+    struct MemoryUsage
+    {
+        /** The number of blocks obtained from the memory manager of the document */
+        XMLSize_t fBlockCount;
+        /** The total size of these blocks */
+        XMLSize_t fBlockBytes;
+        /** The part of the blocks handed out for nodes, strings and other data */
+        XMLSize_t fAllocatedBytes;
+        /** The part of it released by nodes and text buffers, and not reused yet */
+        XMLSize_t fWastedBytes;
+        /** The number of live nodes of each type */
+        XMLSize_t fNodeCount[NodeObjectType_Count];
+        /** The memory taken by the live nodes of each type, strings not included */
+        XMLSize_t fNodeBytes[NodeObjectType_Count];
+        /**
+         * The character data held by the nodes of each type in the document tree;
+         * attribute values are counted for their attribute. Only filled in when
+         * the tree is walked.
+         */
+        XMLSize_t fStringBytes[NodeObjectType_Count];
+        /** The number of names and URIs in the string pool of the document. Only
+         *  filled in when the tree is walked. */
+        XMLSize_t fPooledStringCount;
+        /** The memory taken by them. Only filled in when the tree is walked. */
+        XMLSize_t fPooledStringBytes;
     };
 
     //@{
@@ -94,6 +128,18 @@ public:
      */
     virtual XMLSize_t getMemoryAllocationBlockSize() const = 0;
 
+    /**
+     * Reports how much memory the document holds and what it is used for.
+     * The heap figures and the node counts are kept up to date as the
+     * document changes, so reading them is cheap. The breakdown of the
+     * string storage needs a walk of the document tree and the string pool.
+     *
+     * @param usage      receives the figures
+     * @param walkTree   whether to fill in the string storage breakdown as well;
+     *                   when false, its fields are set to 0
+     */
+    virtual void getMemoryUsage(MemoryUsage& usage, bool walkTree = false) const = 0;
+
     //@}
 
     //@{
@@ -0,0 +1,121 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+#if !defined(XERCESC_INCLUDE_GUARD_DOMRECORDHANDLER_HPP)
+#define XERCESC_INCLUDE_GUARD_DOMRECORDHANDLER_HPP
+
+#include <xercesc/util/XercesDefs.hpp>
+
+namespace XERCES_CPP_NAMESPACE {
+
+
+class DOMDocument;
+
+/**
+  * Callback interface for building a document one record at a time.
+  *
+  * <p>When a record handler is installed on a DOM parser, the parser only
+  * builds the subtrees rooted at the elements the handler selects as
+  * records. Each record is built into a document of its own, handed to
+  * handleRecord and released as soon as that method returns, so the
+  * memory used by the parser is bounded by the size of the largest
+  * record rather than by the size of the whole document.</p>
+  *
+  * <p>Content outside of the records is not built. The document returned
+  * by the parser only holds the prolog, the document type and the
+  * comments and processing instructions outside of the root element.</p>
+  *
+  * @see AbstractDOMParser#setRecordHandler
+  */
+
+class CDOM_EXPORT DOMRecordHandler
+{
+protected:
+    // -----------------------------------------------------------------------
+    //  Hidden constructors
+    // -----------------------------------------------------------------------
+    /** @name Hidden constructors */
+    //@{
+    DOMRecordHandler() {};
+    //@}
+
+private:
+    // -----------------------------------------------------------------------
+    // Unimplemented constructors and operators
+    // -----------------------------------------------------------------------
+    /** @name Unimplemented constructors and operators */
+    //@{
+    DOMRecordHandler(const DOMRecordHandler &);
+    DOMRecordHandler & operator = (const DOMRecordHandler &);
+    //@}
+
+public:
+    // -----------------------------------------------------------------------
+    //  All constructors are hidden, just the destructor is available
+    // -----------------------------------------------------------------------
+    /** @name Destructor */
+    //@{
+    /**
+     * Destructor
+     *
+     */
+    virtual ~DOMRecordHandler() {};
+    //@}
+
+    // -----------------------------------------------------------------------
+    //  Virtual DOMRecordHandler interface
+    // -----------------------------------------------------------------------
+    /** @name Non-standard Extension */
+    //@{
+    /**
+     * Called for every start tag outside of a record to find out whether
+     * the element starts a new record. Elements nested in a record are
+     * always part of it and are not reported.
+     *
+     * @param namespaceURI The namespace URI of the element, or null if
+     *                     the element has none or namespace processing
+     *                     is disabled.
+     * @param localName    The local name of the element, or its qualified
+     *                     name if namespace processing is disabled.
+     * @param depth        The nesting depth of the element, the root
+     *                     element being at depth 1.
+     * @return <code>true</code> if the element is the root of a record.
+     */
+    virtual bool isRecordRoot(const XMLCh* const namespaceURI,
+                              const XMLCh* const localName,
+                              const XMLSize_t    depth) = 0;
+
+    /**
+     * Called when the end tag of a record has been parsed.
+     *
+     * @param record A document whose document element is the root of the
+     *               record. It is owned by the parser and released when
+     *               this method returns; nodes which must outlive the call
+     *               have to be cloned or imported into another document.
+     */
+    virtual void handleRecord(DOMDocument* const record) = 0;
+    //@}
+
+};
+
+}
+
+#endif
@@ -0,0 +1,98 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+#if !defined(XERCESC_INCLUDE_GUARD_DOMSNAPSHOT_HPP)
+#define XERCESC_INCLUDE_GUARD_DOMSNAPSHOT_HPP
+
+ /**
+  * Non-standard extension.
+  *
+  * This class writes a document into a binary snapshot and builds a
+  * document back from one, which is much faster than parsing the same
+  * document as XML again.
+  *
+  * <p>A snapshot is a single block of bytes: a header, one fixed size
+  * record per node in document order, and a table of the distinct strings
+  * of the document. Records refer to their parent node and to their
+  * strings by index, so the block does not depend on the address it is
+  * loaded at and can be read straight from a memory mapped file. Reading
+  * it creates the nodes directly, without scanning or checking any
+  * markup, and copies the strings into the new document, so the block
+  * can be unmapped as soon as <code>read</code> returns.
+  *
+  * <p>A snapshot holds the tree, including the document type with its
+  * entities and notations, whether attributes were specified or are
+  * ID attributes, and ignorable whitespace. Type information, user data
+  * and the default attributes of the DTD are not kept. A snapshot can only
+  * be read on a platform with the byte order of the one that wrote it.
+  */
+
+#include <xercesc/util/PlatformUtils.hpp>
+
+namespace XERCES_CPP_NAMESPACE {
+
+
+class DOMDocument;
+class XMLFormatTarget;
+
+class CDOM_EXPORT DOMSnapshot
+{
+public:
+    // -----------------------------------------------------------------------
+    //  Static DOMSnapshot interface
+    // -----------------------------------------------------------------------
+    /** @name Non-standard extension */
+    //@{
+    /**
+     * Write a snapshot of a document.
+     *
+     * @param document The document to write. It is not changed.
+     * @param target   Where the bytes of the snapshot are written to. The
+     *                 formatter passed to it is always null.
+     * @exception DOMLSException SERIALIZE_ERR: Raised if the document is too
+     *            large for the 32 bit offsets of the format.
+     */
+    static void write(const DOMDocument* document, XMLFormatTarget* target);
+
+    /**
+     * Build a document from a snapshot.
+     *
+     * @param image   The first byte of the snapshot, aligned to at least
+     *                four bytes.
+     * @param size    The number of bytes available at <code>image</code>.
+     * @param manager The memory manager of the new document.
+     * @return A new document, owned by the caller, who releases it with
+     *         <code>release()</code>.
+     * @exception DOMLSException PARSE_ERR: Raised if the bytes are not a
+     *            snapshot that can be read on this platform.
+     */
+    static DOMDocument* read(const void* image,
+                             XMLSize_t size,
+                             MemoryManager* const manager = XMLPlatformUtils::fgMemoryManager);
+    //@}
+
+private:
+    DOMSnapshot();
+};
+
+}
+
+#endif
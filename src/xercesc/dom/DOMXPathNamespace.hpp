@@ -47,6 +47,8 @@ class DOMElement;
  * namespaceURI is the namespace URI of the namespace represented by the node.
  * nodeValue is the same as namespaceURI.
  * adoptNode, cloneNode, and importNode fail on this node type by raising a DOMException with the code NOT_SUPPORTED_ERR.
+ * A namespace node belongs to the <code>DOMXPathResult</code> it was returned in and
+ * is deleted when that result is released or reused for another evaluation.
  * Note: In future versions of the XPath specification, the definition of a namespace node may
  * be changed incompatibly, in which case incompatible changes to field values may be required to
  * implement versions beyond XPath 1.0.
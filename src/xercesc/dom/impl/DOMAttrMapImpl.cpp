@@ -32,10 +32,43 @@
 
 namespace XERCES_CPP_NAMESPACE {
 
+// ---------------------------------------------------------------------------
+//  Local helpers for the (namespaceURI, localName) hash index
+// ---------------------------------------------------------------------------
+
+// Number of attributes past which namespace lookups are hashed.
+static const XMLSize_t kNSIndexThreshold = 16;
+
+static inline const XMLCh* nsIndexLocalName(const DOMNode* node)
+{
+    // Nodes without a local name (DOM Level 1 attributes) are matched on
+    // their node name, see findNamePoint(namespaceURI, localName).
+    const XMLCh* localName = node->getLocalName();
+    return localName ? localName : node->getNodeName();
+}
+
+static inline XMLSize_t nsIndexHash(const XMLCh* namespaceURI, const XMLCh* localName)
+{
+    XMLSize_t hashVal = 0;
+    if (namespaceURI) {
+        for (const XMLCh* curCh = namespaceURI; *curCh; curCh++)
+            hashVal += (hashVal * 37) + (hashVal >> 24) + (XMLSize_t)(*curCh);
+    }
+    hashVal += (hashVal * 37) + (hashVal >> 24) + (XMLSize_t)chColon;
+    if (localName) {
+        for (const XMLCh* curCh = localName; *curCh; curCh++)
+            hashVal += (hashVal * 37) + (hashVal >> 24) + (XMLSize_t)(*curCh);
+    }
+    return hashVal;
+}
+
 DOMAttrMapImpl::DOMAttrMapImpl(DOMNode *ownerNod)
 {
     this->fOwnerNode=ownerNod;
     this->fNodes = 0;
+    this->fNSIndex = 0;
+    this->fNSIndexSize = 0;
+    this->fNSIndexCount = 0;
 	hasDefaults(false);
 }
 
@@ -43,6 +76,9 @@ DOMAttrMapImpl::DOMAttrMapImpl(DOMNode *ownerNod, const DOMAttrMapImpl *defaults
 {
     this->fOwnerNode=ownerNod;
     this->fNodes = 0;
+    this->fNSIndex = 0;
+    this->fNSIndexSize = 0;
+    this->fNSIndexCount = 0;
 	hasDefaults(false);
 	if (defaults != 0)
 	{
@@ -63,7 +99,14 @@ void DOMAttrMapImpl::cloneContent(const DOMAttrMapImpl *srcmap)
     if ((srcmap != 0) && (srcmap->fNodes != 0))
     {
         if (fNodes != 0)
+        {
             fNodes->reset();
+            if (fNSIndex != 0)
+            {
+                memset(fNSIndex, 0, fNSIndexSize * sizeof(DOMNode*));
+                fNSIndexCount = 0;
+            }
+        }
         else
         {
             XMLSize_t size = srcmap->fNodes->size();
@@ -81,6 +124,7 @@ void DOMAttrMapImpl::cloneContent(const DOMAttrMapImpl *srcmap)
             castToNodeImpl(clone)->fOwnerNode = fOwnerNode;
             castToNodeImpl(clone)->isOwned(true);
             fNodes->addElement(clone);
+            nodeAdded(clone);
         }
     }
 }
@@ -178,6 +222,7 @@ DOMNode *DOMAttrMapImpl::setNamedItem(DOMNode *arg)
     {
         previous = fNodes->elementAt(i);
         fNodes->setElementAt(arg,i);
+        nodeRemoved(previous);
     }
     else
     {
@@ -188,6 +233,7 @@ DOMNode *DOMAttrMapImpl::setNamedItem(DOMNode *arg)
         }
         fNodes->insertElementAt(arg,i);
     }
+    nodeAdded(arg);
     if (previous != 0) {
         castToNodeImpl(previous)->fOwnerNode = doc;
         castToNodeImpl(previous)->isOwned(false);
@@ -203,6 +249,31 @@ int DOMAttrMapImpl::findNamePoint(const XMLCh *namespaceURI,
 {
     if (fNodes == 0)
 	return -1;
+
+    if (fNSIndex != 0)
+    {
+        // Probe the hash index. Should several attributes share the same
+        // (namespaceURI, localName) key (possible through setNamedItem with
+        // different prefixes), return the one the linear search below would
+        // find first, i.e. the one with the lowest node name.
+        const XMLSize_t mask = fNSIndexSize - 1;
+        const DOMNode* found = 0;
+        for (XMLSize_t h = nsIndexHash(namespaceURI, localName) & mask;
+             fNSIndex[h] != 0;
+             h = (h + 1) & mask)
+        {
+            const DOMNode *node = fNSIndex[h];
+            if (XMLString::equals(node->getNamespaceURI(), namespaceURI) &&
+                XMLString::equals(nsIndexLocalName(node), localName))
+            {
+                if (found == 0 ||
+                    XMLString::compareString(node->getNodeName(), found->getNodeName()) < 0)
+                    found = node;
+            }
+        }
+        return found ? findNodePoint(found) : -1;
+    }
+
     // This is a linear search through the same fNodes Vector.
     // The Vector is sorted on the DOM Level 1 nodename.
     // The DOM Level 2 NS keys are namespaceURI and Localname,
@@ -255,6 +326,7 @@ DOMNode *DOMAttrMapImpl::setNamedItemNS(DOMNode* arg)
     if(i>=0) {
         previous = fNodes->elementAt(i);
         fNodes->setElementAt(arg,i);
+        nodeRemoved(previous);
     } else {
         i=findNamePoint(arg->getNodeName()); // Insert point (may be end of list)
         if (i<0)
@@ -263,6 +335,7 @@ DOMNode *DOMAttrMapImpl::setNamedItemNS(DOMNode* arg)
             fNodes=new ((DOMDocumentImpl*)doc) DOMNodeVector(doc);
         fNodes->insertElementAt(arg,i);
     }
+    nodeAdded(arg);
     if (previous != 0) {
         castToNodeImpl(previous)->fOwnerNode = doc;
         castToNodeImpl(previous)->isOwned(false);
@@ -284,6 +357,7 @@ DOMNode *DOMAttrMapImpl::removeNamedItem(const XMLCh *name)
 
     removed = fNodes->elementAt(i);
     fNodes->removeElementAt(i);
+    nodeRemoved(removed);
     castToNodeImpl(removed)->fOwnerNode = fOwnerNode->getOwnerDocument();
     castToNodeImpl(removed)->isOwned(false);
 
@@ -314,6 +388,7 @@ DOMNode *DOMAttrMapImpl::removeNamedItemNS(const XMLCh *namespaceURI, const XMLC
 
     DOMNode * removed = fNodes -> elementAt(i);
     fNodes -> removeElementAt(i);	//remove n from nodes
+    nodeRemoved(removed);
     castToNodeImpl(removed)->fOwnerNode = fOwnerNode->getOwnerDocument();
     castToNodeImpl(removed)->isOwned(false);
 
@@ -347,6 +422,7 @@ DOMNode * DOMAttrMapImpl::removeNamedItemAt(XMLSize_t index)
         throw DOMException(DOMException::NOT_FOUND_ERR, 0, GetDOMNamedNodeMapMemoryManager);
 
     fNodes->removeElementAt(index);
+    nodeRemoved(removed);
     castToNodeImpl(removed)->fOwnerNode = fOwnerNode->getOwnerDocument();
     castToNodeImpl(removed)->isOwned(false);
 
@@ -451,12 +527,16 @@ void DOMAttrMapImpl::setNamedItemFast(DOMNode *arg)
     int i = findNamePoint(arg->getNodeName());
 
     if(i >= 0)
+    {
+      nodeRemoved(fNodes->elementAt(i));
       fNodes->setElementAt(arg, i);
+    }
     else
     {
       i= -1 -i;
       fNodes->insertElementAt(arg, i);
     }
+    nodeAdded(arg);
 }
 
 void DOMAttrMapImpl::setNamedItemNSFast(DOMNode* arg)
@@ -469,6 +549,7 @@ void DOMAttrMapImpl::setNamedItemNSFast(DOMNode* arg)
 
     if(i >= 0)
     {
+        nodeRemoved(fNodes->elementAt(i));
         fNodes->setElementAt(arg,i);
     }
     else
@@ -480,6 +561,7 @@ void DOMAttrMapImpl::setNamedItemNSFast(DOMNode* arg)
 
         fNodes->insertElementAt(arg,i);
     }
+    nodeAdded(arg);
 }
 
 void DOMAttrMapImpl::reserve (XMLSize_t n)
@@ -491,4 +573,114 @@ void DOMAttrMapImpl::reserve (XMLSize_t n)
   }
 }
 
+// ---------------------------------------------------------------------------
+//  DOMAttrMapImpl: Namespace hash index maintenance
+// ---------------------------------------------------------------------------
+
+// Must be called after arg has been stored in fNodes.
+void DOMAttrMapImpl::nodeAdded(DOMNode *arg)
+{
+    if (fNSIndex != 0)
+    {
+        // Keep the load factor at or below 1/2.
+        if ((fNSIndexCount + 1) * 2 > fNSIndexSize)
+            buildNSIndex(fNSIndexSize * 2);
+        else
+            insertNSIndex(arg);
+    }
+    else if (fNodes->size() > kNSIndexThreshold)
+    {
+        XMLSize_t size = 64;
+        while (size < fNodes->size() * 4)
+            size *= 2;
+        buildNSIndex(size);
+    }
+}
+
+// Must be called after arg has been taken out of fNodes.
+void DOMAttrMapImpl::nodeRemoved(DOMNode *arg)
+{
+    if (fNSIndex == 0)
+        return;
+
+    const XMLSize_t mask = fNSIndexSize - 1;
+    XMLSize_t h = nsIndexHash(arg->getNamespaceURI(), nsIndexLocalName(arg)) & mask;
+    while (fNSIndex[h] != 0 && fNSIndex[h] != arg)
+        h = (h + 1) & mask;
+
+    if (fNSIndex[h] == 0)
+        return;
+
+    // Backward shift deletion so that no tombstones are needed.
+    fNSIndex[h] = 0;
+    fNSIndexCount--;
+    for (XMLSize_t j = (h + 1) & mask; fNSIndex[j] != 0; j = (j + 1) & mask)
+    {
+        DOMNode *node = fNSIndex[j];
+        XMLSize_t home = nsIndexHash(node->getNamespaceURI(), nsIndexLocalName(node)) & mask;
+
+        // Move the entry into the hole unless its home slot lies
+        // cyclically within (h, j].
+        bool inRange = (h <= j) ? (h < home && home <= j) : (h < home || home <= j);
+        if (!inRange)
+        {
+            fNSIndex[h] = node;
+            fNSIndex[j] = 0;
+            h = j;
+        }
+    }
+}
+
+void DOMAttrMapImpl::buildNSIndex(XMLSize_t size)
+{
+    // The old table (if any) stays in the document heap, the same way
+    // DOMNodeVector handles growth.
+    DOMDocumentImpl *doc = (DOMDocumentImpl*)fOwnerNode->getOwnerDocument();
+    fNSIndex = (DOMNode**) doc->allocate(sizeof(DOMNode*) * size);
+    memset(fNSIndex, 0, sizeof(DOMNode*) * size);
+    fNSIndexSize = size;
+    fNSIndexCount = 0;
+
+    XMLSize_t sz = fNodes->size();
+    for (XMLSize_t i = 0; i < sz; ++i)
+        insertNSIndex(fNodes->elementAt(i));
+}
+
+void DOMAttrMapImpl::insertNSIndex(DOMNode *arg)
+{
+    const XMLSize_t mask = fNSIndexSize - 1;
+    XMLSize_t h = nsIndexHash(arg->getNamespaceURI(), nsIndexLocalName(arg)) & mask;
+    while (fNSIndex[h] != 0)
+        h = (h + 1) & mask;
+    fNSIndex[h] = arg;
+    fNSIndexCount++;
+}
+
+// Returns the position of arg in fNodes, or -1 if it is not there.
+int DOMAttrMapImpl::findNodePoint(const DOMNode *arg) const
+{
+    // fNodes is sorted on the node name so start with a binary search and
+    // then check the neighbours that share the same name.
+    const XMLCh *name = arg->getNodeName();
+    int i = findNamePoint(name);
+    if (i >= 0)
+    {
+        for (int j = i; j >= 0 && XMLString::equals(fNodes->elementAt(j)->getNodeName(), name); --j)
+            if (fNodes->elementAt(j) == arg)
+                return j;
+        const int len = (int)fNodes->size();
+        for (int j = i + 1; j < len && XMLString::equals(fNodes->elementAt(j)->getNodeName(), name); ++j)
+            if (fNodes->elementAt(j) == arg)
+                return j;
+    }
+
+    // The ordering can be off if an attribute prefix was changed after it
+    // was added; fall back to a plain scan.
+    const XMLSize_t len = fNodes->size();
+    for (XMLSize_t j = 0; j < len; ++j)
+        if (fNodes->elementAt(j) == arg)
+            return (int)j;
+    return -1;
+}
+
 }
@@ -46,10 +46,24 @@ protected:
     DOMNode*          fOwnerNode;       // the node this map belongs to
     bool              attrDefaults;
 
+    // Open-addressing hash index over fNodes keyed on (namespaceURI,
+    // localName). It is only built once the map grows past
+    // a small number of attributes; smaller maps keep using the linear
+    // scan which is faster for them.
+    DOMNode**         fNSIndex;
+    XMLSize_t         fNSIndexSize;     // capacity, always a power of 2
+    XMLSize_t         fNSIndexCount;
+
     virtual void      cloneContent(const DOMAttrMapImpl *srcmap);
 
     bool              readOnly();  // revisit.  Look at owner node read-only.
 
+    void              nodeAdded(DOMNode *arg);
+    void              nodeRemoved(DOMNode *arg);
+    void              buildNSIndex(XMLSize_t size);
+    void              insertNSIndex(DOMNode *arg);
+    int               findNodePoint(const DOMNode *arg) const;
+
 public:
     DOMAttrMapImpl(DOMNode *ownerNod);
 
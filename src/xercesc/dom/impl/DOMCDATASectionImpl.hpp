@@ -49,6 +49,8 @@ protected:
     DOMChildNode          fChild;
     DOMCharacterDataImpl  fCharacterData;
 
+    friend class DOMDocumentCursorBase;
+
 
 public:
     DOMCDATASectionImpl(DOMDocument *ownerDoc, const XMLCh* data);
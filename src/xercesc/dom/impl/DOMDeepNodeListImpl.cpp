@@ -41,6 +41,9 @@ DOMDeepNodeListImpl::DOMDeepNodeListImpl(const DOMNode *rootNode,
     , fNamespaceURI(0)
     , fMatchAllURI(false)
     , fMatchURIandTagname(false)
+    , fFrozenItems(0)
+    , fFrozenLength(0)
+    , fFrozen(false)
 {
     fTagName = ((DOMDocumentImpl *)(castToNodeImpl(rootNode)->getOwnerDocument()))->getPooledString(tagName);
     fMatchAll = XMLString::equals(fTagName, kAstr);
@@ -57,6 +60,9 @@ DOMDeepNodeListImpl::DOMDeepNodeListImpl(const DOMNode *rootNode,
     , fCurrentIndexPlus1(0)
     , fMatchAllURI(false)
     , fMatchURIandTagname(true)
+    , fFrozenItems(0)
+    , fFrozenLength(0)
+    , fFrozen(false)
 {
     DOMDocumentImpl* doc = (DOMDocumentImpl *)castToNodeImpl(rootNode)->getOwnerDocument();
 
@@ -73,6 +79,9 @@ DOMDeepNodeListImpl::~DOMDeepNodeListImpl()
 
 XMLSize_t DOMDeepNodeListImpl::getLength() const
 {
+    if (fFrozen)
+        return fFrozenLength;
+
     // Reset cache to beginning of list
     item(0);
 
@@ -84,6 +93,9 @@ XMLSize_t DOMDeepNodeListImpl::getLength() const
 
 DOMNode *DOMDeepNodeListImpl::item(XMLSize_t index) const
 {
+    if (fFrozen)
+        return index < fFrozenLength ? fFrozenItems[index] : 0;
+
     return ((DOMDeepNodeListImpl*)this)->cacheItem(index);
 }
 
@@ -152,6 +164,30 @@ DOMNode *DOMDeepNodeListImpl::cacheItem(XMLSize_t index)
 
 
 
+void DOMDeepNodeListImpl::freeze()
+{
+    if (fFrozen)
+        return;
+
+    XMLSize_t length = 0;
+    DOMNode* current = (DOMNode*)fRootNode;
+    while ((current = nextMatchingElementAfter(current)) != 0)
+        length++;
+
+    // The items live on the document heap, like the list itself
+    if (length)
+    {
+        DOMDocumentImpl* doc = (DOMDocumentImpl *)castToNodeImpl(fRootNode)->getOwnerDocument();
+        fFrozenItems = (DOMNode**)doc->allocate(length * sizeof(DOMNode*));
+        current = (DOMNode*)fRootNode;
+        for (XMLSize_t i = 0; i < length; i++)
+            fFrozenItems[i] = current = nextMatchingElementAfter(current);
+    }
+    fFrozenLength = length;
+    fFrozen = true;
+}
+
+
 /* Iterative tree-walker. When you have a Parent link, there's often no
 need to resort to recursion. NOTE THAT only Element nodes are matched
 since we're specifically supporting getElementsByTagName().
@@ -54,6 +54,11 @@ protected:
     bool	     fMatchAllURI;
     bool             fMatchURIandTagname; //match both namespaceURI and tagName
 
+    // All matching elements, once the list is frozen
+    DOMNode**        fFrozenItems;
+    XMLSize_t        fFrozenLength;
+    bool             fFrozen;
+
 public:
     DOMDeepNodeListImpl(const DOMNode *rootNode, const XMLCh *tagName);
     DOMDeepNodeListImpl(const DOMNode *rootNode,	//DOM Level 2
@@ -64,6 +69,10 @@ public:
     virtual DOMNode*     item(XMLSize_t index) const;
     DOMNode*             cacheItem(XMLSize_t index);
 
+    // Collects the matching elements once, so that the list can be read
+    // from several threads and no longer follows changes to the tree
+    void                 freeze();
+
 protected:
     DOMNode*          nextMatchingElementAfter(DOMNode *current);
 
@@ -266,6 +266,12 @@ DOMDeepNodeListPool<TVal, THasher>::getById(const XMLSize_t elemId) const
     return fIdPtrs[elemId];
 }
 
+template <class TVal, class THasher>
+XMLSize_t DOMDeepNodeListPool<TVal, THasher>::getIdCount() const
+{
+    return fIdCounter;
+}
+
 // ---------------------------------------------------------------------------
 //  DOMDeepNodeListPool: Putters
 // ---------------------------------------------------------------------------
@@ -127,6 +127,7 @@ public:
 
     TVal* getById(const XMLSize_t elemId);
     const TVal* getById(const XMLSize_t elemId) const;
+    XMLSize_t getIdCount() const;
 
     // -----------------------------------------------------------------------
     //  Putters
@@ -0,0 +1,381 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+#if !defined(XERCESC_INCLUDE_GUARD_DOMDOCUMENTCURSOR_HPP)
+#define XERCESC_INCLUDE_GUARD_DOMDOCUMENTCURSOR_HPP
+
+//
+//  This file is part of the implementation of the C++ XML DOM, and only
+//  works with the nodes it creates.
+//
+//  Unlike the other files in this directory, applications may include it
+//  to walk large trees faster than DOMTreeWalker or DOMNodeIterator can.
+//  Those go through the virtual DOMNode interface for every link they
+//  follow and through DOMNodeFilter for every node. The cursor reads the
+//  links of the implementation classes directly, makes a single virtual
+//  call per node to learn its type, and calls a filter that can be
+//  inlined.
+//
+
+#include <xercesc/dom/DOMNodeFilter.hpp>
+#include "DOMAttrImpl.hpp"
+#include "DOMCDATASectionImpl.hpp"
+#include "DOMCommentImpl.hpp"
+#include "DOMDocumentFragmentImpl.hpp"
+#include "DOMDocumentImpl.hpp"
+#include "DOMDocumentTypeImpl.hpp"
+#include "DOMElementImpl.hpp"
+#include "DOMEntityImpl.hpp"
+#include "DOMEntityReferenceImpl.hpp"
+#include "DOMNotationImpl.hpp"
+#include "DOMProcessingInstructionImpl.hpp"
+#include "DOMStringPool.hpp"
+#include "DOMTextImpl.hpp"
+
+namespace XERCES_CPP_NAMESPACE {
+
+/**
+ * Non-standard extension.
+ *
+ * The position of a DOMDocumentCursor, which is what its filter is given.
+ * The tree must not be changed while a cursor walks it.
+ */
+class DOMDocumentCursorBase
+{
+public:
+    /** The node the cursor is at, or null before the first and after the last node */
+    DOMNode* getNode() const
+    {
+        return fCurrent;
+    }
+
+    /** The type of the node the cursor is at */
+    DOMNode::NodeType getNodeType() const
+    {
+        return fType;
+    }
+
+    /** The number of levels the node is below the root */
+    XMLSize_t getDepth() const
+    {
+        return fDepth;
+    }
+
+    /** The name of the node, as <code>getNodeName()</code> returns it */
+    const XMLCh* getNodeName() const
+    {
+        switch (fType)
+        {
+        case DOMNode::ELEMENT_NODE:
+            return static_cast<DOMElementImpl*>(fCurrent)->fName;
+        case DOMNode::PROCESSING_INSTRUCTION_NODE:
+            return static_cast<DOMProcessingInstructionImpl*>(fCurrent)->fTarget;
+        case DOMNode::ENTITY_REFERENCE_NODE:
+            return static_cast<DOMEntityReferenceImpl*>(fCurrent)->fName;
+        default:
+            return fCurrent->getNodeName();
+        }
+    }
+
+    /** The value of the node, as <code>getNodeValue()</code> returns it */
+    const XMLCh* getNodeValue() const
+    {
+        switch (fType)
+        {
+        case DOMNode::ELEMENT_NODE:
+        case DOMNode::ENTITY_REFERENCE_NODE:
+        case DOMNode::DOCUMENT_NODE:
+        case DOMNode::DOCUMENT_FRAGMENT_NODE:
+            return 0;
+        case DOMNode::TEXT_NODE:
+            return static_cast<DOMTextImpl*>(fCurrent)->fCharacterData.fDataBuf->getRawBuffer();
+        case DOMNode::CDATA_SECTION_NODE:
+            return static_cast<DOMCDATASectionImpl*>(fCurrent)->fCharacterData.fDataBuf->getRawBuffer();
+        case DOMNode::COMMENT_NODE:
+            return static_cast<DOMCommentImpl*>(fCurrent)->fCharacterData.fDataBuf->getRawBuffer();
+        case DOMNode::PROCESSING_INSTRUCTION_NODE:
+            return static_cast<DOMProcessingInstructionImpl*>(fCurrent)->fCharacterData.fDataBuf->getRawBuffer();
+        default:
+            return fCurrent->getNodeValue();
+        }
+    }
+
+    /** Don't go into the children of the node the cursor is at */
+    void skipChildren()
+    {
+        fSkipChildren = true;
+    }
+
+    /** Go back to before the root */
+    void reset()
+    {
+        fCurrent = 0;
+        fStarted = false;
+    }
+
+protected:
+    DOMDocumentCursorBase(DOMNode* root)
+        : fRoot(root)
+        , fCurrent(0)
+        , fType(DOMNode::ELEMENT_NODE)
+        , fNodeImpl(0)
+        , fParentImpl(0)
+        , fChildImpl(0)
+        , fDepth(0)
+        , fStarted(false)
+        , fSkipChildren(false)
+    {
+    }
+
+    // Moves to the next node in document order below the root, the root
+    //   itself first. Returns false at the end.
+    bool step()
+    {
+        if (!fStarted)
+        {
+            fStarted = true;
+            fDepth = 0;
+            if (fRoot == 0)
+                return false;
+            moveTo(fRoot);
+            return true;
+        }
+        if (fCurrent == 0)
+            return false;
+
+        const bool skipChildren = fSkipChildren;
+        fSkipChildren = false;
+        if (!skipChildren && fParentImpl && fParentImpl->fFirstChild)
+        {
+            fDepth++;
+            moveTo(fParentImpl->fFirstChild);
+            return true;
+        }
+
+        while (fCurrent != fRoot)
+        {
+            if (fChildImpl && fChildImpl->nextSibling)
+            {
+                moveTo(fChildImpl->nextSibling);
+                return true;
+            }
+            DOMNode* parent = fNodeImpl->isOwned() ? fNodeImpl->fOwnerNode : 0;
+            if (parent == 0)
+                break;
+            fDepth--;
+            moveTo(parent);
+        }
+        fCurrent = 0;
+        return false;
+    }
+
+private:
+    // Finds the parts of the node that hold its links
+    void moveTo(DOMNode* node)
+    {
+        fCurrent = node;
+        fType = node->getNodeType();
+        fParentImpl = 0;
+        fChildImpl = 0;
+        switch (fType)
+        {
+        case DOMNode::ELEMENT_NODE:
+            {
+                DOMElementImpl* impl = static_cast<DOMElementImpl*>(node);
+                fNodeImpl = &impl->fNode;
+                fParentImpl = &impl->fParent;
+                fChildImpl = &impl->fChild;
+                break;
+            }
+        case DOMNode::TEXT_NODE:
+            {
+                DOMTextImpl* impl = static_cast<DOMTextImpl*>(node);
+                fNodeImpl = &impl->fNode;
+                fChildImpl = &impl->fChild;
+                break;
+            }
+        case DOMNode::CDATA_SECTION_NODE:
+            {
+                DOMCDATASectionImpl* impl = static_cast<DOMCDATASectionImpl*>(node);
+                fNodeImpl = &impl->fNode;
+                fChildImpl = &impl->fChild;
+                break;
+            }
+        case DOMNode::COMMENT_NODE:
+            {
+                DOMCommentImpl* impl = static_cast<DOMCommentImpl*>(node);
+                fNodeImpl = &impl->fNode;
+                fChildImpl = &impl->fChild;
+                break;
+            }
+        case DOMNode::PROCESSING_INSTRUCTION_NODE:
+            {
+                DOMProcessingInstructionImpl* impl = static_cast<DOMProcessingInstructionImpl*>(node);
+                fNodeImpl = &impl->fNode;
+                fChildImpl = &impl->fChild;
+                break;
+            }
+        case DOMNode::ENTITY_REFERENCE_NODE:
+            {
+                DOMEntityReferenceImpl* impl = static_cast<DOMEntityReferenceImpl*>(node);
+                fNodeImpl = &impl->fNode;
+                fParentImpl = &impl->fParent;
+                fChildImpl = &impl->fChild;
+                break;
+            }
+        case DOMNode::DOCUMENT_TYPE_NODE:
+            {
+                DOMDocumentTypeImpl* impl = static_cast<DOMDocumentTypeImpl*>(node);
+                fNodeImpl = &impl->fNode;
+                fParentImpl = &impl->fParent;
+                fChildImpl = &impl->fChild;
+                break;
+            }
+        case DOMNode::DOCUMENT_NODE:
+            {
+                DOMDocumentImpl* impl = static_cast<DOMDocumentImpl*>(node);
+                fNodeImpl = &impl->fNode;
+                fParentImpl = &impl->fParent;
+                break;
+            }
+        case DOMNode::DOCUMENT_FRAGMENT_NODE:
+            {
+                DOMDocumentFragmentImpl* impl = static_cast<DOMDocumentFragmentImpl*>(node);
+                fNodeImpl = &impl->fNode;
+                fParentImpl = &impl->fParent;
+                break;
+            }
+        case DOMNode::ATTRIBUTE_NODE:
+            {
+                DOMAttrImpl* impl = static_cast<DOMAttrImpl*>(node);
+                fNodeImpl = &impl->fNode;
+                fParentImpl = &impl->fParent;
+                break;
+            }
+        case DOMNode::ENTITY_NODE:
+            {
+                DOMEntityImpl* impl = static_cast<DOMEntityImpl*>(node);
+                fNodeImpl = &impl->fNode;
+                fParentImpl = &impl->fParent;
+                break;
+            }
+        case DOMNode::NOTATION_NODE:
+            fNodeImpl = &static_cast<DOMNotationImpl*>(node)->fNode;
+            break;
+        default:
+            // Only a root can be of another type, and it has no children
+            fNodeImpl = 0;
+            break;
+        }
+    }
+
+    // -----------------------------------------------------------------------
+    // Unimplemented constructors and operators
+    // -----------------------------------------------------------------------
+    DOMDocumentCursorBase(const DOMDocumentCursorBase&);
+    DOMDocumentCursorBase& operator=(const DOMDocumentCursorBase&);
+
+    DOMNode*            fRoot;
+    DOMNode*            fCurrent;
+    DOMNode::NodeType   fType;
+    DOMNodeImpl*        fNodeImpl;
+    DOMParentNode*      fParentImpl;
+    DOMChildNode*       fChildImpl;
+    XMLSize_t           fDepth;
+    bool                fStarted;
+    bool                fSkipChildren;
+};
+
+/**
+ * Non-standard extension.
+ *
+ * The filter of a DOMDocumentCursor that accepts every node.
+ */
+struct DOMDocumentCursorAcceptAll
+{
+    DOMNodeFilter::FilterAction operator()(const DOMDocumentCursorBase&) const
+    {
+        return DOMNodeFilter::FILTER_ACCEPT;
+    }
+};
+
+/**
+ * Non-standard extension.
+ *
+ * Walks a subtree in document order, like a DOMNodeIterator, without virtual
+ * calls other than one per node to learn its type. The filter is a function
+ * object that is given the position of the cursor and returns a
+ * <code>DOMNodeFilter::FilterAction</code>: FILTER_SKIP passes over the node
+ * but not its children, FILTER_REJECT passes over both. Attributes, entities
+ * and notations are only visited when they are the root.
+ *
+ * <pre>
+ * struct Elements {
+ *     DOMNodeFilter::FilterAction operator()(const DOMDocumentCursorBase& at) const {
+ *         return at.getNodeType() == DOMNode::ELEMENT_NODE ? DOMNodeFilter::FILTER_ACCEPT
+ *                                                          : DOMNodeFilter::FILTER_SKIP;
+ *     }
+ * };
+ * DOMDocumentCursor<Elements> cursor(doc);
+ * while (cursor.nextNode())
+ *     use(cursor.getNodeName());
+ * </pre>
+ */
+template <class TFilter = DOMDocumentCursorAcceptAll>
+class DOMDocumentCursor : public DOMDocumentCursorBase
+{
+public:
+    DOMDocumentCursor(DOMNode* root, const TFilter& filter = TFilter())
+        : DOMDocumentCursorBase(root)
+        , fFilter(filter)
+    {
+    }
+
+    /**
+     * Moves to the next node the filter accepts.
+     *
+     * @return false if there is none, which leaves the cursor after the last node
+     */
+    bool nextNode()
+    {
+        while (step())
+        {
+            switch (fFilter(*this))
+            {
+            case DOMNodeFilter::FILTER_ACCEPT:
+                return true;
+            case DOMNodeFilter::FILTER_REJECT:
+                skipChildren();
+                break;
+            default:
+                break;
+            }
+        }
+        return false;
+    }
+
+private:
+    TFilter fFilter;
+};
+
+}
+
+#endif
@@ -50,6 +50,7 @@ protected:
     DOMDocumentFragmentImpl(DOMDocument *);
     DOMDocumentFragmentImpl(const DOMDocumentFragmentImpl &other, bool deep);
     friend class DOMDocumentImpl;
+    friend class DOMDocumentCursorBase;
 
 private:
     // -----------------------------------------------------------------------
@@ -50,6 +50,9 @@
 #include <xercesc/util/XMLInitializer.hpp>
 #include <xercesc/util/Janitor.hpp>
 
+#include <atomic>
+#include <cstring>
+
 namespace XERCES_CPP_NAMESPACE {
 
 // The chunk size to allocate from the system allocator.
@@ -59,6 +62,42 @@ static XMLSize_t kMaxSubAllocationSize =  0x0100;  // Any request for more bytes
                                                    // than this will be handled by
                                                    // allocating directly with system.
 
+// A node list created after the document was frozen, with its own copy of
+// the keys it was requested with.
+struct DOMFrozenNodeList
+{
+    const DOMNode*       fRootNode;
+    const XMLCh*         fNamespaceURI;
+    const XMLCh*         fLocalName;
+    bool                 fLevel2;
+    DOMDeepNodeListImpl* fList;
+    DOMFrozenNodeList*   fNext;
+};
+
+// The state of a frozen document that readers on several threads may
+// change. Both lists only ever grow, by compare-and-swap of their head.
+class DOMFrozenState : public XMemory
+{
+public:
+    enum { kBucketCount = 109 };
+
+    DOMFrozenState() : fBlocks(0)
+    {
+        for (XMLSize_t i = 0; i < kBucketCount; i++)
+            fLists[i].store(0, std::memory_order_relaxed);
+    }
+
+    // Blocks taken from the memory manager, each headed by a pointer to the
+    // previous one
+    std::atomic<void*>              fBlocks;
+    // Hash table of the node lists created since freezing
+    std::atomic<DOMFrozenNodeList*> fLists[kBucketCount];
+
+private:
+    DOMFrozenState(const DOMFrozenState&);
+    DOMFrozenState& operator=(const DOMFrozenState&);
+};
+
 void XMLInitializer::initializeDOMHeap (XMLSize_t initialHeapAllocSize,
                                         XMLSize_t maxHeapAllocSize,
                                         XMLSize_t maxSubAllocationSize)
@@ -88,19 +127,26 @@ DOMDocumentImpl::DOMDocumentImpl(DOMImplementation* domImpl, MemoryManager* cons
       fXmlVersion(0),
       fDocumentURI(0),
       fDOMConfiguration(0),
-      fUserDataTableKeys(17, manager),
+      fUserDataTableKeys(0),
       fUserDataTable(0),
       fCurrentBlock(0),
       fCurrentSingletonBlock(0),
       fFreePtr(0),
       fFreeBytesRemaining(0),
       fHeapAllocSize(kInitialHeapAllocSize),
+      fCurrentBlockSize(0),
+      fHeapBlockCount(0),
+      fHeapBlockBytes(0),
+      fHeapAllocatedBytes(0),
+      fFrozenState(0),
       fRecycleNodePtr(0),
       fRecycleBufferPtr(0),
       fNodeListPool(0),
       fDocType(0),
       fDocElement(0),
-      fNameTableSize(257),
+      fNameTable(0),
+      fNameTableSize(0),
+      fNameTableCount(0),
       fNormalizer(0),
       fRanges(0),
       fNodeIterators(0),
@@ -109,10 +155,8 @@ DOMDocumentImpl::DOMDocumentImpl(DOMImplementation* domImpl, MemoryManager* cons
       fChanges(0),
       errorChecking(true)
 {
-    fNameTable = (DOMStringPoolEntry**)allocate (
-      sizeof (DOMStringPoolEntry*) * fNameTableSize);
-    for (XMLSize_t i = 0; i < fNameTableSize; i++)
-      fNameTable[i] = 0;
+    memset(fNodeCount, 0, sizeof(fNodeCount));
+    memset(fNodeSize, 0, sizeof(fNodeSize));
 }
 
 
@@ -131,19 +175,26 @@ DOMDocumentImpl::DOMDocumentImpl(const XMLCh *fNamespaceURI,
       fXmlVersion(0),
       fDocumentURI(0),
       fDOMConfiguration(0),
-      fUserDataTableKeys(17, manager),
+      fUserDataTableKeys(0),
       fUserDataTable(0),
       fCurrentBlock(0),
       fCurrentSingletonBlock(0),
       fFreePtr(0),
       fFreeBytesRemaining(0),
       fHeapAllocSize(kInitialHeapAllocSize),
+      fCurrentBlockSize(0),
+      fHeapBlockCount(0),
+      fHeapBlockBytes(0),
+      fHeapAllocatedBytes(0),
+      fFrozenState(0),
       fRecycleNodePtr(0),
       fRecycleBufferPtr(0),
       fNodeListPool(0),
       fDocType(0),
       fDocElement(0),
-      fNameTableSize(257),
+      fNameTable(0),
+      fNameTableSize(0),
+      fNameTableCount(0),
       fNormalizer(0),
       fRanges(0),
       fNodeIterators(0),
@@ -152,10 +203,8 @@ DOMDocumentImpl::DOMDocumentImpl(const XMLCh *fNamespaceURI,
       fChanges(0),
       errorChecking(true)
 {
-    fNameTable = (DOMStringPoolEntry**)allocate (
-      sizeof (DOMStringPoolEntry*) * fNameTableSize);
-    for (XMLSize_t i = 0; i < fNameTableSize; i++)
-      fNameTable[i] = 0;
+    memset(fNodeCount, 0, sizeof(fNodeCount));
+    memset(fNodeSize, 0, sizeof(fNodeSize));
 
     try {
         setDocumentType(doctype);
@@ -222,6 +271,8 @@ DOMDocumentImpl::~DOMDocumentImpl()
     if (fUserDataTable)
         delete fUserDataTable;//fUserDataTable->cleanup();
 
+    delete fUserDataTableKeys;
+
     if (fRecycleNodePtr) {
         fRecycleNodePtr->deleteAllElements();
         delete fRecycleNodePtr;
@@ -420,6 +471,10 @@ DOMNodeIterator* DOMDocumentImpl::createNodeIterator (
 
     DOMNodeIteratorImpl* nodeIterator = new (this) DOMNodeIteratorImpl(this, root, whatToShow, filter, entityReferenceExpansion);
 
+    // A frozen tree can't change, so there is nothing to notify it of
+    if (fFrozenState)
+        return nodeIterator;
+
     if (fNodeIterators == 0L) {
         //fNodeIterators = new (this) NodeIterators(1, false);
         fNodeIterators = new (fMemoryManager) NodeIterators(1, false, fMemoryManager);
@@ -675,6 +730,10 @@ DOMRange* DOMDocumentImpl::createRange()
 
     DOMRangeImpl* range = new (this) DOMRangeImpl(this, fMemoryManager);
 
+    // A frozen tree can't change, so there is nothing to notify it of
+    if (fFrozenState)
+        return range;
+
     if (fRanges == 0L) {
         //fRanges = new (this) Ranges(1, false);
         fRanges = new (fMemoryManager) Ranges(1, false, fMemoryManager); // XMemory
@@ -755,7 +814,10 @@ bool DOMDocumentImpl::isKidOK(const DOMNode *parent, const DOMNode *child)
 
 void            DOMDocumentImpl::changed()
 {
-    fChanges++;
+    // Only nodes outside of a frozen tree can change, and readers of the
+    // tree may be checking the counter
+    if (!fFrozenState)
+        fChanges++;
 }
 
 
@@ -827,6 +889,96 @@ XMLSize_t DOMDocumentImpl::getMemoryAllocationBlockSize() const
     return fHeapAllocSize;
 }
 
+// Adds the character data in the tree below node to the string usage of
+// the given type, or of the type of each node if there is none
+static void countStringBytes(const DOMNode* node, DOMMemoryManager::MemoryUsage& usage, int type)
+{
+    for (const DOMNode* child = node->getFirstChild(); child != 0; child = child->getNextSibling())
+    {
+        int childType = type;
+        switch (child->getNodeType())
+        {
+        case DOMNode::TEXT_NODE:
+            if (childType < 0)
+                childType = DOMMemoryManager::TEXT_OBJECT;
+            break;
+        case DOMNode::CDATA_SECTION_NODE:
+            if (childType < 0)
+                childType = DOMMemoryManager::CDATA_SECTION_OBJECT;
+            break;
+        case DOMNode::COMMENT_NODE:
+            if (childType < 0)
+                childType = DOMMemoryManager::COMMENT_OBJECT;
+            break;
+        case DOMNode::PROCESSING_INSTRUCTION_NODE:
+            if (childType < 0)
+                childType = DOMMemoryManager::PROCESSING_INSTRUCTION_OBJECT;
+            break;
+        case DOMNode::ELEMENT_NODE:
+            {
+                const DOMNamedNodeMap* attrs = child->getAttributes();
+                for (XMLSize_t i = 0; attrs != 0 && i < attrs->getLength(); i++)
+                {
+                    const DOMNode* attr = attrs->item(i);
+                    countStringBytes(attr, usage, attr->getLocalName() ? DOMMemoryManager::ATTR_NS_OBJECT
+                                                                       : DOMMemoryManager::ATTR_OBJECT);
+                }
+            }
+            // fall through
+        default:
+            countStringBytes(child, usage, type);
+            continue;
+        }
+
+        const XMLCh* value = child->getNodeValue();
+        if (value)
+            usage.fStringBytes[childType] += (XMLString::stringLen(value) + 1) * sizeof(XMLCh);
+    }
+}
+
+void DOMDocumentImpl::getMemoryUsage(DOMMemoryManager::MemoryUsage& usage, bool walkTree) const
+{
+    memset(&usage, 0, sizeof(usage));
+    usage.fBlockCount = fHeapBlockCount;
+    usage.fBlockBytes = fHeapBlockBytes;
+    usage.fAllocatedBytes = fHeapAllocatedBytes;
+
+    for (int type = 0; type < DOMMemoryManager::NodeObjectType_Count; type++)
+    {
+        usage.fNodeCount[type] = fNodeCount[type];
+        usage.fNodeBytes[type] = fNodeCount[type] * fNodeSize[type];
+        if (fRecycleNodePtr && fRecycleNodePtr->operator[](type))
+            usage.fWastedBytes += fRecycleNodePtr->operator[](type)->size() * fNodeSize[type];
+    }
+    if (fRecycleBufferPtr)
+    {
+        for (XMLSize_t i = 0; i < fRecycleBufferPtr->size(); i++)
+            usage.fWastedBytes += (fRecycleBufferPtr->elementAt(i)->getCapacity() + 1) * sizeof(XMLCh);
+    }
+
+    if (!walkTree)
+        return;
+
+    countStringBytes(this, usage, -1);
+    if (fDocType)
+    {
+        // the entities and notations are not children of the doctype
+        const DOMNamedNodeMap* entities = fDocType->getEntities();
+        for (XMLSize_t i = 0; entities != 0 && i < entities->getLength(); i++)
+            countStringBytes(entities->item(i), usage, -1);
+    }
+
+    for (XMLSize_t i = 0; fNameTable != 0 && i < fNameTableSize; i++)
+    {
+        for (const DOMStringPoolEntry* spe = fNameTable[i]; spe != 0; spe = spe->fNext)
+        {
+            usage.fPooledStringCount++;
+            usage.fPooledStringBytes += XMLPlatformUtils::alignPointerForNewBlockAllocation(
+                sizeof(DOMStringPoolEntry) + spe->fLength * sizeof(XMLCh));
+        }
+    }
+}
+
 void DOMDocumentImpl::setMemoryAllocationBlockSize(XMLSize_t size)
 {
     // the new size must be bigger than the maximum amount of each allocation
@@ -836,8 +988,12 @@ void DOMDocumentImpl::setMemoryAllocationBlockSize(XMLSize_t size)
 
 void DOMDocumentImpl::release(void* oldBuffer)
 {
+    // the heap of a frozen document doesn't change anymore
+    if (fFrozenState)
+        return;
+
     // only release blocks that are stored in a block by itself
-    XMLSize_t sizeOfHeader = XMLPlatformUtils::alignPointerForNewBlockAllocation(sizeof(void *));
+    XMLSize_t sizeOfHeader = XMLPlatformUtils::alignPointerForNewBlockAllocation(sizeof(void *) + sizeof(XMLSize_t));
     void** cursor = &fCurrentSingletonBlock;
     while (*cursor != 0)
     {
@@ -847,6 +1003,10 @@ void DOMDocumentImpl::release(void* oldBuffer)
             // found: deallocate and replace the pointer value with the next block
             void* current = *cursor;
             *cursor = *nextBlock;
+            const XMLSize_t blockSize = *(XMLSize_t*)((void**)current + 1);
+            fHeapBlockCount--;
+            fHeapBlockBytes -= blockSize;
+            fHeapAllocatedBytes -= blockSize - sizeOfHeader;
             fMemoryManager->deallocate(current);
             break;
         }
@@ -860,16 +1020,24 @@ void* DOMDocumentImpl::allocate(XMLSize_t amount)
   //	beyond this one will be maintained at the same alignment.
   amount = XMLPlatformUtils::alignPointerForNewBlockAllocation(amount);
 
+  if (fFrozenState)
+    return allocateFrozen(amount);
+
   // If the request is for a largish block, hand it off to the system
   //   allocator.  The block still must be linked into a special list of
   //   allocated big blocks so that it will be deleted when the time comes.
   if (amount > kMaxSubAllocationSize)
   {
-    //	The size of the header we add to our raw blocks
-    XMLSize_t sizeOfHeader = XMLPlatformUtils::alignPointerForNewBlockAllocation(sizeof(void *));
+    //	The size of the header we add to our raw blocks, which also
+    //	records the size of the block
+    XMLSize_t sizeOfHeader = XMLPlatformUtils::alignPointerForNewBlockAllocation(sizeof(void *) + sizeof(XMLSize_t));
 
     //	Try to allocate the block
     void* newBlock = fMemoryManager->allocate(sizeOfHeader + amount);
+    *(XMLSize_t*)((void**)newBlock + 1) = sizeOfHeader + amount;
+    fHeapBlockCount++;
+    fHeapBlockBytes += sizeOfHeader + amount;
+    fHeapAllocatedBytes += amount;
 
     //	Link it into the list beyond current block, as current block
     //	is still being subdivided. If there is no current block
@@ -905,6 +1073,9 @@ void* DOMDocumentImpl::allocate(XMLSize_t amount)
     fCurrentBlock = newBlock;
     fFreePtr = (char *)newBlock + sizeOfHeader;
     fFreeBytesRemaining = fHeapAllocSize - sizeOfHeader;
+    fCurrentBlockSize = fHeapAllocSize;
+    fHeapBlockCount++;
+    fHeapBlockBytes += fHeapAllocSize;
 
     if(fHeapAllocSize<kMaxHeapAllocSize)
       fHeapAllocSize*=2;
@@ -914,11 +1085,65 @@ void* DOMDocumentImpl::allocate(XMLSize_t amount)
   void *retPtr = fFreePtr;
   fFreePtr += amount;
   fFreeBytesRemaining -= amount;
+  fHeapAllocatedBytes += amount;
 
   return retPtr;
 }
 
 
+bool DOMDocumentImpl::growInPlace(void* block, XMLSize_t oldAmount, XMLSize_t newAmount)
+{
+  if (fFrozenState)
+    return false;
+
+  oldAmount = XMLPlatformUtils::alignPointerForNewBlockAllocation(oldAmount);
+  newAmount = XMLPlatformUtils::alignPointerForNewBlockAllocation(newAmount);
+
+  // Only the last sub-allocated block ends where the free space begins;
+  //   singleton blocks never do
+  if ((char*)block + oldAmount != fFreePtr || newAmount < oldAmount ||
+      newAmount - oldAmount > fFreeBytesRemaining)
+    return false;
+
+  fFreePtr += newAmount - oldAmount;
+  fFreeBytesRemaining -= newAmount - oldAmount;
+  fHeapAllocatedBytes += newAmount - oldAmount;
+  return true;
+}
+
+void DOMDocumentImpl::adoptHeapBlock(void* block, XMLSize_t blockSize)
+{
+  XMLSize_t sizeOfHeader = XMLPlatformUtils::alignPointerForNewBlockAllocation(sizeof(void *));
+
+  *(void **)block = fCurrentBlock;
+  fCurrentBlock = block;
+  fFreePtr = (char *)block + sizeOfHeader;
+  fFreeBytesRemaining = blockSize - sizeOfHeader;
+  fCurrentBlockSize = blockSize;
+  fHeapBlockCount++;
+  fHeapBlockBytes += blockSize;
+
+  // carry on with the sizes that follow the adopted block
+  while (fHeapAllocSize <= blockSize && fHeapAllocSize < kMaxHeapAllocSize)
+    fHeapAllocSize *= 2;
+}
+
+void* DOMDocumentImpl::releaseKeepingHeapBlock(XMLSize_t& blockSize)
+{
+  // The current block is the last and largest one taken. Nothing in it is
+  //   freed while the document is released, so it can be unlinked first.
+  void* block = fCurrentBlock;
+  blockSize = fCurrentBlockSize;
+  if (block != 0)
+  {
+    fCurrentBlock = *(void **)block;
+    fFreePtr = 0;
+    fFreeBytesRemaining = 0;
+  }
+  release();
+  return block;
+}
+
 void DOMDocumentImpl::deleteHeap()
 {
     while (fCurrentBlock != 0)
@@ -933,11 +1158,169 @@ void DOMDocumentImpl::deleteHeap()
         fMemoryManager->deallocate(fCurrentSingletonBlock);
         fCurrentSingletonBlock = nextBlock;
     }
+    fHeapBlockCount = fHeapBlockBytes = fHeapAllocatedBytes = 0;
+
+    if (fFrozenState)
+    {
+        void* block = fFrozenState->fBlocks.load(std::memory_order_acquire);
+        while (block != 0)
+        {
+            void *nextBlock = *(void **)block;
+            fMemoryManager->deallocate(block);
+            block = nextBlock;
+        }
+        delete fFrozenState;
+        fFrozenState = 0;
+    }
+}
+
+
+void* DOMDocumentImpl::allocateFrozen(XMLSize_t amount)
+{
+    // Every request gets a block of its own, so that threads don't share a
+    //   free pointer. The block is pushed onto the list of frozen blocks.
+    XMLSize_t sizeOfHeader = XMLPlatformUtils::alignPointerForNewBlockAllocation(sizeof(void *));
+    void* newBlock = fMemoryManager->allocate(sizeOfHeader + amount);
+
+    void* head = fFrozenState->fBlocks.load(std::memory_order_relaxed);
+    do
+    {
+        *(void **)newBlock = head;
+    }
+    while (!fFrozenState->fBlocks.compare_exchange_weak(head, newBlock,
+                                                        std::memory_order_release,
+                                                        std::memory_order_relaxed));
+
+    return (char*)newBlock + sizeOfHeader;
+}
+
+
+//
+//  Adds a string that is not in the pool yet. The table of buckets starts
+//  small, since most documents only have a few names, and is replaced by a
+//  larger one when it holds as many strings as it has buckets.
+//
+const XMLCh* DOMDocumentImpl::addPooledString(const XMLCh* in, XMLSize_t n)
+{
+    static const XMLSize_t tableSizes[] = { 31, 127, 509, 2039 };
+    static const XMLSize_t tableSizeCount = sizeof(tableSizes) / sizeof(tableSizes[0]);
+
+    if (fNameTableCount >= fNameTableSize && fNameTableSize < tableSizes[tableSizeCount - 1])
+    {
+        XMLSize_t newSize = tableSizes[0];
+        for (XMLSize_t i = 0; tableSizes[i] <= fNameTableSize; i++)
+            newSize = tableSizes[i + 1];
+
+        DOMStringPoolEntry** newTable = (DOMStringPoolEntry**)allocate(sizeof(DOMStringPoolEntry*) * newSize);
+        memset(newTable, 0, sizeof(DOMStringPoolEntry*) * newSize);
+        for (XMLSize_t i = 0; i < fNameTableSize; i++)
+        {
+            DOMStringPoolEntry* spe = fNameTable[i];
+            while (spe != 0)
+            {
+                DOMStringPoolEntry* next = spe->fNext;
+                XMLSize_t newHash = spe->fLength ? XMLString::hashN(spe->fString, spe->fLength - 1, newSize) : 0;
+                spe->fNext = newTable[newHash];
+                newTable[newHash] = spe;
+                spe = next;
+            }
+        }
+        if (fNameTable != 0)
+            release(fNameTable);
+        fNameTable = newTable;
+        fNameTableSize = newSize;
+    }
+
+    // Compute size to allocate.  Note that there's 1 char of string
+    // declared in the struct, so we don't need to add one again to
+    // account for the trailing null.
+    //
+    XMLSize_t sizeToAllocate = sizeof(DOMStringPoolEntry) + n*sizeof(XMLCh);
+    DOMStringPoolEntry* spe = (DOMStringPoolEntry *)allocate(sizeToAllocate);
+    spe->fLength = n;
+    memcpy((XMLCh*)spe->fString, in, n * sizeof(XMLCh));
+    ((XMLCh*)spe->fString)[n] = 0;
+
+    XMLSize_t inHash = n ? XMLString::hashN(in, n - 1, fNameTableSize) : 0;
+    spe->fNext = fNameTable[inHash];
+    fNameTable[inHash] = spe;
+    fNameTableCount++;
+
+    return spe->fString;
+}
+
+const XMLCh* DOMDocumentImpl::copyFrozenString(const XMLCh* in, XMLSize_t n)
+{
+    XMLCh* copy = (XMLCh*)allocateFrozen((n + 1) * sizeof(XMLCh));
+    memcpy(copy, in, n * sizeof(XMLCh));
+    copy[n] = 0;
+    return copy;
+}
+
+
+DOMNodeList *DOMDocumentImpl::getFrozenDeepNodeList(const DOMNode *rootNode,
+                                                   const XMLCh *namespaceURI,
+                                                   const XMLCh *localName,
+                                                   bool level2)
+{
+    // The lists that were requested before freezing have been filled in
+    if (fNodeListPool)
+    {
+        const DOMDeepNodeListPool<DOMDeepNodeListImpl>* pool = fNodeListPool;
+        const DOMDeepNodeListImpl* poolList = pool->getByKey(rootNode, localName, namespaceURI);
+        if (poolList)
+            return (DOMDeepNodeListImpl*)poolList;
+    }
+
+    XMLSize_t hashVal = XMLString::hash(localName, DOMFrozenState::kBucketCount);
+    hashVal = (hashVal + (XMLSize_t)rootNode) % DOMFrozenState::kBucketCount;
+    std::atomic<DOMFrozenNodeList*>& bucket = fFrozenState->fLists[hashVal];
+
+    DOMFrozenNodeList* head = bucket.load(std::memory_order_acquire);
+    DOMFrozenNodeList* seen = 0;
+    DOMFrozenNodeList* newEntry = 0;
+    while (true)
+    {
+        // Look at the entries added since the last look
+        for (DOMFrozenNodeList* entry = head; entry != seen; entry = entry->fNext)
+        {
+            if (entry->fRootNode == rootNode && entry->fLevel2 == level2 &&
+                XMLString::equals(entry->fLocalName, localName) &&
+                XMLString::equals(entry->fNamespaceURI, namespaceURI))
+                return entry->fList;
+        }
+
+        if (!newEntry)
+        {
+            DOMDeepNodeListImpl* list = level2
+                ? new (this) DOMDeepNodeListImpl(rootNode, namespaceURI, localName)
+                : new (this) DOMDeepNodeListImpl(rootNode, localName);
+            list->freeze();
+
+            newEntry = (DOMFrozenNodeList*)allocateFrozen(sizeof(DOMFrozenNodeList));
+            newEntry->fRootNode = rootNode;
+            newEntry->fNamespaceURI = namespaceURI ? cloneString(namespaceURI) : 0;
+            newEntry->fLocalName = cloneString(localName);
+            newEntry->fLevel2 = level2;
+            newEntry->fList = list;
+        }
+
+        // Publish the list, unless another thread got there first
+        seen = head;
+        newEntry->fNext = head;
+        if (bucket.compare_exchange_strong(head, newEntry,
+                                           std::memory_order_acq_rel,
+                                           std::memory_order_acquire))
+            return newEntry->fList;
+    }
 }
 
 
 DOMNodeList *DOMDocumentImpl::getDeepNodeList(const DOMNode *rootNode, const XMLCh *tagName)
 {
+    if (fFrozenState)
+        return getFrozenDeepNodeList(rootNode, 0, tagName, false);
+
     if(!fNodeListPool) {
         fNodeListPool = new (this) DOMDeepNodeListPool<DOMDeepNodeListImpl>(109, false);
     }
@@ -956,6 +1339,9 @@ DOMNodeList *DOMDocumentImpl::getDeepNodeList(const DOMNode *rootNode,     //DOM
                                                    const XMLCh *namespaceURI,
                                                    const XMLCh *localName)
 {
+    if (fFrozenState)
+        return getFrozenDeepNodeList(rootNode, namespaceURI, localName, true);
+
     if(!fNodeListPool) {
         fNodeListPool = new (this) DOMDeepNodeListPool<DOMDeepNodeListImpl>(109, false);
     }
@@ -1074,6 +1460,9 @@ DOMNode* DOMDocumentImpl::adoptNode(DOMNode* sourceNode) {
 
 void DOMDocumentImpl::normalizeDocument() {
 
+    if (fFrozenState)
+        throw DOMException(DOMException::NO_MODIFICATION_ALLOWED_ERR, 0, fMemoryManager);
+
     if(!fNormalizer)
         fNormalizer = new (fMemoryManager) DOMNormalizer(fMemoryManager);
 
@@ -1087,6 +1476,53 @@ DOMConfiguration* DOMDocumentImpl::getDOMConfig() const {
     return fDOMConfiguration;
 }
 
+// Computes the values of the attributes in the subtree, so that the
+// complicated ones are in the string pool before it is frozen.
+static void poolAttributeValues(DOMNode* node)
+{
+    for (DOMNode* child = node->getFirstChild(); child != 0; child = child->getNextSibling())
+    {
+        DOMNamedNodeMap* attributes = child->getAttributes();
+        if (attributes)
+        {
+            for (XMLSize_t i = 0; i < attributes->getLength(); i++)
+                attributes->item(i)->getNodeValue();
+        }
+        poolAttributeValues(child);
+    }
+}
+
+void DOMDocumentImpl::freeze() {
+
+    if (fFrozenState)
+        return;
+
+    // Build the state that readers would otherwise create lazily
+    getDOMConfig();
+    poolAttributeValues(this);
+    if (fDocType)
+    {
+        DOMNamedNodeMap* entities = fDocType->getEntities();
+        for (XMLSize_t i = 0; i < entities->getLength(); i++)
+            poolAttributeValues(entities->item(i));
+    }
+
+    if (fNodeListPool)
+    {
+        for (XMLSize_t id = 1; id <= fNodeListPool->getIdCount(); id++)
+            fNodeListPool->getById(id)->freeze();
+    }
+
+    fNode.setReadOnly(true, true);
+
+    // From now on the heap, the string pool and the node list pool are only read
+    fFrozenState = new (fMemoryManager) DOMFrozenState();
+}
+
+bool DOMDocumentImpl::isFrozen() const {
+    return fFrozenState != 0;
+}
+
 DOMNode *DOMDocumentImpl::importNode(const DOMNode *source, bool deep, bool cloningDoc)
 {
     DOMNode *newnode=0;
@@ -1307,8 +1743,13 @@ DOMNode *DOMDocumentImpl::importNode(const DOMNode *source, bool deep, bool clon
 // user data utility
 void* DOMDocumentImpl::setUserData(DOMNodeImpl* n, const XMLCh* key, void* data, DOMUserDataHandler* handler)
 {
+    if (fFrozenState)
+        throw DOMException(DOMException::NO_MODIFICATION_ALLOWED_ERR, 0, fMemoryManager);
+
     void* oldData = 0;
-    unsigned int keyId=fUserDataTableKeys.addOrFind(key);
+    if (!fUserDataTableKeys)
+        fUserDataTableKeys = new (fMemoryManager) XMLStringPool(17, fMemoryManager);
+    unsigned int keyId=fUserDataTableKeys->addOrFind(key);
 
     if (!fUserDataTable) {
         // create the table on heap so that it can be cleaned in destructor
@@ -1347,7 +1788,7 @@ void* DOMDocumentImpl::setUserData(DOMNodeImpl* n, const XMLCh* key, void* data,
 void* DOMDocumentImpl::getUserData(const DOMNodeImpl* n, const XMLCh* key) const
 {
     if (fUserDataTable) {
-        unsigned int keyId=fUserDataTableKeys.getId(key);
+        unsigned int keyId=fUserDataTableKeys->getId(key);
         if(keyId!=0) {
             DOMUserDataRecord* dataRecord = fUserDataTable->get((void*)n, keyId);
             if (dataRecord)
@@ -1387,7 +1828,7 @@ void DOMDocumentImpl::callUserDataHandlers(const DOMNodeImpl* n, DOMUserDataHand
             if (handler) {
                 // get the data
                 void* data = userDataRecord->getKey();
-                const XMLCh* userKey = fUserDataTableKeys.getValueForId(key2);
+                const XMLCh* userKey = fUserDataTableKeys->getValueForId(key2);
                 handler->handle(operation, userKey, data, src, dst);
             }
         }
@@ -1415,8 +1856,11 @@ DOMNode* DOMDocumentImpl::renameNode(DOMNode* n, const XMLCh* namespaceURI, cons
 
     switch (n->getNodeType()) {
         case ELEMENT_NODE:
-            return ((DOMElementImpl*)n)->rename(namespaceURI, name);
         case ATTRIBUTE_NODE:
+            if (castToNodeImpl(n)->isReadOnly())
+                throw DOMException(DOMException::NO_MODIFICATION_ALLOWED_ERR, 0, getMemoryManager());
+            if (n->getNodeType() == ELEMENT_NODE)
+                return ((DOMElementImpl*)n)->rename(namespaceURI, name);
             return ((DOMAttrImpl*)n)->rename(namespaceURI, name);
         default:
             break;
@@ -1467,6 +1911,10 @@ void DOMDocumentImpl::releaseDocNotifyUserData(DOMNode* object)
 
 void DOMDocumentImpl::release(DOMNode* object, DOMMemoryManager::NodeObjectType type)
 {
+    // the heap of a frozen document doesn't change anymore
+    if (fFrozenState)
+        return;
+
     if (!fRecycleNodePtr)
         fRecycleNodePtr = new (fMemoryManager) RefArrayOf<DOMNodePtr> (15, fMemoryManager);
 
@@ -1474,10 +1922,17 @@ void DOMDocumentImpl::release(DOMNode* object, DOMMemoryManager::NodeObjectType
         fRecycleNodePtr->operator[](type) = new (fMemoryManager) RefStackOf<DOMNode> (15, false, fMemoryManager);
 
     fRecycleNodePtr->operator[](type)->push(object);
+
+    // a doctype may have been allocated by another document
+    if (fNodeCount[type])
+        fNodeCount[type]--;
 }
 
 void DOMDocumentImpl::releaseBuffer(DOMBuffer* buffer)
 {
+    if (fFrozenState)
+        return;
+
     if (!fRecycleBufferPtr)
         fRecycleBufferPtr = new (fMemoryManager) RefStackOf<DOMBuffer> (15, false, fMemoryManager);
 
@@ -1486,7 +1941,7 @@ void DOMDocumentImpl::releaseBuffer(DOMBuffer* buffer)
 
 DOMBuffer* DOMDocumentImpl::popBuffer(XMLSize_t nMinSize)
 {
-    if (!fRecycleBufferPtr || fRecycleBufferPtr->empty())
+    if (fFrozenState || !fRecycleBufferPtr || fRecycleBufferPtr->empty())
         return 0;
 
     for(XMLSize_t index=fRecycleBufferPtr->size()-1;index>0;index--)
@@ -1499,6 +1954,15 @@ DOMBuffer* DOMDocumentImpl::popBuffer(XMLSize_t nMinSize)
 
 void * DOMDocumentImpl::allocate(XMLSize_t amount, DOMMemoryManager::NodeObjectType type)
 {
+    // Nodes of a type may differ in size, the largest one is accounted for
+    amount = XMLPlatformUtils::alignPointerForNewBlockAllocation(amount);
+    if (fFrozenState)
+        return allocateFrozen(amount);
+
+    if (amount > fNodeSize[type])
+        fNodeSize[type] = amount;
+    fNodeCount[type]++;
+
     if (!fRecycleNodePtr)
         return allocate(amount);
 
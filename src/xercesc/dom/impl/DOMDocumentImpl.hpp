@@ -71,6 +71,7 @@ class DOMImplementation;
 class DOMNodeIDMap;
 class DOMRangeImpl;
 class DOMBuffer;
+class DOMFrozenState;
 class MemoryManager;
 class XPathNSResolver;
 class XPathExpression;
@@ -162,6 +163,7 @@ public:
 
     // Add all functions that are pure virtual in DOMMemoryManager
     virtual XMLSize_t getMemoryAllocationBlockSize() const;
+    virtual void getMemoryUsage(DOMMemoryManager::MemoryUsage& usage, bool walkTree = false) const;
     virtual void setMemoryAllocationBlockSize(XMLSize_t size);
     virtual void* allocate(XMLSize_t amount);
     virtual void* allocate(XMLSize_t amount, DOMMemoryManager::NodeObjectType type);
@@ -169,6 +171,15 @@ public:
     virtual void release(void* oldBuffer);
     virtual void release(DOMNode* object, DOMMemoryManager::NodeObjectType type);
     virtual XMLCh* cloneString(const XMLCh *src);
+    // Grows the block last returned by allocate() if the current heap block
+    //   has room after it, so that its content does not have to move
+    bool growInPlace(void* block, XMLSize_t oldAmount, XMLSize_t newAmount);
+    // Makes a block of the given size, taken from the memory manager of the
+    //   document, the block the next allocations are carved from
+    void adoptHeapBlock(void* block, XMLSize_t blockSize);
+    // Releases the document like release(), except for its largest heap
+    //   block, which is returned for adoptHeapBlock() on another document
+    void* releaseKeepingHeapBlock(XMLSize_t& blockSize);
 
     //
     // Functions to keep track of document mutations, so that node list chached
@@ -235,6 +246,10 @@ public:
     virtual void                 normalizeDocument();
     virtual DOMConfiguration*    getDOMConfig() const;
 
+    // Non-standard extension
+    virtual void                 freeze();
+    virtual bool                 isFrozen() const;
+
     void                         setInputEncoding(const XMLCh* actualEncoding);
     void                         setXmlEncoding(const XMLCh* encoding);
     // helper functions to prevent storing userdata pointers on every node.
@@ -269,6 +284,7 @@ public:
     //
     const XMLCh*                 getPooledString(const XMLCh*);
     const XMLCh*                 getPooledNString(const XMLCh*, XMLSize_t);
+    const XMLCh*                 addPooledString(const XMLCh*, XMLSize_t);
     void                         deleteHeap();
     void                         releaseDocNotifyUserData(DOMNode* object);
     void                         releaseBuffer(DOMBuffer* buffer);
@@ -295,6 +311,14 @@ private:
     DOMDocumentImpl(const DOMDocumentImpl &);
     DOMDocumentImpl & operator = (const DOMDocumentImpl &);
 
+    // Thread safe replacements used once the document is frozen
+    void*                        allocateFrozen(XMLSize_t amount);
+    const XMLCh*                 copyFrozenString(const XMLCh* in, XMLSize_t n);
+    DOMNodeList*                 getFrozenDeepNodeList(const DOMNode *rootNode,
+                                                       const XMLCh *namespaceURI,
+                                                       const XMLCh *localName,
+                                                       bool level2);
+
 protected:
     // -----------------------------------------------------------------------
     //  data
@@ -307,7 +331,7 @@ protected:
     const XMLCh*          fDocumentURI;
     DOMConfiguration*     fDOMConfiguration;
 
-    XMLStringPool         fUserDataTableKeys;
+    XMLStringPool*        fUserDataTableKeys;
     RefHash2KeysTableOf<DOMUserDataRecord, PtrHasher>* fUserDataTable;
 
 
@@ -331,7 +355,22 @@ protected:
     void*                 fCurrentSingletonBlock;
     char*                 fFreePtr;
     XMLSize_t             fFreeBytesRemaining,
-                          fHeapAllocSize;
+                          fHeapAllocSize,
+                          fCurrentBlockSize;
+
+    // Accounting of the heap for getMemoryUsage(): the blocks taken from
+    //   fMemoryManager, the bytes handed out of them, and the live nodes and
+    //   the size of a node of each type. The header of a singleton block
+    //   also records its size, so that releasing it can be accounted for.
+    XMLSize_t             fHeapBlockCount,
+                          fHeapBlockBytes,
+                          fHeapAllocatedBytes;
+    XMLSize_t             fNodeCount[DOMMemoryManager::NodeObjectType_Count];
+    XMLSize_t             fNodeSize[DOMMemoryManager::NodeObjectType_Count];
+
+    // Once frozen, tracks the memory allocated and the node lists created
+    //   while several threads may read the document. Zero until freeze().
+    DOMFrozenState*       fFrozenState;
 
     // To recycle the DOMNode pointer
     RefArrayOf<DOMNodePtr>* fRecycleNodePtr;
@@ -346,8 +385,11 @@ protected:
     DOMDocumentType*      fDocType;
     DOMElement*           fDocElement;
 
+    // The buckets of the pooled strings, created with the first string and
+    //   made larger as the pool fills up
     DOMStringPoolEntry**  fNameTable;
-    XMLSize_t             fNameTableSize;
+    XMLSize_t             fNameTableSize,
+                          fNameTableCount;
 
     DOMNormalizer*        fNormalizer;
     Ranges*               fRanges;
@@ -371,32 +413,23 @@ inline const XMLCh*  DOMDocumentImpl::getPooledString(const XMLCh *in)
     return 0;
   XMLSize_t n = XMLString::stringLen(in);
 
-  DOMStringPoolEntry    **pspe;
-  DOMStringPoolEntry    *spe;
-
-  XMLSize_t inHash = XMLString::hash(in, fNameTableSize);
-  pspe = &fNameTable[inHash];
-  while (*pspe != 0)
+  if (fNameTable != 0)
   {
-    if ((*pspe)->fLength == n && XMLString::equals((*pspe)->fString, in))
-      return (*pspe)->fString;
-    pspe = &((*pspe)->fNext);
+    const DOMStringPoolEntry* spe = fNameTable[XMLString::hash(in, fNameTableSize)];
+    while (spe != 0)
+    {
+      if (spe->fLength == n && XMLString::equals(spe->fString, in))
+        return spe->fString;
+      spe = spe->fNext;
+    }
   }
 
-  // This string hasn't been seen before.  Add it to the pool.
-  //
-
-  // Compute size to allocate.  Note that there's 1 char of string
-  // declared in the struct, so we don't need to add one again to
-  // account for the trailing null.
+  // This string hasn't been seen before.  Add it to the pool, unless
+  // other threads may be reading the pool.
   //
-  XMLSize_t sizeToAllocate = sizeof(DOMStringPoolEntry) + n*sizeof(XMLCh);
-  *pspe = spe = (DOMStringPoolEntry *)allocate(sizeToAllocate);
-  spe->fLength = n;
-  spe->fNext = 0;
-  XMLString::copyString((XMLCh*)spe->fString, in);
-
-  return spe->fString;
+  if (fFrozenState)
+    return copyFrozenString(in, n);
+  return addPooledString(in, n);
 }
 
 inline const XMLCh* DOMDocumentImpl::getPooledNString(const XMLCh *in, XMLSize_t n)
@@ -404,32 +437,25 @@ inline const XMLCh* DOMDocumentImpl::getPooledNString(const XMLCh *in, XMLSize_t
   if (in == 0)
     return 0;
 
-  DOMStringPoolEntry    **pspe;
-  DOMStringPoolEntry    *spe;
-
-  XMLSize_t inHash = XMLString::hashN(in, n, fNameTableSize);
-  pspe = &fNameTable[inHash];
-  while (*pspe != 0)
+  if (fNameTable != 0)
   {
-    if ((*pspe)->fLength == n && XMLString::equalsN((*pspe)->fString, in, n))
-      return (*pspe)->fString;
-    pspe = &((*pspe)->fNext);
+    // hashN() looks at one character more than it is asked to, so this
+    //   hashes the same characters as hash() does in getPooledString()
+    const DOMStringPoolEntry* spe = fNameTable[n ? XMLString::hashN(in, n - 1, fNameTableSize) : 0];
+    while (spe != 0)
+    {
+      if (spe->fLength == n && XMLString::equalsN(spe->fString, in, n))
+        return spe->fString;
+      spe = spe->fNext;
+    }
   }
 
-  // This string hasn't been seen before.  Add it to the pool.
+  // This string hasn't been seen before.  Add it to the pool, unless
+  // other threads may be reading the pool.
   //
-
-  // Compute size to allocate.  Note that there's 1 char of string
-  // declared in the struct, so we don't need to add one again to
-  // account for the trailing null.
-  //
-  XMLSize_t sizeToAllocate = sizeof(DOMStringPoolEntry) + n*sizeof(XMLCh);
-  *pspe = spe = (DOMStringPoolEntry *)allocate(sizeToAllocate);
-  spe->fLength = n;
-  spe->fNext = 0;
-  XMLString::copyNString((XMLCh*)spe->fString, in, n);
-
-  return spe->fString;
+  if (fFrozenState)
+    return copyFrozenString(in, n);
+  return addPooledString(in, n);
 }
 
 inline int DOMDocumentImpl::indexofQualifiedName(const XMLCh* name)
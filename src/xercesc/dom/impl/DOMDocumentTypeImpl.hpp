@@ -70,6 +70,8 @@ protected:
 
     friend class AbstractDOMParser;
     friend class DOMDocumentImpl;
+    friend class DOMSnapshotReader;
+    friend class DOMDocumentCursorBase;
 
 public:
     DOMDocumentTypeImpl(DOMDocument *, const XMLCh *, bool);
@@ -64,6 +64,7 @@ protected:
     void	cloneEntityRefTree() const;
 
     friend class XercesDOMParser;
+    friend class DOMDocumentCursorBase;
 
 public:
     DOMEntityImpl(DOMDocument *doc, const XMLCh *eName);
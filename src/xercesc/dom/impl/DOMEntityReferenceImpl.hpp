@@ -53,6 +53,7 @@ protected:
     const XMLCh    *fBaseURI;
 
     friend class XercesDOMParser;
+    friend class DOMDocumentCursorBase;
 
 public:
     DOMEntityReferenceImpl(DOMDocument *ownerDoc, const XMLCh *entityName);
@@ -19,6 +19,10 @@
  * $Id$
  */
 
+#if HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
 #include "DOMLSSerializerImpl.hpp"
 #include "DOMLSOutputImpl.hpp"
 #include "DOMErrorImpl.hpp"
@@ -38,6 +42,13 @@
 #include <xercesc/dom/StDOMNode.hpp>
 #include <xercesc/util/OutOfMemoryException.hpp>
 #include <xercesc/util/XMLChar.hpp>
+#include <xercesc/util/ValueVectorOf.hpp>
+#include <xercesc/util/RefHashTableOf.hpp>
+
+#if XERCES_USE_MUTEXMGR_STD
+#	include <system_error>
+#	include <thread>
+#endif
 
 namespace XERCES_CPP_NAMESPACE {
 
@@ -59,6 +70,7 @@ static const int WHITESPACE_IN_ELEMENT_CONTENT_ID = 0x7;
 static const int BYTE_ORDER_MARK_ID               = 0x8;
 static const int XML_DECLARATION                  = 0x9;
 static const int FORMAT_PRETTY_PRINT_1ST_LEVEL_ID = 0xA;
+static const int PARALLEL_SERIALIZATION_ID        = 0xB;
 
 //    feature                      true                       false
 // ================================================================================
@@ -88,7 +100,8 @@ static const bool  featuresSupported[] = {
     true,  false, // whitespace-in-element-content
     true,  true,  // http://apache.org/xml/features/dom/byte-order-mark
     true,  true,  // xml-declaration
-    true,  true   // http://apache.org/xml/features/pretty-print/space-first-level-elements
+    true,  true,  // http://apache.org/xml/features/pretty-print/space-first-level-elements
+    true,  true   // http://apache.org/xml/features/dom/parallel-serialization
 };
 
 // default end-of-line sequence
@@ -255,6 +268,7 @@ DOMLSSerializerImpl::~DOMLSSerializerImpl()
     fMemoryManager->deallocate(fNewLine);//delete [] fNewLine;
     delete fNamespaceStack;
     delete fSupportedParameters;
+    fMemoryManager->deallocate(fOutBuffer);
     // we don't own/adopt error handler and filter
 }
 
@@ -273,6 +287,11 @@ DOMLSSerializerImpl::DOMLSSerializerImpl(MemoryManager* const manager)
 ,fLineFeedInTextNodePrinted(false)
 ,fLastWhiteSpaceInTextNode(0)
 ,fIsXml11(false)
+,fTarget(0)
+,fOutBuffer(0)
+,fOutLength(0)
+,fChunkWriter(false)
+,fThreadCount(0)
 ,fNamespaceStack(0)
 ,fMemoryManager(manager)
 {
@@ -292,8 +311,9 @@ DOMLSSerializerImpl::DOMLSSerializerImpl(MemoryManager* const manager)
     setFeature(BYTE_ORDER_MARK_ID,               false);
     setFeature(XML_DECLARATION,                  true );
     setFeature(FORMAT_PRETTY_PRINT_1ST_LEVEL_ID, true );
+    setFeature(PARALLEL_SERIALIZATION_ID,        false);
 
-    fSupportedParameters=new (fMemoryManager) DOMStringListImpl(12, fMemoryManager);
+    fSupportedParameters=new (fMemoryManager) DOMStringListImpl(14, fMemoryManager);
     fSupportedParameters->add(XMLUni::fgDOMErrorHandler);
     fSupportedParameters->add(XMLUni::fgDOMWRTCanonicalForm);
     fSupportedParameters->add(XMLUni::fgDOMWRTDiscardDefaultContent);
@@ -306,6 +326,8 @@ DOMLSSerializerImpl::DOMLSSerializerImpl(MemoryManager* const manager)
     fSupportedParameters->add(XMLUni::fgDOMWRTBOM);
     fSupportedParameters->add(XMLUni::fgDOMXMLDeclaration);
     fSupportedParameters->add(XMLUni::fgDOMWRTXercesPrettyPrint);
+    fSupportedParameters->add(XMLUni::fgDOMWRTXercesParallelSerialization);
+    fSupportedParameters->add(XMLUni::fgDOMWRTXercesParallelThreads);
 }
 
 bool DOMLSSerializerImpl::canSetParameter(const XMLCh* featName
@@ -313,6 +335,8 @@ bool DOMLSSerializerImpl::canSetParameter(const XMLCh* featName
 {
     if(XMLString::compareIStringASCII(featName, XMLUni::fgDOMErrorHandler)==0)
         return true;
+    if(XMLString::compareIStringASCII(featName, XMLUni::fgDOMWRTXercesParallelThreads)==0)
+        return true;
     return false;
 }
 
@@ -328,6 +352,8 @@ void DOMLSSerializerImpl::setParameter(const XMLCh* featName
 {
     if(XMLString::compareIStringASCII(featName, XMLUni::fgDOMErrorHandler)==0)
         fErrorHandler = (DOMErrorHandler*)value;
+    else if(XMLString::compareIStringASCII(featName, XMLUni::fgDOMWRTXercesParallelThreads)==0)
+        fThreadCount = value ? *(const XMLSize_t*)value : 0;
     else
         throw DOMException(DOMException::NOT_SUPPORTED_ERR, 0, fMemoryManager);
 }
@@ -365,6 +391,10 @@ const void* DOMLSSerializerImpl::getParameter(const XMLCh* featName) const
     {
         return (void*)fErrorHandler;
     }
+    else if(XMLString::compareIStringASCII(featName, XMLUni::fgDOMWRTXercesParallelThreads)==0)
+    {
+        return (void*)&fThreadCount;
+    }
     else
     {
         int featureId = INVALID_FEATURE_ID;
@@ -504,10 +534,26 @@ bool DOMLSSerializerImpl::write(const DOMNode* nodeToWrite,
         return false;
     }
 
+    //
+    // Plain UTF-8 output, which is neither filtered nor pretty-printed, is
+    // encoded straight into the output buffer by processTree(). Anything it
+    // does not handle itself is still written by processNode().
+    //
+    const bool streamOut = !fFilter && !getFeature(FORMAT_PRETTY_PRINT_ID) &&
+                           ((XMLString::compareIStringASCII(fEncodingUsed, XMLUni::fgUTF8EncodingString)  == 0) ||
+                            (XMLString::compareIStringASCII(fEncodingUsed, XMLUni::fgUTF8EncodingString2) == 0)  );
+
     try
     {
         Janitor<XMLFormatter> janName(fFormatter);
-        processNode(nodeToWrite);
+        if (streamOut)
+        {
+            fTarget = pTarget;
+            fOutLength = 0;
+            processTree(nodeToWrite);
+        }
+        else
+            processNode(nodeToWrite);
         pTarget->flush();
     }
 
@@ -1372,6 +1418,8 @@ bool DOMLSSerializerImpl::checkFeature(const XMLCh* const featName
         featureId = XML_DECLARATION;
     else if (XMLString::equals(featName, XMLUni::fgDOMWRTXercesPrettyPrint))
         featureId = FORMAT_PRETTY_PRINT_1ST_LEVEL_ID;
+    else if (XMLString::equals(featName, XMLUni::fgDOMWRTXercesParallelSerialization))
+        featureId = PARALLEL_SERIALIZATION_ID;
 
 
     //feature name not resolvable
@@ -1764,4 +1812,727 @@ void DOMLSSerializerImpl::ensureValidString(const DOMNode* nodeToWrite, const XM
     }
 }
 
+// ---------------------------------------------------------------------------
+//  Streaming path for UTF-8 output
+//
+//  processTree() walks the tree without recursion and encodes the nodes into
+//  fOutBuffer itself, rather than going through the formatter for every
+//  string. The output is the same as the one of processNode() with neither
+//  filter nor pretty-printing, which is still used for the node types and
+//  cases handled here only by deferring to it.
+//
+//  With parallel serialization the children of an element are split into
+//  runs, each written by a serializer of its own, a chunk writer, into a
+//  memory buffer on a thread of its own. The buffers are then handed to the
+//  target in document order. A chunk writer starts from the namespace
+//  bindings in scope at the element, so it declares the same namespaces as
+//  processTree() would. Runs which can't be written that way are written
+//  again here, so the output is the same as the sequential one.
+// ---------------------------------------------------------------------------
+namespace {
+
+// thrown by a chunk writer which gives up on its run
+class ChunkAbort
+{
+};
+
+// a run of children and the serializer writing it
+class ChunkWriter : public XMemory
+{
+public:
+    ChunkWriter(MemoryManager* const manager)
+    : fWriter(0)
+    , fTarget(1023, manager)
+    , fFirst(0)
+    , fEnd(0)
+    , fCount(0)
+    {
+    }
+
+    ~ChunkWriter()
+    {
+#if XERCES_USE_MUTEXMGR_STD
+        // never leave a running thread behind, even when unwinding
+        if (fThread.joinable())
+            fThread.join();
+#endif
+        delete fWriter;
+    }
+
+    DOMLSSerializerImpl*    fWriter;
+    MemBufFormatTarget      fTarget;
+    const DOMNode*          fFirst;
+    const DOMNode*          fEnd;
+    XMLSize_t               fCount;
+#if XERCES_USE_MUTEXMGR_STD
+    std::thread             fThread;
+#endif
+
+private:
+    ChunkWriter(const ChunkWriter&);
+    ChunkWriter& operator=(const ChunkWriter&);
+};
+
+// turns every error and warning into a failure of the run
+class ChunkErrorHandler : public DOMErrorHandler
+{
+public:
+    ChunkErrorHandler()
+    {
+    }
+
+    virtual bool handleError(const DOMError&)
+    {
+        return false;
+    }
+};
+
+ChunkErrorHandler gChunkErrorHandler;
+
+}
+
+void DOMLSSerializerImpl::processTree(const DOMNode* const nodeToWrite)
+{
+    if (!fOutBuffer)
+        fOutBuffer = (XMLByte*) fMemoryManager->allocate(kOutBufferSize * sizeof(XMLByte));
+
+    // the features can't change while writing
+    const bool discardDefaults = getFeature(DISCARD_DEFAULT_CONTENT_ID);
+    const bool keepEntities    = getFeature(ENTITIES_ID);
+    const bool splitCdata      = getFeature(SPLIT_CDATA_SECTIONS_ID);
+
+    // the children of the topmost element with more than one child are
+    // written in parallel, if asked for
+    bool splitPending = getFeature(PARALLEL_SERIALIZATION_ID);
+
+    // for each open element, whether it pushed a namespace map
+    ValueVectorOf<bool> openElements(16, fMemoryManager);
+    int level = 0;
+
+    try
+    {
+        const DOMNode* node = nodeToWrite;
+        while (true)
+        {
+            const DOMNode* child = 0;
+            const XMLCh*   nodeValue = node->getNodeValue();
+
+            switch (node->getNodeType())
+            {
+            case DOMNode::ELEMENT_NODE:
+                {
+                    const bool pushedMap = writeStartTag(node, discardDefaults, keepEntities);
+                    child = node->getFirstChild();
+
+                    bool split = false;
+                    if (splitPending)
+                    {
+                        splitPending = child && !child->getNextSibling() &&
+                                       child->getNodeType() == DOMNode::ELEMENT_NODE;
+                        split = child && !splitPending;
+                    }
+
+                    if (child)
+                    {
+                        writeOut(chCloseAngle);
+                        if (split && processChildrenInParallel(node))
+                        {
+                            writeOut(gEndElement);
+                            writeOut(node->getNodeName());
+                            writeOut(chCloseAngle);
+                            if (pushedMap)
+                                fNamespaceStack->removeLastElement();
+                            child = 0;
+                            break;
+                        }
+                        openElements.addElement(pushedMap);
+                        level++;
+                    }
+                    else
+                    {
+                        writeOut(chForwardSlash);
+                        writeOut(chCloseAngle);
+                        if (pushedMap)
+                            fNamespaceStack->removeLastElement();
+                    }
+                    break;
+                }
+
+            case DOMNode::TEXT_NODE:
+                writeOut(nodeValue, XMLFormatter::CharEscapes, node);
+                break;
+
+            case DOMNode::CDATA_SECTION_NODE:
+                // nested ']]>' are split or reported by processNode()
+                if (XMLString::patternMatch(nodeValue, gEndCDATA) != -1)
+                {
+                    delegateNode(node, level);
+                    break;
+                }
+                if (!splitCdata)
+                    ensureValidString(node, nodeValue);
+                writeOut(gStartCDATA);
+                writeOut(nodeValue);
+                writeOut(gEndCDATA);
+                break;
+
+            case DOMNode::COMMENT_NODE:
+                ensureValidString(node, nodeValue);
+                writeOut(gStartComment);
+                writeOut(nodeValue);
+                writeOut(gEndComment);
+                break;
+
+            case DOMNode::PROCESSING_INSTRUCTION_NODE:
+                ensureValidString(node, node->getNodeName());
+                ensureValidString(node, nodeValue);
+                writeOut(gStartPI);
+                writeOut(node->getNodeName());
+                if (nodeValue && *nodeValue)
+                {
+                    writeOut(chSpace);
+                    writeOut(nodeValue);
+                }
+                writeOut(gEndPI);
+                break;
+
+            case DOMNode::ENTITY_REFERENCE_NODE:
+                if (keepEntities)
+                {
+                    writeOut(chAmpersand);
+                    writeOut(node->getNodeName());
+                    writeOut(chSemiColon);
+                }
+                else
+                    delegateNode(node, level);
+                break;
+
+            case DOMNode::DOCUMENT_NODE:
+                flushOut();
+                processBOM();
+                if (getFeature(XML_DECLARATION))
+                {
+                    writeOut(gXMLDecl_VersionInfo);
+                    writeOut(fDocumentVersion);
+                    writeOut(gXMLDecl_separator);
+                    writeOut(gXMLDecl_EncodingDecl);
+                    writeOut(fEncodingUsed);
+                    writeOut(gXMLDecl_separator);
+                    writeOut(gXMLDecl_SDDecl);
+                    writeOut(((const DOMDocument*)node)->getXmlStandalone() ? XMLUni::fgYesString : XMLUni::fgNoString);
+                    writeOut(gXMLDecl_separator);
+                    writeOut(gXMLDecl_endtag);
+                }
+                child = node->getFirstChild();
+                break;
+
+            case DOMNode::DOCUMENT_FRAGMENT_NODE:
+                child = node->getFirstChild();
+                break;
+
+            default:
+                delegateNode(node, level);
+                break;
+            }
+
+            if (child)
+            {
+                node = child;
+                continue;
+            }
+
+            // move on to the next sibling, closing the elements left behind
+            while (node != nodeToWrite)
+            {
+                const DOMNode* next = node->getNextSibling();
+                if (next)
+                {
+                    node = next;
+                    break;
+                }
+
+                node = node->getParentNode();
+                if (node->getNodeType() == DOMNode::ELEMENT_NODE)
+                {
+                    writeOut(gEndElement);
+                    writeOut(node->getNodeName());
+                    writeOut(chCloseAngle);
+
+                    level--;
+                    const XMLSize_t last = openElements.size() - 1;
+                    if (openElements.elementAt(last))
+                        fNamespaceStack->removeLastElement();
+                    openElements.removeElementAt(last);
+                }
+            }
+
+            if (node == nodeToWrite)
+                break;
+        }
+    }
+    catch(const OutOfMemoryException&)
+    {
+        throw;
+    }
+    catch(...)
+    {
+        // hand over what was written before the failure, like processNode()
+        flushOut();
+        throw;
+    }
+
+    flushOut();
+}
+
+bool DOMLSSerializerImpl::writeStartTag(const DOMNode* const nodeToWrite
+                                       , bool                 discardDefaults
+                                       , bool                 keepEntities)
+{
+    // same namespace fixup as in processNode()
+    RefHashTableOf<XMLCh>* namespaceMap=NULL;
+
+    writeOut(chOpenAngle);
+    writeOut(nodeToWrite->getNodeName());
+
+    const XMLCh* prefix = nodeToWrite->getPrefix();
+    const XMLCh* uri = nodeToWrite->getNamespaceURI();
+    if((uri && uri[0]) || ((prefix==0 || prefix[0]==0) && isDefaultNamespacePrefixDeclared()))
+    {
+        if(prefix==0 || prefix[0]==0)
+            prefix=XMLUni::fgZeroLenString;
+        if(!isNamespaceBindingActive(prefix, uri))
+        {
+            namespaceMap=new (fMemoryManager) RefHashTableOf<XMLCh>(12, false, fMemoryManager);
+            fNamespaceStack->addElement(namespaceMap);
+            namespaceMap->put((void*)prefix,(XMLCh*)uri);
+            writeOut(chSpace);
+            writeOut(XMLUni::fgXMLNSString);
+            if(!XMLString::equals(prefix,XMLUni::fgZeroLenString))
+            {
+                writeOut(chColon);
+                writeOut(prefix);
+            }
+            writeOut(chEqual);
+            writeOut(chDoubleQuote);
+            writeOut(uri, XMLFormatter::AttrEscapes);
+            writeOut(chDoubleQuote);
+        }
+    }
+
+    DOMNamedNodeMap *attributes = nodeToWrite->getAttributes();
+    XMLSize_t attrCount = attributes->getLength();
+    for (XMLSize_t i = 0; i < attrCount; i++)
+    {
+        const DOMAttr* attribute = (const DOMAttr*)attributes->item(i);
+        if (discardDefaults && !attribute->getSpecified())
+            continue;
+
+        const XMLCh* ns = attribute->getNamespaceURI();
+        if (ns != 0 )
+        {
+            if(XMLString::equals(ns, XMLUni::fgXMLNSURIName))
+            {
+                if(namespaceMap==NULL)
+                {
+                    namespaceMap=new (fMemoryManager) RefHashTableOf<XMLCh>(12, false, fMemoryManager);
+                    fNamespaceStack->addElement(namespaceMap);
+                }
+                const XMLCh* nsPrefix = attribute->getLocalName();
+                if(XMLString::equals(attribute->getNodeName(),XMLUni::fgXMLNSString))
+                    nsPrefix = XMLUni::fgZeroLenString;
+                if(namespaceMap->containsKey((void*)nsPrefix))
+                    continue;
+                namespaceMap->put((void*)attribute->getLocalName(),(XMLCh*)attribute->getNodeValue());
+            }
+            else if(!XMLString::equals(ns, XMLUni::fgXMLURIName))
+            {
+                const XMLCh* attrPrefix = attribute->getPrefix();
+                if(attrPrefix && attrPrefix[0] && !isNamespaceBindingActive(attrPrefix, ns))
+                {
+                    if(namespaceMap==NULL)
+                    {
+                        namespaceMap=new (fMemoryManager) RefHashTableOf<XMLCh>(12, false, fMemoryManager);
+                        fNamespaceStack->addElement(namespaceMap);
+                    }
+                    namespaceMap->put((void*)attrPrefix,(XMLCh*)ns);
+                    writeOut(chSpace);
+                    writeOut(XMLUni::fgXMLNSString);
+                    writeOut(chColon);
+                    writeOut(attrPrefix);
+                    writeOut(chEqual);
+                    writeOut(chDoubleQuote);
+                    writeOut(ns, XMLFormatter::AttrEscapes);
+                    writeOut(chDoubleQuote);
+                }
+            }
+        }
+
+        writeOut(chSpace);
+        writeOut(attribute->getNodeName());
+        writeOut(chEqual);
+        writeOut(chDoubleQuote);
+        if (keepEntities)
+        {
+            for (const DOMNode* child = attribute->getFirstChild(); child != 0; child = child->getNextSibling())
+            {
+                if(child->getNodeType()==DOMNode::TEXT_NODE)
+                    writeOut(child->getNodeValue(), XMLFormatter::AttrEscapes, attribute);
+                else if(child->getNodeType()==DOMNode::ENTITY_REFERENCE_NODE)
+                {
+                    writeOut(chAmpersand);
+                    writeOut(child->getNodeName());
+                    writeOut(chSemiColon);
+                }
+            }
+        }
+        else
+        {
+            // the value of an attribute with several children is built in
+            // the string pool of the document, which is not thread-safe
+            const DOMNode* child = attribute->getFirstChild();
+            if (fChunkWriter && child &&
+                (child->getNextSibling() || child->getNodeType() != DOMNode::TEXT_NODE))
+                throw ChunkAbort();
+            writeOut(attribute->getNodeValue(), XMLFormatter::AttrEscapes, attribute);
+        }
+        writeOut(chDoubleQuote);
+    }
+
+    return namespaceMap!=NULL;
+}
+
+void DOMLSSerializerImpl::writeOut(const XMLCh* const              toWrite
+                                  , const XMLFormatter::EscapeFlags escapes
+                                  , const DOMNode* const            nodeToCheck)
+{
+    if (!toWrite)
+        return;
+
+    // nothing of an invalid string is written, so remember where it starts
+    const DOMNode* checkFor = nodeToCheck;
+    const XMLSize_t start = fOutLength;
+
+    for (const XMLCh* cur = toWrite; *cur; cur++)
+    {
+        if (fOutLength + kOutCharMaxBytes > kOutBufferSize)
+        {
+            // check the rest of the string before handing over a part of it
+            if (checkFor)
+            {
+                const XMLSize_t length = fOutLength;
+                fOutLength = start;
+                ensureValidString(checkFor, cur);
+                fOutLength = length;
+                checkFor = 0;
+            }
+            flushOut();
+        }
+
+        XMLUInt32 ch = *cur;
+
+        // printable ASCII which never needs escaping, by far the common case
+        if (ch >= chSpace && ch < 0x7F &&
+            (escapes == XMLFormatter::NoEscapes ||
+             (ch != chAmpersand && ch != chOpenAngle && ch != chCloseAngle && ch != chDoubleQuote)))
+        {
+            fOutBuffer[fOutLength++] = (XMLByte)ch;
+            continue;
+        }
+
+        // same check as ensureValidString(), which reports the error
+        if (checkFor && (ch < chSpace || ch >= 0xD800))
+        {
+            bool valid;
+            if ((ch >= 0xD800) && (ch <= 0xDBFF))
+                valid = (cur[1] != 0) && (fIsXml11 ? XMLChar1_1::isXMLChar((XMLCh)ch, cur[1])
+                                                   : XMLChar1_0::isXMLChar((XMLCh)ch, cur[1]));
+            else
+                valid = fIsXml11 ? XMLChar1_1::isXMLChar((XMLCh)ch) : XMLChar1_0::isXMLChar((XMLCh)ch);
+
+            if (!valid)
+            {
+                fOutLength = start;
+                ensureValidString(checkFor, toWrite);
+            }
+        }
+
+        // the escapes of XMLFormatter::CharEscapes and AttrEscapes
+        if (escapes != XMLFormatter::NoEscapes)
+        {
+            const char* ref = 0;
+            bool charRef = false;
+            switch (ch)
+            {
+            case chAmpersand:
+                ref = "&amp;";
+                break;
+            case chOpenAngle:
+                ref = "&lt;";
+                break;
+            case chCloseAngle:
+                if (escapes == XMLFormatter::CharEscapes)
+                    ref = "&gt;";
+                break;
+            case chDoubleQuote:
+                if (escapes == XMLFormatter::AttrEscapes)
+                    ref = "&quot;";
+                break;
+            case chCR:
+                charRef = true;
+                break;
+            case chLF:
+            case chHTab:
+                charRef = (escapes == XMLFormatter::AttrEscapes);
+                break;
+            default:
+                break;
+            }
+
+            if (!ref && !charRef && fIsXml11)
+                charRef = XMLChar1_1::isControlChar((XMLCh)ch) && !XMLChar1_1::isWhitespace((XMLCh)ch);
+
+            if (ref)
+            {
+                while (*ref)
+                    fOutBuffer[fOutLength++] = (XMLByte)*ref++;
+                continue;
+            }
+            if (charRef)
+            {
+                writeOutCharRef(ch);
+                continue;
+            }
+        }
+
+        if (ch < 0x80)
+        {
+            fOutBuffer[fOutLength++] = (XMLByte)ch;
+        }
+        else if (ch < 0x800)
+        {
+            fOutBuffer[fOutLength++] = (XMLByte)(0xC0 | (ch >> 6));
+            fOutBuffer[fOutLength++] = (XMLByte)(0x80 | (ch & 0x3F));
+        }
+        else if ((ch >= 0xD800) && (ch <= 0xDBFF) && cur[1])
+        {
+            ch = ((ch - 0xD800) << 10) + ((*++cur - 0xDC00) + 0x10000);
+            fOutBuffer[fOutLength++] = (XMLByte)(0xF0 | (ch >> 18));
+            fOutBuffer[fOutLength++] = (XMLByte)(0x80 | ((ch >> 12) & 0x3F));
+            fOutBuffer[fOutLength++] = (XMLByte)(0x80 | ((ch >> 6) & 0x3F));
+            fOutBuffer[fOutLength++] = (XMLByte)(0x80 | (ch & 0x3F));
+        }
+        else
+        {
+            fOutBuffer[fOutLength++] = (XMLByte)(0xE0 | (ch >> 12));
+            fOutBuffer[fOutLength++] = (XMLByte)(0x80 | ((ch >> 6) & 0x3F));
+            fOutBuffer[fOutLength++] = (XMLByte)(0x80 | (ch & 0x3F));
+        }
+    }
+}
+
+void DOMLSSerializerImpl::writeOutCharRef(XMLUInt32 toWrite)
+{
+    static const char digitList[16] =
+    {
+          '0', '1', '2', '3', '4', '5', '6', '7', '8', '9'
+        , 'A', 'B', 'C', 'D', 'E', 'F'
+    };
+
+    XMLByte digits[8];
+    unsigned int count = 0;
+    do
+    {
+        digits[count++] = digitList[toWrite & 0xF];
+        toWrite >>= 4;
+    } while (toWrite);
+
+    fOutBuffer[fOutLength++] = chAmpersand;
+    fOutBuffer[fOutLength++] = chPound;
+    fOutBuffer[fOutLength++] = chLatin_x;
+    while (count)
+        fOutBuffer[fOutLength++] = digits[--count];
+    fOutBuffer[fOutLength++] = chSemiColon;
+}
+
+void DOMLSSerializerImpl::flushOut()
+{
+    if (fOutLength)
+    {
+        fTarget->writeChars(fOutBuffer, fOutLength, fFormatter);
+        fOutLength = 0;
+    }
+}
+
+void DOMLSSerializerImpl::delegateNode(const DOMNode* const nodeToWrite, int level)
+{
+    // processNode() is not safe to call from a chunk writer
+    if (fChunkWriter)
+        throw ChunkAbort();
+
+    flushOut();
+    processNode(nodeToWrite, level);
+}
+
+bool DOMLSSerializerImpl::processChildrenInParallel(const DOMNode* const parent)
+{
+#if XERCES_USE_MUTEXMGR_STD
+    XMLSize_t childCount = 0;
+    for (const DOMNode* child = parent->getFirstChild(); child != 0; child = child->getNextSibling())
+        childCount++;
+
+    XMLSize_t writerCount = fThreadCount ? fThreadCount : std::thread::hardware_concurrency();
+    if (writerCount > childCount)
+        writerCount = childCount;
+    if (writerCount < 2)
+        return false;
+
+    // A round of runs is held in memory before it is written. The first
+    // runs are short, the following ones are sized from the output of the
+    // previous rounds so that a run stays around kChunkBytes.
+    const XMLSize_t maxRunLength = (childCount + writerCount - 1) / writerCount;
+    XMLSize_t runLength = 16;
+    XMLSize_t childrenWritten = 0;
+    XMLSize_t bytesWritten = 0;
+
+    // the namespace bindings in scope, as found by isNamespaceBindingActive()
+    RefHashTableOf<XMLCh> bindings(29, false, fMemoryManager);
+    for (XMLSize_t i = fNamespaceStack->size(); i > 0; i--)
+    {
+        RefHashTableOf<XMLCh>* curNamespaceMap = fNamespaceStack->elementAt(i - 1);
+        RefHashTableOfEnumerator<XMLCh> enumMap(curNamespaceMap, false, fMemoryManager);
+        while (enumMap.hasMoreElements())
+        {
+            void* prefix = enumMap.nextElementKey();
+            XMLCh* uri = curNamespaceMap->get(prefix);
+            if (uri && !bindings.get(prefix))
+                bindings.put(prefix, uri);
+        }
+    }
+
+    RefVectorOf<ChunkWriter> writers(writerCount, true, fMemoryManager);
+    for (XMLSize_t i = 0; i < writerCount; i++)
+    {
+        ChunkWriter* writer = new (fMemoryManager) ChunkWriter(fMemoryManager);
+        writers.addElement(writer);
+
+        DOMLSSerializerImpl* impl = new (fMemoryManager) DOMLSSerializerImpl(fMemoryManager);
+        writer->fWriter = impl;
+        impl->fFeatures = fFeatures & ~(1 << PARALLEL_SERIALIZATION_ID);
+        impl->fErrorHandler = &gChunkErrorHandler;
+        impl->fDocumentVersion = fDocumentVersion;
+        impl->fEncodingUsed = fEncodingUsed;
+        impl->fNewLineUsed = fNewLineUsed;
+        impl->fIsXml11 = fIsXml11;
+        impl->fTarget = &writer->fTarget;
+        impl->fChunkWriter = true;
+
+        if (!bindings.isEmpty())
+        {
+            RefHashTableOf<XMLCh>* namespaceMap = new (fMemoryManager) RefHashTableOf<XMLCh>(29, false, fMemoryManager);
+            impl->fNamespaceStack->addElement(namespaceMap);
+
+            RefHashTableOfEnumerator<XMLCh> enumMap(&bindings, false, fMemoryManager);
+            while (enumMap.hasMoreElements())
+            {
+                void* prefix = enumMap.nextElementKey();
+                namespaceMap->put(prefix, bindings.get(prefix));
+            }
+        }
+    }
+
+    flushOut();
+
+    const DOMNode* next = parent->getFirstChild();
+    while (next)
+    {
+        if (childrenWritten)
+        {
+            const XMLSize_t childBytes = bytesWritten / childrenWritten + 1;
+            runLength = kChunkBytes / childBytes;
+            if (runLength > kChunkChildren)
+                runLength = kChunkChildren;
+        }
+        if (runLength > maxRunLength)
+            runLength = maxRunLength;
+        if (runLength == 0)
+            runLength = 1;
+
+        // hand out a round of runs, the first one is written by this thread
+        XMLSize_t used = 0;
+        for (; used < writerCount && next; used++)
+        {
+            ChunkWriter* writer = writers.elementAt(used);
+            writer->fTarget.reset();
+            writer->fFirst = next;
+            for (writer->fCount = 0; writer->fCount < runLength && next; writer->fCount++)
+                next = next->getNextSibling();
+            writer->fEnd = next;
+
+            if (used)
+            {
+                try
+                {
+                    writer->fThread = std::thread(&DOMLSSerializerImpl::processChunk, writer->fWriter, writer->fFirst, writer->fEnd);
+                }
+                catch (const std::system_error&)
+                {
+                    writer->fWriter->processChunk(writer->fFirst, writer->fEnd);
+                }
+            }
+        }
+
+        writers.elementAt(0)->fWriter->processChunk(writers.elementAt(0)->fFirst, writers.elementAt(0)->fEnd);
+
+        for (XMLSize_t i = 1; i < used; i++)
+        {
+            if (writers.elementAt(i)->fThread.joinable())
+                writers.elementAt(i)->fThread.join();
+        }
+
+        for (XMLSize_t i = 0; i < used; i++)
+        {
+            ChunkWriter* writer = writers.elementAt(i);
+            if (writer->fWriter->fErrorCount == 0)
+            {
+                childrenWritten += writer->fCount;
+                bytesWritten += writer->fTarget.getLen();
+                fTarget->writeChars(writer->fTarget.getRawBuffer(), writer->fTarget.getLen(), fFormatter);
+                continue;
+            }
+
+            // written again to report the errors from this thread
+            for (const DOMNode* node = writer->fFirst; node != writer->fEnd; node = node->getNextSibling())
+                processTree(node);
+        }
+    }
+
+    return true;
+#else
+    (void)parent;
+    return false;
+#endif
+}
+
+void DOMLSSerializerImpl::processChunk(const DOMNode* const first, const DOMNode* const end)
+{
+    // nothing may escape the thread, a failure is only counted and leaves
+    // the run to the calling thread
+    fErrorCount = 0;
+    fOutLength = 0;
+    const XMLSize_t depth = fNamespaceStack->size();
+
+    try
+    {
+        for (const DOMNode* node = first; node != end; node = node->getNextSibling())
+            processTree(node);
+    }
+    catch(...)
+    {
+        fErrorCount++;
+    }
+
+    while (fNamespaceStack->size() > depth)
+        fNamespaceStack->removeLastElement();
+}
+
 }
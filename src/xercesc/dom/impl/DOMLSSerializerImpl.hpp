@@ -143,6 +143,31 @@ protected:
 
     void processBOM();
 
+    // streaming path used for plain UTF-8 output, see write()
+    void processTree(const DOMNode* const nodeToWrite);
+    bool writeStartTag(const DOMNode* const nodeToWrite
+                     , bool                 discardDefaults
+                     , bool                 keepEntities);
+    void writeOut(const XMLCh* const              toWrite
+                , const XMLFormatter::EscapeFlags escapes = XMLFormatter::NoEscapes
+                , const DOMNode* const            nodeToCheck = 0);
+    void writeOut(const XMLCh toWrite);
+    void writeOutCharRef(XMLUInt32 toWrite);
+    void flushOut();
+    void delegateNode(const DOMNode* const nodeToWrite, int level);
+
+    // parallel serialization of the children of an element, see processTree()
+    bool processChildrenInParallel(const DOMNode* const parent);
+    void processChunk(const DOMNode* const first, const DOMNode* const end);
+
+    enum Constants
+    {
+        kOutBufferSize = 64 * 1024
+    ,   kOutCharMaxBytes = 16
+    ,   kChunkChildren = 1024
+    ,   kChunkBytes = 256 * 1024
+    };
+
     // -----------------------------------------------------------------------
     //  Private data members
     //
@@ -185,6 +210,24 @@ protected:
     //      the current line. Used to track the line number the current
     //      node begins on
     //
+    //  fTarget (session var)
+    //      the format target of write(), it does not own it.
+    //
+    //  fOutBuffer, fOutLength
+    //      the UTF-8 bytes produced by processTree() which have not yet
+    //      been handed to fTarget. The buffer is allocated on first use
+    //      and reused by the following calls to write().
+    //
+    //  fChunkWriter
+    //      true for the serializers writing a run of children on a thread
+    //      of their own, see processChildrenInParallel(). Those give up on
+    //      the nodes only processNode() can write, which are then written
+    //      again by the calling thread.
+    //
+    //  fThreadCount
+    //      the number of threads used for parallel serialization, 0 for
+    //      one per hardware thread.
+    //
     // -----------------------------------------------------------------------
 
     int                           fFeatures;
@@ -203,6 +246,11 @@ protected:
     bool                          fLineFeedInTextNodePrinted;
     unsigned int                  fLastWhiteSpaceInTextNode;
     bool                          fIsXml11;
+    XMLFormatTarget              *fTarget;
+    XMLByte                      *fOutBuffer;
+    XMLSize_t                     fOutLength;
+    bool                          fChunkWriter;
+    XMLSize_t                     fThreadCount;
 
     RefVectorOf< RefHashTableOf<XMLCh> >* fNamespaceStack;
     MemoryManager*               fMemoryManager;
@@ -229,6 +277,14 @@ inline void DOMLSSerializerImpl::setURCharRef()
     fFormatter->setUnRepFlags(XMLFormatter::UnRep_CharRef);
 }
 
+inline void DOMLSSerializerImpl::writeOut(const XMLCh toWrite)
+{
+    // only used for the ASCII characters of the markup
+    if (fOutLength == kOutBufferSize)
+        flushOut();
+    fOutBuffer[fOutLength++] = (XMLByte)toWrite;
+}
+
 }
 
 #endif
@@ -56,6 +56,8 @@ protected:
     XMLCh       *fTarget;
     const XMLCh *fBaseURI;
 
+    friend class DOMDocumentCursorBase;
+
 public:
     DOMProcessingInstructionImpl(DOMDocument *ownerDoc,
                               const XMLCh * target,
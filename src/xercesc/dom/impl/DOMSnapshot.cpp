@@ -0,0 +1,661 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+#include <xercesc/dom/DOMSnapshot.hpp>
+#include <xercesc/dom/DOMImplementation.hpp>
+#include <xercesc/dom/DOMLSException.hpp>
+#include <xercesc/dom/DOMNamedNodeMap.hpp>
+#include <xercesc/framework/XMLFormatter.hpp>
+#include <xercesc/util/Janitor.hpp>
+#include <xercesc/util/OutOfMemoryException.hpp>
+#include <xercesc/util/ValueHashTableOf.hpp>
+#include <xercesc/util/ValueVectorOf.hpp>
+#include <xercesc/util/XMLDOMMsg.hpp>
+#include <xercesc/util/XMLString.hpp>
+
+#include "DOMAttrImpl.hpp"
+#include "DOMAttrMapImpl.hpp"
+#include "DOMAttrNSImpl.hpp"
+#include "DOMCasts.hpp"
+#include "DOMCDATASectionImpl.hpp"
+#include "DOMCommentImpl.hpp"
+#include "DOMDocumentImpl.hpp"
+#include "DOMDocumentTypeImpl.hpp"
+#include "DOMElementImpl.hpp"
+#include "DOMElementNSImpl.hpp"
+#include "DOMEntityImpl.hpp"
+#include "DOMEntityReferenceImpl.hpp"
+#include "DOMNodeIDMap.hpp"
+#include "DOMNotationImpl.hpp"
+#include "DOMProcessingInstructionImpl.hpp"
+#include "DOMTextImpl.hpp"
+
+#include <cstring>
+
+namespace XERCES_CPP_NAMESPACE {
+
+// ---------------------------------------------------------------------------
+//  The snapshot format
+//
+//  All fields are 32 bit values in the byte order of the platform that wrote
+//  the snapshot, and every part starts at a multiple of four bytes:
+//
+//      SnapshotHeader
+//      SnapshotRecord[fRecordCount]    one per node, in document order
+//      XMLUInt32[2 * fStringCount]     offset and length of each string,
+//                                      in characters from fStringDataOffset
+//      XMLCh[]                         the strings, each null terminated
+//
+//  String 0 stands for a null string. A record refers to its parent by its
+//  index, which is always lower than its own. The document is record 0. An
+//  attribute's parent is its owner element, and an entity's or a notation's
+//  parent is the document type. What the strings of a record hold depends on
+//  the node type:
+//
+//      DOCUMENT            documentURI, xmlVersion, xmlEncoding, inputEncoding
+//      DOCUMENT_TYPE       name, publicId, systemId, internalSubset
+//      ELEMENT             name, namespaceURI, localName, prefix
+//      ATTRIBUTE           name, namespaceURI, localName, prefix, value
+//      TEXT, CDATA_SECTION, COMMENT
+//                          data
+//      PROCESSING_INSTRUCTION
+//                          target, data
+//      ENTITY_REFERENCE    name
+//      ENTITY              name, publicId, systemId, notationName, baseURI
+//      NOTATION            name, publicId, systemId, baseURI
+//
+//  The local name of an element or attribute is null if it was created
+//  without namespaces. The count of an element is its number of attributes.
+// ---------------------------------------------------------------------------
+static const XMLByte  gSnapshotMagic[8] = { 'X', 'D', 'O', 'M', 'S', 'N', 'A', 'P' };
+static const XMLUInt32 gSnapshotVersion = 1;
+static const XMLUInt32 gSnapshotByteOrder = 0x01020304;
+
+struct SnapshotHeader
+{
+    XMLByte   fMagic[8];
+    XMLUInt32 fVersion;
+    XMLUInt32 fByteOrder;
+    XMLUInt32 fCharSize;
+    XMLUInt32 fRecordCount;
+    XMLUInt32 fRecordOffset;
+    XMLUInt32 fStringCount;
+    XMLUInt32 fStringTableOffset;
+    XMLUInt32 fStringDataOffset;
+    XMLUInt32 fSize;
+    XMLUInt32 fReserved;
+};
+
+enum SnapshotFlags
+{
+    kSnapshotSpecified  = 0x01,
+    kSnapshotId         = 0x02,
+    kSnapshotIgnorable  = 0x04,
+    kSnapshotStandalone = 0x08,
+    kSnapshotReadOnly   = 0x10
+};
+
+struct SnapshotRecord
+{
+    XMLUInt32 fType;
+    XMLUInt32 fParent;
+    XMLUInt32 fFlags;
+    XMLUInt32 fCount;
+    XMLUInt32 fString[5];
+};
+
+
+// ---------------------------------------------------------------------------
+//  Writing
+// ---------------------------------------------------------------------------
+class DOMSnapshotWriter : public XMemory
+{
+public:
+    DOMSnapshotWriter(MemoryManager* const manager)
+        : fRecords(1024, manager)
+        , fStrings(1024, manager)
+        , fStringTable(2048, manager)
+        , fStringIds(1031, manager)
+        , fStringChars(0)
+    {
+        fStrings.addElement(0);
+        fStringTable.addElement(0);
+        fStringTable.addElement(0);
+    }
+
+    void addTree(const DOMNode* node, XMLUInt32 parent);
+    void write(XMLFormatTarget* target);
+
+private:
+    XMLUInt32 addString(const XMLCh* string);
+    XMLUInt32 addRecord(const DOMNode* node, XMLUInt32 parent);
+
+    DOMSnapshotWriter(const DOMSnapshotWriter&);
+    DOMSnapshotWriter& operator=(const DOMSnapshotWriter&);
+
+    ValueVectorOf<SnapshotRecord>   fRecords;
+    ValueVectorOf<const XMLCh*>     fStrings;
+    ValueVectorOf<XMLUInt32>        fStringTable;
+    // Index of each distinct string; the keys are the strings of the
+    // document, which outlives the writer
+    ValueHashTableOf<XMLUInt32>     fStringIds;
+    XMLSize_t                       fStringChars;
+};
+
+static void throwSnapshotTooLarge(MemoryManager* const manager)
+{
+    throw DOMLSException(DOMLSException::SERIALIZE_ERR, XMLDOMMsg::SERIALIZE_ERR, manager);
+}
+
+XMLUInt32 DOMSnapshotWriter::addString(const XMLCh* string)
+{
+    if (string == 0)
+        return 0;
+    if (fStringIds.containsKey(string))
+        return fStringIds.get(string);
+
+    const XMLSize_t length = XMLString::stringLen(string);
+    const XMLUInt32 id = (XMLUInt32)fStrings.size();
+    fStrings.addElement(string);
+    fStringTable.addElement((XMLUInt32)fStringChars);
+    fStringTable.addElement((XMLUInt32)length);
+    fStringIds.put((void*)string, id);
+
+    fStringChars += length + 1;
+    if (fStringChars > 0x3FFFFFFF)
+        throwSnapshotTooLarge(fStrings.getMemoryManager());
+    return id;
+}
+
+XMLUInt32 DOMSnapshotWriter::addRecord(const DOMNode* node, XMLUInt32 parent)
+{
+    SnapshotRecord record;
+    memset(&record, 0, sizeof(record));
+    record.fType = node->getNodeType();
+    record.fParent = parent;
+
+    switch (node->getNodeType())
+    {
+    case DOMNode::DOCUMENT_NODE:
+        {
+            const DOMDocument* doc = (const DOMDocument*)node;
+            record.fString[0] = addString(doc->getDocumentURI());
+            record.fString[1] = addString(doc->getXmlVersion());
+            record.fString[2] = addString(doc->getXmlEncoding());
+            record.fString[3] = addString(doc->getInputEncoding());
+            if (doc->getXmlStandalone())
+                record.fFlags |= kSnapshotStandalone;
+            break;
+        }
+    case DOMNode::DOCUMENT_TYPE_NODE:
+        {
+            const DOMDocumentType* docType = (const DOMDocumentType*)node;
+            record.fString[0] = addString(docType->getName());
+            record.fString[1] = addString(docType->getPublicId());
+            record.fString[2] = addString(docType->getSystemId());
+            record.fString[3] = addString(docType->getInternalSubset());
+            if (castToNodeImpl(node)->isReadOnly())
+                record.fFlags |= kSnapshotReadOnly;
+            break;
+        }
+    case DOMNode::ELEMENT_NODE:
+        {
+            DOMNamedNodeMap* attributes = node->getAttributes();
+            record.fString[0] = addString(node->getNodeName());
+            record.fString[1] = addString(node->getNamespaceURI());
+            record.fString[2] = addString(node->getLocalName());
+            record.fString[3] = addString(node->getPrefix());
+            record.fCount = (XMLUInt32)attributes->getLength();
+            break;
+        }
+    case DOMNode::ATTRIBUTE_NODE:
+        {
+            const DOMAttr* attr = (const DOMAttr*)node;
+            record.fString[0] = addString(node->getNodeName());
+            record.fString[1] = addString(node->getNamespaceURI());
+            record.fString[2] = addString(node->getLocalName());
+            record.fString[3] = addString(node->getPrefix());
+            record.fString[4] = addString(attr->getValue());
+            if (attr->getSpecified())
+                record.fFlags |= kSnapshotSpecified;
+            if (attr->isId())
+                record.fFlags |= kSnapshotId;
+            break;
+        }
+    case DOMNode::TEXT_NODE:
+        if (((const DOMText*)node)->isIgnorableWhitespace())
+            record.fFlags |= kSnapshotIgnorable;
+        record.fString[0] = addString(node->getNodeValue());
+        break;
+    case DOMNode::CDATA_SECTION_NODE:
+    case DOMNode::COMMENT_NODE:
+        record.fString[0] = addString(node->getNodeValue());
+        break;
+    case DOMNode::PROCESSING_INSTRUCTION_NODE:
+        record.fString[0] = addString(node->getNodeName());
+        record.fString[1] = addString(node->getNodeValue());
+        break;
+    case DOMNode::ENTITY_REFERENCE_NODE:
+        record.fString[0] = addString(node->getNodeName());
+        if (castToNodeImpl(node)->isReadOnly())
+            record.fFlags |= kSnapshotReadOnly;
+        break;
+    case DOMNode::ENTITY_NODE:
+        {
+            const DOMEntity* entity = (const DOMEntity*)node;
+            record.fString[0] = addString(entity->getNodeName());
+            record.fString[1] = addString(entity->getPublicId());
+            record.fString[2] = addString(entity->getSystemId());
+            record.fString[3] = addString(entity->getNotationName());
+            record.fString[4] = addString(entity->getBaseURI());
+            break;
+        }
+    case DOMNode::NOTATION_NODE:
+        {
+            const DOMNotation* notation = (const DOMNotation*)node;
+            record.fString[0] = addString(notation->getNodeName());
+            record.fString[1] = addString(notation->getPublicId());
+            record.fString[2] = addString(notation->getSystemId());
+            record.fString[3] = addString(notation->getBaseURI());
+            break;
+        }
+    default:
+        break;
+    }
+
+    if (fRecords.size() >= 0x3FFFFFFF / sizeof(SnapshotRecord))
+        throwSnapshotTooLarge(fStrings.getMemoryManager());
+    fRecords.addElement(record);
+    return (XMLUInt32)(fRecords.size() - 1);
+}
+
+void DOMSnapshotWriter::addTree(const DOMNode* node, XMLUInt32 parent)
+{
+    const XMLUInt32 index = addRecord(node, parent);
+
+    switch (node->getNodeType())
+    {
+    case DOMNode::ELEMENT_NODE:
+        {
+            DOMNamedNodeMap* attributes = node->getAttributes();
+            for (XMLSize_t i = 0; i < attributes->getLength(); i++)
+                addRecord(attributes->item(i), index);
+            break;
+        }
+    case DOMNode::DOCUMENT_TYPE_NODE:
+        {
+            const DOMDocumentType* docType = (const DOMDocumentType*)node;
+            DOMNamedNodeMap* entities = docType->getEntities();
+            for (XMLSize_t i = 0; i < entities->getLength(); i++)
+                addTree(entities->item(i), index);
+            DOMNamedNodeMap* notations = docType->getNotations();
+            for (XMLSize_t i = 0; i < notations->getLength(); i++)
+                addRecord(notations->item(i), index);
+            return;
+        }
+    case DOMNode::ENTITY_NODE:
+        // The content of a parsed entity is copied from its references when
+        //   it is asked for, and the reader sets the references up again
+        if (((const DOMEntityImpl*)node)->getEntityRef() != 0)
+            return;
+        break;
+    default:
+        break;
+    }
+
+    for (DOMNode* child = node->getFirstChild(); child != 0; child = child->getNextSibling())
+        addTree(child, index);
+}
+
+void DOMSnapshotWriter::write(XMLFormatTarget* target)
+{
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.fMagic, gSnapshotMagic, sizeof(gSnapshotMagic));
+    header.fVersion = gSnapshotVersion;
+    header.fByteOrder = gSnapshotByteOrder;
+    header.fCharSize = sizeof(XMLCh);
+    header.fRecordCount = (XMLUInt32)fRecords.size();
+    header.fRecordOffset = sizeof(SnapshotHeader);
+    header.fStringCount = (XMLUInt32)fStrings.size();
+    header.fStringTableOffset = header.fRecordOffset + header.fRecordCount * sizeof(SnapshotRecord);
+
+    const XMLSize_t dataOffset = header.fStringTableOffset + fStringTable.size() * sizeof(XMLUInt32);
+    const XMLSize_t size = dataOffset + fStringChars * sizeof(XMLCh);
+    if (size > 0xFFFFFFF0)
+        throwSnapshotTooLarge(fStrings.getMemoryManager());
+    header.fStringDataOffset = (XMLUInt32)dataOffset;
+    header.fSize = (XMLUInt32)size;
+
+    target->writeChars((const XMLByte*)&header, sizeof(header), 0);
+    target->writeChars((const XMLByte*)fRecords.rawData(), fRecords.size() * sizeof(SnapshotRecord), 0);
+    target->writeChars((const XMLByte*)fStringTable.rawData(), fStringTable.size() * sizeof(XMLUInt32), 0);
+    for (XMLSize_t i = 1; i < fStrings.size(); i++)
+        target->writeChars((const XMLByte*)fStrings.elementAt(i), (fStringTable.elementAt(2 * i + 1) + 1) * sizeof(XMLCh), 0);
+    target->flush();
+}
+
+
+// ---------------------------------------------------------------------------
+//  Reading
+// ---------------------------------------------------------------------------
+class DOMSnapshotReader
+{
+public:
+    DOMSnapshotReader(const XMLByte* image, XMLSize_t size, MemoryManager* const manager)
+        : fImage(image)
+        , fSize(size)
+        , fHeader(0)
+        , fRecords(0)
+        , fStringTable(0)
+        , fStringData(0)
+        , fMemoryManager(manager)
+    {
+    }
+
+    DOMDocument* read();
+
+private:
+    void         check(bool condition) const;
+    void         checkImage();
+    const XMLCh* getString(XMLUInt32 index) const;
+    XMLSize_t    getLength(XMLUInt32 index) const;
+    DOMNode*     createNode(DOMDocumentImpl* doc, const SnapshotRecord& record, DOMNode* parent);
+
+    DOMSnapshotReader(const DOMSnapshotReader&);
+    DOMSnapshotReader& operator=(const DOMSnapshotReader&);
+
+    const XMLByte*        fImage;
+    XMLSize_t             fSize;
+    const SnapshotHeader* fHeader;
+    const SnapshotRecord* fRecords;
+    const XMLUInt32*      fStringTable;
+    const XMLCh*          fStringData;
+    MemoryManager*        fMemoryManager;
+};
+
+void DOMSnapshotReader::check(bool condition) const
+{
+    if (!condition)
+        throw DOMLSException(DOMLSException::PARSE_ERR, XMLDOMMsg::LSParser_ParsingFailed, fMemoryManager);
+}
+
+void DOMSnapshotReader::checkImage()
+{
+    check(fImage != 0 && ((XMLSize_t)fImage % sizeof(XMLUInt32)) == 0 && fSize >= sizeof(SnapshotHeader));
+
+    fHeader = (const SnapshotHeader*)fImage;
+    check(memcmp(fHeader->fMagic, gSnapshotMagic, sizeof(gSnapshotMagic)) == 0 &&
+          fHeader->fVersion == gSnapshotVersion &&
+          fHeader->fByteOrder == gSnapshotByteOrder &&
+          fHeader->fCharSize == sizeof(XMLCh) &&
+          fHeader->fSize <= fSize);
+
+    // The parts follow each other and fit in the snapshot
+    const XMLSize_t size = fHeader->fSize;
+    check(fHeader->fRecordOffset == sizeof(SnapshotHeader) &&
+          fHeader->fRecordCount != 0 &&
+          fHeader->fRecordCount <= (size - fHeader->fRecordOffset) / sizeof(SnapshotRecord) &&
+          fHeader->fStringTableOffset == fHeader->fRecordOffset + fHeader->fRecordCount * sizeof(SnapshotRecord) &&
+          fHeader->fStringCount != 0 &&
+          fHeader->fStringCount <= (size - fHeader->fStringTableOffset) / (2 * sizeof(XMLUInt32)) &&
+          fHeader->fStringDataOffset == fHeader->fStringTableOffset + fHeader->fStringCount * 2 * sizeof(XMLUInt32));
+
+    fRecords = (const SnapshotRecord*)(fImage + fHeader->fRecordOffset);
+    fStringTable = (const XMLUInt32*)(fImage + fHeader->fStringTableOffset);
+    fStringData = (const XMLCh*)(fImage + fHeader->fStringDataOffset);
+
+    // Every string is null terminated within the snapshot
+    const XMLSize_t dataChars = (size - fHeader->fStringDataOffset) / sizeof(XMLCh);
+    for (XMLUInt32 i = 1; i < fHeader->fStringCount; i++)
+    {
+        const XMLSize_t offset = fStringTable[2 * i];
+        const XMLSize_t length = fStringTable[2 * i + 1];
+        check(offset < dataChars && length < dataChars - offset && fStringData[offset + length] == 0);
+    }
+}
+
+inline const XMLCh* DOMSnapshotReader::getString(XMLUInt32 index) const
+{
+    check(index < fHeader->fStringCount);
+    return index ? fStringData + fStringTable[2 * index] : 0;
+}
+
+inline XMLSize_t DOMSnapshotReader::getLength(XMLUInt32 index) const
+{
+    return index ? fStringTable[2 * index + 1] : 0;
+}
+
+DOMNode* DOMSnapshotReader::createNode(DOMDocumentImpl* doc, const SnapshotRecord& record, DOMNode* parent)
+{
+    const DOMNode::NodeType parentType = parent->getNodeType();
+    const bool parentIsContainer = parentType == DOMNode::ELEMENT_NODE ||
+                                   parentType == DOMNode::ENTITY_NODE ||
+                                   parentType == DOMNode::ENTITY_REFERENCE_NODE;
+    const bool parentIsDocument = parentType == DOMNode::DOCUMENT_NODE;
+
+    DOMNode* node = 0;
+    switch (record.fType)
+    {
+    case DOMNode::ELEMENT_NODE:
+        check(parentIsContainer || (parentIsDocument && doc->getDocumentElement() == 0));
+        if (record.fString[2])
+            node = new (doc, DOMMemoryManager::ELEMENT_NS_OBJECT)
+                DOMElementNSImpl(doc,
+                                 getString(record.fString[1]),
+                                 getString(record.fString[3]),
+                                 getString(record.fString[2]),
+                                 getString(record.fString[0]));
+        else
+            node = new (doc, DOMMemoryManager::ELEMENT_OBJECT) DOMElementImpl(doc, getString(record.fString[0]));
+        if (record.fCount)
+            ((DOMElementImpl*)node)->fAttributes->reserve(record.fCount);
+        break;
+    case DOMNode::ATTRIBUTE_NODE:
+        {
+            check(parentType == DOMNode::ELEMENT_NODE);
+            DOMAttrImpl* attr;
+            DOMAttrMapImpl* map = ((DOMElementImpl*)parent)->fAttributes;
+            map->reserve(1);
+            if (record.fString[2])
+            {
+                attr = new (doc, DOMMemoryManager::ATTR_NS_OBJECT)
+                    DOMAttrNSImpl(doc,
+                                  getString(record.fString[1]),
+                                  getString(record.fString[3]),
+                                  getString(record.fString[2]),
+                                  getString(record.fString[0]));
+                map->setNamedItemNSFast(attr);
+            }
+            else
+            {
+                attr = new (doc, DOMMemoryManager::ATTR_OBJECT) DOMAttrImpl(doc, getString(record.fString[0]));
+                map->setNamedItemFast(attr);
+            }
+            attr->setValueFast(getString(record.fString[4]));
+            attr->setSpecified((record.fFlags & kSnapshotSpecified) != 0);
+            if (record.fFlags & kSnapshotId)
+            {
+                if (doc->fNodeIDMap == 0)
+                    doc->fNodeIDMap = new (doc) DOMNodeIDMap(500, doc);
+                doc->fNodeIDMap->add(attr);
+                attr->fNode.isIdAttr(true);
+            }
+            // Attributes are not children
+            return attr;
+        }
+    case DOMNode::TEXT_NODE:
+        check(parentIsContainer);
+        node = new (doc, DOMMemoryManager::TEXT_OBJECT)
+            DOMTextImpl(doc, getString(record.fString[0]), getLength(record.fString[0]));
+        if (record.fFlags & kSnapshotIgnorable)
+            castToNodeImpl(node)->ignorableWhitespace(true);
+        break;
+    case DOMNode::CDATA_SECTION_NODE:
+        check(parentIsContainer);
+        node = new (doc, DOMMemoryManager::CDATA_SECTION_OBJECT)
+            DOMCDATASectionImpl(doc, getString(record.fString[0]), getLength(record.fString[0]));
+        break;
+    case DOMNode::COMMENT_NODE:
+        check(parentIsContainer || parentIsDocument);
+        node = new (doc, DOMMemoryManager::COMMENT_OBJECT) DOMCommentImpl(doc, getString(record.fString[0]));
+        break;
+    case DOMNode::PROCESSING_INSTRUCTION_NODE:
+        check(parentIsContainer || parentIsDocument);
+        node = new (doc, DOMMemoryManager::PROCESSING_INSTRUCTION_OBJECT)
+            DOMProcessingInstructionImpl(doc, getString(record.fString[0]), getString(record.fString[1]));
+        break;
+    case DOMNode::ENTITY_REFERENCE_NODE:
+        {
+            check(parentIsContainer);
+            const XMLCh* name = getString(record.fString[0]);
+            node = doc->createEntityReferenceByParser(name);
+            castToNodeImpl(node)->setReadOnly(false, true);
+
+            // Like the parser, let the entity copy its content from the reference
+            DOMDocumentType* docType = doc->getDoctype();
+            DOMEntityImpl* entity = docType ? (DOMEntityImpl*)docType->getEntities()->getNamedItem(name) : 0;
+            if (entity && entity->getFirstChild() == 0)
+                entity->setEntityRef((DOMEntityReference*)node);
+            break;
+        }
+    case DOMNode::DOCUMENT_TYPE_NODE:
+        {
+            check(parentIsDocument && doc->getDoctype() == 0 && doc->getDocumentElement() == 0);
+            DOMDocumentTypeImpl* docType = (DOMDocumentTypeImpl*)doc->createDocumentType(getString(record.fString[0]));
+            docType->setPublicId(getString(record.fString[1]));
+            docType->setSystemId(getString(record.fString[2]));
+            if (record.fString[3])
+                docType->setInternalSubset(getString(record.fString[3]));
+            doc->appendChild(docType);
+            return docType;
+        }
+    case DOMNode::ENTITY_NODE:
+        {
+            check(parentType == DOMNode::DOCUMENT_TYPE_NODE);
+            DOMEntityImpl* entity = (DOMEntityImpl*)doc->createEntity(getString(record.fString[0]));
+            entity->setPublicId(getString(record.fString[1]));
+            entity->setSystemId(getString(record.fString[2]));
+            entity->setNotationName(getString(record.fString[3]));
+            entity->setBaseURI(getString(record.fString[4]));
+            DOMNode* previous = ((DOMDocumentType*)parent)->getEntities()->setNamedItem(entity);
+            if (previous)
+                previous->release();
+            return entity;
+        }
+    case DOMNode::NOTATION_NODE:
+        {
+            check(parentType == DOMNode::DOCUMENT_TYPE_NODE);
+            DOMNotationImpl* notation = (DOMNotationImpl*)doc->createNotation(getString(record.fString[0]));
+            notation->setPublicId(getString(record.fString[1]));
+            notation->setSystemId(getString(record.fString[2]));
+            notation->setBaseURI(getString(record.fString[3]));
+            DOMNode* previous = ((DOMDocumentType*)parent)->getNotations()->setNamedItem(notation);
+            if (previous)
+                previous->release();
+            return notation;
+        }
+    default:
+        check(false);
+    }
+
+    if (parentIsDocument)
+        doc->appendChild(node);
+    else
+        castToParentImpl(parent)->appendChildFast(node);
+    return node;
+}
+
+DOMDocument* DOMSnapshotReader::read()
+{
+    checkImage();
+
+    const SnapshotRecord& docRecord = fRecords[0];
+    check(docRecord.fType == DOMNode::DOCUMENT_NODE);
+
+    DOMDocumentImpl* doc = (DOMDocumentImpl*)DOMImplementation::getImplementation()->createDocument(fMemoryManager);
+    try
+    {
+        // Strict error checking is off while the nodes are put together,
+        //   which the parser does as well
+        doc->setErrorChecking(false);
+        doc->setDocumentURI(getString(docRecord.fString[0]));
+        if (docRecord.fString[1])
+            doc->setXmlVersion(getString(docRecord.fString[1]));
+        doc->setXmlEncoding(getString(docRecord.fString[2]));
+        doc->setInputEncoding(getString(docRecord.fString[3]));
+        doc->setXmlStandalone((docRecord.fFlags & kSnapshotStandalone) != 0);
+
+        const XMLUInt32 count = fHeader->fRecordCount;
+        DOMNode** nodes = (DOMNode**)fMemoryManager->allocate(count * sizeof(DOMNode*));
+        ArrayJanitor<DOMNode*> janNodes(nodes, fMemoryManager);
+        nodes[0] = doc;
+
+        for (XMLUInt32 i = 1; i < count; i++)
+        {
+            const SnapshotRecord& record = fRecords[i];
+            check(record.fParent < i && record.fType != DOMNode::DOCUMENT_NODE);
+            nodes[i] = createNode(doc, record, nodes[record.fParent]);
+        }
+
+        // Make read only what was read only, once it has its content
+        for (XMLUInt32 i = 1; i < count; i++)
+        {
+            if (!(fRecords[i].fFlags & kSnapshotReadOnly))
+                continue;
+            if (fRecords[i].fType == DOMNode::DOCUMENT_TYPE_NODE)
+                ((DOMDocumentTypeImpl*)nodes[i])->setReadOnly(true, true);
+            else if (fRecords[i].fType == DOMNode::ENTITY_REFERENCE_NODE)
+                castToNodeImpl(nodes[i])->setReadOnly(true, true);
+        }
+
+        doc->setErrorChecking(true);
+    }
+    catch(const OutOfMemoryException&)
+    {
+        throw;
+    }
+    catch(...)
+    {
+        doc->release();
+        throw;
+    }
+    return doc;
+}
+
+
+// ---------------------------------------------------------------------------
+//  DOMSnapshot: Static interface
+// ---------------------------------------------------------------------------
+void DOMSnapshot::write(const DOMDocument* document, XMLFormatTarget* target)
+{
+    DOMSnapshotWriter writer(((const DOMDocumentImpl*)document)->getMemoryManager());
+    writer.addTree(document, 0);
+    writer.write(target);
+}
+
+DOMDocument* DOMSnapshot::read(const void* image, XMLSize_t size, MemoryManager* const manager)
+{
+    DOMSnapshotReader reader((const XMLByte*)image, size, manager);
+    return reader.read();
+}
+
+}
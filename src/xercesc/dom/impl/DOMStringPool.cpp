@@ -46,12 +46,22 @@ DOMBuffer(DOMDocumentImpl *doc, XMLSize_t capacity) :
 // ---------------------------------------------------------------------------
 void DOMBuffer::expandCapacity(const XMLSize_t extraNeeded, bool releasePrevious /*= false*/)
 {
+    // If nothing was allocated from the document heap since the buffer,
+    // take just what is needed from the room after it. Consecutive appends,
+    // like the chunks of a long text coming from the parser, then neither
+    // copy the content nor leave old copies behind.
+    if (fDoc->growInPlace(fBuffer, (fCapacity+1)*sizeof(XMLCh), (fIndex+extraNeeded+1)*sizeof(XMLCh)))
+    {
+        fCapacity = fIndex + extraNeeded;
+        return;
+    }
+
     //not enough room. Calc new capacity and allocate new buffer
     const XMLSize_t newCap = (XMLSize_t)((fIndex + extraNeeded) * 1.25);
     XMLCh* newBuf = (XMLCh*) fDoc->allocate((newCap+1)*sizeof(XMLCh));
 
-    // Copy over the old stuff
-    memcpy(newBuf, fBuffer, fCapacity * sizeof(XMLCh));
+    // Copy over the content, the rest of the old buffer is unused
+    memcpy(newBuf, fBuffer, fIndex * sizeof(XMLCh));
 
     // If the caller told us to deallocate the old memory, do it;
     // it may know that nobody could possibly get a pointer to the old memory buffer
@@ -17,111 +17,62 @@
 
 #include "DOMXPathExpressionImpl.hpp"
 #include "DOMXPathResultImpl.hpp"
-#include <xercesc/validators/schema/identity/XercesXPath.hpp>
-#include <xercesc/validators/schema/identity/XPathMatcher.hpp>
-#include <xercesc/validators/schema/identity/XPathException.hpp>
-#include <xercesc/validators/schema/SchemaElementDecl.hpp>
-#include <xercesc/util/StringPool.hpp>
-#include <xercesc/util/OutOfMemoryException.hpp>
+#include "DOMXPathPlan.hpp"
+#include <xercesc/framework/XMLBuffer.hpp>
+#include <xercesc/util/Janitor.hpp>
 #include <xercesc/dom/DOMXPathException.hpp>
 #include <xercesc/dom/DOM.hpp>
 
 namespace XERCES_CPP_NAMESPACE {
 
-class WrapperForXPathNSResolver : public XercesNamespaceResolver
-{
-public:
-    WrapperForXPathNSResolver(XMLStringPool* pool, const DOMXPathNSResolver *resolver, MemoryManager* const manager) :
-      fStringPool(pool),
-      fResolver(resolver),
-      fMemoryManager(manager)
-    {
-    }
-
-    virtual unsigned int getNamespaceForPrefix(const XMLCh* const prefix) const
-    {
-        if(fResolver==NULL)
-            throw DOMException(DOMException::NAMESPACE_ERR, 0, fMemoryManager);
-        const XMLCh* nsUri=fResolver->lookupNamespaceURI(prefix);
-        if(nsUri==NULL)
-            throw DOMException(DOMException::NAMESPACE_ERR, 0, fMemoryManager);
-        return fStringPool->addOrFind(nsUri);
-    }
-
-protected:
-    XMLStringPool*              fStringPool;
-    const DOMXPathNSResolver *  fResolver;
-    MemoryManager* const        fMemoryManager;
-};
-
-
-typedef JanitorMemFunCall<DOMXPathExpressionImpl>     CleanupType;
-
 DOMXPathExpressionImpl::DOMXPathExpressionImpl(const XMLCh *expression, const DOMXPathNSResolver *resolver, MemoryManager* const manager) :
- fStringPool(NULL),
- fParsedExpression(NULL),
- fExpression(NULL),
- fMoveToRoot(false),
+ fPlan(NULL),
  fMemoryManager(manager)
 {
-    if(expression==NULL || *expression==0)
-        throw DOMXPathException(DOMXPathException::INVALID_EXPRESSION_ERR, 0, fMemoryManager);
-
-    CleanupType cleanup(this, &DOMXPathExpressionImpl::cleanUp);
-    fStringPool = new (fMemoryManager) XMLStringPool(109, fMemoryManager);
-    // XercesPath will complain if the expression starts with '/', add a "." in front of it and start from the document root
-    if(*expression==chForwardSlash)
-    {
-        fExpression=(XMLCh*)fMemoryManager->allocate((XMLString::stringLen(expression)+2)*sizeof(XMLCh));
-        *fExpression = chPeriod;
-        *(fExpression+1) = chNull;
-        XMLString::catString(fExpression, expression);
-        fMoveToRoot=true;
-    }
-    else
-        fExpression=XMLString::replicate(expression);
-
-    try
-    {
-        WrapperForXPathNSResolver wrappedResolver(fStringPool, resolver, fMemoryManager);
-        fParsedExpression = new (fMemoryManager) XercesXPath(fExpression, fStringPool, &wrappedResolver, 0, true, fMemoryManager);
-    }
-    catch(const XPathException& )
-    {
-        throw DOMXPathException(DOMXPathException::INVALID_EXPRESSION_ERR, 0, fMemoryManager);
-    }
-    catch(const OutOfMemoryException&)
-    {
-        cleanup.release();
-
-        throw;
-    }
-
-    cleanup.release();
+    fPlan = new (fMemoryManager) DOMXPathPlan(expression, resolver, fMemoryManager);
 }
 
 DOMXPathExpressionImpl::~DOMXPathExpressionImpl()
 {
-    cleanUp();
-}
-
-void DOMXPathExpressionImpl::cleanUp()
-{
-    XMLString::release(&fExpression, fMemoryManager);
-    delete fParsedExpression;
-    delete fStringPool;
+    delete fPlan;
 }
 
 DOMXPathResult* DOMXPathExpressionImpl::evaluate(const DOMNode *contextNode,
                                                  DOMXPathResult::ResultType type,
                                                  DOMXPathResult* result) const
 {
-    if(type!=DOMXPathResult::FIRST_ORDERED_NODE_TYPE && type!=DOMXPathResult::ORDERED_NODE_SNAPSHOT_TYPE &&
-       type!=DOMXPathResult::ANY_UNORDERED_NODE_TYPE && type!=DOMXPathResult::UNORDERED_NODE_SNAPSHOT_TYPE)
+    DOMXPathValue::ValueType valueType = fPlan->getResultType();
+    switch(type)
+    {
+    case DOMXPathResult::ANY_TYPE:
+        switch(valueType)
+        {
+        case DOMXPathValue::NUMBER_VALUE:   type = DOMXPathResult::NUMBER_TYPE; break;
+        case DOMXPathValue::STRING_VALUE:   type = DOMXPathResult::STRING_TYPE; break;
+        case DOMXPathValue::BOOLEAN_VALUE:  type = DOMXPathResult::BOOLEAN_TYPE; break;
+        default:                            type = DOMXPathResult::UNORDERED_NODE_ITERATOR_TYPE; break;
+        }
+        break;
+    case DOMXPathResult::NUMBER_TYPE:
+    case DOMXPathResult::STRING_TYPE:
+    case DOMXPathResult::BOOLEAN_TYPE:
+        break;
+    case DOMXPathResult::UNORDERED_NODE_ITERATOR_TYPE:
+    case DOMXPathResult::ORDERED_NODE_ITERATOR_TYPE:
+    case DOMXPathResult::UNORDERED_NODE_SNAPSHOT_TYPE:
+    case DOMXPathResult::ORDERED_NODE_SNAPSHOT_TYPE:
+    case DOMXPathResult::ANY_UNORDERED_NODE_TYPE:
+    case DOMXPathResult::FIRST_ORDERED_NODE_TYPE:
+        // Only node-sets convert to nodes.
+        if(valueType!=DOMXPathValue::NODESET_VALUE)
+            throw DOMXPathException(DOMXPathException::TYPE_ERR, 0, fMemoryManager);
+        break;
+    default:
+        // The XPath 2 sequence types are not supported by an XPath 1.0 engine.
         throw DOMXPathException(DOMXPathException::TYPE_ERR, 0, fMemoryManager);
+    }
 
-    if(contextNode==NULL || contextNode->getNodeType()!=DOMNode::ELEMENT_NODE)
-        throw DOMException(DOMException::NOT_SUPPORTED_ERR, 0, fMemoryManager);
+    Janitor<DOMXPathValue> value(fPlan->evaluate(contextNode));
 
     JanitorMemFunCall<DOMXPathResultImpl> r_cleanup (
       0, &DOMXPathResultImpl::release);
@@ -134,79 +85,44 @@ DOMXPathResult* DOMXPathExpressionImpl::evaluate(const DOMNode *contextNode,
     else
         r->reset(type);
 
-    XPathMatcher matcher(fParsedExpression, fMemoryManager);
-    matcher.startDocumentFragment();
-
-    if(fMoveToRoot)
+    switch(type)
     {
-        contextNode=contextNode->getOwnerDocument();
-        if(contextNode==NULL)
-            throw DOMException(DOMException::NOT_SUPPORTED_ERR, 0, fMemoryManager);
-
-        QName qName(contextNode->getNodeName(), 0, fMemoryManager);
-        SchemaElementDecl elemDecl(&qName);
-        RefVectorOf<XMLAttr> attrList(0, true, fMemoryManager);
-        matcher.startElement(elemDecl, 0, XMLUni::fgZeroLenString, attrList, 0);
-        DOMNode* child=contextNode->getFirstChild();
-        while(child)
+    case DOMXPathResult::NUMBER_TYPE:
+        r->setNumberValue(value->toNumber());
+        break;
+    case DOMXPathResult::BOOLEAN_TYPE:
+        r->setBooleanValue(value->toBoolean());
+        break;
+    case DOMXPathResult::STRING_TYPE:
         {
-            if(child->getNodeType()==DOMNode::ELEMENT_NODE)
-                testNode(&matcher, r, (DOMElement*)child);
-            child=child->getNextSibling();
+            XMLBuffer buf(1023, fMemoryManager);
+            value->toString(buf);
+            r->setStringValue(buf.getRawBuffer());
         }
-        matcher.endElement(elemDecl, XMLUni::fgZeroLenString);
+        break;
+    default:
+        {
+            // Node-sets are produced in document order, which satisfies the
+            // ordered and the unordered result types alike.
+            const ValueVectorOf<DOMNode*>* nodes = value->getNodes();
+            XMLSize_t count = nodes->size();
+            if(count!=0 && (type==DOMXPathResult::ANY_UNORDERED_NODE_TYPE || type==DOMXPathResult::FIRST_ORDERED_NODE_TYPE))
+                count = 1;
+            for(XMLSize_t i=0;i<count;i++)
+                r->addResult(nodes->elementAt(i));
+        }
+        break;
     }
+    r->adoptNamespaceNodes(value->orphanNamespaceNodes());
+    if(contextNode->getNodeType()==DOMNode::DOCUMENT_NODE)
+        r->setDocument((const DOMDocument*)contextNode);
     else
-        testNode(&matcher, r, (DOMElement*)contextNode);
+        r->setDocument(contextNode->getOwnerDocument());
 
     r_cleanup.release ();
     return r;
 }
 
-bool DOMXPathExpressionImpl::testNode(XPathMatcher* matcher, DOMXPathResultImpl* result, DOMElement *node) const
-{
-    int uriId=fStringPool->addOrFind(node->getNamespaceURI());
-    QName qName(node->getNodeName(), uriId, fMemoryManager);
-    SchemaElementDecl elemDecl(&qName);
-    DOMNamedNodeMap* attrMap=node->getAttributes();
-    XMLSize_t attrCount = attrMap->getLength();
-    RefVectorOf<XMLAttr> attrList(attrCount, true, fMemoryManager);
-    for(XMLSize_t i=0;i<attrCount;i++)
-    {
-        DOMAttr* attr=(DOMAttr*)attrMap->item(i);
-        attrList.addElement(new (fMemoryManager) XMLAttr(fStringPool->addOrFind(attr->getNamespaceURI()),
-                                                         attr->getNodeName(),
-                                                         attr->getNodeValue(),
-                                                         XMLAttDef::CData,
-                                                         attr->getSpecified(),
-                                                         fMemoryManager,
-                                                         NULL,
-                                                         true));
-    }
-    matcher->startElement(elemDecl, uriId, node->getPrefix(), attrList, attrCount);
-    unsigned char nMatch=matcher->isMatched();
-    if(nMatch!=0 && nMatch!=XPathMatcher::XP_MATCHED_DP)
-    {
-        result->addResult(node);
-        if(result->getResultType()==DOMXPathResult::ANY_UNORDERED_NODE_TYPE || result->getResultType()==DOMXPathResult::FIRST_ORDERED_NODE_TYPE)
-            return true;    // abort navigation, we found one result
-    }
-
-    if(nMatch==0 || nMatch==XPathMatcher::XP_MATCHED_D || nMatch==XPathMatcher::XP_MATCHED_DP)
-    {
-        DOMNode* child=node->getFirstChild();
-        while(child)
-        {
-            if(child->getNodeType()==DOMNode::ELEMENT_NODE)
-                if(testNode(matcher, result, (DOMElement*)child))
-                    return true;
-            child=child->getNextSibling();
-        }
-    }
-    matcher->endElement(elemDecl, XMLUni::fgZeroLenString);
-    return false;
-}
-
 void DOMXPathExpressionImpl::release()
 {
     DOMXPathExpressionImpl* me = this;
@@ -28,12 +28,8 @@
 
 namespace XERCES_CPP_NAMESPACE {
 
-class DOMElement;
-class XercesXPath;
-class XPathMatcher;
-class DOMXPathResultImpl;
+class DOMXPathPlan;
 class DOMXPathNSResolver;
-class XMLStringPool;
 
 class CDOM_EXPORT DOMXPathExpressionImpl :  public XMemory,
                                             public DOMXPathExpression
@@ -51,15 +47,7 @@ public:
     virtual void release();
 
 protected:
-    bool testNode(XPathMatcher* matcher,
-                  DOMXPathResultImpl* result,
-                  DOMElement *node) const;
-    void cleanUp();
-
-    XMLStringPool*              fStringPool;
-    XercesXPath*                fParsedExpression;
-    XMLCh*                      fExpression;
-    bool                        fMoveToRoot;
+    DOMXPathPlan*               fPlan;
 
     MemoryManager* const        fMemoryManager;
 };
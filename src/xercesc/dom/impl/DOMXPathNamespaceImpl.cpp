@@ -0,0 +1,159 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+#include "DOMDocumentImpl.hpp"
+#include "DOMXPathNamespaceImpl.hpp"
+#include <xercesc/dom/DOMException.hpp>
+#include <xercesc/dom/DOMElement.hpp>
+#include <xercesc/util/XMLString.hpp>
+#include <xercesc/util/XMLUniDefs.hpp>
+
+namespace XERCES_CPP_NAMESPACE {
+
+static const XMLCh gNamespaceNodeName[] =
+{
+    chPound, chLatin_n, chLatin_a, chLatin_m, chLatin_e, chLatin_s, chLatin_p,
+    chLatin_a, chLatin_c, chLatin_e, chNull
+};
+
+DOMXPathNamespaceImpl::DOMXPathNamespaceImpl(DOMDocument *ownerDoc,
+                                             DOMElement *owner,
+                                             const XMLCh *prefix,
+                                             const XMLCh *uri,
+                                             MemoryManager* const manager)
+    : fNode(this, ownerDoc), fOwnerElement(owner), fPrefix(0), fURI(0), fMemoryManager(manager)
+{
+    fNode.setIsLeafNode(true);
+    fNode.isReadOnly(true);
+    if (prefix && *prefix)
+        fPrefix = XMLString::replicate(prefix, fMemoryManager);
+    fURI = XMLString::replicate(uri, fMemoryManager);
+}
+
+DOMXPathNamespaceImpl::~DOMXPathNamespaceImpl()
+{
+    // Drop any user data the application attached to the node.
+    if (fNode.hasUserData())
+        fNode.callUserDataHandlers(DOMUserDataHandler::NODE_DELETED, 0, 0);
+    XMLString::release(&fPrefix, fMemoryManager);
+    XMLString::release(&fURI, fMemoryManager);
+}
+
+
+DOMNode *DOMXPathNamespaceImpl::cloneNode(bool /*deep*/) const
+{
+    throw DOMException(DOMException::NOT_SUPPORTED_ERR, 0, GetDOMNodeMemoryManager);
+}
+
+const XMLCh * DOMXPathNamespaceImpl::getNodeName() const {
+    return gNamespaceNodeName;
+}
+
+DOMNode::NodeType DOMXPathNamespaceImpl::getNodeType() const {
+    return (DOMNode::NodeType)DOMXPathNamespace::XPATH_NAMESPACE_NODE;
+}
+
+const XMLCh * DOMXPathNamespaceImpl::getLocalName() const {
+    return fPrefix;
+}
+
+const XMLCh * DOMXPathNamespaceImpl::getPrefix() const {
+    return fPrefix;
+}
+
+const XMLCh * DOMXPathNamespaceImpl::getNamespaceURI() const {
+    return fURI;
+}
+
+const XMLCh * DOMXPathNamespaceImpl::getNodeValue() const {
+    return fURI;
+}
+
+const XMLCh * DOMXPathNamespaceImpl::getTextContent() const {
+    return fURI;
+}
+
+DOMElement * DOMXPathNamespaceImpl::getOwnerElement() const {
+    return fOwnerElement;
+}
+
+void DOMXPathNamespaceImpl::setNodeValue(const XMLCh *)
+{
+    throw DOMException(DOMException::NO_MODIFICATION_ALLOWED_ERR, 0, GetDOMNodeMemoryManager);
+}
+
+void DOMXPathNamespaceImpl::setPrefix(const XMLCh *)
+{
+    throw DOMException(DOMException::NO_MODIFICATION_ALLOWED_ERR, 0, GetDOMNodeMemoryManager);
+}
+
+void DOMXPathNamespaceImpl::setTextContent(const XMLCh *)
+{
+    throw DOMException(DOMException::NO_MODIFICATION_ALLOWED_ERR, 0, GetDOMNodeMemoryManager);
+}
+
+void DOMXPathNamespaceImpl::release()
+{
+    // The node is owned by the DOMXPathResult it was returned in and is
+    // deleted together with it.
+    fNode.callUserDataHandlers(DOMUserDataHandler::NODE_DELETED, 0, 0);
+}
+
+const XMLCh* DOMXPathNamespaceImpl::getBaseURI() const
+{
+    return 0;
+}
+
+
+           DOMNode*         DOMXPathNamespaceImpl::appendChild(DOMNode *newChild)          {return fNode.appendChild (newChild); }
+           DOMNamedNodeMap* DOMXPathNamespaceImpl::getAttributes() const                   {return fNode.getAttributes (); }
+           DOMNodeList*     DOMXPathNamespaceImpl::getChildNodes() const                   {return fNode.getChildNodes (); }
+           DOMNode*         DOMXPathNamespaceImpl::getFirstChild() const                   {return fNode.getFirstChild (); }
+           DOMNode*         DOMXPathNamespaceImpl::getLastChild() const                    {return fNode.getLastChild (); }
+           DOMNode*         DOMXPathNamespaceImpl::getNextSibling() const                  {return fNode.getNextSibling (); }
+           DOMDocument*     DOMXPathNamespaceImpl::getOwnerDocument() const                {return fNode.getOwnerDocument (); }
+           DOMNode*         DOMXPathNamespaceImpl::getParentNode() const                   {return fNode.getParentNode (); }
+           DOMNode*         DOMXPathNamespaceImpl::getPreviousSibling() const              {return fNode.getPreviousSibling (); }
+           bool             DOMXPathNamespaceImpl::hasChildNodes() const                   {return fNode.hasChildNodes (); }
+           DOMNode*         DOMXPathNamespaceImpl::insertBefore(DOMNode *newChild, DOMNode *refChild)
+                                                                                           {return fNode.insertBefore (newChild, refChild); }
+           void             DOMXPathNamespaceImpl::normalize()                             {fNode.normalize (); }
+           DOMNode*         DOMXPathNamespaceImpl::removeChild(DOMNode *oldChild)          {return fNode.removeChild (oldChild); }
+           DOMNode*         DOMXPathNamespaceImpl::replaceChild(DOMNode *newChild, DOMNode *oldChild)
+                                                                                           {return fNode.replaceChild (newChild, oldChild); }
+           bool             DOMXPathNamespaceImpl::isSupported(const XMLCh *feature, const XMLCh *version) const
+                                                                                           {return fNode.isSupported (feature, version); }
+           bool             DOMXPathNamespaceImpl::hasAttributes() const                   {return fNode.hasAttributes(); }
+           bool             DOMXPathNamespaceImpl::isSameNode(const DOMNode* other) const  {return fNode.isSameNode(other); }
+           bool             DOMXPathNamespaceImpl::isEqualNode(const DOMNode* arg) const   {return fNode.isEqualNode(arg); }
+           void*            DOMXPathNamespaceImpl::setUserData(const XMLCh* key, void* data, DOMUserDataHandler* handler)
+                                                                                           {return fNode.setUserData(key, data, handler); }
+           void*            DOMXPathNamespaceImpl::getUserData(const XMLCh* key) const     {return fNode.getUserData(key); }
+           short            DOMXPathNamespaceImpl::compareDocumentPosition(const DOMNode* other) const {return fNode.compareDocumentPosition(other); }
+           const XMLCh*     DOMXPathNamespaceImpl::lookupPrefix(const XMLCh* namespaceURI) const  {return fNode.lookupPrefix(namespaceURI); }
+           bool             DOMXPathNamespaceImpl::isDefaultNamespace(const XMLCh* namespaceURI) const {return fNode.isDefaultNamespace(namespaceURI); }
+           const XMLCh*     DOMXPathNamespaceImpl::lookupNamespaceURI(const XMLCh* prefix) const  {return fNode.lookupNamespaceURI(prefix); }
+           void*            DOMXPathNamespaceImpl::getFeature(const XMLCh* feature, const XMLCh* version) const {return fNode.getFeature(feature, version); }
+
+// Macro-in implementation accessors.
+DOMNODEIMPL_IMPL(DOMXPathNamespaceImpl);
+
+
+}
@@ -0,0 +1,88 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ * 
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+#if !defined(XERCESC_INCLUDE_GUARD_DOMXPATHNAMESPACEIMPL_HPP)
+#define XERCESC_INCLUDE_GUARD_DOMXPATHNAMESPACEIMPL_HPP
+
+//
+//  This file is part of the internal implementation of the C++ XML DOM.
+//  It should NOT be included or used directly by application programs.
+//
+//  Applications should include the file <xercesc/dom/DOM.hpp> for the entire
+//  DOM API, or xercesc/dom/DOM*.hpp for individual DOM classes, where the class
+//  name is substituded for the *.
+//
+
+#include <xercesc/util/XercesDefs.hpp>
+#include <xercesc/util/XMemory.hpp>
+#include <xercesc/dom/DOMXPathNamespace.hpp>
+
+namespace XERCES_CPP_NAMESPACE {
+
+#include "DOMNodeBase.hpp"
+#include "DOMNodeImpl.hpp"
+
+class DOMDocument;
+class DOMElement;
+
+//
+//  Namespace node returned by the XPath evaluator for the namespace axis.
+//  DOM has no equivalent node type; these nodes are created on demand by
+//  an evaluation, are read-only and are never part of the tree. They are
+//  allocated from the evaluator's memory manager rather than the document
+//  heap, so evaluating an expression never modifies the document, and they
+//  are deleted together with the DOMXPathResult that holds them.
+//
+class CDOM_EXPORT DOMXPathNamespaceImpl: public XMemory, public DOMXPathNamespace, public HasDOMNodeImpl {
+public:
+    DOMNodeImpl      fNode;
+
+    DOMElement*   fOwnerElement;
+    XMLCh *       fPrefix;
+    XMLCh *       fURI;
+    MemoryManager* fMemoryManager;
+
+public:
+    DOMXPathNamespaceImpl(DOMDocument *ownerDoc, DOMElement *owner,
+                          const XMLCh *prefix, const XMLCh *uri,
+                          MemoryManager* const manager);
+
+    virtual ~DOMXPathNamespaceImpl();
+
+public:
+    // Declare all of the functions from DOMNode.
+    DOMNODE_FUNCTIONS;
+
+    // Add accessors for implementation bits.
+    DOMNODEIMPL_DECL;
+
+public:
+    virtual DOMElement *getOwnerElement() const;
+
+private:
+    // unimplemented
+    DOMXPathNamespaceImpl(const DOMXPathNamespaceImpl &other);
+    DOMXPathNamespaceImpl& operator= (const DOMXPathNamespaceImpl& other);
+};
+
+}
+
+#endif
@@ -0,0 +1,1325 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+#include "DOMXPathPlan.hpp"
+
+#include <xercesc/dom/DOMXPathException.hpp>
+#include <xercesc/dom/DOMXPathNSResolver.hpp>
+#include <xercesc/dom/DOMException.hpp>
+#include <xercesc/dom/DOMNode.hpp>
+#include <xercesc/framework/XMLBuffer.hpp>
+#include <xercesc/util/XMLChar.hpp>
+#include <xercesc/util/XMLString.hpp>
+#include <xercesc/util/XMLUniDefs.hpp>
+#include <xercesc/util/StringPool.hpp>
+#include <xercesc/util/Janitor.hpp>
+#include <xercesc/util/OutOfMemoryException.hpp>
+
+#include <limits>
+#include <locale.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace XERCES_CPP_NAMESPACE {
+
+// ---------------------------------------------------------------------------
+//  DOMXPathValue
+// ---------------------------------------------------------------------------
+DOMXPathValue::DOMXPathValue(ValueType type, MemoryManager* const manager)
+    : fType(type)
+    , fNumber(0)
+    , fBoolean(false)
+    , fString(0)
+    , fNodes(0)
+    , fNamespaceNodes(0)
+    , fMemoryManager(manager)
+{
+    if (fType == NODESET_VALUE)
+        fNodes = new (fMemoryManager) ValueVectorOf<DOMNode*>(8, fMemoryManager);
+}
+
+DOMXPathValue::~DOMXPathValue()
+{
+    if (fString)
+        fMemoryManager->deallocate(fString);
+    delete fNodes;
+    delete fNamespaceNodes;
+}
+
+DOMXPathValue::ValueType DOMXPathValue::getType() const
+{
+    return fType;
+}
+
+double DOMXPathValue::getNumber() const
+{
+    return fNumber;
+}
+
+bool DOMXPathValue::getBoolean() const
+{
+    return fBoolean;
+}
+
+const XMLCh* DOMXPathValue::getString() const
+{
+    return fString ? fString : XMLUni::fgZeroLenString;
+}
+
+ValueVectorOf<DOMNode*>* DOMXPathValue::getNodes() const
+{
+    return fNodes;
+}
+
+void DOMXPathValue::setNumber(double value)
+{
+    fNumber = value;
+}
+
+void DOMXPathValue::setBoolean(bool value)
+{
+    fBoolean = value;
+}
+
+void DOMXPathValue::setString(const XMLCh* value)
+{
+    if (fString)
+        fMemoryManager->deallocate(fString);
+    fString = XMLString::replicate(value, fMemoryManager);
+}
+
+void DOMXPathValue::adoptNodes(ValueVectorOf<DOMNode*>* nodes)
+{
+    delete fNodes;
+    fNodes = nodes;
+}
+
+ValueVectorOf<DOMNode*>* DOMXPathValue::orphanNodes()
+{
+    ValueVectorOf<DOMNode*>* nodes = fNodes;
+    fNodes = 0;
+    return nodes;
+}
+
+void DOMXPathValue::adoptNamespaceNodes(RefVectorOf<DOMNode>* nodes)
+{
+    delete fNamespaceNodes;
+    fNamespaceNodes = nodes;
+}
+
+RefVectorOf<DOMNode>* DOMXPathValue::orphanNamespaceNodes()
+{
+    RefVectorOf<DOMNode>* nodes = fNamespaceNodes;
+    fNamespaceNodes = 0;
+    return nodes;
+}
+
+bool DOMXPathValue::toBoolean() const
+{
+    switch (fType)
+    {
+    case NODESET_VALUE:
+        return fNodes->size() != 0;
+    case NUMBER_VALUE:
+        return fNumber != 0 && fNumber == fNumber;
+    case STRING_VALUE:
+        return fString != 0 && *fString != 0;
+    default:
+        return fBoolean;
+    }
+}
+
+double DOMXPathValue::toNumber() const
+{
+    switch (fType)
+    {
+    case NODESET_VALUE:
+        {
+            XMLBuffer buf(1023, fMemoryManager);
+            toString(buf);
+            return stringToNumber(buf.getRawBuffer());
+        }
+    case NUMBER_VALUE:
+        return fNumber;
+    case STRING_VALUE:
+        return stringToNumber(getString());
+    default:
+        return fBoolean ? 1 : 0;
+    }
+}
+
+void DOMXPathValue::toString(XMLBuffer& toFill) const
+{
+    static const XMLCh gTrue[]  = { chLatin_t, chLatin_r, chLatin_u, chLatin_e, chNull };
+    static const XMLCh gFalse[] = { chLatin_f, chLatin_a, chLatin_l, chLatin_s, chLatin_e, chNull };
+
+    switch (fType)
+    {
+    case NODESET_VALUE:
+        if (fNodes->size() != 0)
+            stringValue(fNodes->elementAt(0), toFill);
+        break;
+    case NUMBER_VALUE:
+        numberToString(fNumber, toFill);
+        break;
+    case STRING_VALUE:
+        toFill.append(getString());
+        break;
+    default:
+        toFill.append(fBoolean ? gTrue : gFalse);
+        break;
+    }
+}
+
+//
+//  strtod() and printf() use the decimal point of the current C locale,
+//  while XPath numbers always use a period.
+//
+static char localeDecimalPoint()
+{
+    lconv* lc = localeconv();
+    return *lc->decimal_point;
+}
+
+//
+//  Implements the number() conversion of a string: optional whitespace, an
+//  optional minus sign, a Number (no exponent, no plus sign) and optional
+//  whitespace. Anything else is NaN.
+//
+double DOMXPathValue::stringToNumber(const XMLCh* str)
+{
+    const XMLCh* p = str;
+    while (*p && XMLChar1_0::isWhitespace(*p))
+        p++;
+
+    char buf[128];
+    XMLSize_t len = 0;
+    if (*p == chDash)
+        buf[len++] = '-', p++;
+
+    bool digits = false;
+    while (*p >= chDigit_0 && *p <= chDigit_9)
+    {
+        if (len < sizeof(buf) - 2)
+            buf[len++] = (char)*p;
+        p++;
+        digits = true;
+    }
+    if (*p == chPeriod)
+    {
+        if (len < sizeof(buf) - 2)
+            buf[len++] = localeDecimalPoint();
+        p++;
+        while (*p >= chDigit_0 && *p <= chDigit_9)
+        {
+            if (len < sizeof(buf) - 2)
+                buf[len++] = (char)*p;
+            p++;
+            digits = true;
+        }
+    }
+    while (*p && XMLChar1_0::isWhitespace(*p))
+        p++;
+
+    if (!digits || *p != 0)
+        return std::numeric_limits<double>::quiet_NaN();
+
+    // Very long numerals lose digits past the buffer, fall back to the
+    // slow path so the value stays exact.
+    if (len >= sizeof(buf) - 2)
+    {
+        char* tmp = XMLString::transcode(str, XMLPlatformUtils::fgMemoryManager);
+        char* period = strchr(tmp, '.');
+        if (period)
+            *period = localeDecimalPoint();
+        double val = strtod(tmp, 0);
+        XMLString::release(&tmp, XMLPlatformUtils::fgMemoryManager);
+        return val;
+    }
+
+    buf[len] = 0;
+    return strtod(buf, 0);
+}
+
+//
+//  Formats a number the way the string() function does: NaN, Infinity,
+//  integers without a decimal point and everything else in plain decimal
+//  notation with just enough digits to round-trip.
+//
+void DOMXPathValue::numberToString(double value, XMLBuffer& toFill)
+{
+    static const XMLCh gNaN[] = { chLatin_N, chLatin_a, chLatin_N, chNull };
+    static const XMLCh gInfinity[] = { chLatin_I, chLatin_n, chLatin_f, chLatin_i, chLatin_n, chLatin_i, chLatin_t, chLatin_y, chNull };
+
+    if (value != value)
+    {
+        toFill.append(gNaN);
+        return;
+    }
+    if (value == std::numeric_limits<double>::infinity() || value == -std::numeric_limits<double>::infinity())
+    {
+        if (value < 0)
+            toFill.append(chDash);
+        toFill.append(gInfinity);
+        return;
+    }
+    if (value == 0)
+    {
+        // This also covers negative zero.
+        toFill.append(chDigit_0);
+        return;
+    }
+
+    char digits[64];
+    int precision;
+    for (precision = 1; precision < 17; precision++)
+    {
+        snprintf(digits, sizeof(digits), "%.*e", precision - 1, value);
+        if (strtod(digits, 0) == value)
+            break;
+    }
+    snprintf(digits, sizeof(digits), "%.*e", precision - 1, value);
+
+    // digits now looks like [-]d[.ddd]e[+-]xx, where the decimal point is
+    // the one of the current locale; expand it into plain decimal notation.
+    const char* p = digits;
+    if (*p == '-')
+    {
+        toFill.append(chDash);
+        p++;
+    }
+
+    char mantissa[32];
+    int mantLen = 0;
+    for (; *p && *p != 'e'; p++)
+        if (*p >= '0' && *p <= '9')
+            mantissa[mantLen++] = *p;
+    while (mantLen > 1 && mantissa[mantLen - 1] == '0')
+        mantLen--;
+    int exponent = atoi(p + 1);
+
+    if (exponent < 0)
+    {
+        toFill.append(chDigit_0);
+        toFill.append(chPeriod);
+        for (int i = -1; i > exponent; i--)
+            toFill.append(chDigit_0);
+        for (int i = 0; i < mantLen; i++)
+            toFill.append((XMLCh)mantissa[i]);
+    }
+    else
+    {
+        for (int i = 0; i <= exponent || i < mantLen; i++)
+        {
+            if (i == exponent + 1)
+                toFill.append(chPeriod);
+            toFill.append(i < mantLen ? (XMLCh)mantissa[i] : chDigit_0);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+//  DOMXPathStep and DOMXPathOp
+// ---------------------------------------------------------------------------
+DOMXPathStep::DOMXPathStep(Axis axis, NodeTest test, MemoryManager* const manager)
+    : fAxis(axis)
+    , fTest(test)
+    , fURI(0)
+    , fLocalName(0)
+    , fAnyURI(false)
+    , fPositional(false)
+    , fPredicates(0)
+{
+    fPredicates = new (manager) RefVectorOf<DOMXPathOp>(2, true, manager);
+}
+
+DOMXPathStep::~DOMXPathStep()
+{
+    delete fPredicates;
+}
+
+bool DOMXPathStep::isReverseAxis() const
+{
+    return fAxis == AXIS_ANCESTOR || fAxis == AXIS_ANCESTOR_OR_SELF ||
+           fAxis == AXIS_PRECEDING || fAxis == AXIS_PRECEDING_SIBLING;
+}
+
+DOMXPathOp::DOMXPathOp(OpType type, DOMXPathValue::ValueType resultType, MemoryManager* const manager)
+    : fType(type)
+    , fResultType(resultType)
+    , fLeft(0)
+    , fRight(0)
+    , fNumber(0)
+    , fLiteral(0)
+    , fFunction(FN_LAST)
+    , fArgs(0)
+    , fAbsolute(false)
+    , fSteps(0)
+    , fMemoryManager(manager)
+{
+}
+
+DOMXPathOp::~DOMXPathOp()
+{
+    delete fLeft;
+    delete fRight;
+    if (fLiteral)
+        fMemoryManager->deallocate(fLiteral);
+    delete fArgs;
+    delete fSteps;
+}
+
+// ---------------------------------------------------------------------------
+//  Local data: lexer tokens and the core function table
+// ---------------------------------------------------------------------------
+namespace {
+
+enum TokenType {
+    TK_END,
+    TK_LPAREN,
+    TK_RPAREN,
+    TK_LBRACKET,
+    TK_RBRACKET,
+    TK_DOT,
+    TK_DOTDOT,
+    TK_AT,
+    TK_COMMA,
+    TK_DCOLON,
+    TK_SLASH,
+    TK_DSLASH,
+    TK_PIPE,
+    TK_PLUS,
+    TK_MINUS,
+    TK_EQ,
+    TK_NE,
+    TK_LT,
+    TK_LE,
+    TK_GT,
+    TK_GE,
+    TK_MULTIPLY,
+    TK_AND,
+    TK_OR,
+    TK_MOD,
+    TK_DIV,
+    TK_NAMETEST,        // '*', 'prefix:*' or a QName
+    TK_NODETYPE,        // comment, text, processing-instruction, node
+    TK_FUNCTIONNAME,
+    TK_AXISNAME,
+    TK_LITERAL,
+    TK_NUMBER,
+    TK_VARIABLE
+};
+
+struct XPathToken
+{
+    TokenType   fType;
+    XMLSize_t   fStart;     // offset of the token (literal: of its content)
+    XMLSize_t   fLength;
+    XMLSize_t   fColon;     // QNames: offset of the ':' relative to fStart, 0 if none
+    double      fNumber;
+};
+
+struct XPathFunctionInfo
+{
+    const char*                 fName;
+    DOMXPathOp::Function        fFunction;
+    unsigned int                fMinArgs;
+    unsigned int                fMaxArgs;   // ~0 for unbounded
+    DOMXPathValue::ValueType    fResultType;
+};
+
+const XPathFunctionInfo gFunctions[] =
+{
+    { "last",             DOMXPathOp::FN_LAST,             0, 0,  DOMXPathValue::NUMBER_VALUE  },
+    { "position",         DOMXPathOp::FN_POSITION,         0, 0,  DOMXPathValue::NUMBER_VALUE  },
+    { "count",            DOMXPathOp::FN_COUNT,            1, 1,  DOMXPathValue::NUMBER_VALUE  },
+    { "id",               DOMXPathOp::FN_ID,               1, 1,  DOMXPathValue::NODESET_VALUE },
+    { "local-name",       DOMXPathOp::FN_LOCAL_NAME,       0, 1,  DOMXPathValue::STRING_VALUE  },
+    { "namespace-uri",    DOMXPathOp::FN_NAMESPACE_URI,    0, 1,  DOMXPathValue::STRING_VALUE  },
+    { "name",             DOMXPathOp::FN_NAME,             0, 1,  DOMXPathValue::STRING_VALUE  },
+    { "string",           DOMXPathOp::FN_STRING,           0, 1,  DOMXPathValue::STRING_VALUE  },
+    { "concat",           DOMXPathOp::FN_CONCAT,           2, ~0u, DOMXPathValue::STRING_VALUE },
+    { "starts-with",      DOMXPathOp::FN_STARTS_WITH,      2, 2,  DOMXPathValue::BOOLEAN_VALUE },
+    { "contains",         DOMXPathOp::FN_CONTAINS,         2, 2,  DOMXPathValue::BOOLEAN_VALUE },
+    { "substring-before", DOMXPathOp::FN_SUBSTRING_BEFORE, 2, 2,  DOMXPathValue::STRING_VALUE  },
+    { "substring-after",  DOMXPathOp::FN_SUBSTRING_AFTER,  2, 2,  DOMXPathValue::STRING_VALUE  },
+    { "substring",        DOMXPathOp::FN_SUBSTRING,        2, 3,  DOMXPathValue::STRING_VALUE  },
+    { "string-length",    DOMXPathOp::FN_STRING_LENGTH,    0, 1,  DOMXPathValue::NUMBER_VALUE  },
+    { "normalize-space",  DOMXPathOp::FN_NORMALIZE_SPACE,  0, 1,  DOMXPathValue::STRING_VALUE  },
+    { "translate",        DOMXPathOp::FN_TRANSLATE,        3, 3,  DOMXPathValue::STRING_VALUE  },
+    { "boolean",          DOMXPathOp::FN_BOOLEAN,          1, 1,  DOMXPathValue::BOOLEAN_VALUE },
+    { "not",              DOMXPathOp::FN_NOT,              1, 1,  DOMXPathValue::BOOLEAN_VALUE },
+    { "true",             DOMXPathOp::FN_TRUE,             0, 0,  DOMXPathValue::BOOLEAN_VALUE },
+    { "false",            DOMXPathOp::FN_FALSE,            0, 0,  DOMXPathValue::BOOLEAN_VALUE },
+    { "lang",             DOMXPathOp::FN_LANG,             1, 1,  DOMXPathValue::BOOLEAN_VALUE },
+    { "number",           DOMXPathOp::FN_NUMBER,           0, 1,  DOMXPathValue::NUMBER_VALUE  },
+    { "sum",              DOMXPathOp::FN_SUM,              1, 1,  DOMXPathValue::NUMBER_VALUE  },
+    { "floor",            DOMXPathOp::FN_FLOOR,            1, 1,  DOMXPathValue::NUMBER_VALUE  },
+    { "ceiling",          DOMXPathOp::FN_CEILING,          1, 1,  DOMXPathValue::NUMBER_VALUE  },
+    { "round",            DOMXPathOp::FN_ROUND,            1, 1,  DOMXPathValue::NUMBER_VALUE  }
+};
+
+const XMLSize_t gFunctionCount = sizeof(gFunctions) / sizeof(gFunctions[0]);
+
+struct XPathAxisInfo
+{
+    const char*         fName;
+    DOMXPathStep::Axis  fAxis;
+};
+
+const XPathAxisInfo gAxes[] =
+{
+    { "ancestor",           DOMXPathStep::AXIS_ANCESTOR           },
+    { "ancestor-or-self",   DOMXPathStep::AXIS_ANCESTOR_OR_SELF   },
+    { "attribute",          DOMXPathStep::AXIS_ATTRIBUTE          },
+    { "child",              DOMXPathStep::AXIS_CHILD              },
+    { "descendant",         DOMXPathStep::AXIS_DESCENDANT         },
+    { "descendant-or-self", DOMXPathStep::AXIS_DESCENDANT_OR_SELF },
+    { "following",          DOMXPathStep::AXIS_FOLLOWING          },
+    { "following-sibling",  DOMXPathStep::AXIS_FOLLOWING_SIBLING  },
+    { "namespace",          DOMXPathStep::AXIS_NAMESPACE          },
+    { "parent",             DOMXPathStep::AXIS_PARENT             },
+    { "preceding",          DOMXPathStep::AXIS_PRECEDING          },
+    { "preceding-sibling",  DOMXPathStep::AXIS_PRECEDING_SIBLING  },
+    { "self",               DOMXPathStep::AXIS_SELF               }
+};
+
+const XMLSize_t gAxisCount = sizeof(gAxes) / sizeof(gAxes[0]);
+
+// Compares a token with an ASCII keyword.
+bool matchesKeyword(const XMLCh* str, XMLSize_t len, const char* keyword)
+{
+    XMLSize_t i = 0;
+    for (; i < len; i++)
+        if (keyword[i] == 0 || str[i] != (XMLCh)keyword[i])
+            return false;
+    return keyword[i] == 0;
+}
+
+bool isXPathDigit(XMLCh ch)
+{
+    return ch >= chDigit_0 && ch <= chDigit_9;
+}
+
+// ---------------------------------------------------------------------------
+//  XPathCompiler: tokenizes the expression and builds the DOMXPathOp tree
+//  by recursive descent over the XPath 1.0 grammar.
+// ---------------------------------------------------------------------------
+class XPathCompiler
+{
+public:
+    XPathCompiler(const XMLCh* expression,
+                  const DOMXPathNSResolver* resolver,
+                  XMLStringPool* pool,
+                  MemoryManager* const manager)
+        : fExpression(expression)
+        , fResolver(resolver)
+        , fStringPool(pool)
+        , fTokens(16, manager)
+        , fPos(0)
+        , fMemoryManager(manager)
+    {
+    }
+
+    DOMXPathOp* compile()
+    {
+        tokenize();
+        DOMXPathOp* op = parseOrExpr();
+        if (peek() != TK_END)
+        {
+            delete op;
+            invalid();
+        }
+        return op;
+    }
+
+private:
+    // -----------------------------------------------------------------------
+    //  Lexer
+    // -----------------------------------------------------------------------
+    void invalid() const
+    {
+        throw DOMXPathException(DOMXPathException::INVALID_EXPRESSION_ERR, 0, fMemoryManager);
+    }
+
+    void addToken(TokenType type, XMLSize_t start, XMLSize_t length, XMLSize_t colon = 0, double number = 0)
+    {
+        XPathToken tok;
+        tok.fType = type;
+        tok.fStart = start;
+        tok.fLength = length;
+        tok.fColon = colon;
+        tok.fNumber = number;
+        fTokens.addElement(tok);
+    }
+
+    //  Lexical disambiguation (XPath 1.0, section 3.7): if there is a
+    //  preceding token and it is not '@', '::', '(', '[', ',' or an
+    //  operator, then '*' is the multiply operator and an NCName is an
+    //  operator name.
+    bool operatorExpected() const
+    {
+        if (fTokens.size() == 0)
+            return false;
+        switch (fTokens.elementAt(fTokens.size() - 1).fType)
+        {
+        case TK_AT: case TK_DCOLON: case TK_LPAREN: case TK_LBRACKET: case TK_COMMA:
+        case TK_AND: case TK_OR: case TK_MOD: case TK_DIV: case TK_MULTIPLY:
+        case TK_SLASH: case TK_DSLASH: case TK_PIPE: case TK_PLUS: case TK_MINUS:
+        case TK_EQ: case TK_NE: case TK_LT: case TK_LE: case TK_GT: case TK_GE:
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    XMLSize_t scanNCName(XMLSize_t i) const
+    {
+        if (!XMLChar1_0::isFirstNCNameChar(fExpression[i]))
+            return i;
+        i++;
+        while (fExpression[i] && XMLChar1_0::isNCNameChar(fExpression[i]))
+            i++;
+        return i;
+    }
+
+    XMLSize_t skipSpace(XMLSize_t i) const
+    {
+        while (fExpression[i] && XMLChar1_0::isWhitespace(fExpression[i]))
+            i++;
+        return i;
+    }
+
+    void tokenize()
+    {
+        const XMLCh* expr = fExpression;
+        XMLSize_t i = 0;
+        for (;;)
+        {
+            i = skipSpace(i);
+            XMLCh ch = expr[i];
+            if (ch == 0)
+                break;
+
+            switch (ch)
+            {
+            case chOpenParen:   addToken(TK_LPAREN, i++, 1); continue;
+            case chCloseParen:  addToken(TK_RPAREN, i++, 1); continue;
+            case chOpenSquare:  addToken(TK_LBRACKET, i++, 1); continue;
+            case chCloseSquare: addToken(TK_RBRACKET, i++, 1); continue;
+            case chAt:          addToken(TK_AT, i++, 1); continue;
+            case chComma:       addToken(TK_COMMA, i++, 1); continue;
+            case chPipe:        addToken(TK_PIPE, i++, 1); continue;
+            case chPlus:        addToken(TK_PLUS, i++, 1); continue;
+            case chDash:        addToken(TK_MINUS, i++, 1); continue;
+            case chEqual:       addToken(TK_EQ, i++, 1); continue;
+            case chColon:
+                if (expr[i + 1] != chColon)
+                    invalid();
+                addToken(TK_DCOLON, i, 2);
+                i += 2;
+                continue;
+            case chForwardSlash:
+                if (expr[i + 1] == chForwardSlash)
+                {
+                    addToken(TK_DSLASH, i, 2);
+                    i += 2;
+                }
+                else
+                    addToken(TK_SLASH, i++, 1);
+                continue;
+            case chBang:
+                if (expr[i + 1] != chEqual)
+                    invalid();
+                addToken(TK_NE, i, 2);
+                i += 2;
+                continue;
+            case chOpenAngle:
+                if (expr[i + 1] == chEqual)
+                {
+                    addToken(TK_LE, i, 2);
+                    i += 2;
+                }
+                else
+                    addToken(TK_LT, i++, 1);
+                continue;
+            case chCloseAngle:
+                if (expr[i + 1] == chEqual)
+                {
+                    addToken(TK_GE, i, 2);
+                    i += 2;
+                }
+                else
+                    addToken(TK_GT, i++, 1);
+                continue;
+            case chAsterisk:
+                addToken(operatorExpected() ? TK_MULTIPLY : TK_NAMETEST, i++, 1);
+                continue;
+            case chDoubleQuote:
+            case chSingleQuote:
+                {
+                    XMLSize_t start = i + 1;
+                    XMLSize_t end = start;
+                    while (expr[end] && expr[end] != ch)
+                        end++;
+                    if (expr[end] != ch)
+                        invalid();
+                    addToken(TK_LITERAL, start, end - start);
+                    i = end + 1;
+                }
+                continue;
+            case chDollarSign:
+                {
+                    XMLSize_t end = scanNCName(i + 1);
+                    if (end == i + 1)
+                        invalid();
+                    if (expr[end] == chColon && expr[end + 1] != chColon)
+                    {
+                        XMLSize_t end2 = scanNCName(end + 1);
+                        if (end2 == end + 1)
+                            invalid();
+                        end = end2;
+                    }
+                    addToken(TK_VARIABLE, i, end - i);
+                    i = end;
+                }
+                continue;
+            default:
+                break;
+            }
+
+            if (ch == chPeriod && !isXPathDigit(expr[i + 1]))
+            {
+                if (expr[i + 1] == chPeriod)
+                {
+                    addToken(TK_DOTDOT, i, 2);
+                    i += 2;
+                }
+                else
+                    addToken(TK_DOT, i++, 1);
+                continue;
+            }
+
+            if (ch == chPeriod || isXPathDigit(ch))
+            {
+                XMLSize_t end = i;
+                while (isXPathDigit(expr[end]))
+                    end++;
+                if (expr[end] == chPeriod)
+                {
+                    end++;
+                    while (isXPathDigit(expr[end]))
+                        end++;
+                }
+                XMLBuffer buf(end - i + 1, fMemoryManager);
+                buf.append(expr + i, end - i);
+                addToken(TK_NUMBER, i, end - i, 0, DOMXPathValue::stringToNumber(buf.getRawBuffer()));
+                i = end;
+                continue;
+            }
+
+            XMLSize_t end = scanNCName(i);
+            if (end == i)
+                invalid();
+
+            if (operatorExpected())
+            {
+                XMLSize_t len = end - i;
+                if (matchesKeyword(expr + i, len, "and"))
+                    addToken(TK_AND, i, len);
+                else if (matchesKeyword(expr + i, len, "or"))
+                    addToken(TK_OR, i, len);
+                else if (matchesKeyword(expr + i, len, "mod"))
+                    addToken(TK_MOD, i, len);
+                else if (matchesKeyword(expr + i, len, "div"))
+                    addToken(TK_DIV, i, len);
+                else
+                    invalid();
+                i = end;
+                continue;
+            }
+
+            // prefix:* and prefix:local
+            XMLSize_t colon = 0;
+            if (expr[end] == chColon && expr[end + 1] != chColon)
+            {
+                if (expr[end + 1] == chAsterisk)
+                {
+                    addToken(TK_NAMETEST, i, end + 2 - i, end - i);
+                    i = end + 2;
+                    continue;
+                }
+                XMLSize_t end2 = scanNCName(end + 1);
+                if (end2 == end + 1)
+                    invalid();
+                colon = end - i;
+                end = end2;
+            }
+
+            XMLSize_t next = skipSpace(end);
+            if (expr[next] == chOpenParen)
+            {
+                XMLSize_t len = end - i;
+                if (colon == 0 &&
+                    (matchesKeyword(expr + i, len, "comment") ||
+                     matchesKeyword(expr + i, len, "text") ||
+                     matchesKeyword(expr + i, len, "processing-instruction") ||
+                     matchesKeyword(expr + i, len, "node")))
+                    addToken(TK_NODETYPE, i, len);
+                else
+                    addToken(TK_FUNCTIONNAME, i, len, colon);
+            }
+            else if (colon == 0 && expr[next] == chColon && expr[next + 1] == chColon)
+                addToken(TK_AXISNAME, i, end - i);
+            else
+                addToken(TK_NAMETEST, i, end - i, colon);
+            i = end;
+        }
+        addToken(TK_END, i, 0);
+    }
+
+    // -----------------------------------------------------------------------
+    //  Parser helpers
+    // -----------------------------------------------------------------------
+    TokenType peek(XMLSize_t ahead = 0) const
+    {
+        XMLSize_t index = fPos + ahead;
+        if (index >= fTokens.size())
+            return TK_END;
+        return fTokens.elementAt(index).fType;
+    }
+
+    const XPathToken& next()
+    {
+        const XPathToken& tok = fTokens.elementAt(fPos);
+        if (tok.fType != TK_END)
+            fPos++;
+        return tok;
+    }
+
+    void expect(TokenType type)
+    {
+        if (peek() != type)
+            invalid();
+        next();
+    }
+
+    const XMLCh* poolString(const XMLCh* str, XMLSize_t len)
+    {
+        XMLBuffer buf(len + 1, fMemoryManager);
+        buf.append(str, len);
+        return fStringPool->getValueForId(fStringPool->addOrFind(buf.getRawBuffer()));
+    }
+
+    const XMLCh* resolvePrefix(const XPathToken& tok)
+    {
+        XMLBuffer prefix(tok.fColon + 1, fMemoryManager);
+        prefix.append(fExpression + tok.fStart, tok.fColon);
+
+        if (fResolver == 0)
+            throw DOMException(DOMException::NAMESPACE_ERR, 0, fMemoryManager);
+        const XMLCh* uri = fResolver->lookupNamespaceURI(prefix.getRawBuffer());
+        if (uri == 0)
+            throw DOMException(DOMException::NAMESPACE_ERR, 0, fMemoryManager);
+        return fStringPool->getValueForId(fStringPool->addOrFind(uri));
+    }
+
+    DOMXPathOp* newOp(DOMXPathOp::OpType type, DOMXPathValue::ValueType resultType,
+                      DOMXPathOp* left = 0, DOMXPathOp* right = 0)
+    {
+        DOMXPathOp* op = new (fMemoryManager) DOMXPathOp(type, resultType, fMemoryManager);
+        op->fLeft = left;
+        op->fRight = right;
+        return op;
+    }
+
+    // Parses 'left (op right)*' where the operators are given by the
+    // callback; used for all left-associative binary levels.
+    typedef DOMXPathOp* (XPathCompiler::*ParseFn)();
+
+    DOMXPathOp* parseBinary(ParseFn operand, const TokenType* tokens,
+                            const DOMXPathOp::OpType* ops, XMLSize_t count,
+                            DOMXPathValue::ValueType resultType)
+    {
+        DOMXPathOp* left = (this->*operand)();
+        for (;;)
+        {
+            TokenType type = peek();
+            XMLSize_t i = 0;
+            while (i < count && tokens[i] != type)
+                i++;
+            if (i == count)
+                return left;
+            next();
+
+            Janitor<DOMXPathOp> janLeft(left);
+            DOMXPathOp* right = (this->*operand)();
+            janLeft.orphan();
+            left = newOp(ops[i], resultType, left, right);
+        }
+    }
+
+    // -----------------------------------------------------------------------
+    //  Grammar productions
+    // -----------------------------------------------------------------------
+    DOMXPathOp* parseOrExpr()
+    {
+        static const TokenType tokens[] = { TK_OR };
+        static const DOMXPathOp::OpType ops[] = { DOMXPathOp::OP_OR };
+        return parseBinary(&XPathCompiler::parseAndExpr, tokens, ops, 1, DOMXPathValue::BOOLEAN_VALUE);
+    }
+
+    DOMXPathOp* parseAndExpr()
+    {
+        static const TokenType tokens[] = { TK_AND };
+        static const DOMXPathOp::OpType ops[] = { DOMXPathOp::OP_AND };
+        return parseBinary(&XPathCompiler::parseEqualityExpr, tokens, ops, 1, DOMXPathValue::BOOLEAN_VALUE);
+    }
+
+    DOMXPathOp* parseEqualityExpr()
+    {
+        static const TokenType tokens[] = { TK_EQ, TK_NE };
+        static const DOMXPathOp::OpType ops[] = { DOMXPathOp::OP_EQ, DOMXPathOp::OP_NE };
+        return parseBinary(&XPathCompiler::parseRelationalExpr, tokens, ops, 2, DOMXPathValue::BOOLEAN_VALUE);
+    }
+
+    DOMXPathOp* parseRelationalExpr()
+    {
+        static const TokenType tokens[] = { TK_LT, TK_LE, TK_GT, TK_GE };
+        static const DOMXPathOp::OpType ops[] = { DOMXPathOp::OP_LT, DOMXPathOp::OP_LE, DOMXPathOp::OP_GT, DOMXPathOp::OP_GE };
+        return parseBinary(&XPathCompiler::parseAdditiveExpr, tokens, ops, 4, DOMXPathValue::BOOLEAN_VALUE);
+    }
+
+    DOMXPathOp* parseAdditiveExpr()
+    {
+        static const TokenType tokens[] = { TK_PLUS, TK_MINUS };
+        static const DOMXPathOp::OpType ops[] = { DOMXPathOp::OP_ADD, DOMXPathOp::OP_SUB };
+        return parseBinary(&XPathCompiler::parseMultiplicativeExpr, tokens, ops, 2, DOMXPathValue::NUMBER_VALUE);
+    }
+
+    DOMXPathOp* parseMultiplicativeExpr()
+    {
+        static const TokenType tokens[] = { TK_MULTIPLY, TK_DIV, TK_MOD };
+        static const DOMXPathOp::OpType ops[] = { DOMXPathOp::OP_MUL, DOMXPathOp::OP_DIV, DOMXPathOp::OP_MOD };
+        return parseBinary(&XPathCompiler::parseUnaryExpr, tokens, ops, 3, DOMXPathValue::NUMBER_VALUE);
+    }
+
+    DOMXPathOp* parseUnaryExpr()
+    {
+        if (peek() == TK_MINUS)
+        {
+            next();
+            return newOp(DOMXPathOp::OP_NEG, DOMXPathValue::NUMBER_VALUE, parseUnaryExpr());
+        }
+        return parseUnionExpr();
+    }
+
+    DOMXPathOp* parseUnionExpr()
+    {
+        static const TokenType tokens[] = { TK_PIPE };
+        static const DOMXPathOp::OpType ops[] = { DOMXPathOp::OP_UNION };
+        return parseBinary(&XPathCompiler::parsePathExpr, tokens, ops, 1, DOMXPathValue::NODESET_VALUE);
+    }
+
+    DOMXPathOp* parsePathExpr()
+    {
+        switch (peek())
+        {
+        case TK_LITERAL:
+        case TK_NUMBER:
+        case TK_LPAREN:
+        case TK_VARIABLE:
+        case TK_FUNCTIONNAME:
+            break;
+        default:
+            return parseLocationPath();
+        }
+
+        DOMXPathOp* filter = parseFilterExpr();
+        if (peek() != TK_SLASH && peek() != TK_DSLASH)
+            return filter;
+
+        DOMXPathOp* path = newOp(DOMXPathOp::OP_PATH, DOMXPathValue::NODESET_VALUE, filter);
+        Janitor<DOMXPathOp> janPath(path);
+        path->fSteps = new (fMemoryManager) RefVectorOf<DOMXPathStep>(4, true, fMemoryManager);
+        parseRelativeLocationPath(path, true);
+        return janPath.release();
+    }
+
+    DOMXPathOp* parseFilterExpr()
+    {
+        DOMXPathOp* primary = parsePrimaryExpr();
+        if (peek() != TK_LBRACKET)
+            return primary;
+
+        DOMXPathOp* filter = newOp(DOMXPathOp::OP_FILTER, DOMXPathValue::NODESET_VALUE, primary);
+        Janitor<DOMXPathOp> janFilter(filter);
+        filter->fArgs = new (fMemoryManager) RefVectorOf<DOMXPathOp>(2, true, fMemoryManager);
+        while (peek() == TK_LBRACKET)
+        {
+            next();
+            filter->fArgs->addElement(parseOrExpr());
+            expect(TK_RBRACKET);
+        }
+        return janFilter.release();
+    }
+
+    DOMXPathOp* parsePrimaryExpr()
+    {
+        const XPathToken& tok = next();
+        switch (tok.fType)
+        {
+        case TK_LPAREN:
+            {
+                DOMXPathOp* op = parseOrExpr();
+                Janitor<DOMXPathOp> janOp(op);
+                expect(TK_RPAREN);
+                return janOp.release();
+            }
+        case TK_LITERAL:
+            {
+                DOMXPathOp* op = newOp(DOMXPathOp::OP_LITERAL, DOMXPathValue::STRING_VALUE);
+                op->fLiteral = (XMLCh*)fMemoryManager->allocate((tok.fLength + 1) * sizeof(XMLCh));
+                XMLString::copyNString(op->fLiteral, fExpression + tok.fStart, tok.fLength);
+                op->fLiteral[tok.fLength] = chNull;
+                return op;
+            }
+        case TK_NUMBER:
+            {
+                DOMXPathOp* op = newOp(DOMXPathOp::OP_NUMBER, DOMXPathValue::NUMBER_VALUE);
+                op->fNumber = tok.fNumber;
+                return op;
+            }
+        case TK_FUNCTIONNAME:
+            return parseFunctionCall(tok);
+        default:
+            // Variable references cannot be bound through the DOM XPath
+            // API, so they are rejected like any other syntax error.
+            invalid();
+            return 0;
+        }
+    }
+
+    DOMXPathOp* parseFunctionCall(const XPathToken& tok)
+    {
+        const XPathFunctionInfo* info = 0;
+        if (tok.fColon == 0)
+        {
+            for (XMLSize_t i = 0; i < gFunctionCount; i++)
+                if (matchesKeyword(fExpression + tok.fStart, tok.fLength, gFunctions[i].fName))
+                {
+                    info = &gFunctions[i];
+                    break;
+                }
+        }
+        // Extension functions are not supported.
+        if (info == 0)
+            invalid();
+
+        DOMXPathOp* op = newOp(DOMXPathOp::OP_FUNCTION, info->fResultType);
+        Janitor<DOMXPathOp> janOp(op);
+        op->fFunction = info->fFunction;
+        op->fArgs = new (fMemoryManager) RefVectorOf<DOMXPathOp>(3, true, fMemoryManager);
+
+        expect(TK_LPAREN);
+        if (peek() != TK_RPAREN)
+        {
+            op->fArgs->addElement(parseOrExpr());
+            while (peek() == TK_COMMA)
+            {
+                next();
+                op->fArgs->addElement(parseOrExpr());
+            }
+        }
+        expect(TK_RPAREN);
+
+        XMLSize_t argCount = op->fArgs->size();
+        if (argCount < info->fMinArgs || argCount > info->fMaxArgs)
+            invalid();
+
+        // Functions that require a node-set argument.
+        if ((info->fFunction == DOMXPathOp::FN_COUNT || info->fFunction == DOMXPathOp::FN_SUM ||
+             info->fFunction == DOMXPathOp::FN_LOCAL_NAME || info->fFunction == DOMXPathOp::FN_NAMESPACE_URI ||
+             info->fFunction == DOMXPathOp::FN_NAME) &&
+            argCount == 1 && op->fArgs->elementAt(0)->fResultType != DOMXPathValue::NODESET_VALUE)
+            throw DOMXPathException(DOMXPathException::TYPE_ERR, 0, fMemoryManager);
+
+        return janOp.release();
+    }
+
+    DOMXPathOp* parseLocationPath()
+    {
+        DOMXPathOp* path = newOp(DOMXPathOp::OP_PATH, DOMXPathValue::NODESET_VALUE);
+        Janitor<DOMXPathOp> janPath(path);
+        path->fSteps = new (fMemoryManager) RefVectorOf<DOMXPathStep>(4, true, fMemoryManager);
+
+        if (peek() == TK_SLASH)
+        {
+            next();
+            path->fAbsolute = true;
+            if (startsStep())
+                parseRelativeLocationPath(path, false);
+        }
+        else if (peek() == TK_DSLASH)
+        {
+            path->fAbsolute = true;
+            parseRelativeLocationPath(path, true);
+        }
+        else
+            parseRelativeLocationPath(path, false);
+
+        return janPath.release();
+    }
+
+    bool startsStep() const
+    {
+        switch (peek())
+        {
+        case TK_DOT: case TK_DOTDOT: case TK_AT: case TK_AXISNAME:
+        case TK_NAMETEST: case TK_NODETYPE:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    //  Parses Step (('/' | '//') Step)*. If leadingSeparator is set the
+    //  path is expected to start with a '/' or '//' separator.
+    void parseRelativeLocationPath(DOMXPathOp* path, bool leadingSeparator)
+    {
+        bool needSeparator = leadingSeparator;
+        for (;;)
+        {
+            bool descendant = false;
+            if (needSeparator)
+            {
+                TokenType sep = peek();
+                if (sep == TK_DSLASH)
+                    descendant = true;
+                else if (sep != TK_SLASH)
+                    return;
+                next();
+            }
+            needSeparator = true;
+
+            DOMXPathStep* step = parseStep();
+            if (descendant)
+            {
+                // '//' abbreviates '/descendant-or-self::node()/'. A child
+                // step that doesn't look at positions can be folded into a
+                // single descendant step, which saves building the
+                // intermediate node-set of every node in the subtree.
+                if (step->fAxis == DOMXPathStep::AXIS_CHILD && !step->fPositional)
+                    step->fAxis = DOMXPathStep::AXIS_DESCENDANT;
+                else
+                {
+                    Janitor<DOMXPathStep> janStep(step);
+                    path->fSteps->addElement(new (fMemoryManager) DOMXPathStep(
+                        DOMXPathStep::AXIS_DESCENDANT_OR_SELF, DOMXPathStep::TEST_NODE, fMemoryManager));
+                    janStep.orphan();
+                }
+            }
+            path->fSteps->addElement(step);
+        }
+    }
+
+    DOMXPathStep* parseStep()
+    {
+        if (peek() == TK_DOT)
+        {
+            next();
+            return new (fMemoryManager) DOMXPathStep(DOMXPathStep::AXIS_SELF, DOMXPathStep::TEST_NODE, fMemoryManager);
+        }
+        if (peek() == TK_DOTDOT)
+        {
+            next();
+            return new (fMemoryManager) DOMXPathStep(DOMXPathStep::AXIS_PARENT, DOMXPathStep::TEST_NODE, fMemoryManager);
+        }
+
+        DOMXPathStep::Axis axis = DOMXPathStep::AXIS_CHILD;
+        if (peek() == TK_AT)
+        {
+            next();
+            axis = DOMXPathStep::AXIS_ATTRIBUTE;
+        }
+        else if (peek() == TK_AXISNAME)
+        {
+            const XPathToken& tok = next();
+            XMLSize_t i = 0;
+            while (i < gAxisCount && !matchesKeyword(fExpression + tok.fStart, tok.fLength, gAxes[i].fName))
+                i++;
+            if (i == gAxisCount)
+                invalid();
+            axis = gAxes[i].fAxis;
+            expect(TK_DCOLON);
+        }
+
+        DOMXPathStep* step = 0;
+        const XPathToken& tok = next();
+        if (tok.fType == TK_NAMETEST)
+        {
+            step = new (fMemoryManager) DOMXPathStep(axis, DOMXPathStep::TEST_NAME, fMemoryManager);
+            Janitor<DOMXPathStep> janStep(step);
+            const XMLCh* name = fExpression + tok.fStart;
+            if (tok.fLength == 1 && *name == chAsterisk)
+                step->fAnyURI = true;
+            else
+            {
+                XMLSize_t localStart = 0;
+                if (tok.fColon != 0)
+                {
+                    step->fURI = resolvePrefix(tok);
+                    localStart = tok.fColon + 1;
+                }
+                if (name[localStart] != chAsterisk)
+                    step->fLocalName = poolString(name + localStart, tok.fLength - localStart);
+            }
+            janStep.orphan();
+        }
+        else if (tok.fType == TK_NODETYPE)
+        {
+            const XMLCh* name = fExpression + tok.fStart;
+            DOMXPathStep::NodeTest test = DOMXPathStep::TEST_NODE;
+            if (matchesKeyword(name, tok.fLength, "comment"))
+                test = DOMXPathStep::TEST_COMMENT;
+            else if (matchesKeyword(name, tok.fLength, "text"))
+                test = DOMXPathStep::TEST_TEXT;
+            else if (matchesKeyword(name, tok.fLength, "processing-instruction"))
+                test = DOMXPathStep::TEST_PI;
+
+            step = new (fMemoryManager) DOMXPathStep(axis, test, fMemoryManager);
+            Janitor<DOMXPathStep> janStep(step);
+            expect(TK_LPAREN);
+            if (test == DOMXPathStep::TEST_PI && peek() == TK_LITERAL)
+            {
+                const XPathToken& lit = next();
+                step->fLocalName = poolString(fExpression + lit.fStart, lit.fLength);
+            }
+            expect(TK_RPAREN);
+            janStep.orphan();
+        }
+        else
+            invalid();
+
+        Janitor<DOMXPathStep> janStep(step);
+        while (peek() == TK_LBRACKET)
+        {
+            next();
+            DOMXPathOp* pred = parseOrExpr();
+            step->fPredicates->addElement(pred);
+            if (isPositional(pred))
+                step->fPositional = true;
+            expect(TK_RBRACKET);
+        }
+        return janStep.release();
+    }
+
+    //  A predicate is positional if its value is a number (it is then
+    //  compared with the context position) or if it calls position() or
+    //  last() in its own context.
+    static bool isPositional(const DOMXPathOp* pred)
+    {
+        return pred->fResultType == DOMXPathValue::NUMBER_VALUE ||
+               usesContextPosition(pred);
+    }
+
+    static bool usesContextPosition(const DOMXPathOp* op)
+    {
+        if (op == 0)
+            return false;
+        switch (op->fType)
+        {
+        case DOMXPathOp::OP_FUNCTION:
+            if (op->fFunction == DOMXPathOp::FN_LAST || op->fFunction == DOMXPathOp::FN_POSITION)
+                return true;
+            for (XMLSize_t i = 0; i < op->fArgs->size(); i++)
+                if (usesContextPosition(op->fArgs->elementAt(i)))
+                    return true;
+            return false;
+        case DOMXPathOp::OP_FILTER:
+        case DOMXPathOp::OP_PATH:
+            // Predicates and steps establish their own context.
+            return usesContextPosition(op->fLeft);
+        default:
+            return usesContextPosition(op->fLeft) || usesContextPosition(op->fRight);
+        }
+    }
+
+    const XMLCh*                fExpression;
+    const DOMXPathNSResolver*   fResolver;
+    XMLStringPool*              fStringPool;
+    ValueVectorOf<XPathToken>   fTokens;
+    XMLSize_t                   fPos;
+    MemoryManager*              fMemoryManager;
+};
+
+}
+
+// ---------------------------------------------------------------------------
+//  DOMXPathPlan: Constructors and Destructor
+// ---------------------------------------------------------------------------
+typedef JanitorMemFunCall<DOMXPathPlan> CleanupType;
+
+DOMXPathPlan::DOMXPathPlan(const XMLCh* expression,
+                           const DOMXPathNSResolver* resolver,
+                           MemoryManager* const manager)
+    : fRoot(0)
+    , fStringPool(0)
+    , fMemoryManager(manager)
+{
+    if (expression == 0 || *expression == 0)
+        throw DOMXPathException(DOMXPathException::INVALID_EXPRESSION_ERR, 0, fMemoryManager);
+
+    CleanupType cleanup(this, &DOMXPathPlan::cleanUp);
+    try
+    {
+        fStringPool = new (fMemoryManager) XMLStringPool(31, fMemoryManager);
+        XPathCompiler compiler(expression, resolver, fStringPool, fMemoryManager);
+        fRoot = compiler.compile();
+    }
+    catch(const OutOfMemoryException&)
+    {
+        cleanup.release();
+        throw;
+    }
+    cleanup.release();
+}
+
+DOMXPathPlan::~DOMXPathPlan()
+{
+    cleanUp();
+}
+
+void DOMXPathPlan::cleanUp()
+{
+    delete fRoot;
+    fRoot = 0;
+    delete fStringPool;
+    fStringPool = 0;
+}
+
+DOMXPathValue::ValueType DOMXPathPlan::getResultType() const
+{
+    return fRoot->fResultType;
+}
+
+}
@@ -0,0 +1,292 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ * 
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+#if !defined(XERCESC_INCLUDE_GUARD_DOMXPATHPLAN_HPP)
+#define XERCESC_INCLUDE_GUARD_DOMXPATHPLAN_HPP
+
+//
+//  This file is part of the internal implementation of the C++ XML DOM.
+//  It should NOT be included or used directly by application programs.
+//
+//  Applications should include the file <xercesc/dom/DOM.hpp> for the entire
+//  DOM API, or xercesc/dom/DOM*.hpp for individual DOM classes, where the class
+//  name is substituded for the *.
+//
+
+#include <xercesc/util/XMemory.hpp>
+#include <xercesc/util/PlatformUtils.hpp>
+#include <xercesc/util/RefVectorOf.hpp>
+#include <xercesc/util/ValueVectorOf.hpp>
+
+namespace XERCES_CPP_NAMESPACE {
+
+class DOMNode;
+class DOMXPathNSResolver;
+class XMLBuffer;
+class XMLStringPool;
+
+//
+//  The value of an XPath 1.0 expression: a node-set, a number, a string or
+//  a boolean. Node-sets are always kept in document order without
+//  duplicates.
+//
+class DOMXPathValue : public XMemory
+{
+public:
+    enum ValueType {
+        NODESET_VALUE,
+        NUMBER_VALUE,
+        STRING_VALUE,
+        BOOLEAN_VALUE
+    };
+
+    DOMXPathValue(ValueType type, MemoryManager* const manager);
+    ~DOMXPathValue();
+
+    ValueType getType() const;
+    double getNumber() const;
+    bool getBoolean() const;
+    const XMLCh* getString() const;
+    ValueVectorOf<DOMNode*>* getNodes() const;
+
+    void setNumber(double value);
+    void setBoolean(bool value);
+    void setString(const XMLCh* value);
+    void adoptNodes(ValueVectorOf<DOMNode*>* nodes);
+    ValueVectorOf<DOMNode*>* orphanNodes();
+
+    // The namespace nodes created while evaluating the expression; the
+    // value owns them so that node-sets may refer to them.
+    void adoptNamespaceNodes(RefVectorOf<DOMNode>* nodes);
+    RefVectorOf<DOMNode>* orphanNamespaceNodes();
+
+    // Conversions as performed by the boolean(), number() and string()
+    // core functions.
+    bool toBoolean() const;
+    double toNumber() const;
+    void toString(XMLBuffer& toFill) const;
+
+    static double stringToNumber(const XMLCh* str);
+    static void numberToString(double value, XMLBuffer& toFill);
+    static void stringValue(const DOMNode* node, XMLBuffer& toFill);
+
+private:
+    // unimplemented
+    DOMXPathValue(const DOMXPathValue&);
+    DOMXPathValue& operator=(const DOMXPathValue&);
+
+    ValueType                   fType;
+    double                      fNumber;
+    bool                        fBoolean;
+    XMLCh*                      fString;
+    ValueVectorOf<DOMNode*>*    fNodes;
+    RefVectorOf<DOMNode>*       fNamespaceNodes;
+    MemoryManager*              fMemoryManager;
+};
+
+class DOMXPathOp;
+
+//
+//  One location step: axis, node test and predicates.
+//
+class DOMXPathStep : public XMemory
+{
+public:
+    enum Axis {
+        AXIS_ANCESTOR,
+        AXIS_ANCESTOR_OR_SELF,
+        AXIS_ATTRIBUTE,
+        AXIS_CHILD,
+        AXIS_DESCENDANT,
+        AXIS_DESCENDANT_OR_SELF,
+        AXIS_FOLLOWING,
+        AXIS_FOLLOWING_SIBLING,
+        AXIS_NAMESPACE,
+        AXIS_PARENT,
+        AXIS_PRECEDING,
+        AXIS_PRECEDING_SIBLING,
+        AXIS_SELF
+    };
+
+    enum NodeTest {
+        TEST_NAME,
+        TEST_NODE,
+        TEST_TEXT,
+        TEST_COMMENT,
+        TEST_PI
+    };
+
+    DOMXPathStep(Axis axis, NodeTest test, MemoryManager* const manager);
+    ~DOMXPathStep();
+
+    bool isReverseAxis() const;
+
+    //  fURI, fLocalName
+    //      For TEST_NAME the expanded name to match; a null fLocalName
+    //      stands for '*'. When fAnyURI is set the namespace is not
+    //      checked at all (a bare '*'). For TEST_PI fLocalName is the
+    //      optional target literal. Strings belong to the plan's pool.
+    //
+    //  fPositional
+    //      True if one of the predicates depends on the context position
+    //      or size, i.e. the step cannot be evaluated node by node.
+    Axis                        fAxis;
+    NodeTest                    fTest;
+    const XMLCh*                fURI;
+    const XMLCh*                fLocalName;
+    bool                        fAnyURI;
+    bool                        fPositional;
+    RefVectorOf<DOMXPathOp>*    fPredicates;
+
+private:
+    // unimplemented
+    DOMXPathStep(const DOMXPathStep&);
+    DOMXPathStep& operator=(const DOMXPathStep&);
+};
+
+//
+//  A node of the compiled expression tree.
+//
+class DOMXPathOp : public XMemory
+{
+public:
+    enum OpType {
+        OP_OR,
+        OP_AND,
+        OP_EQ,
+        OP_NE,
+        OP_LT,
+        OP_LE,
+        OP_GT,
+        OP_GE,
+        OP_ADD,
+        OP_SUB,
+        OP_MUL,
+        OP_DIV,
+        OP_MOD,
+        OP_NEG,
+        OP_UNION,
+        OP_LITERAL,
+        OP_NUMBER,
+        OP_FUNCTION,
+        OP_FILTER,
+        OP_PATH
+    };
+
+    enum Function {
+        FN_LAST,
+        FN_POSITION,
+        FN_COUNT,
+        FN_ID,
+        FN_LOCAL_NAME,
+        FN_NAMESPACE_URI,
+        FN_NAME,
+        FN_STRING,
+        FN_CONCAT,
+        FN_STARTS_WITH,
+        FN_CONTAINS,
+        FN_SUBSTRING_BEFORE,
+        FN_SUBSTRING_AFTER,
+        FN_SUBSTRING,
+        FN_STRING_LENGTH,
+        FN_NORMALIZE_SPACE,
+        FN_TRANSLATE,
+        FN_BOOLEAN,
+        FN_NOT,
+        FN_TRUE,
+        FN_FALSE,
+        FN_LANG,
+        FN_NUMBER,
+        FN_SUM,
+        FN_FLOOR,
+        FN_CEILING,
+        FN_ROUND
+    };
+
+    DOMXPathOp(OpType type, DOMXPathValue::ValueType resultType, MemoryManager* const manager);
+    ~DOMXPathOp();
+
+    //  fResultType
+    //      The static type of the value this operation produces.
+    //
+    //  fLeft, fRight
+    //      Operands of binary operators; fLeft is also the operand of
+    //      OP_NEG, the primary expression of OP_FILTER and the optional
+    //      filter expression a OP_PATH starts from.
+    //
+    //  fArgs
+    //      Function arguments for OP_FUNCTION, predicates for OP_FILTER.
+    //
+    //  fAbsolute, fSteps
+    //      OP_PATH only: whether the path starts at the root, and its
+    //      location steps.
+    OpType                      fType;
+    DOMXPathValue::ValueType    fResultType;
+    DOMXPathOp*                 fLeft;
+    DOMXPathOp*                 fRight;
+    double                      fNumber;
+    XMLCh*                      fLiteral;
+    Function                    fFunction;
+    RefVectorOf<DOMXPathOp>*    fArgs;
+    bool                        fAbsolute;
+    RefVectorOf<DOMXPathStep>*  fSteps;
+    MemoryManager*              fMemoryManager;
+
+private:
+    // unimplemented
+    DOMXPathOp(const DOMXPathOp&);
+    DOMXPathOp& operator=(const DOMXPathOp&);
+};
+
+//
+//  A compiled XPath 1.0 expression. The expression is parsed once into a
+//  tree of DOMXPathOp; evaluate() does not modify the plan so a plan can
+//  be evaluated concurrently against different context nodes.
+//
+class DOMXPathPlan : public XMemory
+{
+public:
+    DOMXPathPlan(const XMLCh* expression,
+                 const DOMXPathNSResolver* resolver,
+                 MemoryManager* const manager = XMLPlatformUtils::fgMemoryManager);
+    ~DOMXPathPlan();
+
+    // Returns the static type of the expression.
+    DOMXPathValue::ValueType getResultType() const;
+
+    // Evaluates the expression; the caller adopts the returned value.
+    DOMXPathValue* evaluate(const DOMNode* contextNode) const;
+
+private:
+    // unimplemented
+    DOMXPathPlan(const DOMXPathPlan&);
+    DOMXPathPlan& operator=(const DOMXPathPlan&);
+
+    void cleanUp();
+
+    DOMXPathOp*                 fRoot;
+    XMLStringPool*              fStringPool;
+    MemoryManager*              fMemoryManager;
+};
+
+}
+
+#endif
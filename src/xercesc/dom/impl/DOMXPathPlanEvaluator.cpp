@@ -0,0 +1,1681 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+//
+//  Evaluation of compiled XPath 1.0 expressions (see DOMXPathPlan.cpp for
+//  the compiler) against the DOM.
+//
+//  The DOM is mapped onto the XPath data model as follows: entity
+//  reference nodes are transparent (their children appear in place of
+//  them), the document type node is not part of the tree, and adjacent
+//  text and CDATA section nodes form a single text node which is
+//  represented by the first of them. Namespace nodes are created on demand
+//  as DOMXPathNamespace nodes owned by the evaluation; the document itself
+//  is never written to, so one document may be queried from several
+//  threads at once.
+//
+
+#include "DOMXPathPlan.hpp"
+#include "DOMDocumentImpl.hpp"
+#include "DOMXPathNamespaceImpl.hpp"
+
+#include <xercesc/dom/DOMAttr.hpp>
+#include <xercesc/dom/DOMDocument.hpp>
+#include <xercesc/dom/DOMElement.hpp>
+#include <xercesc/dom/DOMException.hpp>
+#include <xercesc/dom/DOMNamedNodeMap.hpp>
+#include <xercesc/dom/DOMNode.hpp>
+#include <xercesc/dom/DOMXPathException.hpp>
+#include <xercesc/dom/DOMXPathNamespace.hpp>
+#include <xercesc/framework/XMLBuffer.hpp>
+#include <xercesc/util/Janitor.hpp>
+#include <xercesc/util/RefArrayVectorOf.hpp>
+#include <xercesc/util/RefHashTableOf.hpp>
+#include <xercesc/util/ValueHashTableOf.hpp>
+#include <xercesc/util/XMLString.hpp>
+#include <xercesc/util/XMLUni.hpp>
+#include <xercesc/util/XMLUniDefs.hpp>
+
+#include <limits>
+#include <math.h>
+
+namespace XERCES_CPP_NAMESPACE {
+
+namespace {
+
+//  Node-sets at least this large that are out of document order are sorted
+//  by walking the tree instead of comparing node pairs.
+const XMLSize_t kTraversalSortThreshold = 64;
+
+const DOMNode::NodeType kNamespaceNodeType = (DOMNode::NodeType)DOMXPathNamespace::XPATH_NAMESPACE_NODE;
+
+const XMLCh gLang[] = { chLatin_l, chLatin_a, chLatin_n, chLatin_g, chNull };
+const XMLCh gXMLLang[] = { chLatin_x, chLatin_m, chLatin_l, chColon, chLatin_l, chLatin_a, chLatin_n, chLatin_g, chNull };
+
+typedef ValueVectorOf<DOMNode*> NodeVector;
+
+// ---------------------------------------------------------------------------
+//  Navigation in the XPath view of the DOM
+// ---------------------------------------------------------------------------
+inline bool isTextNode(const DOMNode* node)
+{
+    DOMNode::NodeType type = node->getNodeType();
+    return type == DOMNode::TEXT_NODE || type == DOMNode::CDATA_SECTION_NODE;
+}
+
+inline bool isAttributeOrNamespace(const DOMNode* node)
+{
+    DOMNode::NodeType type = node->getNodeType();
+    return type == DOMNode::ATTRIBUTE_NODE || type == kNamespaceNodeType;
+}
+
+inline bool hasChildNodes(const DOMNode* node)
+{
+    DOMNode::NodeType type = node->getNodeType();
+    return type == DOMNode::ELEMENT_NODE || type == DOMNode::DOCUMENT_NODE ||
+           type == DOMNode::DOCUMENT_FRAGMENT_NODE;
+}
+
+// Namespace declarations are namespace nodes, not attributes, in XPath.
+bool isNamespaceDeclaration(const DOMNode* attr)
+{
+    if (attr->getLocalName())
+        return XMLString::equals(attr->getNamespaceURI(), XMLUni::fgXMLNSURIName);
+
+    const XMLCh* name = attr->getNodeName();
+    return XMLString::equals(name, XMLUni::fgXMLNSString) ||
+           XMLString::startsWith(name, XMLUni::fgXMLNSColonString);
+}
+
+// The parent in the DOM tree, attributes and namespace nodes belong to
+// their owner element.
+DOMNode* rawParentOf(const DOMNode* node)
+{
+    DOMNode::NodeType type = node->getNodeType();
+    if (type == DOMNode::ATTRIBUTE_NODE)
+        return ((const DOMAttr*)node)->getOwnerElement();
+    if (type == kNamespaceNodeType)
+        return ((const DOMXPathNamespace*)node)->getOwnerElement();
+    return node->getParentNode();
+}
+
+DOMNode* parentOf(const DOMNode* node)
+{
+    DOMNode* parent = rawParentOf(node);
+    while (parent && parent->getNodeType() == DOMNode::ENTITY_REFERENCE_NODE)
+        parent = parent->getParentNode();
+    return parent;
+}
+
+DOMNode* rawNext(const DOMNode* node)
+{
+    for (;;)
+    {
+        DOMNode* sibling = node->getNextSibling();
+        if (sibling)
+            return sibling;
+        node = node->getParentNode();
+        if (node == 0 || node->getNodeType() != DOMNode::ENTITY_REFERENCE_NODE)
+            return 0;
+    }
+}
+
+DOMNode* rawPrevious(const DOMNode* node)
+{
+    for (;;)
+    {
+        DOMNode* sibling = node->getPreviousSibling();
+        if (sibling)
+            return sibling;
+        node = node->getParentNode();
+        if (node == 0 || node->getNodeType() != DOMNode::ENTITY_REFERENCE_NODE)
+            return 0;
+    }
+}
+
+// Resolves a candidate sibling moving forward: steps into entity
+// references and over nodes that are not part of the XPath tree.
+DOMNode* enterForward(DOMNode* node)
+{
+    while (node)
+    {
+        DOMNode::NodeType type = node->getNodeType();
+        if (type == DOMNode::ENTITY_REFERENCE_NODE)
+        {
+            DOMNode* child = node->getFirstChild();
+            node = child ? child : rawNext(node);
+        }
+        else if (type == DOMNode::DOCUMENT_TYPE_NODE)
+            node = rawNext(node);
+        else
+            return node;
+    }
+    return 0;
+}
+
+DOMNode* enterBackward(DOMNode* node)
+{
+    while (node)
+    {
+        DOMNode::NodeType type = node->getNodeType();
+        if (type == DOMNode::ENTITY_REFERENCE_NODE)
+        {
+            DOMNode* child = node->getLastChild();
+            node = child ? child : rawPrevious(node);
+        }
+        else if (type == DOMNode::DOCUMENT_TYPE_NODE)
+            node = rawPrevious(node);
+        else
+            return node;
+    }
+    return 0;
+}
+
+inline DOMNode* flatNext(const DOMNode* node)
+{
+    return enterForward(rawNext(node));
+}
+
+inline DOMNode* flatPrevious(const DOMNode* node)
+{
+    return enterBackward(rawPrevious(node));
+}
+
+// Returns the node representing the text node 'node' is part of.
+DOMNode* textLeader(DOMNode* node)
+{
+    if (node && isTextNode(node))
+    {
+        DOMNode* prev;
+        while ((prev = flatPrevious(node)) != 0 && isTextNode(prev))
+            node = prev;
+    }
+    return node;
+}
+
+DOMNode* firstChildOf(const DOMNode* node)
+{
+    return hasChildNodes(node) ? enterForward(node->getFirstChild()) : 0;
+}
+
+DOMNode* lastChildOf(const DOMNode* node)
+{
+    return hasChildNodes(node) ? textLeader(enterBackward(node->getLastChild())) : 0;
+}
+
+DOMNode* nextSiblingOf(const DOMNode* node)
+{
+    DOMNode* next = flatNext(node);
+    if (isTextNode(node))
+        while (next && isTextNode(next))
+            next = flatNext(next);
+    return next;
+}
+
+DOMNode* previousSiblingOf(const DOMNode* node)
+{
+    return textLeader(flatPrevious(node));
+}
+
+// The next node in document order that is not a descendant of 'node'.
+DOMNode* nextAfterSubtree(const DOMNode* node)
+{
+    while (node)
+    {
+        DOMNode* next = nextSiblingOf(node);
+        if (next)
+            return next;
+        node = parentOf(node);
+    }
+    return 0;
+}
+
+// The next node in document order within the subtree rooted at 'top'.
+DOMNode* nextInSubtree(const DOMNode* node, const DOMNode* top)
+{
+    DOMNode* child = firstChildOf(node);
+    if (child)
+        return child;
+    while (node != top)
+    {
+        DOMNode* next = nextSiblingOf(node);
+        if (next)
+            return next;
+        node = parentOf(node);
+    }
+    return 0;
+}
+
+void appendTextDescendants(const DOMNode* node, XMLBuffer& toFill)
+{
+    for (const DOMNode* child = node->getFirstChild(); child; child = child->getNextSibling())
+    {
+        DOMNode::NodeType type = child->getNodeType();
+        if (type == DOMNode::TEXT_NODE || type == DOMNode::CDATA_SECTION_NODE)
+            toFill.append(child->getNodeValue());
+        else if (type == DOMNode::ELEMENT_NODE || type == DOMNode::ENTITY_REFERENCE_NODE)
+            appendTextDescendants(child, toFill);
+    }
+}
+
+// ---------------------------------------------------------------------------
+//  Document order
+// ---------------------------------------------------------------------------
+XMLSize_t depthOf(const DOMNode* node)
+{
+    XMLSize_t depth = 0;
+    while ((node = rawParentOf(node)) != 0)
+        depth++;
+    return depth;
+}
+
+// Namespace nodes come first, then attributes, then children.
+inline int siblingRank(const DOMNode* node)
+{
+    DOMNode::NodeType type = node->getNodeType();
+    if (type == kNamespaceNodeType)
+        return 0;
+    return type == DOMNode::ATTRIBUTE_NODE ? 1 : 2;
+}
+
+int compareSiblings(const DOMNode* a, const DOMNode* b)
+{
+    int rankA = siblingRank(a);
+    int rankB = siblingRank(b);
+    if (rankA != rankB)
+        return rankA < rankB ? -1 : 1;
+
+    if (rankA == 0)
+    {
+        int result = XMLString::compareString(a->getPrefix(), b->getPrefix());
+        return result < 0 ? -1 : (result > 0 ? 1 : 0);
+    }
+
+    if (rankA == 1)
+    {
+        DOMNamedNodeMap* attrs = ((const DOMAttr*)a)->getOwnerElement()->getAttributes();
+        XMLSize_t count = attrs->getLength();
+        for (XMLSize_t i = 0; i < count; i++)
+        {
+            const DOMNode* attr = attrs->item(i);
+            if (attr == a)
+                return -1;
+            if (attr == b)
+                return 1;
+        }
+        return 0;
+    }
+
+    // Walk forward from both nodes at once, whichever finds the other
+    // first is the earlier one.
+    const DOMNode* fromA = a;
+    const DOMNode* fromB = b;
+    for (;;)
+    {
+        fromA = fromA->getNextSibling();
+        if (fromA == b)
+            return -1;
+        if (fromA == 0)
+            return 1;
+        fromB = fromB->getNextSibling();
+        if (fromB == a)
+            return 1;
+        if (fromB == 0)
+            return -1;
+    }
+}
+
+int compareDocumentOrder(const DOMNode* a, const DOMNode* b)
+{
+    if (a == b)
+        return 0;
+
+    XMLSize_t depthA = depthOf(a);
+    XMLSize_t depthB = depthOf(b);
+    const DOMNode* upA = a;
+    const DOMNode* upB = b;
+    for (XMLSize_t i = depthA; i > depthB; i--)
+        upA = rawParentOf(upA);
+    for (XMLSize_t i = depthB; i > depthA; i--)
+        upB = rawParentOf(upB);
+
+    // One is an ancestor of the other.
+    if (upA == upB)
+        return depthA < depthB ? -1 : 1;
+
+    for (;;)
+    {
+        const DOMNode* parentA = rawParentOf(upA);
+        const DOMNode* parentB = rawParentOf(upB);
+        if (parentA == parentB)
+            break;
+        upA = parentA;
+        upB = parentB;
+    }
+
+    // Nodes from different trees; any stable order will do.
+    if (rawParentOf(upA) == 0)
+        return upA < upB ? -1 : 1;
+
+    return compareSiblings(upA, upB);
+}
+
+void truncateNodes(NodeVector& nodes, XMLSize_t size)
+{
+    while (nodes.size() > size)
+        nodes.removeElementAt(nodes.size() - 1);
+}
+
+void mergeSortNodes(DOMNode** nodes, DOMNode** scratch, XMLSize_t count)
+{
+    if (count < 2)
+        return;
+
+    XMLSize_t half = count / 2;
+    mergeSortNodes(nodes, scratch, half);
+    mergeSortNodes(nodes + half, scratch, count - half);
+
+    XMLSize_t i = 0, j = half, k = 0;
+    while (i < half && j < count)
+        scratch[k++] = compareDocumentOrder(nodes[j], nodes[i]) < 0 ? nodes[j++] : nodes[i++];
+    while (i < half)
+        scratch[k++] = nodes[i++];
+    while (j < count)
+        scratch[k++] = nodes[j++];
+    for (k = 0; k < count; k++)
+        nodes[k] = scratch[k];
+}
+
+// Collects the nodes by walking the tree they belong to. Returns false if
+// they don't all belong to the same tree.
+bool sortByTraversal(NodeVector& nodes, MemoryManager* const manager)
+{
+    ValueHashTableOf<bool, PtrHasher> members(nodes.size() * 2 + 1, manager);
+    XMLSize_t distinct = 0;
+    for (XMLSize_t i = 0; i < nodes.size(); i++)
+    {
+        DOMNode* node = nodes.elementAt(i);
+        if (node->getNodeType() == kNamespaceNodeType)
+            return false;
+        if (!members.containsKey(node))
+        {
+            members.put(node, true);
+            distinct++;
+        }
+    }
+
+    DOMNode* root = nodes.elementAt(0);
+    for (DOMNode* parent = rawParentOf(root); parent; parent = rawParentOf(parent))
+        root = parent;
+
+    NodeVector sorted(distinct, manager);
+    DOMNode* node = root;
+    while (node && sorted.size() < distinct)
+    {
+        if (members.containsKey(node))
+            sorted.addElement(node);
+
+        if (node->getNodeType() == DOMNode::ELEMENT_NODE)
+        {
+            DOMNamedNodeMap* attrs = node->getAttributes();
+            XMLSize_t count = attrs->getLength();
+            for (XMLSize_t i = 0; i < count; i++)
+                if (members.containsKey(attrs->item(i)))
+                    sorted.addElement(attrs->item(i));
+        }
+
+        DOMNode* child = node->getFirstChild();
+        if (child)
+            node = child;
+        else
+        {
+            while (node != root && node->getNextSibling() == 0)
+                node = node->getParentNode();
+            node = (node == root) ? 0 : node->getNextSibling();
+        }
+    }
+
+    if (sorted.size() != distinct)
+        return false;
+
+    nodes.removeAllElements();
+    for (XMLSize_t i = 0; i < distinct; i++)
+        nodes.addElement(sorted.elementAt(i));
+    return true;
+}
+
+// Puts a node-set into document order and removes duplicates.
+void sortDocumentOrder(NodeVector& nodes, MemoryManager* const manager)
+{
+    XMLSize_t count = nodes.size();
+    if (count < 2)
+        return;
+
+    XMLSize_t i = 1;
+    while (i < count && compareDocumentOrder(nodes.elementAt(i - 1), nodes.elementAt(i)) < 0)
+        i++;
+    if (i == count)
+        return;
+
+    if (count >= kTraversalSortThreshold && sortByTraversal(nodes, manager))
+        return;
+
+    DOMNode** scratch = (DOMNode**)manager->allocate(2 * count * sizeof(DOMNode*));
+    ArrayJanitor<DOMNode*> janScratch(scratch, manager);
+    DOMNode** sorted = scratch + count;
+    for (i = 0; i < count; i++)
+        sorted[i] = nodes.elementAt(i);
+    mergeSortNodes(sorted, scratch, count);
+
+    XMLSize_t kept = 0;
+    for (i = 0; i < count; i++)
+        if (kept == 0 || compareDocumentOrder(nodes.elementAt(kept - 1), sorted[i]) != 0)
+            nodes.setElementAt(sorted[i], kept++);
+    truncateNodes(nodes, kept);
+}
+
+// ---------------------------------------------------------------------------
+//  Scalar comparisons
+// ---------------------------------------------------------------------------
+struct XPathScalar
+{
+    DOMXPathValue::ValueType    fType;
+    double                      fNumber;
+    bool                        fBoolean;
+    const XMLCh*                fString;
+};
+
+XPathScalar makeScalar(const DOMXPathValue* value)
+{
+    XPathScalar scalar;
+    scalar.fType = value->getType();
+    scalar.fNumber = value->getNumber();
+    scalar.fBoolean = value->getBoolean();
+    scalar.fString = value->getString();
+    return scalar;
+}
+
+XPathScalar makeScalar(const XMLCh* str)
+{
+    XPathScalar scalar;
+    scalar.fType = DOMXPathValue::STRING_VALUE;
+    scalar.fNumber = 0;
+    scalar.fBoolean = false;
+    scalar.fString = str;
+    return scalar;
+}
+
+double scalarNumber(const XPathScalar& scalar)
+{
+    switch (scalar.fType)
+    {
+    case DOMXPathValue::NUMBER_VALUE:
+        return scalar.fNumber;
+    case DOMXPathValue::BOOLEAN_VALUE:
+        return scalar.fBoolean ? 1 : 0;
+    default:
+        return DOMXPathValue::stringToNumber(scalar.fString);
+    }
+}
+
+bool scalarBoolean(const XPathScalar& scalar)
+{
+    switch (scalar.fType)
+    {
+    case DOMXPathValue::NUMBER_VALUE:
+        return scalar.fNumber != 0 && scalar.fNumber == scalar.fNumber;
+    case DOMXPathValue::BOOLEAN_VALUE:
+        return scalar.fBoolean;
+    default:
+        return *scalar.fString != 0;
+    }
+}
+
+bool compareNumbers(DOMXPathOp::OpType op, double a, double b)
+{
+    switch (op)
+    {
+    case DOMXPathOp::OP_EQ: return a == b;
+    case DOMXPathOp::OP_NE: return a != b;
+    case DOMXPathOp::OP_LT: return a < b;
+    case DOMXPathOp::OP_LE: return a <= b;
+    case DOMXPathOp::OP_GT: return a > b;
+    default:                return a >= b;
+    }
+}
+
+bool compareScalars(DOMXPathOp::OpType op, const XPathScalar& a, const XPathScalar& b)
+{
+    if (op == DOMXPathOp::OP_EQ || op == DOMXPathOp::OP_NE)
+    {
+        bool equal;
+        if (a.fType == DOMXPathValue::BOOLEAN_VALUE || b.fType == DOMXPathValue::BOOLEAN_VALUE)
+            equal = scalarBoolean(a) == scalarBoolean(b);
+        else if (a.fType == DOMXPathValue::NUMBER_VALUE || b.fType == DOMXPathValue::NUMBER_VALUE)
+            equal = scalarNumber(a) == scalarNumber(b);
+        else
+            equal = XMLString::equals(a.fString, b.fString);
+        return op == DOMXPathOp::OP_EQ ? equal : !equal;
+    }
+    return compareNumbers(op, scalarNumber(a), scalarNumber(b));
+}
+
+DOMXPathOp::OpType swapOperands(DOMXPathOp::OpType op)
+{
+    switch (op)
+    {
+    case DOMXPathOp::OP_LT: return DOMXPathOp::OP_GT;
+    case DOMXPathOp::OP_LE: return DOMXPathOp::OP_GE;
+    case DOMXPathOp::OP_GT: return DOMXPathOp::OP_LT;
+    case DOMXPathOp::OP_GE: return DOMXPathOp::OP_LE;
+    default:                return op;
+    }
+}
+
+// ---------------------------------------------------------------------------
+//  String helpers for the core function library
+// ---------------------------------------------------------------------------
+inline bool isXPathSpace(XMLCh ch)
+{
+    return ch == chSpace || ch == chHTab || ch == chLF || ch == chCR;
+}
+
+inline bool isSurrogatePair(const XMLCh* str)
+{
+    return str[0] >= 0xD800 && str[0] <= 0xDBFF && str[1] >= 0xDC00 && str[1] <= 0xDFFF;
+}
+
+bool findSubstring(const XMLCh* str, const XMLCh* pattern, XMLSize_t& index)
+{
+    XMLSize_t patternLen = XMLString::stringLen(pattern);
+    XMLSize_t strLen = XMLString::stringLen(str);
+    for (XMLSize_t i = 0; i + patternLen <= strLen; i++)
+    {
+        if (XMLString::compareNString(str + i, pattern, patternLen) == 0)
+        {
+            index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+double roundNumber(double value)
+{
+    if (value != value || value == std::numeric_limits<double>::infinity() || value == -std::numeric_limits<double>::infinity())
+        return value;
+    if (value < 0 && value >= -0.5)
+        return -0.0;
+    return floor(value + 0.5);
+}
+
+// ---------------------------------------------------------------------------
+//  XPathEvaluator
+// ---------------------------------------------------------------------------
+struct XPathContext
+{
+    DOMNode*    fNode;
+    XMLSize_t   fPosition;
+    XMLSize_t   fSize;
+};
+
+class XPathEvaluator
+{
+public:
+    XPathEvaluator(MemoryManager* const manager)
+        : fMemoryManager(manager)
+        , fNamespaceNodes(0)
+        , fNamespaceCache(0)
+    {
+    }
+
+    ~XPathEvaluator()
+    {
+        delete fNamespaceCache;
+        delete fNamespaceNodes;
+    }
+
+    DOMXPathValue* evaluate(const DOMXPathOp* op, const XPathContext& context);
+
+    RefVectorOf<DOMNode>* orphanNamespaceNodes()
+    {
+        RefVectorOf<DOMNode>* nodes = fNamespaceNodes;
+        fNamespaceNodes = 0;
+        return nodes;
+    }
+
+private:
+    DOMXPathValue* newNumber(double value) const
+    {
+        DOMXPathValue* result = new (fMemoryManager) DOMXPathValue(DOMXPathValue::NUMBER_VALUE, fMemoryManager);
+        result->setNumber(value);
+        return result;
+    }
+
+    DOMXPathValue* newBoolean(bool value) const
+    {
+        DOMXPathValue* result = new (fMemoryManager) DOMXPathValue(DOMXPathValue::BOOLEAN_VALUE, fMemoryManager);
+        result->setBoolean(value);
+        return result;
+    }
+
+    DOMXPathValue* newString(const XMLCh* value) const
+    {
+        DOMXPathValue* result = new (fMemoryManager) DOMXPathValue(DOMXPathValue::STRING_VALUE, fMemoryManager);
+        result->setString(value);
+        return result;
+    }
+
+    bool evaluateBoolean(const DOMXPathOp* op, const XPathContext& context)
+    {
+        Janitor<DOMXPathValue> value(evaluate(op, context));
+        return value->toBoolean();
+    }
+
+    double evaluateNumber(const DOMXPathOp* op, const XPathContext& context)
+    {
+        Janitor<DOMXPathValue> value(evaluate(op, context));
+        return value->toNumber();
+    }
+
+    void evaluateString(const DOMXPathOp* op, const XPathContext& context, XMLBuffer& toFill)
+    {
+        Janitor<DOMXPathValue> value(evaluate(op, context));
+        value->toString(toFill);
+    }
+
+    DOMXPathValue* evaluateNodeSet(const DOMXPathOp* op, const XPathContext& context)
+    {
+        DOMXPathValue* value = evaluate(op, context);
+        if (value->getType() != DOMXPathValue::NODESET_VALUE)
+        {
+            delete value;
+            throw DOMXPathException(DOMXPathException::TYPE_ERR, 0, fMemoryManager);
+        }
+        return value;
+    }
+
+    DOMXPathValue* evaluateComparison(const DOMXPathOp* op, const XPathContext& context);
+    bool compareNodeSets(DOMXPathOp::OpType op, const NodeVector& left, const NodeVector& right);
+    DOMXPathValue* evaluateUnion(const DOMXPathOp* op, const XPathContext& context);
+    DOMXPathValue* evaluateFunction(const DOMXPathOp* op, const XPathContext& context);
+    DOMXPathValue* evaluateNameFunction(const DOMXPathOp* op, const XPathContext& context);
+    DOMXPathValue* evaluateId(const DOMXPathOp* op, const XPathContext& context);
+    bool evaluateLang(const DOMXPathOp* op, const XPathContext& context);
+    DOMXPathValue* evaluateFilter(const DOMXPathOp* op, const XPathContext& context);
+    DOMXPathValue* evaluatePath(const DOMXPathOp* op, const XPathContext& context);
+
+    void applyStep(const DOMXPathStep* step, DOMNode* contextNode, NodeVector& result);
+    void collectAxis(const DOMXPathStep* step, DOMNode* contextNode, NodeVector& result, XMLSize_t limit);
+    const NodeVector* collectNamespaces(DOMElement* element);
+    void applyPredicates(const RefVectorOf<DOMXPathOp>* predicates, XMLSize_t first, NodeVector& nodes);
+
+    //  fNamespaceNodes
+    //      Every namespace node created by this evaluation. Ownership moves
+    //      to the final value, and from there to the DOMXPathResult.
+    //
+    //  fNamespaceCache
+    //      The namespace nodes of each element visited so far, so that the
+    //      same namespace node is returned each time the element is reached.
+    MemoryManager* const                fMemoryManager;
+    RefVectorOf<DOMNode>*               fNamespaceNodes;
+    RefHashTableOf<NodeVector, PtrHasher>* fNamespaceCache;
+};
+
+bool matchesNodeTest(const DOMXPathStep* step, const DOMNode* node)
+{
+    DOMNode::NodeType type = node->getNodeType();
+    switch (step->fTest)
+    {
+    case DOMXPathStep::TEST_NODE:
+        return true;
+    case DOMXPathStep::TEST_TEXT:
+        return type == DOMNode::TEXT_NODE || type == DOMNode::CDATA_SECTION_NODE;
+    case DOMXPathStep::TEST_COMMENT:
+        return type == DOMNode::COMMENT_NODE;
+    case DOMXPathStep::TEST_PI:
+        return type == DOMNode::PROCESSING_INSTRUCTION_NODE &&
+               (step->fLocalName == 0 || XMLString::equals(node->getNodeName(), step->fLocalName));
+    default:
+        break;
+    }
+
+    // A name test only selects nodes of the principal node type of the axis.
+    if (step->fAxis == DOMXPathStep::AXIS_NAMESPACE)
+    {
+        if (type != kNamespaceNodeType)
+            return false;
+        if (step->fAnyURI)
+            return true;
+        return step->fURI == 0 &&
+               (step->fLocalName == 0 || XMLString::equals(node->getPrefix(), step->fLocalName));
+    }
+    if (type != (step->fAxis == DOMXPathStep::AXIS_ATTRIBUTE ? DOMNode::ATTRIBUTE_NODE : DOMNode::ELEMENT_NODE))
+        return false;
+    if (step->fAnyURI)
+        return true;
+    if (!XMLString::equals(node->getNamespaceURI(), step->fURI))
+        return false;
+    if (step->fLocalName == 0)
+        return true;
+
+    const XMLCh* localName = node->getLocalName();
+    return XMLString::equals(localName ? localName : node->getNodeName(), step->fLocalName);
+}
+
+// Adds a candidate to an axis; returns false once the limit is reached.
+inline bool addCandidate(const DOMXPathStep* step, DOMNode* node, NodeVector& result, XMLSize_t limit)
+{
+    if (matchesNodeTest(step, node))
+    {
+        result.addElement(node);
+        if (result.size() == limit)
+            return false;
+    }
+    return true;
+}
+
+DOMXPathValue* XPathEvaluator::evaluate(const DOMXPathOp* op, const XPathContext& context)
+{
+    switch (op->fType)
+    {
+    case DOMXPathOp::OP_OR:
+        return newBoolean(evaluateBoolean(op->fLeft, context) || evaluateBoolean(op->fRight, context));
+    case DOMXPathOp::OP_AND:
+        return newBoolean(evaluateBoolean(op->fLeft, context) && evaluateBoolean(op->fRight, context));
+    case DOMXPathOp::OP_EQ:
+    case DOMXPathOp::OP_NE:
+    case DOMXPathOp::OP_LT:
+    case DOMXPathOp::OP_LE:
+    case DOMXPathOp::OP_GT:
+    case DOMXPathOp::OP_GE:
+        return evaluateComparison(op, context);
+    case DOMXPathOp::OP_ADD:
+        return newNumber(evaluateNumber(op->fLeft, context) + evaluateNumber(op->fRight, context));
+    case DOMXPathOp::OP_SUB:
+        return newNumber(evaluateNumber(op->fLeft, context) - evaluateNumber(op->fRight, context));
+    case DOMXPathOp::OP_MUL:
+        return newNumber(evaluateNumber(op->fLeft, context) * evaluateNumber(op->fRight, context));
+    case DOMXPathOp::OP_DIV:
+        return newNumber(evaluateNumber(op->fLeft, context) / evaluateNumber(op->fRight, context));
+    case DOMXPathOp::OP_MOD:
+        return newNumber(fmod(evaluateNumber(op->fLeft, context), evaluateNumber(op->fRight, context)));
+    case DOMXPathOp::OP_NEG:
+        return newNumber(-evaluateNumber(op->fLeft, context));
+    case DOMXPathOp::OP_UNION:
+        return evaluateUnion(op, context);
+    case DOMXPathOp::OP_LITERAL:
+        return newString(op->fLiteral);
+    case DOMXPathOp::OP_NUMBER:
+        return newNumber(op->fNumber);
+    case DOMXPathOp::OP_FUNCTION:
+        return evaluateFunction(op, context);
+    case DOMXPathOp::OP_FILTER:
+        return evaluateFilter(op, context);
+    default:
+        return evaluatePath(op, context);
+    }
+}
+
+DOMXPathValue* XPathEvaluator::evaluateComparison(const DOMXPathOp* op, const XPathContext& context)
+{
+    Janitor<DOMXPathValue> left(evaluate(op->fLeft, context));
+    Janitor<DOMXPathValue> right(evaluate(op->fRight, context));
+    bool leftNodes = left->getType() == DOMXPathValue::NODESET_VALUE;
+    bool rightNodes = right->getType() == DOMXPathValue::NODESET_VALUE;
+
+    if (!leftNodes && !rightNodes)
+        return newBoolean(compareScalars(op->fType, makeScalar(left.get()), makeScalar(right.get())));
+
+    if (leftNodes && rightNodes)
+        return newBoolean(compareNodeSets(op->fType, *left->getNodes(), *right->getNodes()));
+
+    // One node-set and one scalar; normalize to 'node-set op scalar'.
+    const DOMXPathValue* nodeSet = leftNodes ? left.get() : right.get();
+    const DOMXPathValue* other = leftNodes ? right.get() : left.get();
+    DOMXPathOp::OpType compareOp = leftNodes ? op->fType : swapOperands(op->fType);
+
+    if (other->getType() == DOMXPathValue::BOOLEAN_VALUE)
+    {
+        XPathScalar converted = makeScalar(other);
+        converted.fBoolean = nodeSet->toBoolean();
+        return newBoolean(compareScalars(compareOp, converted, makeScalar(other)));
+    }
+
+    const NodeVector& nodes = *nodeSet->getNodes();
+    XPathScalar otherScalar = makeScalar(other);
+    XMLBuffer buf(1023, fMemoryManager);
+    for (XMLSize_t i = 0; i < nodes.size(); i++)
+    {
+        buf.reset();
+        DOMXPathValue::stringValue(nodes.elementAt(i), buf);
+        if (compareScalars(compareOp, makeScalar(buf.getRawBuffer()), otherScalar))
+            return newBoolean(true);
+    }
+    return newBoolean(false);
+}
+
+bool XPathEvaluator::compareNodeSets(DOMXPathOp::OpType op, const NodeVector& left, const NodeVector& right)
+{
+    if (left.size() == 0 || right.size() == 0)
+        return false;
+
+    XMLBuffer buf(1023, fMemoryManager);
+    if (op == DOMXPathOp::OP_EQ)
+    {
+        RefArrayVectorOf<XMLCh> strings(right.size(), true, fMemoryManager);
+        ValueHashTableOf<bool, StringHasher> lookup(right.size() * 2 + 1, fMemoryManager);
+        for (XMLSize_t i = 0; i < right.size(); i++)
+        {
+            buf.reset();
+            DOMXPathValue::stringValue(right.elementAt(i), buf);
+            XMLCh* str = XMLString::replicate(buf.getRawBuffer(), fMemoryManager);
+            strings.addElement(str);
+            lookup.put(str, true);
+        }
+        for (XMLSize_t i = 0; i < left.size(); i++)
+        {
+            buf.reset();
+            DOMXPathValue::stringValue(left.elementAt(i), buf);
+            if (lookup.containsKey(buf.getRawBuffer()))
+                return true;
+        }
+        return false;
+    }
+
+    if (op == DOMXPathOp::OP_NE)
+    {
+        // Some pair differs unless every string value is the same.
+        DOMXPathValue::stringValue(left.elementAt(0), buf);
+        XMLCh* first = XMLString::replicate(buf.getRawBuffer(), fMemoryManager);
+        ArrayJanitor<XMLCh> janFirst(first, fMemoryManager);
+        for (XMLSize_t i = 0; i < left.size() + right.size(); i++)
+        {
+            buf.reset();
+            DOMXPathValue::stringValue(i < left.size() ? left.elementAt(i) : right.elementAt(i - left.size()), buf);
+            if (!XMLString::equals(first, buf.getRawBuffer()))
+                return true;
+        }
+        return false;
+    }
+
+    // Relational operators only need the extremes of each side.
+    double minLeft = 0, maxLeft = 0, minRight = 0, maxRight = 0;
+    bool haveLeft = false, haveRight = false;
+    for (XMLSize_t i = 0; i < left.size() + right.size(); i++)
+    {
+        bool isLeft = i < left.size();
+        buf.reset();
+        DOMXPathValue::stringValue(isLeft ? left.elementAt(i) : right.elementAt(i - left.size()), buf);
+        double value = DOMXPathValue::stringToNumber(buf.getRawBuffer());
+        if (value != value)
+            continue;
+
+        double& minValue = isLeft ? minLeft : minRight;
+        double& maxValue = isLeft ? maxLeft : maxRight;
+        bool& have = isLeft ? haveLeft : haveRight;
+        if (!have || value < minValue)
+            minValue = value;
+        if (!have || value > maxValue)
+            maxValue = value;
+        have = true;
+    }
+    if (!haveLeft || !haveRight)
+        return false;
+
+    if (op == DOMXPathOp::OP_LT || op == DOMXPathOp::OP_LE)
+        return compareNumbers(op, minLeft, maxRight);
+    return compareNumbers(op, maxLeft, minRight);
+}
+
+DOMXPathValue* XPathEvaluator::evaluateUnion(const DOMXPathOp* op, const XPathContext& context)
+{
+    Janitor<DOMXPathValue> left(evaluateNodeSet(op->fLeft, context));
+    Janitor<DOMXPathValue> right(evaluateNodeSet(op->fRight, context));
+    const NodeVector& a = *left->getNodes();
+    const NodeVector& b = *right->getNodes();
+
+    NodeVector* merged = new (fMemoryManager) NodeVector(a.size() + b.size() + 1, fMemoryManager);
+    DOMXPathValue* result = new (fMemoryManager) DOMXPathValue(DOMXPathValue::NODESET_VALUE, fMemoryManager);
+    result->adoptNodes(merged);
+
+    XMLSize_t i = 0, j = 0;
+    while (i < a.size() && j < b.size())
+    {
+        int order = compareDocumentOrder(a.elementAt(i), b.elementAt(j));
+        if (order < 0)
+            merged->addElement(a.elementAt(i++));
+        else if (order > 0)
+            merged->addElement(b.elementAt(j++));
+        else
+        {
+            merged->addElement(a.elementAt(i++));
+            j++;
+        }
+    }
+    while (i < a.size())
+        merged->addElement(a.elementAt(i++));
+    while (j < b.size())
+        merged->addElement(b.elementAt(j++));
+    return result;
+}
+
+DOMXPathValue* XPathEvaluator::evaluateFunction(const DOMXPathOp* op, const XPathContext& context)
+{
+    const RefVectorOf<DOMXPathOp>& args = *op->fArgs;
+    XMLSize_t argCount = args.size();
+
+    switch (op->fFunction)
+    {
+    case DOMXPathOp::FN_LAST:
+        return newNumber((double)context.fSize);
+    case DOMXPathOp::FN_POSITION:
+        return newNumber((double)context.fPosition);
+    case DOMXPathOp::FN_COUNT:
+        {
+            Janitor<DOMXPathValue> nodes(evaluateNodeSet(args.elementAt(0), context));
+            return newNumber((double)nodes->getNodes()->size());
+        }
+    case DOMXPathOp::FN_ID:
+        return evaluateId(op, context);
+    case DOMXPathOp::FN_LOCAL_NAME:
+    case DOMXPathOp::FN_NAMESPACE_URI:
+    case DOMXPathOp::FN_NAME:
+        return evaluateNameFunction(op, context);
+    case DOMXPathOp::FN_TRUE:
+        return newBoolean(true);
+    case DOMXPathOp::FN_FALSE:
+        return newBoolean(false);
+    case DOMXPathOp::FN_BOOLEAN:
+        return newBoolean(evaluateBoolean(args.elementAt(0), context));
+    case DOMXPathOp::FN_NOT:
+        return newBoolean(!evaluateBoolean(args.elementAt(0), context));
+    case DOMXPathOp::FN_LANG:
+        return newBoolean(evaluateLang(op, context));
+    case DOMXPathOp::FN_NUMBER:
+        if (argCount == 0)
+        {
+            XMLBuffer buf(1023, fMemoryManager);
+            DOMXPathValue::stringValue(context.fNode, buf);
+            return newNumber(DOMXPathValue::stringToNumber(buf.getRawBuffer()));
+        }
+        return newNumber(evaluateNumber(args.elementAt(0), context));
+    case DOMXPathOp::FN_SUM:
+        {
+            Janitor<DOMXPathValue> value(evaluateNodeSet(args.elementAt(0), context));
+            const NodeVector& nodes = *value->getNodes();
+            XMLBuffer buf(1023, fMemoryManager);
+            double sum = 0;
+            for (XMLSize_t i = 0; i < nodes.size(); i++)
+            {
+                buf.reset();
+                DOMXPathValue::stringValue(nodes.elementAt(i), buf);
+                sum += DOMXPathValue::stringToNumber(buf.getRawBuffer());
+            }
+            return newNumber(sum);
+        }
+    case DOMXPathOp::FN_FLOOR:
+        return newNumber(floor(evaluateNumber(args.elementAt(0), context)));
+    case DOMXPathOp::FN_CEILING:
+        return newNumber(ceil(evaluateNumber(args.elementAt(0), context)));
+    case DOMXPathOp::FN_ROUND:
+        return newNumber(roundNumber(evaluateNumber(args.elementAt(0), context)));
+    default:
+        break;
+    }
+
+    // String functions
+    XMLBuffer first(1023, fMemoryManager);
+    XMLBuffer second(1023, fMemoryManager);
+    XMLBuffer result(1023, fMemoryManager);
+
+    if (argCount == 0)
+        DOMXPathValue::stringValue(context.fNode, first);
+    else
+        evaluateString(args.elementAt(0), context, first);
+    if (argCount > 1 && op->fFunction != DOMXPathOp::FN_SUBSTRING)
+        evaluateString(args.elementAt(1), context, second);
+
+    const XMLCh* str = first.getRawBuffer();
+    XMLSize_t index = 0;
+    switch (op->fFunction)
+    {
+    case DOMXPathOp::FN_STRING:
+        return newString(str);
+    case DOMXPathOp::FN_CONCAT:
+        result.append(str);
+        result.append(second.getRawBuffer());
+        for (XMLSize_t i = 2; i < argCount; i++)
+            evaluateString(args.elementAt(i), context, result);
+        return newString(result.getRawBuffer());
+    case DOMXPathOp::FN_STARTS_WITH:
+        return newBoolean(XMLString::compareNString(str, second.getRawBuffer(), second.getLen()) == 0 &&
+                          first.getLen() >= second.getLen());
+    case DOMXPathOp::FN_CONTAINS:
+        return newBoolean(findSubstring(str, second.getRawBuffer(), index));
+    case DOMXPathOp::FN_SUBSTRING_BEFORE:
+        if (findSubstring(str, second.getRawBuffer(), index))
+            result.append(str, index);
+        return newString(result.getRawBuffer());
+    case DOMXPathOp::FN_SUBSTRING_AFTER:
+        if (findSubstring(str, second.getRawBuffer(), index))
+            result.append(str + index + second.getLen());
+        return newString(result.getRawBuffer());
+    case DOMXPathOp::FN_SUBSTRING:
+        {
+            // Positions count characters, not UTF-16 code units.
+            double start = roundNumber(evaluateNumber(args.elementAt(1), context));
+            double end = std::numeric_limits<double>::infinity();
+            if (argCount == 3)
+                end = start + roundNumber(evaluateNumber(args.elementAt(2), context));
+
+            double position = 1;
+            for (XMLSize_t i = 0; str[i]; position++)
+            {
+                XMLSize_t charLen = isSurrogatePair(str + i) ? 2 : 1;
+                if (position >= start && position < end)
+                    result.append(str + i, charLen);
+                i += charLen;
+            }
+            return newString(result.getRawBuffer());
+        }
+    case DOMXPathOp::FN_STRING_LENGTH:
+        {
+            double length = 0;
+            for (XMLSize_t i = 0; str[i]; length++)
+                i += isSurrogatePair(str + i) ? 2 : 1;
+            return newNumber(length);
+        }
+    case DOMXPathOp::FN_NORMALIZE_SPACE:
+        {
+            bool pendingSpace = false;
+            for (XMLSize_t i = 0; str[i]; i++)
+            {
+                if (isXPathSpace(str[i]))
+                    pendingSpace = result.getLen() != 0;
+                else
+                {
+                    if (pendingSpace)
+                        result.append(chSpace);
+                    pendingSpace = false;
+                    result.append(str[i]);
+                }
+            }
+            return newString(result.getRawBuffer());
+        }
+    case DOMXPathOp::FN_TRANSLATE:
+        {
+            XMLBuffer to(1023, fMemoryManager);
+            evaluateString(args.elementAt(2), context, to);
+            const XMLCh* from = second.getRawBuffer();
+            for (XMLSize_t i = 0; str[i]; i++)
+            {
+                int pos = XMLString::indexOf(from, str[i]);
+                if (pos < 0)
+                    result.append(str[i]);
+                else if ((XMLSize_t)pos < to.getLen())
+                    result.append(to.getRawBuffer()[pos]);
+            }
+            return newString(result.getRawBuffer());
+        }
+    default:
+        break;
+    }
+    throw DOMXPathException(DOMXPathException::INVALID_EXPRESSION_ERR, 0, fMemoryManager);
+}
+
+DOMXPathValue* XPathEvaluator::evaluateNameFunction(const DOMXPathOp* op, const XPathContext& context)
+{
+    const DOMNode* node = context.fNode;
+    Janitor<DOMXPathValue> arg(0);
+    if (op->fArgs->size() != 0)
+    {
+        arg.reset(evaluateNodeSet(op->fArgs->elementAt(0), context));
+        node = arg->getNodes()->size() ? arg->getNodes()->elementAt(0) : 0;
+    }
+
+    const XMLCh* name = 0;
+    if (node)
+    {
+        switch (node->getNodeType())
+        {
+        case DOMNode::ELEMENT_NODE:
+        case DOMNode::ATTRIBUTE_NODE:
+            if (op->fFunction == DOMXPathOp::FN_NAMESPACE_URI)
+                name = node->getNamespaceURI();
+            else if (op->fFunction == DOMXPathOp::FN_LOCAL_NAME && node->getLocalName())
+                name = node->getLocalName();
+            else
+                name = node->getNodeName();
+            break;
+        case DOMNode::PROCESSING_INSTRUCTION_NODE:
+            if (op->fFunction != DOMXPathOp::FN_NAMESPACE_URI)
+                name = node->getNodeName();
+            break;
+        default:
+            if (node->getNodeType() == kNamespaceNodeType && op->fFunction != DOMXPathOp::FN_NAMESPACE_URI)
+                name = node->getPrefix();
+            break;
+        }
+    }
+    return newString(name ? name : XMLUni::fgZeroLenString);
+}
+
+DOMXPathValue* XPathEvaluator::evaluateId(const DOMXPathOp* op, const XPathContext& context)
+{
+    XMLBuffer ids(1023, fMemoryManager);
+    Janitor<DOMXPathValue> arg(evaluate(op->fArgs->elementAt(0), context));
+    if (arg->getType() == DOMXPathValue::NODESET_VALUE)
+    {
+        const NodeVector& nodes = *arg->getNodes();
+        for (XMLSize_t i = 0; i < nodes.size(); i++)
+        {
+            DOMXPathValue::stringValue(nodes.elementAt(i), ids);
+            ids.append(chSpace);
+        }
+    }
+    else
+        arg->toString(ids);
+
+    DOMDocument* doc = context.fNode->getNodeType() == DOMNode::DOCUMENT_NODE
+                           ? (DOMDocument*)context.fNode
+                           : context.fNode->getOwnerDocument();
+
+    DOMXPathValue* result = new (fMemoryManager) DOMXPathValue(DOMXPathValue::NODESET_VALUE, fMemoryManager);
+    Janitor<DOMXPathValue> janResult(result);
+    XMLBuffer token(127, fMemoryManager);
+    const XMLCh* str = ids.getRawBuffer();
+    for (XMLSize_t i = 0; ; i++)
+    {
+        if (str[i] == 0 || isXPathSpace(str[i]))
+        {
+            if (token.getLen() != 0 && doc)
+            {
+                DOMElement* element = doc->getElementById(token.getRawBuffer());
+                if (element)
+                    result->getNodes()->addElement(element);
+            }
+            token.reset();
+            if (str[i] == 0)
+                break;
+        }
+        else
+            token.append(str[i]);
+    }
+    sortDocumentOrder(*result->getNodes(), fMemoryManager);
+    return janResult.release();
+}
+
+bool XPathEvaluator::evaluateLang(const DOMXPathOp* op, const XPathContext& context)
+{
+    XMLBuffer lang(127, fMemoryManager);
+    evaluateString(op->fArgs->elementAt(0), context, lang);
+
+    for (const DOMNode* node = context.fNode; node; node = parentOf(node))
+    {
+        if (node->getNodeType() != DOMNode::ELEMENT_NODE)
+            continue;
+
+        const DOMElement* element = (const DOMElement*)node;
+        const DOMAttr* attr = element->getAttributeNodeNS(XMLUni::fgXMLURIName, gLang);
+        if (attr == 0)
+            attr = element->getAttributeNode(gXMLLang);
+        if (attr == 0)
+            continue;
+
+        const XMLCh* value = attr->getValue();
+        XMLSize_t len = lang.getLen();
+        return XMLString::stringLen(value) >= len &&
+               XMLString::compareNIString(value, lang.getRawBuffer(), len) == 0 &&
+               (value[len] == chNull || value[len] == chDash);
+    }
+    return false;
+}
+
+DOMXPathValue* XPathEvaluator::evaluateFilter(const DOMXPathOp* op, const XPathContext& context)
+{
+    DOMXPathValue* result = evaluateNodeSet(op->fLeft, context);
+    Janitor<DOMXPathValue> janResult(result);
+    applyPredicates(op->fArgs, 0, *result->getNodes());
+    return janResult.release();
+}
+
+DOMXPathValue* XPathEvaluator::evaluatePath(const DOMXPathOp* op, const XPathContext& context)
+{
+    DOMXPathValue* result = 0;
+    if (op->fLeft)
+        result = evaluateNodeSet(op->fLeft, context);
+    else
+    {
+        result = new (fMemoryManager) DOMXPathValue(DOMXPathValue::NODESET_VALUE, fMemoryManager);
+        DOMNode* start = context.fNode;
+        if (op->fAbsolute)
+            for (DOMNode* parent = rawParentOf(start); parent; parent = rawParentOf(parent))
+                start = parent;
+        result->getNodes()->addElement(start);
+    }
+    Janitor<DOMXPathValue> janResult(result);
+
+    XMLSize_t stepCount = op->fSteps ? op->fSteps->size() : 0;
+    for (XMLSize_t s = 0; s < stepCount && result->getNodes()->size() != 0; s++)
+    {
+        const DOMXPathStep* step = op->fSteps->elementAt(s);
+        const NodeVector& current = *result->getNodes();
+        NodeVector* next = new (fMemoryManager) NodeVector(current.size() + 7, fMemoryManager);
+        Janitor<NodeVector> janNext(next);
+
+        for (XMLSize_t i = 0; i < current.size(); i++)
+            applyStep(step, current.elementAt(i), *next);
+
+        // Attributes, namespaces and self of nodes in document order are
+        // themselves in document order; anything else may need sorting.
+        if (current.size() > 1 &&
+            step->fAxis != DOMXPathStep::AXIS_ATTRIBUTE &&
+            step->fAxis != DOMXPathStep::AXIS_NAMESPACE &&
+            step->fAxis != DOMXPathStep::AXIS_SELF)
+            sortDocumentOrder(*next, fMemoryManager);
+
+        result->adoptNodes(janNext.release());
+    }
+    return janResult.release();
+}
+
+void XPathEvaluator::applyStep(const DOMXPathStep* step, DOMNode* contextNode, NodeVector& result)
+{
+    const RefVectorOf<DOMXPathOp>* predicates = step->fPredicates;
+    XMLSize_t first = 0;
+    XMLSize_t limit = 0;
+
+    // [n] with a constant n only needs the first n nodes of the axis.
+    if (predicates->size() != 0 && predicates->elementAt(0)->fType == DOMXPathOp::OP_NUMBER)
+    {
+        double position = predicates->elementAt(0)->fNumber;
+        if (!(position >= 1) || position != floor(position) || position > (double)(XMLSize_t)-1 / 2)
+            return;
+        limit = (XMLSize_t)position;
+        first = 1;
+    }
+
+    NodeVector candidates(8, fMemoryManager);
+    collectAxis(step, contextNode, candidates, limit);
+    if (first == 1)
+    {
+        if (candidates.size() != limit)
+            return;
+        DOMNode* selected = candidates.elementAt(limit - 1);
+        candidates.removeAllElements();
+        candidates.addElement(selected);
+    }
+    applyPredicates(predicates, first, candidates);
+
+    // Candidates are in proximity order, which is reverse document order
+    // for the reverse axes.
+    XMLSize_t count = candidates.size();
+    if (step->isReverseAxis())
+        for (XMLSize_t i = count; i > 0; i--)
+            result.addElement(candidates.elementAt(i - 1));
+    else
+        for (XMLSize_t i = 0; i < count; i++)
+            result.addElement(candidates.elementAt(i));
+}
+
+void XPathEvaluator::collectAxis(const DOMXPathStep* step, DOMNode* contextNode, NodeVector& result, XMLSize_t limit)
+{
+    DOMNode* node = 0;
+    switch (step->fAxis)
+    {
+    case DOMXPathStep::AXIS_SELF:
+    default:
+        addCandidate(step, contextNode, result, limit);
+        break;
+
+    case DOMXPathStep::AXIS_CHILD:
+        for (node = firstChildOf(contextNode); node; node = nextSiblingOf(node))
+            if (!addCandidate(step, node, result, limit))
+                break;
+        break;
+
+    case DOMXPathStep::AXIS_DESCENDANT_OR_SELF:
+        if (!addCandidate(step, contextNode, result, limit))
+            break;
+        // fall through
+    case DOMXPathStep::AXIS_DESCENDANT:
+        for (node = firstChildOf(contextNode); node; node = nextInSubtree(node, contextNode))
+            if (!addCandidate(step, node, result, limit))
+                break;
+        break;
+
+    case DOMXPathStep::AXIS_PARENT:
+        node = parentOf(contextNode);
+        if (node)
+            addCandidate(step, node, result, limit);
+        break;
+
+    case DOMXPathStep::AXIS_ANCESTOR_OR_SELF:
+        if (!addCandidate(step, contextNode, result, limit))
+            break;
+        // fall through
+    case DOMXPathStep::AXIS_ANCESTOR:
+        for (node = parentOf(contextNode); node; node = parentOf(node))
+            if (!addCandidate(step, node, result, limit))
+                break;
+        break;
+
+    case DOMXPathStep::AXIS_FOLLOWING_SIBLING:
+        if (isAttributeOrNamespace(contextNode))
+            break;
+        for (node = nextSiblingOf(contextNode); node; node = nextSiblingOf(node))
+            if (!addCandidate(step, node, result, limit))
+                break;
+        break;
+
+    case DOMXPathStep::AXIS_PRECEDING_SIBLING:
+        if (isAttributeOrNamespace(contextNode))
+            break;
+        for (node = previousSiblingOf(contextNode); node; node = previousSiblingOf(node))
+            if (!addCandidate(step, node, result, limit))
+                break;
+        break;
+
+    case DOMXPathStep::AXIS_FOLLOWING:
+        // The children of an attribute's owner element follow the attribute.
+        if (isAttributeOrNamespace(contextNode))
+        {
+            DOMNode* owner = parentOf(contextNode);
+            node = firstChildOf(owner);
+            if (node == 0)
+                node = nextAfterSubtree(owner);
+        }
+        else
+            node = nextAfterSubtree(contextNode);
+        for (; node; node = nextInSubtree(node, 0))
+            if (!addCandidate(step, node, result, limit))
+                break;
+        break;
+
+    case DOMXPathStep::AXIS_PRECEDING:
+        {
+            // Walk in reverse document order, skipping the ancestors.
+            node = isAttributeOrNamespace(contextNode) ? parentOf(contextNode) : contextNode;
+            DOMNode* ancestor = parentOf(node);
+            for (;;)
+            {
+                DOMNode* prev = previousSiblingOf(node);
+                if (prev)
+                {
+                    DOMNode* last;
+                    while ((last = lastChildOf(prev)) != 0)
+                        prev = last;
+                    node = prev;
+                }
+                else
+                {
+                    node = parentOf(node);
+                    if (node == 0)
+                        break;
+                    if (node == ancestor)
+                    {
+                        ancestor = parentOf(ancestor);
+                        continue;
+                    }
+                }
+                if (!addCandidate(step, node, result, limit))
+                    break;
+            }
+        }
+        break;
+
+    case DOMXPathStep::AXIS_ATTRIBUTE:
+        if (contextNode->getNodeType() != DOMNode::ELEMENT_NODE)
+            break;
+        if (step->fTest == DOMXPathStep::TEST_NAME && !step->fAnyURI && step->fLocalName)
+        {
+            // A single attribute by name: go through the attribute map's
+            // lookup, which is hashed on wide elements.
+            DOMElement* element = (DOMElement*)contextNode;
+            node = element->getAttributeNodeNS(step->fURI, step->fLocalName);
+            if (node == 0 && step->fURI == 0)
+                node = element->getAttributeNode(step->fLocalName);
+            if (node && !isNamespaceDeclaration(node))
+                addCandidate(step, node, result, limit);
+        }
+        else
+        {
+            DOMNamedNodeMap* attrs = contextNode->getAttributes();
+            XMLSize_t count = attrs->getLength();
+            for (XMLSize_t i = 0; i < count; i++)
+            {
+                node = attrs->item(i);
+                if (!isNamespaceDeclaration(node) && !addCandidate(step, node, result, limit))
+                    break;
+            }
+        }
+        break;
+
+    case DOMXPathStep::AXIS_NAMESPACE:
+        if (contextNode->getNodeType() == DOMNode::ELEMENT_NODE)
+        {
+            const NodeVector* namespaces = collectNamespaces((DOMElement*)contextNode);
+            for (XMLSize_t i = 0; i < namespaces->size(); i++)
+                if (!addCandidate(step, namespaces->elementAt(i), result, limit))
+                    break;
+        }
+        break;
+    }
+}
+
+//
+//  Builds the namespace nodes of an element from the namespace declarations
+//  in scope and the bindings implied by the names of the element and its
+//  ancestors, so documents built through the DOM API without explicit
+//  declarations still get their namespace nodes. The nodes are returned
+//  sorted by prefix, which is the document order used for them.
+//
+const NodeVector* XPathEvaluator::collectNamespaces(DOMElement* element)
+{
+    if (fNamespaceCache == 0)
+        fNamespaceCache = new (fMemoryManager) RefHashTableOf<NodeVector, PtrHasher>(29, true, fMemoryManager);
+    else
+    {
+        const NodeVector* cached = fNamespaceCache->get(element);
+        if (cached)
+            return cached;
+    }
+    if (fNamespaceNodes == 0)
+        fNamespaceNodes = new (fMemoryManager) RefVectorOf<DOMNode>(8, true, fMemoryManager);
+
+    ValueVectorOf<const XMLCh*> prefixes(8, fMemoryManager);
+    ValueVectorOf<const XMLCh*> uris(8, fMemoryManager);
+
+    for (DOMNode* node = element; node && node->getNodeType() == DOMNode::ELEMENT_NODE; node = parentOf(node))
+    {
+        DOMNamedNodeMap* attrs = node->getAttributes();
+        XMLSize_t count = attrs->getLength();
+        for (XMLSize_t i = 0; i <= count + 1; i++)
+        {
+            const XMLCh* prefix = 0;
+            const XMLCh* uri = 0;
+            if (i < count)
+            {
+                DOMNode* attr = attrs->item(i);
+                if (isNamespaceDeclaration(attr))
+                {
+                    const XMLCh* name = attr->getNodeName();
+                    XMLSize_t nameLen = XMLString::stringLen(XMLUni::fgXMLNSString);
+                    prefix = name[nameLen] == chColon ? name + nameLen + 1 : XMLUni::fgZeroLenString;
+                    uri = attr->getNodeValue();
+                }
+                else if (attr->getPrefix())
+                {
+                    prefix = attr->getPrefix();
+                    uri = attr->getNamespaceURI();
+                }
+                else
+                    continue;
+            }
+            else if (i == count && node->getLocalName())
+            {
+                // An unprefixed element without a namespace has no default
+                // namespace in scope.
+                prefix = node->getPrefix() ? node->getPrefix() : XMLUni::fgZeroLenString;
+                uri = node->getNamespaceURI() ? node->getNamespaceURI() : XMLUni::fgZeroLenString;
+            }
+            else if (i == count + 1 && node == element)
+            {
+                prefix = XMLUni::fgXMLString;
+                uri = XMLUni::fgXMLURIName;
+            }
+            else
+                continue;
+
+            XMLSize_t j = 0;
+            while (j < prefixes.size() && !XMLString::equals(prefixes.elementAt(j), prefix))
+                j++;
+            if (j == prefixes.size())
+            {
+                prefixes.addElement(prefix);
+                uris.addElement(uri);
+            }
+        }
+    }
+
+    NodeVector* result = new (fMemoryManager) NodeVector(prefixes.size(), fMemoryManager);
+    fNamespaceCache->put(element, result);
+
+    DOMDocument* doc = element->getOwnerDocument();
+    for (XMLSize_t i = 0; i < prefixes.size(); i++)
+    {
+        // xmlns="" undeclares the default namespace.
+        if (uris.elementAt(i) == 0 || *uris.elementAt(i) == 0)
+            continue;
+
+        DOMNode* node = new (fMemoryManager) DOMXPathNamespaceImpl(doc, element, prefixes.elementAt(i), uris.elementAt(i), fMemoryManager);
+        fNamespaceNodes->addElement(node);
+        XMLSize_t pos = result->size();
+        while (pos > 0 && XMLString::compareString(result->elementAt(pos - 1)->getPrefix(), node->getPrefix()) > 0)
+            pos--;
+        result->insertElementAt(node, pos);
+    }
+    return result;
+}
+
+void XPathEvaluator::applyPredicates(const RefVectorOf<DOMXPathOp>* predicates, XMLSize_t first, NodeVector& nodes)
+{
+    for (XMLSize_t p = first; p < predicates->size() && nodes.size() != 0; p++)
+    {
+        const DOMXPathOp* predicate = predicates->elementAt(p);
+        XMLSize_t size = nodes.size();
+
+        if (predicate->fType == DOMXPathOp::OP_NUMBER)
+        {
+            double position = predicate->fNumber;
+            if (position >= 1 && position <= (double)size && position == floor(position))
+            {
+                DOMNode* selected = nodes.elementAt((XMLSize_t)position - 1);
+                nodes.removeAllElements();
+                nodes.addElement(selected);
+            }
+            else
+                nodes.removeAllElements();
+            continue;
+        }
+
+        XMLSize_t kept = 0;
+        for (XMLSize_t i = 0; i < size; i++)
+        {
+            XPathContext context;
+            context.fNode = nodes.elementAt(i);
+            context.fPosition = i + 1;
+            context.fSize = size;
+
+            Janitor<DOMXPathValue> value(evaluate(predicate, context));
+            bool keep = value->getType() == DOMXPathValue::NUMBER_VALUE
+                            ? value->getNumber() == (double)(i + 1)
+                            : value->toBoolean();
+            if (keep)
+                nodes.setElementAt(context.fNode, kept++);
+        }
+        truncateNodes(nodes, kept);
+    }
+}
+
+}
+
+// ---------------------------------------------------------------------------
+//  DOMXPathValue: string-value of a node
+// ---------------------------------------------------------------------------
+void DOMXPathValue::stringValue(const DOMNode* node, XMLBuffer& toFill)
+{
+    switch (node->getNodeType())
+    {
+    case DOMNode::ELEMENT_NODE:
+    case DOMNode::DOCUMENT_NODE:
+    case DOMNode::DOCUMENT_FRAGMENT_NODE:
+        appendTextDescendants(node, toFill);
+        break;
+    case DOMNode::TEXT_NODE:
+    case DOMNode::CDATA_SECTION_NODE:
+        for (const DOMNode* text = node; text && isTextNode(text); text = flatNext(text))
+            toFill.append(text->getNodeValue());
+        break;
+    default:
+        if (node->getNodeValue())
+            toFill.append(node->getNodeValue());
+        break;
+    }
+}
+
+// ---------------------------------------------------------------------------
+//  DOMXPathPlan: Evaluation
+// ---------------------------------------------------------------------------
+DOMXPathValue* DOMXPathPlan::evaluate(const DOMNode* contextNode) const
+{
+    if (contextNode == 0)
+        throw DOMException(DOMException::NOT_SUPPORTED_ERR, 0, fMemoryManager);
+
+    switch (contextNode->getNodeType())
+    {
+    case DOMNode::DOCUMENT_NODE:
+    case DOMNode::DOCUMENT_FRAGMENT_NODE:
+    case DOMNode::ELEMENT_NODE:
+    case DOMNode::ATTRIBUTE_NODE:
+    case DOMNode::TEXT_NODE:
+    case DOMNode::CDATA_SECTION_NODE:
+    case DOMNode::COMMENT_NODE:
+    case DOMNode::PROCESSING_INSTRUCTION_NODE:
+        break;
+    default:
+        if (contextNode->getNodeType() != kNamespaceNodeType)
+            throw DOMException(DOMException::NOT_SUPPORTED_ERR, 0, fMemoryManager);
+        break;
+    }
+
+    XPathContext context;
+    context.fNode = textLeader(const_cast<DOMNode*>(contextNode));
+    context.fPosition = 1;
+    context.fSize = 1;
+
+    XPathEvaluator evaluator(fMemoryManager);
+    DOMXPathValue* value = evaluator.evaluate(fRoot, context);
+    value->adoptNamespaceNodes(evaluator.orphanNamespaceNodes());
+    return value;
+}
+
+}
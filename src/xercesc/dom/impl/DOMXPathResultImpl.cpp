@@ -16,8 +16,13 @@
  */
 
 #include "DOMXPathResultImpl.hpp"
+#include "DOMDocumentImpl.hpp"
+#include <xercesc/dom/DOMException.hpp>
 #include <xercesc/dom/DOMNode.hpp>
 #include <xercesc/dom/DOMXPathException.hpp>
+#include <xercesc/util/Janitor.hpp>
+#include <xercesc/util/ValueHashTableOf.hpp>
+#include <xercesc/util/XMLString.hpp>
 
 namespace XERCES_CPP_NAMESPACE {
 
@@ -25,7 +30,13 @@ DOMXPathResultImpl::DOMXPathResultImpl(ResultType type,
                                        MemoryManager* const manager)
     : fType(type),
       fMemoryManager(manager),
-      fIndex (0)
+      fNamespaceNodes (0),
+      fDocument (0),
+      fChanges (0),
+      fIndex (0),
+      fNumberValue (0),
+      fBooleanValue (false),
+      fStringValue (0)
 {
     fSnapshot = new (fMemoryManager) RefVectorOf<DOMNode>(13, false, fMemoryManager);
 }
@@ -33,6 +44,8 @@ DOMXPathResultImpl::DOMXPathResultImpl(ResultType type,
 DOMXPathResultImpl::~DOMXPathResultImpl()
 {
     delete fSnapshot;
+    delete fNamespaceNodes;
+    XMLString::release(&fStringValue, fMemoryManager);
 }
 
 //
@@ -54,6 +67,8 @@ bool DOMXPathResultImpl::isNode() const
 
 bool DOMXPathResultImpl::getBooleanValue() const
 {
+    if(fType == BOOLEAN_TYPE)
+        return fBooleanValue;
     throw DOMXPathException(DOMXPathException::TYPE_ERR, 0, fMemoryManager);
 }
 
@@ -64,11 +79,15 @@ int DOMXPathResultImpl::getIntegerValue() const
 
 double DOMXPathResultImpl::getNumberValue() const
 {
+    if(fType == NUMBER_TYPE)
+        return fNumberValue;
     throw DOMXPathException(DOMXPathException::TYPE_ERR, 0, fMemoryManager);
 }
 
 const XMLCh* DOMXPathResultImpl::getStringValue() const
 {
+    if(fType == STRING_TYPE)
+        return fStringValue;
     throw DOMXPathException(DOMXPathException::TYPE_ERR, 0, fMemoryManager);
 }
 
@@ -82,17 +101,35 @@ DOMNode* DOMXPathResultImpl::getNodeValue() const
   {
     return fIndex < fSnapshot->size() ? fSnapshot->elementAt(fIndex) : 0;
   }
+  else if (isIteratorType())
+  {
+    // fIndex counts the nodes consumed by iterateNext()
+    return fIndex > 0 && fIndex <= fSnapshot->size() ? fSnapshot->elementAt(fIndex - 1) : 0;
+  }
   else
     throw DOMXPathException(DOMXPathException::TYPE_ERR, 0, fMemoryManager);
 }
 
 bool DOMXPathResultImpl::iterateNext()
 {
-    throw DOMXPathException(DOMXPathException::TYPE_ERR, 0, fMemoryManager);
+    if(!isIteratorType())
+        throw DOMXPathException(DOMXPathException::TYPE_ERR, 0, fMemoryManager);
+
+    if(getInvalidIteratorState())
+        throw DOMException(DOMException::INVALID_STATE_ERR, 0, fMemoryManager);
+
+    if(fIndex <= fSnapshot->size())
+        fIndex++;
+    return fIndex <= fSnapshot->size();
 }
 
 bool DOMXPathResultImpl::getInvalidIteratorState() const
 {
+    // The result holds its own copy of the node list, but an iterator is
+    // invalidated by any change to the structure of the document, as
+    // recorded by its change counter.
+    if(isIteratorType())
+        return fDocument != 0 && ((const DOMDocumentImpl*)fDocument)->changes() != fChanges;
     throw DOMXPathException(DOMXPathException::TYPE_ERR, 0, fMemoryManager);
 }
 
@@ -128,6 +165,11 @@ void DOMXPathResultImpl::reset(ResultType type)
     fType = type;
     fSnapshot->removeAllElements();
     fIndex = 0;
+    fDocument = 0;
+    fChanges = 0;
+    fNumberValue = 0;
+    fBooleanValue = false;
+    XMLString::release(&fStringValue, fMemoryManager);
 }
 
 void DOMXPathResultImpl::addResult(DOMNode* node)
@@ -135,4 +177,58 @@ void DOMXPathResultImpl::addResult(DOMNode* node)
     fSnapshot->addElement(node);
 }
 
+void DOMXPathResultImpl::setNumberValue(double value)
+{
+    fNumberValue = value;
+}
+
+void DOMXPathResultImpl::setBooleanValue(bool value)
+{
+    fBooleanValue = value;
+}
+
+void DOMXPathResultImpl::setStringValue(const XMLCh* value)
+{
+    XMLString::release(&fStringValue, fMemoryManager);
+    fStringValue = XMLString::replicate(value, fMemoryManager);
+}
+
+void DOMXPathResultImpl::setDocument(const DOMDocument* document)
+{
+    fDocument = document;
+    fChanges = document ? ((const DOMDocumentImpl*)document)->changes() : 0;
+}
+
+void DOMXPathResultImpl::adoptNamespaceNodes(RefVectorOf<DOMNode>* nodes)
+{
+    RefVectorOf<DOMNode>* previous = fNamespaceNodes;
+    fNamespaceNodes = nodes;
+    if (previous == 0)
+        return;
+
+    // When the result is reused, one of its own namespace nodes may have
+    // been the context node and may be part of the new result, so keep
+    // the ones that are still referenced.
+    Janitor<RefVectorOf<DOMNode> > janPrevious(previous);
+    if (previous->size() == 0 || fSnapshot->size() == 0)
+        return;
+
+    ValueHashTableOf<bool, PtrHasher> referenced(fSnapshot->size() * 2 + 1, fMemoryManager);
+    for (XMLSize_t i = 0; i < fSnapshot->size(); i++)
+        referenced.put(fSnapshot->elementAt(i), true);
+    for (XMLSize_t i = previous->size(); i > 0; i--)
+    {
+        if (!referenced.containsKey(previous->elementAt(i - 1)))
+            continue;
+        if (fNamespaceNodes == 0)
+            fNamespaceNodes = new (fMemoryManager) RefVectorOf<DOMNode>(8, true, fMemoryManager);
+        fNamespaceNodes->addElement(previous->orphanElementAt(i - 1));
+    }
+}
+
+bool DOMXPathResultImpl::isIteratorType() const
+{
+    return fType == UNORDERED_NODE_ITERATOR_TYPE || fType == ORDERED_NODE_ITERATOR_TYPE;
+}
+
 }
@@ -28,6 +28,8 @@
 
 namespace XERCES_CPP_NAMESPACE {
 
+class DOMDocument;
+
 class CDOM_EXPORT DOMXPathResultImpl :  public XMemory,
                                         public DOMXPathResult
 {
@@ -53,12 +55,25 @@ public:
 public:
     void reset(ResultType type);
     void addResult(DOMNode* node);
+    void setNumberValue(double value);
+    void setBooleanValue(bool value);
+    void setStringValue(const XMLCh* value);
+    void adoptNamespaceNodes(RefVectorOf<DOMNode>* nodes);
+    void setDocument(const DOMDocument* document);
 
 protected:
+    bool isIteratorType() const;
+
     ResultType              fType;
     MemoryManager* const    fMemoryManager;
     RefVectorOf<DOMNode>*   fSnapshot;
+    RefVectorOf<DOMNode>*   fNamespaceNodes;
+    const DOMDocument*      fDocument;
+    int                     fChanges;
     XMLSize_t               fIndex;
+    double                  fNumberValue;
+    bool                    fBooleanValue;
+    XMLCh*                  fStringValue;
 };
 
 }
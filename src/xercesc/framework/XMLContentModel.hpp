@@ -123,6 +123,36 @@ public:
                                     XMLSize_t elementIndex,
                                     SubstitutionGroupComparator * comparator) const = 0;
 
+    // -----------------------------------------------------------------------
+    //  The incremental content model interface
+    //
+    //  A model that supports it is driven one child at a time, as the start
+    //  tags are seen, so the caller only has to keep a state and a loop
+    //  counter per open element instead of the list of its children. The
+    //  state starts at 0 and the loop counter at 0 for each element.
+    //  validateNextChild() returns false, leaving the state unchanged, if the
+    //  child is not valid at this point; validateEndOfContent() tells whether
+    //  the content may end in the given state. Models that do not support
+    //  this are only checked through validateContent() at the end tag.
+    // -----------------------------------------------------------------------
+    virtual bool supportsIncrementalValidation() const
+    {
+        return false;
+    }
+
+    virtual bool validateNextChild(const QName* const
+                                 , unsigned int&
+                                 , unsigned int&
+                                 , SubstitutionGroupComparator*) const
+    {
+        return false;
+    }
+
+    virtual bool validateEndOfContent(unsigned int, unsigned int) const
+    {
+        return false;
+    }
+
 protected :
     // -----------------------------------------------------------------------
     //  Hidden Constructors
@@ -32,9 +32,14 @@
 #include <xercesc/framework/XMLFormatter.hpp>
 #include <xercesc/util/Janitor.hpp>
 #include <xercesc/util/XMLChar.hpp>
+#include <xercesc/util/OutOfMemoryException.hpp>
 
 #include <cstring>
 
+#if XERCES_HAVE_EMMINTRIN_H
+#   include <emmintrin.h>
+#endif
+
 namespace XERCES_CPP_NAMESPACE {
 
 // ---------------------------------------------------------------------------
@@ -134,6 +139,65 @@ bool XMLFormatter::inEscapeList(const XMLFormatter::EscapeFlags escStyle
 
 }
 
+//
+//  Return the first char from srcPtr on which needs escaping in the given
+//  style, or endPtr if there is none. With SSE2, 8 chars are checked at once
+//  against the escape list and, for XML 1.1, the control char ranges; only
+//  the blocks with a possible hit are looked at char by char.
+//
+const XMLCh* XMLFormatter::findEscape(const XMLFormatter::EscapeFlags escStyle
+                                    , const XMLCh*                    srcPtr
+                                    , const XMLCh* const              endPtr)
+{
+#ifdef XERCES_HAVE_SSE2_INTRINSIC
+    if (XMLPlatformUtils::fgSSE2ok && (endPtr - srcPtr) >= 8)
+    {
+        __m128i escChars[kEscapeCount];
+        unsigned int escCount = 0;
+        for (const XMLCh* escList = gEscapeChars[escStyle]; *escList; escList++)
+            escChars[escCount++] = _mm_set1_epi16((short)*escList);
+
+        const __m128i lastC0   = _mm_set1_epi16(0x1F);
+        const __m128i firstC1  = _mm_set1_epi16(0x7F);
+        const __m128i rangeC1  = _mm_set1_epi16(0x9F - 0x7F);
+        const __m128i zero     = _mm_setzero_si128();
+
+        while ((endPtr - srcPtr) >= 8)
+        {
+            const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcPtr));
+            __m128i hits = zero;
+            for (unsigned int i = 0; i < escCount; i++)
+                hits = _mm_or_si128(hits, _mm_cmpeq_epi16(chars, escChars[i]));
+
+            if (fIsXML11)
+            {
+                // unsigned compares: chars <= 0x1F, and 0x7F <= chars <= 0x9F
+                hits = _mm_or_si128(hits, _mm_cmpeq_epi16(_mm_subs_epu16(chars, lastC0), zero));
+                hits = _mm_or_si128(hits, _mm_cmpeq_epi16(_mm_subs_epu16(_mm_sub_epi16(chars, firstC1), rangeC1), zero));
+            }
+
+            if (_mm_movemask_epi8(hits) == 0)
+            {
+                srcPtr += 8;
+                continue;
+            }
+
+            // XML 1.1 whitespace is also among the hits
+            for (const XMLCh* blockEnd = srcPtr + 8; srcPtr < blockEnd; srcPtr++)
+            {
+                if (inEscapeList(escStyle, *srcPtr))
+                    return srcPtr;
+            }
+        }
+    }
+#endif
+
+    while ((srcPtr < endPtr) && !inEscapeList(escStyle, *srcPtr))
+        srcPtr++;
+
+    return srcPtr;
+}
+
 
 // ---------------------------------------------------------------------------
 //  XMLFormatter: Constructors and Destructor
@@ -389,106 +453,123 @@ XMLFormatter::formatBuf(const   XMLCh* const    toFormat
                                     ? fUnRepFlags : unrepFlags;
 
     //
-    //  If the actual unrep action is that they want to provide char refs
-    //  for unrepresentable chars, then this one is a much more difficult
-    //  one to do cleanly, and we handle it separately.
+    //  The output of this call is collected in the temp buffer, tmpLen
+    //  bytes of it so far. Whatever gets transcoded before a failure still
+    //  goes out, as it would have if written piece by piece.
     //
-    if (actualUnRep == UnRep_CharRef)
-    {
-        specialFormat(toFormat, count, actualEsc);
-        return;
-    }
-
-    //
-    //  If we don't have any escape flags set, then we can do the most
-    //  efficient loop, else we have to do it the hard way.
-    //
-    const XMLCh*    srcPtr = toFormat;
-    const XMLCh*    endPtr = toFormat + count;
-    if (actualEsc == NoEscapes)
+    XMLSize_t tmpLen = 0;
+    try
     {
         //
-        //  Just do a whole buffer at a time into the temp buffer, cap
-        //  it off, and send it to the target.
+        //  If the actual unrep action is that they want to provide char refs
+        //  for unrepresentable chars, then this one is a much more difficult
+        //  one to do cleanly, and we handle it separately.
         //
-        if (srcPtr < endPtr)
-           srcPtr += handleUnEscapedChars(srcPtr, endPtr - srcPtr, actualUnRep);
-    }
-     else
-    {
+        //  If we don't have any escape flags set, then we can do the most
+        //  efficient loop, else we have to do it the hard way.
         //
-        //  Escape chars that require it according to the scale flags
-        //  we were given. For the others, try to accumulate them and
-        //  format them in as big as bulk as we can.
-        //
-        while (srcPtr < endPtr)
+        const XMLCh*    srcPtr = toFormat;
+        const XMLCh*    endPtr = toFormat + count;
+        if (actualUnRep == UnRep_CharRef)
+        {
+            specialFormat(toFormat, count, actualEsc, tmpLen);
+        }
+         else if (actualEsc == NoEscapes)
         {
             //
-            //  Run a temp pointer up until we hit a character that we have
-            //  to escape. Then we can convert all the chars between our
-            //  current source pointer and here all at once.
+            //  Just do a whole buffer at a time into the temp buffer, cap
+            //  it off, and send it to the target.
             //
-            const XMLCh* tmpPtr = srcPtr;
-            while ((tmpPtr < endPtr) && !inEscapeList(actualEsc, *tmpPtr))
-                tmpPtr++;
-
+            if (srcPtr < endPtr)
+               srcPtr += handleUnEscapedChars(srcPtr, endPtr - srcPtr, actualUnRep,
+                                              tmpLen);
+        }
+         else
+        {
             //
-            //  If we got any chars, then lets convert them and write them
-            //  out.
+            //  Escape chars that require it according to the scale flags
+            //  we were given. For the others, try to accumulate them and
+            //  format them in as big as bulk as we can.
             //
-            if (tmpPtr > srcPtr)
-               srcPtr += handleUnEscapedChars(srcPtr, tmpPtr - srcPtr,
-                                              actualUnRep);
-
-             else if (tmpPtr < endPtr)
+            while (srcPtr < endPtr)
             {
                 //
-                //  Ok, so we've hit a char that must be escaped. So do
-                //  this one specially.
+                //  Run a temp pointer up until we hit a character that we
+                //  have to escape. Then we can convert all the chars between
+                //  our current source pointer and here all at once.
                 //
-                const XMLByte * theChars;
-                switch (*srcPtr) {
-                    case chAmpersand :
-                        theChars = getCharRef(fAmpLen, fAmpRef, gAmpRef);
-                        fTarget->writeChars(theChars, fAmpLen, this);
-                        break;
-
-                    case chSingleQuote :
-                        theChars = getCharRef(fAposLen, fAposRef, gAposRef);
-                        fTarget->writeChars(theChars, fAposLen, this);
-                        break;
-
-                    case chDoubleQuote :
-                        theChars = getCharRef(fQuoteLen, fQuoteRef, gQuoteRef);
-                        fTarget->writeChars(theChars, fQuoteLen, this);
-                        break;
-
-                    case chCloseAngle :
-                        theChars = getCharRef(fGTLen, fGTRef, gGTRef);
-                        fTarget->writeChars(theChars, fGTLen, this);
-                        break;
-
-                    case chOpenAngle :
-                        theChars = getCharRef(fLTLen, fLTRef, gLTRef);
-                        fTarget->writeChars(theChars, fLTLen, this);
-                        break;
-
-                    default:
-                        // control characters
-                        writeCharRef(*srcPtr);
-                        break;
+                const XMLCh* tmpPtr = findEscape(actualEsc, srcPtr, endPtr);
+
+                //
+                //  If we got any chars, then lets convert them and write them
+                //  out.
+                //
+                if (tmpPtr > srcPtr)
+                   srcPtr += handleUnEscapedChars(srcPtr, tmpPtr - srcPtr,
+                                                  actualUnRep, tmpLen);
+
+                 else if (tmpPtr < endPtr)
+                {
+                    //
+                    //  Ok, so we've hit a char that must be escaped. So do
+                    //  this one specially.
+                    //
+                    const XMLByte * theChars;
+                    switch (*srcPtr) {
+                        case chAmpersand :
+                            theChars = getCharRef(fAmpLen, fAmpRef, gAmpRef);
+                            writeBytes(theChars, fAmpLen, tmpLen);
+                            break;
+
+                        case chSingleQuote :
+                            theChars = getCharRef(fAposLen, fAposRef, gAposRef);
+                            writeBytes(theChars, fAposLen, tmpLen);
+                            break;
+
+                        case chDoubleQuote :
+                            theChars = getCharRef(fQuoteLen, fQuoteRef, gQuoteRef);
+                            writeBytes(theChars, fQuoteLen, tmpLen);
+                            break;
+
+                        case chCloseAngle :
+                            theChars = getCharRef(fGTLen, fGTRef, gGTRef);
+                            writeBytes(theChars, fGTLen, tmpLen);
+                            break;
+
+                        case chOpenAngle :
+                            theChars = getCharRef(fLTLen, fLTRef, gLTRef);
+                            writeBytes(theChars, fLTLen, tmpLen);
+                            break;
+
+                        default:
+                            // control characters
+                            writeCharRef(*srcPtr, tmpLen);
+                            break;
+                    }
+                    srcPtr++;
                 }
-                srcPtr++;
             }
         }
     }
+    catch(const OutOfMemoryException&)
+    {
+        throw;
+    }
+    catch(...)
+    {
+        flushTmpBuf(tmpLen);
+        throw;
+    }
+
+    flushTmpBuf(tmpLen);
 }
 
 
 XMLSize_t
 XMLFormatter::handleUnEscapedChars(const XMLCh *                  srcPtr,
                                    const XMLSize_t                oCount,
-                                   const UnRepFlags               actualUnRep)
+                                   const UnRepFlags               actualUnRep,
+                                   XMLSize_t&                     tmpLen)
 {
    //
    //  Use that to figure out what I should pass to the transcoder. If we
@@ -504,23 +585,30 @@ XMLFormatter::handleUnEscapedChars(const XMLCh *                  srcPtr,
    XMLSize_t charsEaten;
    XMLSize_t count = oCount;
 
+   //
+   //  The chars are transcoded straight behind the output already in the
+   //  temp buffer, which is only handed over to the target when full.
+   //
    while (count) {
      const XMLSize_t srcChars = (count > XMLSize_t (kTmpBufSize))
        ? XMLSize_t (kTmpBufSize) : count;
 
+      if (tmpLen == kTmpBufSize)
+         flushTmpBuf(tmpLen);
+
+      charsEaten = 0;
       const XMLSize_t outBytes
          = fXCoder->transcodeTo(srcPtr, srcChars,
-                                fTmpBuf, kTmpBufSize,
+                                &fTmpBuf[tmpLen], kTmpBufSize - tmpLen,
                                 charsEaten, unRepOpts);
 
-      if (outBytes) {
-         fTmpBuf[outBytes]     = 0; fTmpBuf[outBytes + 1] = 0;
-         fTmpBuf[outBytes + 2] = 0; fTmpBuf[outBytes + 3] = 0;
-         fTarget->writeChars(fTmpBuf, outBytes, this);
-      }
+      tmpLen  += outBytes;
+      srcPtr  += charsEaten;
+      count   -= charsEaten;
 
-      srcPtr += charsEaten;
-      count  -= charsEaten;
+      // Make room if the next char did not fit anymore
+      if (count && tmpLen)
+         flushTmpBuf(tmpLen);
    }
 
    return oCount; // This should be an assertion that count == 0.
@@ -559,7 +647,7 @@ void XMLFormatter::writeBOM(const XMLByte* const toFormat
 // ---------------------------------------------------------------------------
 //  XMLFormatter: Private helper methods
 // ---------------------------------------------------------------------------
-void XMLFormatter::writeCharRef(const XMLCh &toWrite)
+void XMLFormatter::writeCharRef(const XMLCh &toWrite, XMLSize_t& tmpLen)
 {
     XMLCh tmpBuf[32];
     tmpBuf[0] = chAmpersand;
@@ -573,14 +661,11 @@ void XMLFormatter::writeCharRef(const XMLCh &toWrite)
     tmpBuf[bufLen+1] = chNull;
 
     // write it out
-    formatBuf(tmpBuf
-            , bufLen + 1
-            , XMLFormatter::NoEscapes
-            , XMLFormatter::UnRep_Fail);
+    handleUnEscapedChars(tmpBuf, bufLen + 1, XMLFormatter::UnRep_Fail, tmpLen);
 
 }
 
-void XMLFormatter::writeCharRef(XMLSize_t toWrite)
+void XMLFormatter::writeCharRef(XMLSize_t toWrite, XMLSize_t& tmpLen)
 {
     XMLCh tmpBuf[64];
     tmpBuf[0] = chAmpersand;
@@ -594,10 +679,7 @@ void XMLFormatter::writeCharRef(XMLSize_t toWrite)
     tmpBuf[bufLen+1] = chNull;
 
     // write it out
-    formatBuf(tmpBuf
-            , bufLen + 1
-            , XMLFormatter::NoEscapes
-            , XMLFormatter::UnRep_Fail);
+    handleUnEscapedChars(tmpBuf, bufLen + 1, XMLFormatter::UnRep_Fail, tmpLen);
 
 }
 
@@ -608,22 +690,24 @@ const XMLByte* XMLFormatter::getCharRef(XMLSize_t     &count,
 {
    if (!ref) {
 
+       // Not in the temp buffer, which may hold output not yet written
+       XMLByte refBuf[64];
        XMLSize_t charsEaten;
        const XMLSize_t outBytes =
            fXCoder->transcodeTo(stdRef, XMLString::stringLen(stdRef),
-                                fTmpBuf, kTmpBufSize, charsEaten,
+                                refBuf, sizeof(refBuf) - 4, charsEaten,
                                 XMLTranscoder::UnRep_Throw);
 
-       fTmpBuf[outBytes] = 0;
-       fTmpBuf[outBytes + 1] = 0;
-       fTmpBuf[outBytes + 2] = 0;
-       fTmpBuf[outBytes + 3] = 0;
+       refBuf[outBytes] = 0;
+       refBuf[outBytes + 1] = 0;
+       refBuf[outBytes + 2] = 0;
+       refBuf[outBytes + 3] = 0;
 
        ref = (XMLByte*) fMemoryManager->allocate
        (
            (outBytes + 4) * sizeof(XMLByte)
        );//new XMLByte[outBytes + 4];
-       memcpy(ref, fTmpBuf, outBytes + 4);
+       memcpy(ref, refBuf, outBytes + 4);
        count = outBytes;
    }
 
@@ -632,7 +716,8 @@ const XMLByte* XMLFormatter::getCharRef(XMLSize_t     &count,
 
 void XMLFormatter::specialFormat(const  XMLCh* const    toFormat
                                 , const XMLSize_t       count
-                                , const EscapeFlags     escapeFlags)
+                                , const EscapeFlags     escapeFlags
+                                ,       XMLSize_t&      tmpLen)
 {
     //
     //  We have to check each character and see if it could be represented.
@@ -658,7 +743,9 @@ void XMLFormatter::specialFormat(const  XMLCh* const    toFormat
 
         if (tmpPtr > srcPtr)
         {
-            // We got at least some chars that can be done normally
+            // We got at least some chars that can be done normally, after
+            // the char refs collected so far
+            flushTmpBuf(tmpLen);
             formatBuf
             (
                 srcPtr
@@ -685,11 +772,11 @@ void XMLFormatter::specialFormat(const  XMLCh* const    toFormat
                     // hex 0xFFFF printed.
                     tmpPtr = srcPtr;
                     tmpPtr++; // point at low surrogate
-                    writeCharRef((XMLSize_t) (0x10000+((*srcPtr-0xD800)<<10)+*tmpPtr-0xDC00));
+                    writeCharRef((XMLSize_t) (0x10000+((*srcPtr-0xD800)<<10)+*tmpPtr-0xDC00), tmpLen);
                     srcPtr++; // advance to low surrogate (will advance again below)
                 }
                 else {
-                    writeCharRef(*srcPtr);
+                    writeCharRef(*srcPtr, tmpLen);
                 }
 
                 // Move up the source pointer and break out if needed
@@ -701,4 +788,36 @@ void XMLFormatter::specialFormat(const  XMLCh* const    toFormat
     }
 }
 
+void XMLFormatter::writeBytes(const XMLByte* const toWrite
+                            , const XMLSize_t      count
+                            ,       XMLSize_t&     tmpLen)
+{
+    if (tmpLen + count > kTmpBufSize)
+    {
+        flushTmpBuf(tmpLen);
+        if (count > kTmpBufSize)
+        {
+            fTarget->writeChars(toWrite, count, this);
+            return;
+        }
+    }
+
+    memcpy(&fTmpBuf[tmpLen], toWrite, count);
+    tmpLen += count;
+}
+
+void XMLFormatter::flushTmpBuf(XMLSize_t& tmpLen)
+{
+    if (tmpLen)
+    {
+        // Targets may treat the bytes as a null terminated string
+        fTmpBuf[tmpLen]     = 0; fTmpBuf[tmpLen + 1] = 0;
+        fTmpBuf[tmpLen + 2] = 0; fTmpBuf[tmpLen + 3] = 0;
+
+        const XMLSize_t count = tmpLen;
+        tmpLen = 0;
+        fTarget->writeChars(fTmpBuf, count, this);
+    }
+}
+
 }
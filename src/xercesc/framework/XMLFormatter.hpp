@@ -358,22 +358,34 @@ private :
                               XMLByte*      &ref,
                               const XMLCh *  stdRef);
 
-    void writeCharRef(const XMLCh &toWrite);
-    void writeCharRef(XMLSize_t toWrite);
+    void writeCharRef(const XMLCh &toWrite, XMLSize_t& tmpLen);
+    void writeCharRef(XMLSize_t toWrite, XMLSize_t& tmpLen);
 
     bool inEscapeList(const XMLFormatter::EscapeFlags escStyle
                     , const XMLCh                     toCheck);
 
+    const XMLCh* findEscape(const XMLFormatter::EscapeFlags escStyle
+                          , const XMLCh*                    srcPtr
+                          , const XMLCh* const              endPtr);
+
+    void writeBytes(const XMLByte* const toWrite
+                  , const XMLSize_t      count
+                  ,       XMLSize_t&     tmpLen);
+
+    void flushTmpBuf(XMLSize_t& tmpLen);
+
 
     XMLSize_t handleUnEscapedChars(const XMLCh *      srcPtr,
                                    const XMLSize_t    count,
-                                   const UnRepFlags   unrepFlags);
+                                   const UnRepFlags   unrepFlags,
+                                   XMLSize_t&         tmpLen);
 
     void specialFormat
     (
         const   XMLCh* const    toFormat
         , const XMLSize_t       count
         , const EscapeFlags     escapeFlags
+        ,       XMLSize_t&      tmpLen
     );
 
 
@@ -402,7 +414,11 @@ private :
     //
     //  fTmpBuf
     //      An output buffer that we use to transcode chars into before we
-    //      send them off to be output.
+    //      send them off to be output. The output of a formatting call,
+    //      char refs included, is collected there and handed to the target
+    //      at the end of the call or whenever the buffer is full. How much
+    //      of it is filled is kept by the call itself, so it is always
+    //      empty in between calls.
     //
     //  fAposRef
     //  fAmpRef
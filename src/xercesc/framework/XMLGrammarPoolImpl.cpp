@@ -153,6 +153,11 @@ void XMLGrammarPoolImpl::lockPool()
         {
             fSynchronizedStringPool = new (memMgr) XMLSynchronizedStringPool(fStringPool, 109, memMgr);
         }
+
+        // Nothing is built lazily in the grammars once they are shared
+        RefHashTableOfEnumerator<Grammar> grammarEnum(fGrammarRegistry, false, memMgr);
+        while (grammarEnum.hasMoreElements())
+            grammarEnum.nextElement().prepareForSharing();
         if (!fXSModelIsValid)
         {
             createXSModel();
@@ -265,6 +270,18 @@ void XMLGrammarPoolImpl::serializeGrammars(BinOutputStream* const binOut)
  *   .empty gramamrRegistry
  ***/
 void XMLGrammarPoolImpl::deserializeGrammars(BinInputStream* const binIn)
+{
+    XSerializeEngine  serEng(binIn, this);
+    loadGrammars(serEng);
+}
+
+void XMLGrammarPoolImpl::deserializeGrammars(const XMLByte* const image, const XMLSize_t imageSize)
+{
+    XSerializeEngine  serEng(image, imageSize, this);
+    loadGrammars(serEng);
+}
+
+void XMLGrammarPoolImpl::loadGrammars(XSerializeEngine& serEng)
 {
     MemoryManager *memMgr = getMemoryManager();
     unsigned int stringCount = fStringPool->getStringCount();
@@ -295,10 +312,9 @@ void XMLGrammarPoolImpl::deserializeGrammars(BinInputStream* const binIn)
     // thrown during deserialization.
     JanitorMemFunCall<XMLGrammarPoolImpl>   cleanup(this, &XMLGrammarPoolImpl::cleanUp);
 
+    bool locked = false;
     try
     {
-        XSerializeEngine  serEng(binIn, this);
-
         //version information
         unsigned int  StorerLevel;
         serEng>>StorerLevel;
@@ -320,8 +336,8 @@ void XMLGrammarPoolImpl::deserializeGrammars(BinInputStream* const binIn)
                     , memMgr);
         }
 
-        //lock status
-        serEng>>fLocked;
+        //lock status, the pool is locked once everything is loaded
+        serEng>>locked;
 
         //StringPool, don't use >>
         fStringPool->serialize(serEng);
@@ -345,9 +361,9 @@ void XMLGrammarPoolImpl::deserializeGrammars(BinInputStream* const binIn)
     // Everything is OK, so we can release the cleanup object.
     cleanup.release();
 
-    if (fLocked)
+    if (locked)
     {
-        createXSModel();
+        lockPool();
     }
 }
 
@@ -27,6 +27,7 @@
 namespace XERCES_CPP_NAMESPACE {
 
 class XMLSynchronizedStringPool;
+class XSerializeEngine;
 
 class XMLUTIL_EXPORT XMLGrammarPoolImpl : public XMLGrammarPool
 {
@@ -232,13 +233,34 @@ public :
       *
       *    Client application shall be aware of the unpredicatable/undefined consequence
       *    of this decoupling.
+      *
+      * Locking
+      *
+      *    A pool that was locked when it was serialized is locked again by
+      *    deserialization, and its grammars are prepared like lockPool() does.
       */
 
     virtual void     serializeGrammars(BinOutputStream* const);
     virtual void     deserializeGrammars(BinInputStream* const);
 
+    /**
+      * Non-standard extension.
+      *
+      * Deserializes the grammars from the bytes written by serializeGrammars(),
+      * held in memory, for instance by mapping a file. The bytes are read in
+      * place instead of being copied, and can be released once this returns.
+      * They must be aligned like memory returned by a MemoryManager, which a
+      * mapped file always is.
+      *
+      * @param image     The first byte written by serializeGrammars()
+      * @param imageSize The number of bytes at <code>image</code>
+      */
+    void             deserializeGrammars(const XMLByte* const image, const XMLSize_t imageSize);
+
 private:
 
+    void            loadGrammars(XSerializeEngine& serEng);
+
     virtual void    createXSModel();
 
     void
@@ -116,6 +116,9 @@ XMLSize_t ElemStack::addLevel()
     fStack[fStackTop]->fThisElement = 0;
     fStack[fStackTop]->fReaderNum = 0xFFFFFFFF;
     fStack[fStackTop]->fChildCount = 0;
+    fStack[fStackTop]->fChildrenValidated = false;
+    fStack[fStackTop]->fContentState = 0;
+    fStack[fStackTop]->fContentLoop = 0;
     fStack[fStackTop]->fMapCount = 0;
     fStack[fStackTop]->fValidationFlag = false;
     fStack[fStackTop]->fCommentOrPISeen = false;
@@ -153,6 +156,9 @@ XMLSize_t ElemStack::addLevel(XMLElementDecl* const toSet, const XMLSize_t reade
     fStack[fStackTop]->fThisElement = toSet;
     fStack[fStackTop]->fReaderNum = readerNum;
     fStack[fStackTop]->fChildCount = 0;
+    fStack[fStackTop]->fChildrenValidated = false;
+    fStack[fStackTop]->fContentState = 0;
+    fStack[fStackTop]->fContentLoop = 0;
     fStack[fStackTop]->fMapCount = 0;
     fStack[fStackTop]->fValidationFlag = false;
     fStack[fStackTop]->fCommentOrPISeen = false;
@@ -247,6 +253,29 @@ XMLSize_t ElemStack::addChild(QName* const child, const bool toParent)
     return curRow->fChildCount - 1;
 }
 
+XMLSize_t ElemStack::addValidatedChild(const unsigned int  contentState
+                                     , const unsigned int  contentLoop
+                                     , const bool          toParent)
+{
+    if (!fStackTop)
+        ThrowXMLwithMemMgr(EmptyStackException, XMLExcepts::ElemStack_EmptyStack, fMemoryManager);
+
+    if (toParent && (fStackTop < 2))
+        ThrowXMLwithMemMgr(NoSuchElementException, XMLExcepts::ElemStack_NoParentPushed, fMemoryManager);
+
+    StackElem* curRow = toParent
+                        ? fStack[fStackTop - 2] : fStack[fStackTop - 1];
+
+    //
+    //  The child has already been checked against the content model, so
+    //  only the state it left the model in is kept, not the child itself.
+    //
+    curRow->fChildrenValidated = true;
+    curRow->fContentState = contentState;
+    curRow->fContentLoop = contentLoop;
+    return curRow->fChildCount++;
+}
+
 const ElemStack::StackElem* ElemStack::topElement() const
 {
     if (!fStackTop)
@@ -255,6 +284,14 @@ const ElemStack::StackElem* ElemStack::topElement() const
     return fStack[fStackTop - 1];
 }
 
+const ElemStack::StackElem* ElemStack::parentElement() const
+{
+    if (fStackTop < 2)
+        ThrowXMLwithMemMgr(NoSuchElementException, XMLExcepts::ElemStack_NoParentPushed, fMemoryManager);
+
+    return fStack[fStackTop - 2];
+}
+
 
 // ---------------------------------------------------------------------------
 //  ElemStack: Prefix map methods
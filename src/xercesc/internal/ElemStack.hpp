@@ -83,6 +83,11 @@ public :
     //      The fRowCapacity is how large fChildIds has grown so far.
     //      fChildCount is how many of them are valid right now.
     //
+    //      When the content model of the element checks each child as its
+    //      start tag is seen, fChildrenValidated is set and the children are
+    //      only counted. fContentState and fContentLoop are then the state
+    //      and loop counter the content model has reached so far.
+    //
     //      The fMapCapacity is how large fMap has grown so far. fMapCount
     //      is how many of them are valid right now.
     //
@@ -104,6 +109,9 @@ public :
         XMLSize_t           fChildCapacity;
         XMLSize_t           fChildCount;
         QName**             fChildren;
+        bool                fChildrenValidated;
+        unsigned int        fContentState;
+        unsigned int        fContentLoop;
 
         PrefMapElem*        fMap;
         XMLSize_t           fMapCapacity;
@@ -147,7 +155,14 @@ public :
     //  Stack top access
     // -----------------------------------------------------------------------
     XMLSize_t addChild(QName* const child, const bool toParent);
+    XMLSize_t addValidatedChild
+    (
+        const unsigned int   contentState
+        , const unsigned int contentLoop
+        , const bool         toParent
+    );
     const StackElem* topElement() const;
+    const StackElem* parentElement() const;
     void setElement(XMLElementDecl* const toSet, const XMLSize_t readerNum);
 
     void setValidationFlag(bool validationFlag);
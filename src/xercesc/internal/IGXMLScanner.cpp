@@ -1072,6 +1072,15 @@ void IGXMLScanner::scanEndTag(bool& gotData)
                , topElem->fThisElement->getFullName()
                );
        }
+        if (topElem->fChildrenValidated && fGrammarType == Grammar::SchemaGrammarType)
+        {
+            ((SchemaValidator*) fValidator)->setContentState
+            (
+                topElem->fContentState
+                , topElem->fContentLoop
+            );
+        }
+
         XMLSize_t failure;
         bool res = fValidator->checkContent
         (
@@ -2587,7 +2596,10 @@ bool IGXMLScanner::scanStartTagNS(bool& gotData)
         //  If the element stack is not empty, then add this element as a
         //  child of the previous top element. If its empty, this is the root
         //  elem and is not the child of anything.
-        fElemStack.addChild(elemDecl->getElementName(), true);
+        if (cm && cm->supportsIncrementalValidation())
+            validateChildContent(elemDecl->getElementName(), cm);
+        else
+            fElemStack.addChild(elemDecl->getElementName(), true);
     }
 
     // PSVI handling:  even if it turns out there are
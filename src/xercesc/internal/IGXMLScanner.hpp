@@ -164,6 +164,8 @@ private :
     bool laxElementValidation(QName* element, ContentLeafNameTypeVector* cv,
                               const XMLContentModel* const cm,
                               const XMLSize_t parentElemDepth);
+    void validateChildContent(QName* const child,
+                              const XMLContentModel* const cm);
     bool anyAttributeValidation(SchemaAttDef* attWildCard,
                                 unsigned int uriId,
                                 bool& skipThisOne,
@@ -1794,6 +1794,7 @@ void IGXMLScanner::resolveSchemaGrammar(const XMLCh* const loc, const XMLCh* con
 
         parser.setValidationScheme(XercesDOMParser::Val_Never);
         parser.setDoNamespaces(true);
+        parser.setIgnoreAnnotations(fIgnoreAnnotations);
         parser.setUserEntityHandler(fEntityHandler);
         parser.setUserErrorReporter(fErrorReporter);
 
@@ -2152,6 +2153,7 @@ Grammar* IGXMLScanner::loadXMLSchemaGrammar(const InputSource& src,
 
     parser.setValidationScheme(XercesDOMParser::Val_Never);
     parser.setDoNamespaces(true);
+    parser.setIgnoreAnnotations(fIgnoreAnnotations);
     parser.setUserEntityHandler(fEntityHandler);
     parser.setUserErrorReporter(fErrorReporter);
 
@@ -3337,6 +3339,35 @@ bool IGXMLScanner::switchGrammar(const XMLCh* const newGrammarNameSpace)
     }
 }
 
+// The content model of the parent checks this child right away, so that
+// only the state the model has reached is kept until the parent's end tag.
+void IGXMLScanner::validateChildContent(QName* const child,
+                                        const XMLContentModel* const cm)
+{
+    const ElemStack::StackElem* parentElem = fElemStack.parentElement();
+    unsigned int contentState = parentElem->fContentState;
+    unsigned int contentLoop = parentElem->fContentLoop;
+
+    // Only the first bad child is reported, as at the end tag
+    if (contentState != XMLContentModel::gInvalidTrans)
+    {
+        SubstitutionGroupComparator comparator(fGrammarResolver, fURIStringPool);
+        if (!cm->validateNextChild(child, contentState, contentLoop, &comparator))
+        {
+            fValidator->emitError
+            (
+                XMLValid::ElementNotValidForContent
+                , child->getRawName()
+                , parentElem->fThisElement->getFormattedContentModel()
+            );
+            contentState = XMLContentModel::gInvalidTrans;
+            contentLoop = 0;
+        }
+    }
+
+    fElemStack.addValidatedChild(contentState, contentLoop, true);
+}
+
 // check if we should skip or lax the validation of the element
 // if skip - no validation
 // if lax - validate only if the element if found
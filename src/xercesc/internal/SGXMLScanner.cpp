@@ -922,6 +922,15 @@ void SGXMLScanner::scanEndTag(bool& gotData)
     DatatypeValidator* psviMemberType = 0;
     if (fValidate)
     {
+        if (topElem->fChildrenValidated)
+        {
+            ((SchemaValidator*) fValidator)->setContentState
+            (
+                topElem->fContentState
+                , topElem->fContentLoop
+            );
+        }
+
         XMLSize_t failure;
         bool res = fValidator->checkContent
         (
@@ -1579,7 +1588,10 @@ bool SGXMLScanner::scanStartTag(bool& gotData)
         //  If the element stack is not empty, then add this element as a
         //  child of the previous top element. If its empty, this is the root
         //  elem and is not the child of anything.
-        fElemStack.addChild(elemDecl->getElementName(), true);
+        if (cm && cm->supportsIncrementalValidation())
+            validateChildContent(elemDecl->getElementName(), cm);
+        else
+            fElemStack.addChild(elemDecl->getElementName(), true);
     }
 
     // PSVI handling:  must reset this, even if no attributes...
@@ -3611,6 +3623,7 @@ void SGXMLScanner::resolveSchemaGrammar(const XMLCh* const loc, const XMLCh* con
 
         parser.setValidationScheme(XercesDOMParser::Val_Never);
         parser.setDoNamespaces(true);
+        parser.setIgnoreAnnotations(fIgnoreAnnotations);
         parser.setUserEntityHandler(fEntityHandler);
         parser.setUserErrorReporter(fErrorReporter);
 
@@ -3940,6 +3953,7 @@ Grammar* SGXMLScanner::loadXMLSchemaGrammar(const InputSource& src,
 
     parser.setValidationScheme(XercesDOMParser::Val_Never);
     parser.setDoNamespaces(true);
+    parser.setIgnoreAnnotations(fIgnoreAnnotations);
     parser.setUserEntityHandler(fEntityHandler);
     parser.setUserErrorReporter(fErrorReporter);
 
@@ -4724,6 +4738,35 @@ bool SGXMLScanner::switchGrammar(const XMLCh* const newGrammarNameSpace)
     }
 }
 
+// The content model of the parent checks this child right away, so that
+// only the state the model has reached is kept until the parent's end tag.
+void SGXMLScanner::validateChildContent(QName* const child,
+                                        const XMLContentModel* const cm)
+{
+    const ElemStack::StackElem* parentElem = fElemStack.parentElement();
+    unsigned int contentState = parentElem->fContentState;
+    unsigned int contentLoop = parentElem->fContentLoop;
+
+    // Only the first bad child is reported, as at the end tag
+    if (contentState != XMLContentModel::gInvalidTrans)
+    {
+        SubstitutionGroupComparator comparator(fGrammarResolver, fURIStringPool);
+        if (!cm->validateNextChild(child, contentState, contentLoop, &comparator))
+        {
+            fValidator->emitError
+            (
+                XMLValid::ElementNotValidForContent
+                , child->getRawName()
+                , parentElem->fThisElement->getFormattedContentModel()
+            );
+            contentState = XMLContentModel::gInvalidTrans;
+            contentLoop = 0;
+        }
+    }
+
+    fElemStack.addValidatedChild(contentState, contentLoop, true);
+}
+
 // check if we should skip or lax the validation of the element
 // if skip - no validation
 // if lax - validate only if the element if found
@@ -117,6 +117,8 @@ protected:
     bool laxElementValidation(QName* element, ContentLeafNameTypeVector* cv,
                               const XMLContentModel* const cm,
                               const XMLSize_t parentElemDepth);
+    void validateChildContent(QName* const child,
+                              const XMLContentModel* const cm);
     XMLSize_t rawAttrScan
     (
         const   XMLCh* const                elemName
@@ -111,6 +111,7 @@ XMLScanner::XMLScanner(XMLValidator* const valToAdopt,
     , fDisableDefaultEntityResolution(false)
     , fSkipDTDValidation(false)
     , fHandleMultipleImports(false)
+    , fParallelSchemaLoading(false)
     , fErrorCount(0)
     , fEntityExpansionLimit(0)
     , fEntityExpansionCount(0)
@@ -213,6 +214,7 @@ XMLScanner::XMLScanner( XMLDocumentHandler* const  docHandler
     , fDisableDefaultEntityResolution(false)
     , fSkipDTDValidation(false)
     , fHandleMultipleImports(false)
+    , fParallelSchemaLoading(false)
     , fErrorCount(0)
     , fEntityExpansionLimit(0)
     , fEntityExpansionCount(0)
@@ -287,6 +287,7 @@ public :
     bool getDisableDefaultEntityResolution() const;
     bool getSkipDTDValidation() const;
     bool getHandleMultipleImports() const;
+    bool getParallelSchemaLoading() const;
 
     // -----------------------------------------------------------------------
     //  Getter methods
@@ -393,6 +394,7 @@ public :
     void setDisableDefaultEntityResolution(const bool newValue);
     void setSkipDTDValidation(const bool newValue);
     void setHandleMultipleImports(const bool newValue);
+    void setParallelSchemaLoading(const bool newValue);
 
     // -----------------------------------------------------------------------
     //  Mutator methods
@@ -788,6 +790,7 @@ protected:
     bool                        fDisableDefaultEntityResolution;
     bool                        fSkipDTDValidation;
     bool                        fHandleMultipleImports;
+    bool                        fParallelSchemaLoading;
     int                         fErrorCount;
     XMLSize_t                   fEntityExpansionLimit;
     XMLSize_t                   fEntityExpansionCount;
@@ -1186,6 +1189,11 @@ inline bool XMLScanner::getHandleMultipleImports() const
     return fHandleMultipleImports;
 }
 
+inline bool XMLScanner::getParallelSchemaLoading() const
+{
+    return fParallelSchemaLoading;
+}
+
 // ---------------------------------------------------------------------------
 //  XMLScanner: Setter methods
 // ---------------------------------------------------------------------------
@@ -1400,6 +1408,11 @@ inline void XMLScanner::setHandleMultipleImports(const bool newValue)
     fHandleMultipleImports = newValue;
 }
 
+inline void XMLScanner::setParallelSchemaLoading(const bool newValue)
+{
+    fParallelSchemaLoading = newValue;
+}
+
 // ---------------------------------------------------------------------------
 //  XMLScanner: Mutator methods
 // ---------------------------------------------------------------------------
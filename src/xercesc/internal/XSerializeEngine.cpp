@@ -87,7 +87,8 @@ XSerializeEngine::~XSerializeEngine()
         delete fLoadPool;
     }
 
-    getMemoryManager()->deallocate(fBufStart);
+    if (!fImageEnd)
+        getMemoryManager()->deallocate(fBufStart);
 
 }
 
@@ -105,6 +106,8 @@ XSerializeEngine::XSerializeEngine(BinInputStream*         inStream
 ,fBufEnd(0)
 ,fBufCur(fBufStart)
 ,fBufLoadMax(fBufStart)
+,fImageCur(0)
+,fImageEnd(0)
 ,fStorePool(0)
 ,fLoadPool( new (gramPool->getMemoryManager()) ValueVectorOf<void*>(29, gramPool->getMemoryManager(), false))
 ,fObjectCount(0)
@@ -116,6 +119,36 @@ XSerializeEngine::XSerializeEngine(BinInputStream*         inStream
 
 }
 
+XSerializeEngine::XSerializeEngine(const XMLByte* const    image
+                                 , const XMLSize_t         imageSize
+                                 , XMLGrammarPool* const   gramPool
+                                 , XMLSize_t               bufSize)
+:fStoreLoad(mode_Load)
+,fStorerLevel(0)
+,fGrammarPool(gramPool)
+,fInputStream(0)
+,fOutputStream(0)
+,fBufCount(0)
+,fBufSize(bufSize)
+,fBufStart((XMLByte*) image)
+,fBufEnd(0)
+,fBufCur(fBufStart)
+,fBufLoadMax(fBufStart)
+,fImageCur(image)
+,fImageEnd(image + imageSize)
+,fStorePool(0)
+,fLoadPool( new (gramPool->getMemoryManager()) ValueVectorOf<void*>(29, gramPool->getMemoryManager(), false))
+,fObjectCount(0)
+{
+    ensurePointer((void*) image);
+
+    /***
+     *  point the buffer at the first bytes of the image
+     ***/
+    fillBuffer();
+
+}
+
 XSerializeEngine::XSerializeEngine(BinOutputStream*        outStream
                                  , XMLGrammarPool* const   gramPool
                                  , XMLSize_t               bufSize)
@@ -130,6 +163,8 @@ XSerializeEngine::XSerializeEngine(BinOutputStream*        outStream
 ,fBufEnd(fBufStart+bufSize)
 ,fBufCur(fBufStart)
 ,fBufLoadMax(0)
+,fImageCur(0)
+,fImageEnd(0)
 ,fStorePool( new (gramPool->getMemoryManager()) RefHashTableOf<XSerializedObjectId, PtrHasher>(29, true, gramPool->getMemoryManager()) )
 ,fLoadPool(0)
 ,fObjectCount(0)
@@ -571,11 +606,7 @@ XSerializeEngine& XSerializeEngine::operator<<(XMLCh xch)
 
 XSerializeEngine& XSerializeEngine::operator>>(XMLCh& xch)
 {
-    checkAndFillBuffer(calBytesNeeded(sizeof(XMLCh)));
-
-    alignBufCur(sizeof(XMLCh));
-    xch = *reinterpret_cast<XMLCh*>(fBufCur);
-    fBufCur += sizeof(XMLCh);
+    xch = *reinterpret_cast<XMLCh*>(loadAligned(sizeof(XMLCh)));
     return *this;
 }
 
@@ -685,11 +716,7 @@ XSerializeEngine& XSerializeEngine::operator<<(short sh)
 
 XSerializeEngine& XSerializeEngine::operator>>(short& sh)
 {
-    checkAndFillBuffer(calBytesNeeded(sizeof(short)));
-
-    alignBufCur(sizeof(short));
-    sh = *reinterpret_cast<short*>(fBufCur);
-    fBufCur += sizeof(short);
+    sh = *reinterpret_cast<short*>(loadAligned(sizeof(short)));
     return *this;
 }
 
@@ -705,11 +732,7 @@ XSerializeEngine& XSerializeEngine::operator<<(int i)
 
 XSerializeEngine& XSerializeEngine::operator>>(int& i)
 {
-    checkAndFillBuffer(calBytesNeeded(sizeof(int)));
-
-    alignBufCur(sizeof(int));
-    i = *reinterpret_cast<int*>(fBufCur);
-    fBufCur += sizeof(int);
+    i = *reinterpret_cast<int*>(loadAligned(sizeof(int)));
     return *this;
 }
 
@@ -727,11 +750,7 @@ XSerializeEngine& XSerializeEngine::operator<<(unsigned int ui)
 XSerializeEngine& XSerializeEngine::operator>>(unsigned int& ui)
 {
 
-    checkAndFillBuffer(calBytesNeeded(sizeof(unsigned int)));
-
-    alignBufCur(sizeof(unsigned int));
-    ui = *reinterpret_cast<unsigned int*>(fBufCur);
-    fBufCur += sizeof(unsigned int);
+    ui = *reinterpret_cast<unsigned int*>(loadAligned(sizeof(unsigned int)));
     return *this;
 }
 
@@ -747,11 +766,7 @@ XSerializeEngine& XSerializeEngine::operator<<(long l)
 
 XSerializeEngine& XSerializeEngine::operator>>(long& l)
 {
-    checkAndFillBuffer(calBytesNeeded(sizeof(long)));
-
-    alignBufCur(sizeof(long));
-    l = *reinterpret_cast<long*>(fBufCur);
-    fBufCur += sizeof(long);
+    l = *reinterpret_cast<long*>(loadAligned(sizeof(long)));
     return *this;
 }
 
@@ -767,11 +782,7 @@ XSerializeEngine& XSerializeEngine::operator<<(unsigned long ul)
 
 XSerializeEngine& XSerializeEngine::operator>>(unsigned long& ul)
 {
-    checkAndFillBuffer(calBytesNeeded(sizeof(unsigned long)));
-
-    alignBufCur(sizeof(unsigned long));
-    ul = *reinterpret_cast<unsigned long*>(fBufCur);
-    fBufCur += sizeof(unsigned long);
+    ul = *reinterpret_cast<unsigned long*>(loadAligned(sizeof(unsigned long)));
     return *this;
 }
 
@@ -787,11 +798,7 @@ XSerializeEngine& XSerializeEngine::operator<<(float f)
 
 XSerializeEngine& XSerializeEngine::operator>>(float& f)
 {
-    checkAndFillBuffer(calBytesNeeded(sizeof(float)));
-
-    alignBufCur(sizeof(float));
-    *reinterpret_cast<float*>(&f) = *reinterpret_cast<float*>(fBufCur);
-    fBufCur += sizeof(float);
+    *reinterpret_cast<float*>(&f) = *reinterpret_cast<float*>(loadAligned(sizeof(float)));
     return *this;
 }
 
@@ -807,11 +814,7 @@ XSerializeEngine& XSerializeEngine::operator<<(double d)
 
 XSerializeEngine& XSerializeEngine::operator>>(double& d)
 {
-    checkAndFillBuffer(calBytesNeeded(sizeof(double)));
-
-    alignBufCur(sizeof(double));
-    *reinterpret_cast<double*>(&d) = *reinterpret_cast<double*>(fBufCur);
-    fBufCur += sizeof(double);
+    *reinterpret_cast<double*>(&d) = *reinterpret_cast<double*>(loadAligned(sizeof(double)));
     return *this;
 }
 
@@ -913,9 +916,22 @@ void XSerializeEngine::fillBuffer()
     ensureLoading();
     ensureLoadBuffer();
 
-    resetBuffer();
-
-    XMLSize_t bytesRead = fInputStream->readBytes(fBufStart, fBufSize);
+    // The stream has to fill the whole buffer, so there is no need to
+    // clear it first
+    XMLSize_t bytesRead;
+    if (fImageEnd)
+    {
+        // the next buffer is read in place, it is never written to
+        bytesRead = fImageEnd - fImageCur;
+        if (bytesRead > fBufSize)
+            bytesRead = fBufSize;
+        fBufStart = (XMLByte*) fImageCur;
+        fImageCur += bytesRead;
+    }
+    else
+    {
+        bytesRead = fInputStream->readBytes(fBufStart, fBufSize);
+    }
 
     /***
      * InputStream MUST fill in the exact amount of bytes as requested
@@ -989,6 +1005,21 @@ inline void XSerializeEngine::checkAndFillBuffer(XMLSize_t bytesNeedToRead)
 
 }
 
+// Aligns the cursor for a value of the given size, refilling the buffer
+// if the value is not in it, and returns where the value starts
+inline XMLByte* XSerializeEngine::loadAligned(XMLSize_t size)
+{
+    XMLByte* data = fBufCur + alignAdjust(size);
+    if ((data + size) > fBufLoadMax)
+    {
+        fillBuffer();
+        data = fBufCur + alignAdjust(size);
+    }
+
+    fBufCur = data + size;
+    return data;
+}
+
 inline void XSerializeEngine::ensureStoreBuffer() const
 {
     XMLSize_t a = (XMLSize_t) (fBufCur - fBufStart);
@@ -78,6 +78,28 @@ public:
                    , XMLGrammarPool* const   gramPool
                    , XMLSize_t               bufSize = 8192 );
 
+    /***
+      *
+      *  Constructor for de-serialization(loading) from bytes in memory,
+      *  such as a memory mapped file
+      *
+      *  The buffers are read in place, without being copied. Application
+      *  needs to make sure that the bytes persist beyond the life of this
+      *  SerializeEngine, and that they are aligned like memory returned by
+      *  a MemoryManager.
+      *
+      *  Param
+      *     image            the bytes written by serialization
+      *     imageSize        the number of bytes at image
+      *     gramPool         Grammar Pool
+      *     bufSize          the size of the buffers used by serialization
+      *
+      ***/
+    XSerializeEngine(const XMLByte* const    image
+                   , const XMLSize_t         imageSize
+                   , XMLGrammarPool* const   gramPool
+                   , XMLSize_t               bufSize = 8192 );
+
 
     /***
       *
@@ -575,6 +597,8 @@ private:
 
     inline void           checkAndFlushBuffer(XMLSize_t bytesNeedToWrite);
 
+    inline XMLByte*       loadAligned(XMLSize_t size);
+
            void           fillBuffer();
 
            void           flushBuffer();
@@ -653,6 +677,11 @@ private:
     //  fBufLoadMax:
     //               Indicating the end of the valid content in the buffer
     //
+    //  fImageCur/fImageEnd:
+    //               The bytes not read yet when loading from memory, in
+    //               which case fBufStart points into them rather than to
+    //               an allocated buffer. Both are null otherwise.
+    //
     //  fStorePool:
     //                Object collection for storing
     //
@@ -672,11 +701,14 @@ private:
 
     //buffer
     const XMLSize_t                        fBufSize;
-	XMLByte* const                         fBufStart;
+    XMLByte*                               fBufStart;
 	XMLByte* const                         fBufEnd;
     XMLByte*                               fBufCur;
     XMLByte*                               fBufLoadMax;
 
+    const XMLByte*                         fImageCur;
+    const XMLByte* const                   fImageEnd;
+
 
 
     /***
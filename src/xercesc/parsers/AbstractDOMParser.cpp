@@ -41,6 +41,7 @@
 #include <xercesc/dom/DOMImplementation.hpp>
 #include <xercesc/dom/DOMImplementationRegistry.hpp>
 #include <xercesc/dom/DOMElement.hpp>
+#include <xercesc/dom/DOMRecordHandler.hpp>
 #include <xercesc/dom/impl/DOMAttrImpl.hpp>
 #include <xercesc/dom/impl/DOMAttrNSImpl.hpp>
 #include <xercesc/dom/impl/DOMTypeInfoImpl.hpp>
@@ -63,6 +64,7 @@
 #include <xercesc/validators/common/GrammarResolver.hpp>
 #include <xercesc/validators/schema/SchemaSymbols.hpp>
 #include <xercesc/util/OutOfMemoryException.hpp>
+#include <xercesc/util/XMLChar.hpp>
 #include <xercesc/xinclude/XIncludeUtils.hpp>
 
 namespace XERCES_CPP_NAMESPACE {
@@ -105,6 +107,21 @@ AbstractDOMParser::AbstractDOMParser( XMLValidator* const   valToAdopt
 , fBufMgr(manager)
 , fInternalSubset(fBufMgr.bidOnBuffer())
 , fPSVIHandler(0)
+, fRecordHandler(0)
+, fOuterDocument(0)
+, fElementDepth(0)
+, fRecordDepth(0)
+, fRecordRejected(false)
+, fSpareHeapBlock(0)
+, fSpareHeapBlockSize(0)
+, fWhitespaceScheme(WS_Keep)
+, fStrippedRuns(0)
+, fMixedParents(0)
+, fStrippedChars(0)
+, fStrippedLen(0)
+, fStrippedCapacity(0)
+, fDroppedDepth(0)
+, fUnwrappedParents(0)
 {
     CleanupType cleanup(this, &AbstractDOMParser::cleanUp);
 
@@ -146,11 +163,17 @@ void AbstractDOMParser::initialize()
     fScanner->setDocTypeHandler(this);
     fScanner->setURIStringPool(fURIStringPool);
 
+    fStrippedRuns = new (fMemoryManager) ValueStackOf<StrippedRun>(8, fMemoryManager);
+    fMixedParents = new (fMemoryManager) ValueStackOf<DOMNode*>(8, fMemoryManager);
+    fUnwrappedParents = new (fMemoryManager) ValueStackOf<DOMNode*>(8, fMemoryManager);
+
     this->reset();
 }
 
 void AbstractDOMParser::cleanUp()
 {
+    discardRecord();
+
     if (fDocumentVector)
         delete fDocumentVector;
 
@@ -163,6 +186,14 @@ void AbstractDOMParser::cleanUp()
     //delete fURIStringPool;
     fMemoryManager->deallocate(fImplementationFeatures);
 
+    if (fSpareHeapBlock)
+        fMemoryManager->deallocate(fSpareHeapBlock);
+
+    delete fStrippedRuns;
+    delete fMixedParents;
+    delete fUnwrappedParents;
+    fMemoryManager->deallocate(fStrippedChars);
+
     if (fValidator)
         delete fValidator;
 }
@@ -172,6 +203,8 @@ void AbstractDOMParser::cleanUp()
 // ---------------------------------------------------------------------------
 void AbstractDOMParser::reset()
 {
+    discardRecord();
+
     // if fDocument exists already, store the old pointer in the vector for deletion later
     if (fDocument && !fDocumentAdoptedByUser) {
         if (!fDocumentVector) {
@@ -195,6 +228,9 @@ void AbstractDOMParser::reset()
 void AbstractDOMParser::resetInProgress()
 {
     fParseInProgress = false;
+
+    // A parse that failed within a record leaves the record document behind
+    discardRecord();
 }
 
 
@@ -224,6 +260,114 @@ DOMDocument* AbstractDOMParser::adoptDocument()
     return fDocument;
 }
 
+void AbstractDOMParser::recycleDocument(DOMDocument* doc)
+{
+    DOMDocumentImpl* docImpl = (DOMDocumentImpl*)doc;
+    if (docImpl == fDocument)
+        fDocument = 0;
+
+    // The block has to go back to the memory manager it came from
+    if (docImpl->getMemoryManager() != fMemoryManager)
+    {
+        docImpl->release();
+        return;
+    }
+
+    XMLSize_t blockSize;
+    void* block = docImpl->releaseKeepingHeapBlock(blockSize);
+    if (block == 0)
+        return;
+
+    // Keep the larger block
+    if (blockSize > fSpareHeapBlockSize)
+    {
+        if (fSpareHeapBlock)
+            fMemoryManager->deallocate(fSpareHeapBlock);
+        fSpareHeapBlock = block;
+        fSpareHeapBlockSize = blockSize;
+    }
+    else
+        fMemoryManager->deallocate(block);
+}
+
+
+// ---------------------------------------------------------------------------
+//  AbstractDOMParser: Record mode and element dropping helper methods
+// ---------------------------------------------------------------------------
+DOMDocumentImpl* AbstractDOMParser::createDocumentImpl()
+{
+    DOMDocumentImpl* doc;
+    if(fImplementationFeatures == 0)
+        doc = (DOMDocumentImpl *)DOMImplementation::getImplementation()->createDocument(fMemoryManager);
+    else
+        doc = (DOMDocumentImpl *)DOMImplementationRegistry::getDOMImplementation(fImplementationFeatures)->createDocument(fMemoryManager);
+
+    if (fSpareHeapBlock)
+    {
+        doc->adoptHeapBlock(fSpareHeapBlock, fSpareHeapBlockSize);
+        fSpareHeapBlock = 0;
+        fSpareHeapBlockSize = 0;
+    }
+
+    // set DOM error checking off
+    doc->setErrorChecking(false);
+    return doc;
+}
+
+void AbstractDOMParser::startRecord()
+{
+    DOMDocumentImpl* record = createDocumentImpl();
+    record->setDocumentURI(fDocument->getDocumentURI());
+    record->setInputEncoding(fDocument->getInputEncoding());
+    record->setXmlEncoding(fDocument->getXmlEncoding());
+    record->setXmlVersion(fDocument->getXmlVersion());
+    record->setXmlStandalone(fDocument->getXmlStandalone());
+
+    fOuterDocument = fDocument;
+    fDocument = record;
+    fCurrentParent = fDocument;
+    fCurrentNode = fDocument;
+    fRecordDepth = fElementDepth;
+    fRecordRejected = false;
+}
+
+void AbstractDOMParser::endRecord()
+{
+    // The record is released if the handler throws, and otherwise recycled
+    // for the next one
+    DOMDocumentImpl* record = fDocument;
+    JanitorMemFunCall<DOMDocumentImpl> janRecord(record, &DOMDocumentImpl::release);
+
+    // Get back to the outer document first, the handler may throw
+    fDocument = fOuterDocument;
+    fOuterDocument = 0;
+    fRecordDepth = 0;
+    fCurrentParent = fDocument;
+    fCurrentNode = fDocument;
+    fWithinElement = false;
+
+    if (!fRecordRejected)
+    {
+        record->setErrorChecking(true);
+        fRecordHandler->handleRecord(record);
+    }
+
+    janRecord.release();
+    recycleDocument(record);
+}
+
+void AbstractDOMParser::discardRecord()
+{
+    if (fOuterDocument)
+    {
+        recycleDocument(fDocument);
+        fDocument = fOuterDocument;
+        fOuterDocument = 0;
+    }
+    fRecordDepth = 0;
+    fElementDepth = 0;
+}
+
 
 // ---------------------------------------------------------------------------
 //  AbstractDOMParser: Getter methods
@@ -357,6 +501,11 @@ bool AbstractDOMParser::getHandleMultipleImports() const
     return fScanner->getHandleMultipleImports();
 }
 
+bool AbstractDOMParser::getParallelSchemaLoading() const
+{
+    return fScanner->getParallelSchemaLoading();
+}
+
 // ---------------------------------------------------------------------------
 //  AbstractDOMParser: Setter methods
 // ---------------------------------------------------------------------------
@@ -371,6 +520,14 @@ void AbstractDOMParser::setPSVIHandler(PSVIHandler* const handler)
     }
 }
 
+void AbstractDOMParser::setRecordHandler(DOMRecordHandler* const handler)
+{
+    if (fParseInProgress)
+        ThrowXMLwithMemMgr(IOException, XMLExcepts::Gen_ParseInProgress, fMemoryManager);
+
+    fRecordHandler = handler;
+}
+
 
 void AbstractDOMParser::setDoNamespaces(const bool newState)
 {
@@ -523,6 +680,11 @@ void AbstractDOMParser::setHandleMultipleImports(const bool newValue)
     fScanner->setHandleMultipleImports(newValue);
 }
 
+void AbstractDOMParser::setParallelSchemaLoading(const bool newValue)
+{
+    fScanner->setParallelSchemaLoading(newValue);
+}
+
 void AbstractDOMParser::setDocument(DOMDocument* toSet)
 {
     fDocument = (DOMDocumentImpl *)toSet;
@@ -680,7 +842,7 @@ void AbstractDOMParser::handleElementPSVI(const XMLCh* const            localNam
                                         ,       PSVIElement *           elementInfo)
 {
     // associate the info now; if the user wants, she can override what we did
-    if(fCreateSchemaInfo)
+    if(fCreateSchemaInfo && !isDropping() && !isUnwrappedTag())
     {
         DOMTypeInfoImpl* typeInfo=new (getDocument()) DOMTypeInfoImpl();
         typeInfo->setNumericProperty(DOMPSVITypeInfo::PSVI_Validity, elementInfo->getValidity());
@@ -733,7 +895,7 @@ void AbstractDOMParser::handleAttributesPSVI( const XMLCh* const            loca
                                             , const XMLCh* const            uri
                                             ,       PSVIAttributeList *     psviAttributes)
 {
-    if(fCreateSchemaInfo)
+    if(fCreateSchemaInfo && !isDropping() && !isUnwrappedTag())
     {
         for (XMLSize_t index=0; index < psviAttributes->getLength(); index++) {
             xercesc::PSVIAttribute *attrInfo=psviAttributes->getAttributePSVIAtIndex(index);
@@ -781,6 +943,137 @@ void AbstractDOMParser::handleAttributesPSVI( const XMLCh* const            loca
         fPSVIHandler->handleAttributesPSVI(localName, uri, psviAttributes);
 }
 
+void AbstractDOMParser::dropElement(const bool isEmpty)
+{
+    // Text that follows goes into a node of its own, as it would after a
+    // built element
+    fCurrentNode = fCurrentParent;
+    if (!isEmpty)
+        fDroppedDepth = 1;
+}
+
+void AbstractDOMParser::unwrapElement(const bool isEmpty)
+{
+    fCurrentNode = fCurrentParent;
+    if (!isEmpty)
+        fUnwrappedParents->push(fCurrentParent);
+}
+
+bool AbstractDOMParser::isUnwrappedTag()
+{
+    // Between the tags of a built element, fCurrentParent is that element;
+    // for an unwrapped one it stays the parent. A built element is never on
+    // top when it ends, the elements unwrapped within it have ended before.
+    return !fUnwrappedParents->empty() && fUnwrappedParents->peek() == fCurrentParent;
+}
+
+
+// ---------------------------------------------------------------------------
+//  AbstractDOMParser: Whitespace stripping helper methods
+// ---------------------------------------------------------------------------
+
+//
+//  Called for character data that does not continue a text node. Returns
+//  true if the characters are only whitespace and were not built, and
+//  otherwise builds the whitespace that was stripped just before them, so
+//  the caller can add them to fCurrentNode if that is a text node.
+//
+bool AbstractDOMParser::stripWhitespace(const XMLCh* const chars, const XMLSize_t length)
+{
+    if (fWhitespaceScheme == WS_StripElementContent &&
+        !fMixedParents->empty() && fMixedParents->peek() == fCurrentParent)
+        return false;
+
+    DOMNode* previous = fCurrentParent->getLastChild();
+    bool pending = !fStrippedRuns->empty() &&
+                   fStrippedRuns->peek().fParent == fCurrentParent &&
+                   fStrippedRuns->peek().fPrevious == previous;
+
+    if (!XMLChar1_0::isAllSpaces(chars, length))
+    {
+        if (fWhitespaceScheme == WS_StripElementContent)
+            keepStrippedWhitespace();
+        else if (pending)
+            buildStrippedRun();
+        return false;
+    }
+
+    if (!pending)
+    {
+        // Under WS_Strip, an earlier run of the parent can't be needed
+        // anymore since markup followed it
+        if (fWhitespaceScheme == WS_Strip &&
+            !fStrippedRuns->empty() && fStrippedRuns->peek().fParent == fCurrentParent)
+            fStrippedLen = fStrippedRuns->pop().fOffset;
+
+        StrippedRun run = { fCurrentParent, previous, fStrippedLen };
+        fStrippedRuns->push(run);
+    }
+
+    if (fStrippedLen + length > fStrippedCapacity)
+    {
+        const XMLSize_t newCapacity = (fStrippedLen + length) * 2;
+        XMLCh* newChars = (XMLCh*) fMemoryManager->allocate(newCapacity * sizeof(XMLCh));
+        if (fStrippedLen)
+            memcpy(newChars, fStrippedChars, fStrippedLen * sizeof(XMLCh));
+        fMemoryManager->deallocate(fStrippedChars);
+        fStrippedChars = newChars;
+        fStrippedCapacity = newCapacity;
+    }
+    memcpy(fStrippedChars + fStrippedLen, chars, length * sizeof(XMLCh));
+    fStrippedLen += length;
+    return true;
+}
+
+//
+//  Called under WS_StripElementContent when the current parent turns out to
+//  hold other text than whitespace. Builds the runs stripped from it so far,
+//  and marks it so that no more are stripped.
+//
+void AbstractDOMParser::keepStrippedWhitespace()
+{
+    if (!fMixedParents->empty() && fMixedParents->peek() == fCurrentParent)
+        return;
+
+    fMixedParents->push(fCurrentParent);
+    while (!fStrippedRuns->empty() && fStrippedRuns->peek().fParent == fCurrentParent)
+        buildStrippedRun();
+}
+
+//
+//  Called when the current parent ends, its stripped runs are not needed.
+//
+void AbstractDOMParser::dropStrippedWhitespace()
+{
+    while (!fStrippedRuns->empty() && fStrippedRuns->peek().fParent == fCurrentParent)
+        fStrippedLen = fStrippedRuns->pop().fOffset;
+
+    if (!fMixedParents->empty() && fMixedParents->peek() == fCurrentParent)
+        fMixedParents->pop();
+}
+
+//
+//  Builds the text node of the run on top of fStrippedRuns and removes it.
+//  If the node ends up last, the run was just before the current position
+//  and the node becomes fCurrentNode.
+//
+void AbstractDOMParser::buildStrippedRun()
+{
+    const StrippedRun run = fStrippedRuns->pop();
+    DOMText* node = createText(fStrippedChars + run.fOffset, fStrippedLen - run.fOffset);
+    fStrippedLen = run.fOffset;
+
+    DOMNode* next = run.fPrevious ? run.fPrevious->getNextSibling()
+                                  : run.fParent->getFirstChild();
+    if (next)
+        run.fParent->insertBefore(node, next);
+    else
+    {
+        castToParentImpl (run.fParent)->appendChildFast (node);
+        fCurrentNode = node;
+    }
+}
+
 // ---------------------------------------------------------------------------
 //  AbstractDOMParser: Implementation of XMLDocumentHandler interface
 // ---------------------------------------------------------------------------
@@ -789,17 +1082,25 @@ void AbstractDOMParser::docCharacters(  const   XMLCh* const    chars
                               , const bool         cdataSection)
 {
     // Ignore chars outside of content
-    if (!fWithinElement)
+    if (!fWithinElement || fDroppedDepth)
         return;
 
     if (cdataSection == true)
     {
+        if (fWhitespaceScheme == WS_StripElementContent)
+            keepStrippedWhitespace();
+
         DOMCDATASection *node = createCDATASection (chars, length);
         castToParentImpl (fCurrentParent)->appendChildFast (node);
         fCurrentNode = node;
     }
     else
     {
+        if (fWhitespaceScheme != WS_Keep &&
+            fCurrentNode->getNodeType() != DOMNode::TEXT_NODE &&
+            stripWhitespace(chars, length))
+            return;
+
         if (fCurrentNode->getNodeType() == DOMNode::TEXT_NODE)
         {
             DOMTextImpl *node = (DOMTextImpl*)fCurrentNode;
@@ -817,7 +1118,7 @@ void AbstractDOMParser::docCharacters(  const   XMLCh* const    chars
 
 void AbstractDOMParser::docComment(const XMLCh* const comment)
 {
-    if (fCreateCommentNodes) {
+    if (fCreateCommentNodes && !isDropping()) {
         DOMComment *dcom = fDocument->createComment(comment);
         castToParentImpl (fCurrentParent)->appendChildFast (dcom);
         fCurrentNode = dcom;
@@ -828,6 +1129,9 @@ void AbstractDOMParser::docComment(const XMLCh* const comment)
 void AbstractDOMParser::docPI(  const   XMLCh* const    target
                       , const XMLCh* const    data)
 {
+    if (isDropping())
+        return;
+
     DOMProcessingInstruction *pi = fDocument->createProcessingInstruction
         (
         target
@@ -840,9 +1144,11 @@ void AbstractDOMParser::docPI(  const   XMLCh* const    target
 
 void AbstractDOMParser::endEntityReference(const XMLEntityDecl&)
 {
-    if (!fCreateEntityReferenceNodes)
+    if (!fCreateEntityReferenceNodes || isDropping())
       return;
 
+    dropStrippedWhitespace();
+
     DOMEntityReferenceImpl *erImpl = 0;
 
     if (fCurrentParent->getNodeType() == DOMNode::ENTITY_REFERENCE_NODE)
@@ -870,6 +1176,27 @@ void AbstractDOMParser::endElement( const   XMLElementDecl&
                            , const bool
                            , const XMLCh* const)
 {
+    if (fDroppedDepth)
+    {
+        fDroppedDepth--;
+        return;
+    }
+
+    if (isDropping())
+    {
+        fElementDepth--;
+        return;
+    }
+
+    if (isUnwrappedTag())
+    {
+        fUnwrappedParents->pop();
+        fCurrentNode = fCurrentParent;
+        return;
+    }
+
+    dropStrippedWhitespace();
+
     fCurrentNode   = fCurrentParent;
     fCurrentParent = fCurrentNode->getParentNode ();
 
@@ -897,6 +1224,13 @@ void AbstractDOMParser::endElement( const   XMLElementDecl&
 	    if(xiu.parseDOMNodeDoingXInclude(fCurrentNode, fDocument, getScanner()->getEntityHandler()))
             fCurrentNode = fCurrentParent->getLastChild();
     }
+
+    if (fRecordHandler)
+    {
+        if (fElementDepth == fRecordDepth)
+            endRecord();
+        fElementDepth--;
+    }
 }
 
 
@@ -905,7 +1239,7 @@ void AbstractDOMParser::ignorableWhitespace(  const XMLCh* const    chars
                                             , const bool)
 {
     // Ignore chars before the root element
-    if (!fWithinElement || !fIncludeIgnorableWhitespace)
+    if (!fWithinElement || !fIncludeIgnorableWhitespace || fDroppedDepth)
         return;
 
     if (fCurrentNode->getNodeType() == DOMNode::TEXT_NODE)
@@ -936,16 +1270,18 @@ void AbstractDOMParser::resetDocument()
 
 void AbstractDOMParser::startDocument()
 {
-    if(fImplementationFeatures == 0)
-        fDocument = (DOMDocumentImpl *)DOMImplementation::getImplementation()->createDocument(fMemoryManager);
-    else
-        fDocument = (DOMDocumentImpl *)DOMImplementationRegistry::getDOMImplementation(fImplementationFeatures)->createDocument(fMemoryManager);
+    fDocument = createDocumentImpl();
+    fElementDepth = 0;
+    fRecordDepth = 0;
+    fStrippedRuns->removeAllElements();
+    fMixedParents->removeAllElements();
+    fStrippedLen = 0;
+    fDroppedDepth = 0;
+    fUnwrappedParents->removeAllElements();
 
     // Just set the document as the current parent and current node
     fCurrentParent = fDocument;
     fCurrentNode   = fDocument;
-    // set DOM error checking off
-    fDocument->setErrorChecking(false);
     fDocument->setDocumentURI(fScanner->getLocator()->getSystemId());
     fDocument->setInputEncoding(fScanner->getReaderMgr()->getCurrentEncodingStr());
 }
@@ -975,6 +1311,42 @@ void AbstractDOMParser::startElement(const XMLElementDecl&   elemDecl
     const XMLCh* namespaceURI = 0;
     bool doNamespaces = fScanner->getDoNamespaces();
 
+    // Within a dropped element only the nesting is followed
+    if (fDroppedDepth)
+    {
+        if (!isEmpty)
+            fDroppedDepth++;
+        return;
+    }
+
+    // In record mode nothing is built until the handler accepts a record
+    // root; elements outside of records only update the nesting depth.
+    //
+    if (fRecordHandler)
+    {
+        fElementDepth++;
+        if (!fRecordDepth)
+        {
+            const XMLCh* localName = elemDecl.getFullName();
+            if (doNamespaces)
+            {
+                localName = elemDecl.getBaseName();
+                if (urlId != fScanner->getEmptyNamespaceId())
+                    namespaceURI = fScanner->getURIText(urlId);
+            }
+
+            if (!fRecordHandler->isRecordRoot(namespaceURI, localName, fElementDepth))
+            {
+                if (isEmpty)
+                    fElementDepth--;
+                return;
+            }
+
+            startRecord();
+            namespaceURI = 0;
+        }
+    }
+
     // Create the element name. Here we are going to bypass the
     // DOMDocument::createElement() interface and instantiate the
     // required types directly in order to avoid name checking
@@ -1207,7 +1579,7 @@ void AbstractDOMParser::startEntityReference(const XMLEntityDecl& entDecl)
 
     // Following line has been moved up so that erImpl is only declared
     // and used if create entity ref flag is true
-    if (fCreateEntityReferenceNodes == true)    {
+    if (fCreateEntityReferenceNodes == true && !isDropping())    {
         DOMEntityReference *er = fDocument->createEntityReferenceByParser(entName);
 
         //set the readOnly flag to false before appending node, will be reset
@@ -1223,8 +1595,9 @@ void AbstractDOMParser::startEntityReference(const XMLEntityDecl& entDecl)
     // this entityRef needs to be stored in Entity map too.
     // We'd decide later whether the entity nodes should be created by a
     // separated method in parser or not. For now just stick it in if
-    // the ref nodes are created
-        if (entity)
+    // the ref nodes are created. A record document does not outlive its
+    // record, so its references are not kept.
+        if (entity && !fRecordDepth)
             entity->setEntityRef(er);
     }
 }
@@ -46,6 +46,7 @@ class DOMElement;
 class GrammarResolver;
 class XMLGrammarPool;
 class PSVIHandler;
+class DOMRecordHandler;
 
 /**
   * This class implements the Document Object Model (DOM) interface.
@@ -81,6 +82,21 @@ public :
         , Val_Auto
     };
 
+    /** WhitespaceSchemes enum used in setWhitespaceScheme
+      *    WS_Keep:                Build a text node for all character data.
+      *    WS_Strip:               Build no text node that holds only whitespace.
+      *    WS_StripElementContent: Build no text node that holds only whitespace,
+      *                            unless its parent also holds other text.
+      *
+      * @see #setWhitespaceScheme
+      */
+    enum WhitespaceSchemes
+    {
+        WS_Keep
+        , WS_Strip
+        , WS_StripElementContent
+    };
+
     //@}
 
 
@@ -125,6 +141,23 @@ public :
       */
     DOMDocument* adoptDocument();
 
+    /** Release an adopted DOM document and keep its memory
+      *
+      * This method releases a document that the caller adopted from this
+      * parser, as DOMDocument::release() does, except that the largest
+      * block of memory of the document is kept by the parser instead of
+      * being freed. The next document the parser builds is allocated from
+      * that block, which saves going to the memory manager for every
+      * document when many small documents are parsed one after the other.
+      *
+      * Documents built in record mode are recycled this way without the
+      * need to call this method.
+      *
+      * @param doc A document adopted from this parser. It must not be
+      *            used after this call.
+      */
+    void recycleDocument(DOMDocument* doc);
+
     //@}
 
 
@@ -276,6 +309,17 @@ public :
       */
     bool getIncludeIgnorableWhitespace() const;
 
+   /** Get the whitespace scheme
+      *
+      * This method returns an enumerated value that tells which text nodes
+      * holding only whitespace are built.
+      *
+      * @return The WhitespaceSchemes value currently set on this parser.
+      *
+      * @see #setWhitespaceScheme
+      */
+    WhitespaceSchemes getWhitespaceScheme() const;
+
    /** Get the set of Namespace/SchemaLocation that is specified externally.
       *
       * This method returns the list of Namespace/SchemaLocation that was
@@ -427,6 +471,15 @@ public :
       */
     const PSVIHandler* getPSVIHandler() const;
 
+    /**
+      * This method returns the installed record handler.
+      *
+      * @return The pointer to the installed record handler object, or
+      *         null if the whole document is built.
+      * @see #setRecordHandler
+      */
+    DOMRecordHandler* getRecordHandler() const;
+
     /** Get the 'associate schema info' flag
       *
       * This method returns the flag that specifies whether
@@ -506,6 +559,15 @@ public :
       * @see #setHandleMultipleImports
       */
     bool getHandleMultipleImports() const;
+
+    /** Get the 'parallel schema loading' flag
+      *
+      * @return true, if the parser is currently configured to parse
+      *         the documents of a schema on several threads, false otherwise.
+      *
+      * @see #setParallelSchemaLoading
+      */
+    bool getParallelSchemaLoading() const;
     //@}
 
 
@@ -635,6 +697,36 @@ public :
       */
     void setIncludeIgnorableWhitespace(const bool include);
 
+   /** Set the whitespace scheme
+      *
+      * This method allows users to drop the whitespace that only indents
+      * the markup of a document, without a grammar telling which of it is
+      * ignorable. The value is one of the WhitespaceSchemes enumerated
+      * values defined by this class:
+      *
+      * <br>  WS_Keep  - build a text node for all character data
+      * <br>  WS_Strip - build no text node for character data between two
+      *                  pieces of markup that is only whitespace
+      * <br>  WS_StripElementContent - like WS_Strip, but keep such text in
+      *                  elements that also hold other text, i.e. elements
+      *                  with mixed content. Until other text is seen, the
+      *                  whitespace of an element is held in a buffer of the
+      *                  parser.
+      *
+      * <p>Only the character data of the document is affected: CDATA
+      * sections and the text of an attribute value are always kept, as is
+      * whitespace that is part of a text node with other characters.
+      * Applications intended to process the "xml:space" attribute should
+      * keep the default.</p>
+      *
+      * <p>The parser's default state is: WS_Keep.</p>
+      *
+      * @param newScheme The new whitespace scheme to use.
+      *
+      * @see #getWhitespaceScheme
+      */
+    void setWhitespaceScheme(const WhitespaceSchemes newScheme);
+
     /**
       * This method allows users to set the validation scheme to be used
       * by this parser. The value is one of the ValSchemes enumerated values
@@ -894,6 +986,27 @@ public :
       */
     virtual void setPSVIHandler(PSVIHandler* const handler);
 
+    /**
+      * This method installs a record handler on the parser, switching it
+      * to record mode.
+      *
+      * In record mode only the subtrees rooted at the elements accepted
+      * by DOMRecordHandler::isRecordRoot are built. Each of them is built
+      * into a document of its own which is passed to
+      * DOMRecordHandler::handleRecord and released as soon as the end
+      * tag of its root has been handled, so that the memory used does
+      * not grow with the size of the document. The document returned by
+      * getDocument only holds what lies outside of the root element.
+      *
+      * The handler cannot be changed while a parse is in progress.
+      *
+      * @param handler A pointer to the record handler, or null to build
+      *                the whole document again.
+      *
+      * @see DOMRecordHandler
+      */
+    void setRecordHandler(DOMRecordHandler* const handler);
+
     /** Set the 'associate schema info' flag
       *
       * This method allows users to specify whether
@@ -919,7 +1032,9 @@ public :
     /** Set the 'ignore annotation' flag
       *
       * This method gives users the option to not generate XSAnnotations
-      * when "traversing" a schema.
+      * when "traversing" a schema. The text of the annotations is then not
+      * kept while the schema documents are parsed either, which saves
+      * memory and time for schemas with much documentation.
       *
       * The parser's default state is false
       *
@@ -969,6 +1084,26 @@ public :
       * @param newValue The state to set
       */
     void setHandleMultipleImports(const bool newValue);
+
+    /** Set the 'parallel schema loading' flag
+      *
+      * This method lets the parser parse the documents included, imported
+      * and redefined by a schema on several threads before the schema is
+      * traversed. The entity resolver is only called on the calling thread,
+      * for the locations of all these documents before the first of them is
+      * traversed. A document which reports an error or a warning, or which
+      * refers to an external entity, is parsed again on the calling thread,
+      * so the grammar and the errors reported are the same as without this
+      * option. The memory manager of the grammar pool must be thread-safe.
+      *
+      * NOTE: This option is ignored if schema validation is disabled, or if
+      * the library is built without the standard C++ thread support.
+      *
+      * The parser's default state is false
+      *
+      * @param newValue The state to set
+      */
+    void setParallelSchemaLoading(const bool newValue);
     //@}
 
 
@@ -1681,12 +1816,80 @@ private :
     void cleanUp();
     void resetInProgress();
 
+    // -----------------------------------------------------------------------
+    //  Record mode helper methods
+    // -----------------------------------------------------------------------
+    DOMDocumentImpl* createDocumentImpl();
+    void startRecord();
+    void endRecord();
+    void discardRecord();
+
+    // -----------------------------------------------------------------------
+    //  Whitespace stripping helper methods
+    //
+    //  A StrippedRun is whitespace that was not built into a text node,
+    //  which would have been the child of fParent after fPrevious, or its
+    //  first child if fPrevious is null. Its characters start at fOffset in
+    //  fStrippedChars.
+    // -----------------------------------------------------------------------
+    struct StrippedRun
+    {
+        DOMNode*    fParent;
+        DOMNode*    fPrevious;
+        XMLSize_t   fOffset;
+    };
+
+    bool stripWhitespace(const XMLCh* const chars, const XMLSize_t length);
+    void keepStrippedWhitespace();
+    void dropStrippedWhitespace();
+    void buildStrippedRun();
+
     // -----------------------------------------------------------------------
     //  Unimplemented constructors and operators
     // -----------------------------------------------------------------------
     AbstractDOMParser(const AbstractDOMParser&);
     AbstractDOMParser& operator=(const AbstractDOMParser&);
 
+protected:
+    // -----------------------------------------------------------------------
+    //  Protected record mode and element dropping helper methods
+    //
+    //  isDropping
+    //      True while events are dropped without building anything: within
+    //      the root element but not within a record, when fCurrentNode is
+    //      the document, and within an element passed to dropElement().
+    //
+    //  isWithinRecord
+    //      True while a record is being built.
+    //
+    //  isRecordEnd
+    //      True when the end tag being reported closes the current record,
+    //      which is handed over as part of endElement().
+    //
+    //  rejectRecord
+    //      Drops the current record instead of handing it over when it ends.
+    //
+    //  dropElement
+    //      Called instead of startElement() to build neither the element
+    //      nor its content. Events are dropped up to its end tag, which is
+    //      dropped as well.
+    //
+    //  unwrapElement
+    //      Called instead of startElement() to build the content of the
+    //      element in place of it. Its end tag is dropped.
+    //
+    //  isUnwrappedTag
+    //      True when the start tag just reported, or the end tag being
+    //      reported, belongs to an element passed to unwrapElement().
+    // -----------------------------------------------------------------------
+    bool isDropping() const;
+    bool isWithinRecord() const;
+    bool isRecordEnd() const;
+    void rejectRecord();
+    void dropElement(const bool isEmpty);
+    void unwrapElement(const bool isEmpty);
+    bool isUnwrappedTag();
+
 protected:
     // -----------------------------------------------------------------------
     //  Protected data members
@@ -1759,6 +1962,55 @@ protected:
 	//   fDoXinclude
 	//      A bool used to request that XInlcude processing occur on the
 	//      Document the parser parses.
+    //
+    //  fRecordHandler
+    //      The installed record handler. If set, only the records it selects
+    //      are built, each into a document of its own.
+    //
+    //  fOuterDocument
+    //      While a record is being built fDocument is the record document
+    //      and this holds the document being parsed.
+    //
+    //  fElementDepth
+    //      The current element nesting depth, only maintained in record mode.
+    //
+    //  fRecordDepth
+    //      The depth of the root of the record being built, 0 if none.
+    //
+    //  fRecordRejected
+    //      Set by rejectRecord() when the current record is not to be handed
+    //      over.
+    //
+    //  fSpareHeapBlock
+    //  fSpareHeapBlockSize
+    //      The memory block kept from the last recycled document, if any,
+    //      and its size. It is given to the next document created.
+    //
+    //  fWhitespaceScheme
+    //      Which text nodes that hold only whitespace are built.
+    //
+    //  fStrippedRuns
+    //      The runs of whitespace that were not built, but may still be
+    //      needed: under WS_Strip the run just before the current position,
+    //      if more text may follow it, and under WS_StripElementContent all
+    //      the runs of the open parents not known to have other text.
+    //
+    //  fMixedParents
+    //      The open parents known to have other text than whitespace, the
+    //      innermost on top. Only used under WS_StripElementContent.
+    //
+    //  fStrippedChars
+    //  fStrippedLen
+    //  fStrippedCapacity
+    //      The characters of the runs in fStrippedRuns, one after the other.
+    //
+    //  fDroppedDepth
+    //      The number of open elements within an element passed to
+    //      dropElement(), that element included; 0 if none.
+    //
+    //  fUnwrappedParents
+    //      For each open element passed to unwrapElement(), the parent its
+    //      content is built into, the innermost on top.
     // -----------------------------------------------------------------------
     bool                          fCreateEntityReferenceNodes;
     bool                          fIncludeIgnorableWhitespace;
@@ -1784,6 +2036,21 @@ protected:
     XMLBufferMgr                  fBufMgr;
     XMLBuffer&                    fInternalSubset;
     PSVIHandler*                  fPSVIHandler;
+    DOMRecordHandler*             fRecordHandler;
+    DOMDocumentImpl*              fOuterDocument;
+    XMLSize_t                     fElementDepth;
+    XMLSize_t                     fRecordDepth;
+    bool                          fRecordRejected;
+    void*                         fSpareHeapBlock;
+    XMLSize_t                     fSpareHeapBlockSize;
+    WhitespaceSchemes             fWhitespaceScheme;
+    ValueStackOf<StrippedRun>*    fStrippedRuns;
+    ValueStackOf<DOMNode*>*       fMixedParents;
+    XMLCh*                        fStrippedChars;
+    XMLSize_t                     fStrippedLen;
+    XMLSize_t                     fStrippedCapacity;
+    XMLSize_t                     fDroppedDepth;
+    ValueStackOf<DOMNode*>*       fUnwrappedParents;
 };
 
 
@@ -1801,6 +2068,11 @@ inline bool AbstractDOMParser::getIncludeIgnorableWhitespace() const
     return fIncludeIgnorableWhitespace;
 }
 
+inline AbstractDOMParser::WhitespaceSchemes AbstractDOMParser::getWhitespaceScheme() const
+{
+    return fWhitespaceScheme;
+}
+
 inline bool AbstractDOMParser::getParseInProgress() const
 {
     return fParseInProgress;
@@ -1831,6 +2103,33 @@ inline const PSVIHandler* AbstractDOMParser::getPSVIHandler() const
     return fPSVIHandler;
 }
 
+inline DOMRecordHandler* AbstractDOMParser::getRecordHandler() const
+{
+    return fRecordHandler;
+}
+
+inline bool AbstractDOMParser::isDropping() const
+{
+    // Within a dropped element, or within the root element but not within
+    // a record
+    return fDroppedDepth || (fRecordHandler && !fRecordDepth && fElementDepth);
+}
+
+inline bool AbstractDOMParser::isWithinRecord() const
+{
+    return fRecordHandler && fRecordDepth;
+}
+
+inline bool AbstractDOMParser::isRecordEnd() const
+{
+    return fRecordHandler && fRecordDepth && fElementDepth == fRecordDepth;
+}
+
+inline void AbstractDOMParser::rejectRecord()
+{
+    fRecordRejected = true;
+}
+
 inline bool AbstractDOMParser::getCreateSchemaInfo() const
 {
     return fCreateSchemaInfo;
@@ -1853,6 +2152,11 @@ inline void AbstractDOMParser::setIncludeIgnorableWhitespace(const bool include)
     fIncludeIgnorableWhitespace = include;
 }
 
+inline void AbstractDOMParser::setWhitespaceScheme(const WhitespaceSchemes newScheme)
+{
+    fWhitespaceScheme = newScheme;
+}
+
 inline void AbstractDOMParser::setCreateCommentNodes(const bool create)
 {
     fCreateCommentNodes = create;
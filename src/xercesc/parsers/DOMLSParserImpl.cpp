@@ -66,6 +66,9 @@ public:
     __AbortFilter() {}
     virtual FilterAction acceptNode(DOMNode*)             { return FILTER_INTERRUPT; }
     virtual FilterAction startElement(DOMElement* )       { return FILTER_INTERRUPT; }
+    virtual FilterAction acceptStartTag(const XMLCh* const, const XMLCh* const,
+                                        const XMLCh* const, const Attributes&)
+                                                          { return FILTER_INTERRUPT; }
     virtual DOMNodeFilter::ShowType getWhatToShow() const { return DOMNodeFilter::SHOW_ALL; }
 };
 
@@ -145,6 +148,7 @@ AbstractDOMParser(valToAdopt, manager, gramPool)
     fSupportedParameters->add(XMLUni::fgXercesSkipDTDValidation);
     fSupportedParameters->add(XMLUni::fgXercesDoXInclude);
     fSupportedParameters->add(XMLUni::fgXercesHandleMultipleImports);
+    fSupportedParameters->add(XMLUni::fgXercesParallelSchemaLoading);
 
     // LSParser by default does namespace processing
     setDoNamespaces(true);
@@ -433,6 +437,10 @@ void DOMLSParserImpl::setParameter(const XMLCh* name, bool state)
     {
         getScanner()->setHandleMultipleImports(state);
     }
+    else if (XMLString::compareIStringASCII(name, XMLUni::fgXercesParallelSchemaLoading) == 0)
+    {
+        getScanner()->setParallelSchemaLoading(state);
+    }
     else
         throw DOMException(DOMException::NOT_FOUND_ERR, 0, getMemoryManager());
 }
@@ -615,6 +623,10 @@ const void* DOMLSParserImpl::getParameter(const XMLCh* name) const
     {
         return (void*)getScanner()->getHandleMultipleImports();
     }
+    else if (XMLString::compareIStringASCII(name, XMLUni::fgXercesParallelSchemaLoading) == 0)
+    {
+        return (void*)getScanner()->getParallelSchemaLoading();
+    }
     else if (XMLString::compareIStringASCII(name, XMLUni::fgXercesEntityResolver) == 0)
     {
         return fXMLEntityResolver;
@@ -693,7 +705,8 @@ bool DOMLSParserImpl::canSetParameter(const XMLCh* name, bool value) const
         XMLString::compareIStringASCII(name, XMLUni::fgXercesDisableDefaultEntityResolution) == 0 ||
         XMLString::compareIStringASCII(name, XMLUni::fgXercesSkipDTDValidation) == 0 ||
 		XMLString::compareIStringASCII(name, XMLUni::fgXercesDoXInclude) == 0 ||
-        XMLString::compareIStringASCII(name, XMLUni::fgXercesHandleMultipleImports) == 0)
+        XMLString::compareIStringASCII(name, XMLUni::fgXercesHandleMultipleImports) == 0 ||
+        XMLString::compareIStringASCII(name, XMLUni::fgXercesParallelSchemaLoading) == 0)
       return true;
     else if(XMLString::compareIStringASCII(name, XMLUni::fgDOMIgnoreUnknownCharacterDenormalization) == 0 ||
             XMLString::compareIStringASCII(name, XMLUni::fgDOMCanonicalForm) == 0 ||
@@ -1187,7 +1200,7 @@ void DOMLSParserImpl::docCharacters(const XMLCh* const    chars
                                   , const bool            cdataSection)
 {
     AbstractDOMParser::docCharacters(chars, length, cdataSection);
-    if(fFilter)
+    if(fFilter && !isDropping())
     {
         // send the notification for the previous text node
         if(fFilterDelayedTextNodes && fCurrentNode->getPreviousSibling() && fFilterDelayedTextNodes->containsKey(fCurrentNode->getPreviousSibling()))
@@ -1223,7 +1236,7 @@ void DOMLSParserImpl::docComment(const XMLCh* const  comment)
     }
 
     AbstractDOMParser::docComment(comment);
-    if(fFilter)
+    if(fFilter && !isDropping())
     {
         DOMNodeFilter::ShowType whatToShow=fFilter->getWhatToShow();
         if(whatToShow & DOMNodeFilter::SHOW_COMMENT)
@@ -1245,7 +1258,7 @@ void DOMLSParserImpl::docPI(const XMLCh* const    target
     }
 
     AbstractDOMParser::docPI(target, data);
-    if(fFilter)
+    if(fFilter && !isDropping())
     {
         DOMNodeFilter::ShowType whatToShow=fFilter->getWhatToShow();
         if(whatToShow & DOMNodeFilter::SHOW_PROCESSING_INSTRUCTION)
@@ -1267,7 +1280,7 @@ void DOMLSParserImpl::startEntityReference(const XMLEntityDecl& entDecl)
 
     DOMNode* origParent = fCurrentParent;
     AbstractDOMParser::startEntityReference(entDecl);
-    if (fCreateEntityReferenceNodes && fFilter)
+    if (fCreateEntityReferenceNodes && fFilter && !isDropping())
     {
         if(fFilterAction && fFilterAction->containsKey(origParent) && fFilterAction->get(origParent)==DOMLSParserFilter::FILTER_REJECT)
             fFilterAction->put(fCurrentNode, DOMLSParserFilter::FILTER_REJECT);
@@ -1279,6 +1292,16 @@ void DOMLSParserImpl::endElement(const XMLElementDecl& elemDecl
                                , const bool            isRoot
                                , const XMLCh* const    elemPrefix)
 {
+    // In record mode the filter only sees the content of the records, but
+    // an abort() still stops the parse between them.
+    if(fFilter && isDropping())
+    {
+        if(fFilter==&g_AbortFilter)
+            throw DOMLSException(DOMLSException::PARSE_ERR, XMLDOMMsg::LSParser_ParsingAborted, fMemoryManager);
+        AbstractDOMParser::endElement(elemDecl, urlId, isRoot, elemPrefix);
+        return;
+    }
+
     if(fFilter)
     {
         // send the notification for the previous text node
@@ -1289,6 +1312,37 @@ void DOMLSParserImpl::endElement(const XMLElementDecl& elemDecl
         }
     }
 
+    // The end tag of a skipped start tag; its content is already in place
+    if(fFilter && isUnwrappedTag())
+    {
+        AbstractDOMParser::endElement(elemDecl, urlId, isRoot, elemPrefix);
+        return;
+    }
+
+    if(fFilter && isRecordEnd())
+    {
+        // The record is handed over as soon as its root ends, so the root
+        // is filtered first; rejecting or skipping it drops the record.
+        if(fFilter->getWhatToShow() & DOMNodeFilter::SHOW_ELEMENT)
+        {
+            DOMNode* thisNode = fCurrentParent;
+            DOMLSParserFilter::FilterAction action;
+            if(fFilterAction && fFilterAction->containsKey(thisNode))
+            {
+                action = fFilterAction->get(thisNode);
+                fFilterAction->removeKey(thisNode);
+            }
+            else
+                action = fFilter->acceptNode(thisNode);
+            if(action == DOMLSParserFilter::FILTER_INTERRUPT)
+                throw DOMLSException(DOMLSException::PARSE_ERR, XMLDOMMsg::LSParser_ParsingAborted, fMemoryManager);
+            if(action != DOMLSParserFilter::FILTER_ACCEPT)
+                rejectRecord();
+        }
+        AbstractDOMParser::endElement(elemDecl, urlId, isRoot, elemPrefix);
+        return;
+    }
+
     AbstractDOMParser::endElement(elemDecl, urlId, isRoot, elemPrefix);
     if(fFilter)
     {
@@ -1348,9 +1402,47 @@ void DOMLSParserImpl::startElement(const XMLElementDecl&         elemDecl
         }
     }
 
+    // Give the filter a chance to drop the element before anything is built
+    // for it. Record roots are left to the record handler.
+    if(fFilter && !isDropping() && (!getRecordHandler() || isWithinRecord()))
+    {
+        const XMLCh* uri = XMLUni::fgZeroLenString;
+        const XMLCh* localName = elemDecl.getFullName();
+        if (getScanner()->getDoNamespaces())
+        {
+            localName = elemDecl.getBaseName();
+            if (urlId != getScanner()->getEmptyNamespaceId())
+                uri = getScanner()->getURIText(urlId);
+        }
+        fAttrList.setVector(&attrList, attrCount, getScanner());
+
+        DOMLSParserFilter::FilterAction action = fFilter->acceptStartTag(uri, localName, elemDecl.getElementName()->getRawName(), fAttrList);
+        switch(action)
+        {
+        case DOMLSParserFilter::FILTER_ACCEPT:      break;
+        case DOMLSParserFilter::FILTER_REJECT:      dropElement(false);
+                                                    break;
+        case DOMLSParserFilter::FILTER_SKIP:        unwrapElement(false);
+                                                    break;
+        case DOMLSParserFilter::FILTER_INTERRUPT:   throw DOMLSException(DOMLSException::PARSE_ERR, XMLDOMMsg::LSParser_ParsingAborted, fMemoryManager);
+        }
+        if(action != DOMLSParserFilter::FILTER_ACCEPT)
+        {
+            if(isEmpty)
+                endElement(elemDecl, urlId, isRoot, elemPrefix);
+            return;
+        }
+    }
+
     DOMNode* origParent = fCurrentParent;
     AbstractDOMParser::startElement(elemDecl, urlId, elemPrefix, attrList, attrCount, false, isRoot);
-    if(fFilter)
+    if(fFilter && isDropping())
+    {
+        // See endElement()
+        if(fFilter==&g_AbortFilter)
+            throw DOMLSException(DOMLSException::PARSE_ERR, XMLDOMMsg::LSParser_ParsingAborted, fMemoryManager);
+    }
+    else if(fFilter)
     {
         // if the parent was already rejected, reject this too
         if(fFilterAction && fFilterAction->containsKey(origParent) && fFilterAction->get(origParent)==DOMLSParserFilter::FILTER_REJECT)
@@ -1362,7 +1454,18 @@ void DOMLSParserImpl::startElement(const XMLElementDecl&         elemDecl
             switch(action)
             {
             case DOMLSParserFilter::FILTER_ACCEPT:      break;
-            case DOMLSParserFilter::FILTER_REJECT:
+            case DOMLSParserFilter::FILTER_REJECT:      if(!isRecordEnd())
+                                                        {
+                                                            // the content will never be shown to the filter, so
+                                                            // it doesn't need to be built either
+                                                            DOMNode* thisNode = fCurrentNode;
+                                                            fCurrentParent = origParent;
+                                                            fCurrentParent->removeChild(thisNode);
+                                                            thisNode->release();
+                                                            dropElement(false);
+                                                            break;
+                                                        }
+                                                        // fall through
             case DOMLSParserFilter::FILTER_SKIP:        if(fFilterAction==0)
                                                             fFilterAction=new (fMemoryManager) ValueHashTableOf<DOMLSParserFilter::FilterAction, PtrHasher>(7, fMemoryManager);
                                                         fFilterAction->put(fCurrentNode, action);
@@ -30,6 +30,7 @@
 #include <xercesc/util/XercesDefs.hpp>
 #include <xercesc/util/RefVectorOf.hpp>
 #include <xercesc/util/ValueHashTableOf.hpp>
+#include <xercesc/internal/VecAttributesImpl.hpp>
 
 namespace XERCES_CPP_NAMESPACE {
 
@@ -637,6 +638,10 @@ private :
     //      so that we ask DOMLSParserFilter::acceptNode only once, when it
     //      is completely created
 	//
+    //  fAttrList
+    //      The attributes of a start tag, as they are passed to
+    //      DOMLSParserFilter::acceptStartTag
+	//
     //  fWrapNodesInDocumentFragment
     //  fWrapNodesContext
     //  fWrapNodesAction
@@ -652,6 +657,7 @@ private :
     DOMStringListImpl*          fSupportedParameters;
     ValueHashTableOf<DOMLSParserFilter::FilterAction, PtrHasher>*   fFilterAction;
     ValueHashTableOf<bool, PtrHasher>*                              fFilterDelayedTextNodes;
+    VecAttributesImpl           fAttrList;
     DOMDocumentFragment*        fWrapNodesInDocumentFragment;
     DOMNode*                    fWrapNodesContext;
     ActionType                  fWrapNodesAction;
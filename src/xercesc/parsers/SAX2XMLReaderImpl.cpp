@@ -1366,6 +1366,10 @@ void SAX2XMLReaderImpl::setFeature(const XMLCh* const name, const bool value)
     {
         fScanner->setHandleMultipleImports(value);
     }
+    else if (XMLString::compareIStringASCII(name, XMLUni::fgXercesParallelSchemaLoading) == 0)
+    {
+        fScanner->setParallelSchemaLoading(value);
+    }
     else
        throw SAXNotRecognizedException("Unknown Feature", fMemoryManager);
 }
@@ -1416,6 +1420,8 @@ bool SAX2XMLReaderImpl::getFeature(const XMLCh* const name) const
         return fScanner->getSkipDTDValidation();
     else if (XMLString::compareIStringASCII(name, XMLUni::fgXercesHandleMultipleImports) == 0)
         return fScanner->getHandleMultipleImports();
+    else if (XMLString::compareIStringASCII(name, XMLUni::fgXercesParallelSchemaLoading) == 0)
+        return fScanner->getParallelSchemaLoading();
     else
        throw SAXNotRecognizedException("Unknown Feature", fMemoryManager);
 
@@ -0,0 +1,359 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+#include <xercesc/parsers/SAX2XPathFilter.hpp>
+#include <xercesc/framework/XMLAttr.hpp>
+#include <xercesc/framework/XMLBuffer.hpp>
+#include <xercesc/util/Janitor.hpp>
+#include <xercesc/util/StringPool.hpp>
+#include <xercesc/util/XMLChar.hpp>
+#include <xercesc/util/XMLUniDefs.hpp>
+#include <xercesc/util/XMLUni.hpp>
+#include <xercesc/validators/schema/SchemaElementDecl.hpp>
+#include <xercesc/validators/schema/identity/XercesXPath.hpp>
+#include <xercesc/validators/schema/identity/XPathMatcher.hpp>
+
+namespace XERCES_CPP_NAMESPACE {
+
+typedef JanitorMemFunCall<SAX2XPathFilter>    CleanupType;
+
+// ---------------------------------------------------------------------------
+//  SAX2XPathFilter: Constructors and Destructor
+// ---------------------------------------------------------------------------
+SAX2XPathFilter::SAX2XPathFilter(SAX2XMLReader* parent
+                                 , MemoryManager* const manager) :
+    SAX2XMLFilterImpl(parent)
+    , fMemoryManager(manager)
+    , fStringPool(0)
+    , fEmptyNamespaceId(0)
+    , fBindings(0)
+    , fXPaths(0)
+    , fMatchers(0)
+    , fElemDecl(0)
+    , fEmptyAttrList(0)
+    , fMappings(0)
+    , fScopeSizes(0)
+    , fReplayedMappings(0)
+    , fDepth(0)
+    , fMatchDepth(0)
+    , fMatchId(-1)
+    , fForwardedEnd(false)
+{
+    CleanupType cleanup(this, &SAX2XPathFilter::cleanUp);
+
+    fStringPool = new (fMemoryManager) XMLStringPool(109, fMemoryManager);
+    fEmptyNamespaceId = fStringPool->addOrFind(XMLUni::fgZeroLenString);
+    fBindings = new (fMemoryManager) ValueHashTableOf<unsigned int>(7, fMemoryManager);
+    fXPaths = new (fMemoryManager) RefVectorOf<XercesXPath>(4, true, fMemoryManager);
+    fMatchers = new (fMemoryManager) RefVectorOf<XPathMatcher>(4, true, fMemoryManager);
+    fElemDecl = new (fMemoryManager) SchemaElementDecl(fMemoryManager);
+    fEmptyAttrList = new (fMemoryManager) RefVectorOf<XMLAttr>(1, false, fMemoryManager);
+    fMappings = new (fMemoryManager) ValueVectorOf<unsigned int>(16, fMemoryManager);
+    fScopeSizes = new (fMemoryManager) ValueVectorOf<XMLSize_t>(16, fMemoryManager);
+    fReplayedMappings = new (fMemoryManager) ValueVectorOf<unsigned int>(8, fMemoryManager);
+
+    cleanup.release();
+}
+
+SAX2XPathFilter::~SAX2XPathFilter()
+{
+    cleanUp();
+}
+
+void SAX2XPathFilter::cleanUp()
+{
+    // The matchers refer to the location paths owned by the expressions
+    delete fMatchers;
+    delete fXPaths;
+    delete fReplayedMappings;
+    delete fScopeSizes;
+    delete fMappings;
+    delete fEmptyAttrList;
+    delete fElemDecl;
+    delete fBindings;
+    delete fStringPool;
+}
+
+// ---------------------------------------------------------------------------
+//  SAX2XPathFilter: Expression management
+// ---------------------------------------------------------------------------
+void SAX2XPathFilter::addNamespaceBinding(const XMLCh* const prefix
+                                          , const XMLCh* const uri)
+{
+    // Keys of the binding table live in the string pool
+    const XMLCh* key = fStringPool->getValueForId(fStringPool->addOrFind(prefix));
+    fBindings->put((void*)key, fStringPool->addOrFind(uri));
+}
+
+XMLSize_t SAX2XPathFilter::addExpression(const XMLCh* const expression)
+{
+    //  The selector grammar only knows relative paths, so every branch of
+    //  the union which is written from the document root gets rooted at
+    //  the context node, which is the document itself.
+    XMLBuffer relative(1023, fMemoryManager);
+    bool branchStart = true;
+    for (const XMLCh* cur = expression; *cur; cur++)
+    {
+        if (branchStart && *cur == chForwardSlash)
+            relative.append(chPeriod);
+
+        if (*cur == chPipe)
+            branchStart = true;
+        else if (!XMLChar1_0::isWhitespace(*cur))
+            branchStart = false;
+
+        relative.append(*cur);
+    }
+
+    XercesXPath* xpath = new (fMemoryManager) XercesXPath
+    (
+        relative.getRawBuffer()
+        , fStringPool
+        , this
+        , fEmptyNamespaceId
+        , true
+        , fMemoryManager
+    );
+    Janitor<XercesXPath> janXPath(xpath);
+
+    XPathMatcher* matcher = new (fMemoryManager) XPathMatcher(xpath, fMemoryManager);
+    Janitor<XPathMatcher> janMatcher(matcher);
+
+    fXPaths->addElement(janXPath.release());
+    fMatchers->addElement(janMatcher.release());
+
+    return fXPaths->size() - 1;
+}
+
+// ---------------------------------------------------------------------------
+//  SAX2XPathFilter: XercesNamespaceResolver interface
+// ---------------------------------------------------------------------------
+unsigned int SAX2XPathFilter::getNamespaceForPrefix(const XMLCh* const prefix) const
+{
+    if (fBindings->containsKey(prefix))
+        return fBindings->get(prefix);
+
+    return fEmptyNamespaceId;
+}
+
+// ---------------------------------------------------------------------------
+//  SAX2XPathFilter: Private helper methods
+// ---------------------------------------------------------------------------
+void SAX2XPathFilter::setElementName(const XMLCh* const uri
+                                     , const XMLCh* const localname
+                                     , const XMLCh* const qname)
+{
+    const unsigned int uriId = (uri && *uri) ? fStringPool->addOrFind(uri)
+                                             : fEmptyNamespaceId;
+
+    // Without namespace processing only the qualified name is reported
+    if (localname && *localname)
+        fElemDecl->setElementName(XMLUni::fgZeroLenString, localname, uriId);
+    else
+        fElemDecl->setElementName(qname, uriId);
+}
+
+void SAX2XPathFilter::replayMappings(const XMLSize_t declStart)
+{
+    // Report the innermost binding of every prefix declared above the new
+    // subtree, unless the root of the subtree redeclares it or the binding
+    // is an undeclaration of the default namespace.
+    for (XMLSize_t i = declStart; i > 0; i -= 2)
+    {
+        const unsigned int prefixId = fMappings->elementAt(i - 2);
+        const unsigned int uriId = fMappings->elementAt(i - 1);
+
+        bool shadowed = false;
+        for (XMLSize_t j = i; j < fMappings->size() && !shadowed; j += 2)
+            shadowed = (fMappings->elementAt(j) == prefixId);
+        if (shadowed || uriId == fEmptyNamespaceId)
+            continue;
+
+        SAX2XMLFilterImpl::startPrefixMapping
+        (
+            fStringPool->getValueForId(prefixId)
+            , fStringPool->getValueForId(uriId)
+        );
+        fReplayedMappings->addElement(prefixId);
+    }
+}
+
+// ---------------------------------------------------------------------------
+//  SAX2XPathFilter: ContentHandler interface
+// ---------------------------------------------------------------------------
+void SAX2XPathFilter::startDocument()
+{
+    fDepth = 0;
+    fMatchDepth = 0;
+    fMatchId = -1;
+    fForwardedEnd = false;
+    fMappings->removeAllElements();
+    fScopeSizes->removeAllElements();
+    fReplayedMappings->removeAllElements();
+
+    // The document is the context node of every expression
+    fElemDecl->setElementName(XMLUni::fgZeroLenString, fEmptyNamespaceId);
+    XMLSize_t count = fMatchers->size();
+    for (XMLSize_t i = 0; i < count; i++)
+    {
+        XPathMatcher* matcher = fMatchers->elementAt(i);
+        matcher->startDocumentFragment();
+        matcher->startElement(*fElemDecl, fEmptyNamespaceId, XMLUni::fgZeroLenString, *fEmptyAttrList, 0);
+    }
+
+    SAX2XMLFilterImpl::startDocument();
+}
+
+void SAX2XPathFilter::endDocument()
+{
+    fElemDecl->setElementName(XMLUni::fgZeroLenString, fEmptyNamespaceId);
+    XMLSize_t count = fMatchers->size();
+    for (XMLSize_t i = 0; i < count; i++)
+        fMatchers->elementAt(i)->endElement(*fElemDecl, XMLUni::fgZeroLenString);
+
+    SAX2XMLFilterImpl::endDocument();
+}
+
+void SAX2XPathFilter::startElement(const   XMLCh* const    uri
+                                   , const XMLCh* const    localname
+                                   , const XMLCh* const    qname
+                                   , const Attributes&     attrs)
+{
+    fDepth++;
+    setElementName(uri, localname, qname);
+
+    // The mappings reported since the enclosing start tag are this element's
+    const XMLSize_t declStart = fScopeSizes->size() ? fScopeSizes->elementAt(fScopeSizes->size() - 1) : 0;
+    fScopeSizes->addElement(fMappings->size());
+
+    const XMLSize_t count = fMatchers->size();
+    const unsigned int uriId = fElemDecl->getURI();
+    for (XMLSize_t i = 0; i < count; i++)
+        fMatchers->elementAt(i)->startElement(*fElemDecl, uriId, XMLUni::fgZeroLenString, *fEmptyAttrList, 0);
+
+    // The matchers keep reporting a match for the content of a matched
+    // element, so only look for a new subtree when outside of one.
+    if (!fMatchDepth)
+    {
+        for (XMLSize_t i = 0; i < count; i++)
+        {
+            if (fMatchers->elementAt(i)->isMatched())
+            {
+                fMatchDepth = fDepth;
+                fMatchId = (int)i;
+                replayMappings(declStart);
+                break;
+            }
+        }
+    }
+
+    if (fMatchDepth)
+    {
+        const XMLSize_t mappings = fMappings->size();
+        for (XMLSize_t i = declStart; i < mappings; i += 2)
+        {
+            SAX2XMLFilterImpl::startPrefixMapping
+            (
+                fStringPool->getValueForId(fMappings->elementAt(i))
+                , fStringPool->getValueForId(fMappings->elementAt(i + 1))
+            );
+        }
+        SAX2XMLFilterImpl::startElement(uri, localname, qname, attrs);
+    }
+}
+
+void SAX2XPathFilter::endElement(const   XMLCh* const    uri
+                                 , const XMLCh* const    localname
+                                 , const XMLCh* const    qname)
+{
+    setElementName(uri, localname, qname);
+
+    const XMLSize_t count = fMatchers->size();
+    for (XMLSize_t i = 0; i < count; i++)
+        fMatchers->elementAt(i)->endElement(*fElemDecl, XMLUni::fgZeroLenString);
+
+    fForwardedEnd = (fMatchDepth != 0);
+    if (fForwardedEnd)
+    {
+        SAX2XMLFilterImpl::endElement(uri, localname, qname);
+
+        if (fMatchDepth == fDepth)
+        {
+            const XMLSize_t replayed = fReplayedMappings->size();
+            for (XMLSize_t i = 0; i < replayed; i++)
+                SAX2XMLFilterImpl::endPrefixMapping(fStringPool->getValueForId(fReplayedMappings->elementAt(i)));
+            fReplayedMappings->removeAllElements();
+
+            fMatchDepth = 0;
+            fMatchId = -1;
+        }
+    }
+
+    // Drop the mappings declared on this element
+    fScopeSizes->removeElementAt(fScopeSizes->size() - 1);
+    const XMLSize_t inScope = fScopeSizes->size() ? fScopeSizes->elementAt(fScopeSizes->size() - 1) : 0;
+    while (fMappings->size() > inScope)
+        fMappings->removeElementAt(fMappings->size() - 1);
+    fDepth--;
+}
+
+void SAX2XPathFilter::startPrefixMapping(const   XMLCh* const    prefix
+                                         , const XMLCh* const    uri)
+{
+    // Whether to report it depends on the element it is declared on
+    fMappings->addElement(fStringPool->addOrFind(prefix));
+    fMappings->addElement(fStringPool->addOrFind(uri));
+}
+
+void SAX2XPathFilter::endPrefixMapping(const XMLCh* const prefix)
+{
+    if (fForwardedEnd)
+        SAX2XMLFilterImpl::endPrefixMapping(prefix);
+}
+
+void SAX2XPathFilter::characters(const   XMLCh* const    chars
+                                 , const XMLSize_t       length)
+{
+    if (fMatchDepth)
+        SAX2XMLFilterImpl::characters(chars, length);
+}
+
+void SAX2XPathFilter::ignorableWhitespace(const   XMLCh* const    chars
+                                          , const XMLSize_t       length)
+{
+    if (fMatchDepth)
+        SAX2XMLFilterImpl::ignorableWhitespace(chars, length);
+}
+
+void SAX2XPathFilter::processingInstruction(const   XMLCh* const    target
+                                            , const XMLCh* const    data)
+{
+    if (fMatchDepth)
+        SAX2XMLFilterImpl::processingInstruction(target, data);
+}
+
+void SAX2XPathFilter::skippedEntity(const XMLCh* const name)
+{
+    if (fMatchDepth)
+        SAX2XMLFilterImpl::skippedEntity(name);
+}
+
+}
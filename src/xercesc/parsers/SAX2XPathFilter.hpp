@@ -0,0 +1,297 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * $Id$
+ */
+
+#if !defined(XERCESC_INCLUDE_GUARD_SAX2XPATHFILTER_HPP)
+#define XERCESC_INCLUDE_GUARD_SAX2XPATHFILTER_HPP
+
+#include <xercesc/parsers/SAX2XMLFilterImpl.hpp>
+#include <xercesc/validators/schema/NamespaceScope.hpp>
+#include <xercesc/util/RefVectorOf.hpp>
+#include <xercesc/util/ValueHashTableOf.hpp>
+#include <xercesc/util/ValueVectorOf.hpp>
+
+namespace XERCES_CPP_NAMESPACE {
+
+class XercesXPath;
+class XPathMatcher;
+class XMLAttr;
+class XMLStringPool;
+class SchemaElementDecl;
+
+/**
+  * This class implements a SAX2 filter which forwards to the installed
+  * content handler only the events belonging to subtrees selected by a
+  * set of streaming XPath expressions. Everything outside of the matched
+  * subtrees is dropped, which makes it possible to pull records out of
+  * arbitrarily large documents without building a DOM.
+  *
+  * The expressions use the restricted XPath subset of the identity
+  * constraint selectors of XML Schema: location paths made of child
+  * steps, optionally starting with <code>.//</code>, with element name,
+  * <code>prefix:*</code> or <code>*</code> node tests and combined with
+  * <code>|</code>. Paths are evaluated relative to the document, so that
+  * <code>/a/b</code>, <code>a/b</code> and <code>./a/b</code> are
+  * equivalent, and <code>//b</code> selects every <code>b</code> element.
+  * Prefixes used in the expressions are bound with addNamespaceBinding()
+  * before the expression is added; unprefixed names only match elements
+  * in no namespace.
+  *
+  * When an element matches, its start tag, its whole content and its end
+  * tag are forwarded, together with the prefix mappings declared on the
+  * elements of the subtree. The mappings declared on its ancestors which
+  * are still in scope are reported before its start tag as well, so the
+  * subtree is namespace well-formed on its own. Matches nested inside an already matched
+  * subtree are part of that subtree and do not start a new one. While
+  * inside a matched subtree getCurrentMatch() returns the index of the
+  * expression that selected it.
+  *
+  * Document start and end, the document locator and all DTD, entity and
+  * error events are always forwarded.
+  */
+
+class PARSERS_EXPORT SAX2XPathFilter :
+    public SAX2XMLFilterImpl
+    , private XercesNamespaceResolver
+{
+public :
+    // -----------------------------------------------------------------------
+    //  Constructors and Destructor
+    // -----------------------------------------------------------------------
+    /** @name Constructors and Destructor */
+    //@{
+    /**
+      * Constructor
+      *
+      * @param parent  The reader whose events are filtered.
+      * @param manager The memory manager used for the compiled expressions
+      *                and the matching state.
+      */
+    SAX2XPathFilter(SAX2XMLReader* parent
+                    , MemoryManager* const manager = XMLPlatformUtils::fgMemoryManager);
+
+    /** The destructor */
+    ~SAX2XPathFilter();
+    //@}
+
+    // -----------------------------------------------------------------------
+    //  Expression management
+    // -----------------------------------------------------------------------
+    /** @name Expression management */
+    //@{
+    /**
+      * Bind a namespace prefix for use in expressions added afterwards.
+      * Binding an already bound prefix replaces the previous binding.
+      *
+      * @param prefix The prefix, without the trailing colon.
+      * @param uri    The namespace URI the prefix stands for.
+      */
+    void addNamespaceBinding(const XMLCh* const prefix, const XMLCh* const uri);
+
+    /**
+      * Compile and add a streaming XPath expression. Expressions may only
+      * be added when no parse is in progress.
+      *
+      * @param expression The location path to match.
+      * @return The match id of the expression, which is its zero based
+      *         index in the order in which expressions were added.
+      * @exception XPathException if the expression is not a valid
+      *            streaming location path or uses an unbound prefix.
+      */
+    XMLSize_t addExpression(const XMLCh* const expression);
+
+    /** Get the number of expressions added so far. */
+    XMLSize_t getExpressionCount() const;
+
+    /**
+      * Get the match id of the subtree currently being forwarded.
+      *
+      * If several expressions select the root of the subtree the lowest
+      * match id is reported.
+      *
+      * @return The match id, or -1 if the current event lies outside of
+      *         any matched subtree.
+      */
+    int getCurrentMatch() const;
+    //@}
+
+    // -----------------------------------------------------------------------
+    //  Implementation of the ContentHandler interface
+    // -----------------------------------------------------------------------
+    /** @name Implementation of the ContentHandler interface */
+    //@{
+    virtual void characters
+    (
+        const   XMLCh* const    chars
+        , const XMLSize_t       length
+    );
+
+    virtual void endDocument();
+
+    virtual void endElement
+    (
+        const XMLCh* const uri
+        , const XMLCh* const localname
+        , const XMLCh* const qname
+    );
+
+    virtual void ignorableWhitespace
+    (
+        const   XMLCh* const    chars
+        , const XMLSize_t       length
+    );
+
+    virtual void processingInstruction
+    (
+        const   XMLCh* const    target
+        , const XMLCh* const    data
+    );
+
+    virtual void startDocument();
+
+    virtual void startElement
+    (
+        const   XMLCh* const    uri,
+        const   XMLCh* const    localname,
+        const   XMLCh* const    qname,
+        const   Attributes&     attrs
+    );
+
+    virtual void startPrefixMapping
+    (
+        const   XMLCh* const    prefix,
+        const   XMLCh* const    uri
+    );
+
+    virtual void endPrefixMapping
+    (
+        const   XMLCh* const    prefix
+    );
+
+    virtual void skippedEntity
+    (
+        const   XMLCh* const    name
+    );
+    //@}
+
+private :
+    // -----------------------------------------------------------------------
+    //  Unimplemented constructors and operators
+    // -----------------------------------------------------------------------
+    SAX2XPathFilter(const SAX2XPathFilter&);
+    SAX2XPathFilter& operator=(const SAX2XPathFilter&);
+
+    // -----------------------------------------------------------------------
+    //  XercesNamespaceResolver interface
+    // -----------------------------------------------------------------------
+    virtual unsigned int getNamespaceForPrefix(const XMLCh* const prefix) const;
+
+    // -----------------------------------------------------------------------
+    //  Private helper methods
+    // -----------------------------------------------------------------------
+    void cleanUp();
+    void setElementName(const XMLCh* const uri
+                        , const XMLCh* const localname
+                        , const XMLCh* const qname);
+    void replayMappings(const XMLSize_t declStart);
+
+    // -----------------------------------------------------------------------
+    //  Private data members
+    //
+    //  fStringPool
+    //      Holds the names and URIs of the compiled expressions as well as
+    //      the URIs of the filtered elements, so that both sides of a node
+    //      test are compared by pool id.
+    //
+    //  fEmptyNamespaceId
+    //      The pool id of the empty string, used as the URI of elements
+    //      in no namespace.
+    //
+    //  fBindings
+    //      Prefix to URI id mapping used while compiling expressions.
+    //
+    //  fXPaths, fMatchers
+    //      The compiled expressions and their matchers, by match id.
+    //
+    //  fElemDecl, fEmptyAttrList
+    //      The element declaration and attribute list handed to the
+    //      matchers. Only the element name is relevant to them, so the
+    //      same declaration is renamed for every element.
+    //
+    //  fMappings
+    //      Pool ids of the prefix/URI pairs in scope, innermost last. The
+    //      pairs reported ahead of a start tag belong to that element.
+    //
+    //  fScopeSizes
+    //      For every open element, the size of fMappings once its own
+    //      declarations were added, so they can be dropped at its end.
+    //
+    //  fReplayedMappings
+    //      Pool ids of the prefixes declared above the root of the current
+    //      subtree which were reported when it started, so that their end
+    //      can be reported when it ends.
+    //
+    //  fDepth
+    //      The element nesting depth, the document being at depth 0.
+    //
+    //  fMatchDepth
+    //      The depth of the root of the matched subtree, 0 if none.
+    //
+    //  fMatchId
+    //      The match id of the current subtree, -1 if none.
+    //
+    //  fForwardedEnd
+    //      Whether the end tag just reported was forwarded, which decides
+    //      whether the end prefix mappings following it are.
+    // -----------------------------------------------------------------------
+    MemoryManager*                      fMemoryManager;
+    XMLStringPool*                      fStringPool;
+    unsigned int                        fEmptyNamespaceId;
+    ValueHashTableOf<unsigned int>*     fBindings;
+    RefVectorOf<XercesXPath>*           fXPaths;
+    RefVectorOf<XPathMatcher>*          fMatchers;
+    SchemaElementDecl*                  fElemDecl;
+    RefVectorOf<XMLAttr>*               fEmptyAttrList;
+    ValueVectorOf<unsigned int>*        fMappings;
+    ValueVectorOf<XMLSize_t>*           fScopeSizes;
+    ValueVectorOf<unsigned int>*        fReplayedMappings;
+    XMLSize_t                           fDepth;
+    XMLSize_t                           fMatchDepth;
+    int                                 fMatchId;
+    bool                                fForwardedEnd;
+};
+
+
+// ---------------------------------------------------------------------------
+//  SAX2XPathFilter: Getter methods
+// ---------------------------------------------------------------------------
+inline XMLSize_t SAX2XPathFilter::getExpressionCount() const
+{
+    return fXPaths->size();
+}
+
+inline int SAX2XPathFilter::getCurrentMatch() const
+{
+    return fMatchId;
+}
+
+}
+
+#endif
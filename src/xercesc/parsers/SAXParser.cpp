@@ -387,6 +387,11 @@ bool SAXParser::getHandleMultipleImports() const
     return fScanner->getHandleMultipleImports();
 }
 
+bool SAXParser::getParallelSchemaLoading() const
+{
+    return fScanner->getParallelSchemaLoading();
+}
+
 // ---------------------------------------------------------------------------
 //  SAXParser: Setter methods
 // ---------------------------------------------------------------------------
@@ -558,6 +563,11 @@ void SAXParser::setHandleMultipleImports(const bool newValue)
     fScanner->setHandleMultipleImports(newValue);
 }
 
+void SAXParser::setParallelSchemaLoading(const bool newValue)
+{
+    fScanner->setParallelSchemaLoading(newValue);
+}
+
 // ---------------------------------------------------------------------------
 //  SAXParser: Overrides of the SAX Parser interface
 // ---------------------------------------------------------------------------
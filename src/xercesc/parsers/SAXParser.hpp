@@ -552,6 +552,15 @@ public :
       * @see #setHandleMultipleImports
       */
     bool getHandleMultipleImports() const;
+
+    /** Get the 'parallel schema loading' flag
+      *
+      * @return true, if the parser is currently configured to parse
+      *         the documents of a schema on several threads, false otherwise.
+      *
+      * @see #setParallelSchemaLoading
+      */
+    bool getParallelSchemaLoading() const;
     //@}
 
 
@@ -931,7 +940,9 @@ public :
     /** Set the 'ignore annotation' flag
       *
       * This method gives users the option to not generate XSAnnotations
-      * when "traversing" a schema.
+      * when "traversing" a schema. The text of the annotations is then not
+      * kept while the schema documents are parsed either, which saves
+      * memory and time for schemas with much documentation.
       *
       * The parser's default state is false
       *
@@ -981,6 +992,26 @@ public :
       * @param newValue The state to set
       */
     void setHandleMultipleImports(const bool newValue);
+
+    /** Set the 'parallel schema loading' flag
+      *
+      * This method lets the parser parse the documents included, imported
+      * and redefined by a schema on several threads before the schema is
+      * traversed. The entity resolver is only called on the calling thread,
+      * for the locations of all these documents before the first of them is
+      * traversed. A document which reports an error or a warning, or which
+      * refers to an external entity, is parsed again on the calling thread,
+      * so the grammar and the errors reported are the same as without this
+      * option. The memory manager of the grammar pool must be thread-safe.
+      *
+      * NOTE: This option is ignored if schema validation is disabled, or if
+      * the library is built without the standard C++ thread support.
+      *
+      * The parser's default state is false
+      *
+      * @param newValue The state to set
+      */
+    void setParallelSchemaLoading(const bool newValue);
     //@}
 
 
@@ -27,6 +27,7 @@
 #include <xercesc/util/RefHash3KeysIdPool.hpp>
 #endif
 
+#include <xercesc/util/Janitor.hpp>
 #include <xercesc/util/NullPointerException.hpp>
 #include <assert.h>
 #include <new>
@@ -304,6 +305,13 @@ template <class TVal, class THasher>
 XMLSize_t
 RefHash3KeysIdPool<TVal, THasher>::put(void* key1, int key2, int key3, TVal* const valueToAdopt)
 {
+    // Apply 0.75 load factor to find threshold.
+    XMLSize_t threshold = fHashModulus * 3 / 4;
+
+    // If we've grown too big, expand the table and rehash.
+    if (fIdCounter >= threshold)
+        rehash();
+
     // First see if the key exists already
     XMLSize_t hashVal;
     XMLSize_t retId;
@@ -373,6 +381,59 @@ RefHash3KeysIdPool<TVal, THasher>::put(void* key1, int key2, int key3, TVal* con
 // ---------------------------------------------------------------------------
 //  RefHash3KeysIdPool: Private methods
 // ---------------------------------------------------------------------------
+template <class TVal, class THasher>
+void RefHash3KeysIdPool<TVal, THasher>::rehash()
+{
+    const XMLSize_t newMod = (fHashModulus * 2) + 1;
+
+    RefHash3KeysTableBucketElem<TVal>** newBucketList =
+        (RefHash3KeysTableBucketElem<TVal>**) fMemoryManager->allocate
+    (
+        newMod * sizeof(RefHash3KeysTableBucketElem<TVal>*)
+    );
+
+    // Make sure the new bucket list is destroyed if an
+    // exception is thrown.
+    ArrayJanitor<RefHash3KeysTableBucketElem<TVal>*>  guard(newBucketList, fMemoryManager);
+
+    memset(newBucketList, 0, newMod * sizeof(newBucketList[0]));
+
+
+    // Rehash all existing entries.
+    for (XMLSize_t index = 0; index < fHashModulus; index++)
+    {
+        // Get the bucket list head for this entry
+        RefHash3KeysTableBucketElem<TVal>* curElem = fBucketList[index];
+
+        while (curElem)
+        {
+            // Save the next element before we detach this one
+            RefHash3KeysTableBucketElem<TVal>* const nextElem = curElem->fNext;
+
+            const XMLSize_t hashVal = fHasher.getHashVal(curElem->fKey1, newMod);
+
+            RefHash3KeysTableBucketElem<TVal>* const newHeadElem = newBucketList[hashVal];
+
+            // Insert at the start of this bucket's list.
+            curElem->fNext = newHeadElem;
+            newBucketList[hashVal] = curElem;
+
+            curElem = nextElem;
+        }
+    }
+
+    RefHash3KeysTableBucketElem<TVal>** const oldBucketList = fBucketList;
+
+    // Everything is OK at this point, so update the
+    // member variables.
+    fBucketList = guard.release();
+    fHashModulus = newMod;
+
+    // Delete the old bucket list.
+    fMemoryManager->deallocate(oldBucketList);//delete[] oldBucketList;
+
+}
+
 template <class TVal, class THasher>
 inline RefHash3KeysTableBucketElem<TVal>* RefHash3KeysIdPool<TVal, THasher>::
 findBucketElem(const void* const key1, const int key2, const int key3, XMLSize_t& hashVal)
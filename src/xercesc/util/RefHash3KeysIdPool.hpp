@@ -157,6 +157,7 @@ private:
     RefHash3KeysTableBucketElem<TVal>* findBucketElem(const void* const key1, const int key2, const int key3, XMLSize_t& hashVal);
     const RefHash3KeysTableBucketElem<TVal>* findBucketElem(const void* const key1, const int key2, const int key3, XMLSize_t& hashVal) const;
     void initialize(const XMLSize_t modulus);
+    void rehash();
 
 
     // -----------------------------------------------------------------------
@@ -84,29 +84,16 @@ void XMLStringPool::flushAll()
 //  XMLStringPool: Private helper methods
 // ---------------------------------------------------------------------------
 unsigned int XMLStringPool::addNewEntry(const XMLCh* const newString)
+{
+    return adoptNewEntry(XMLString::replicate(newString, fMemoryManager));
+}
+
+// The string must have been allocated by the memory manager of the pool
+unsigned int XMLStringPool::adoptNewEntry(XMLCh* const newString)
 {
     // See if we need to expand the id map
     if (fCurId == fMapCapacity)
-    {
-        // Calculate the new capacity, create a temp new map, and zero it
-        const unsigned int newCap = (unsigned int)(fMapCapacity * 1.5);
-        PoolElem** newMap = (PoolElem**) fMemoryManager->allocate
-        (
-            newCap * sizeof(PoolElem*)
-        ); //new PoolElem*[newCap];
-        memset(newMap, 0, sizeof(PoolElem*) * newCap);
-
-        //
-        //  Copy over the old elements from the old map. They are just pointers
-        //  so we can do it all at once.
-        //
-        memcpy(newMap, fIdMap, sizeof(PoolElem*) * fMapCapacity);
-
-        // Clean up the old map and store the new info
-        fMemoryManager->deallocate(fIdMap); //delete [] fIdMap;
-        fIdMap = newMap;
-        fMapCapacity = newCap;
-    }
+        growMap((unsigned int)(fMapCapacity * 1.5));
 
     //
     //  Ok, now create a new element and add it to the hash table. Then store
@@ -115,7 +102,7 @@ unsigned int XMLStringPool::addNewEntry(const XMLCh* const newString)
     //
     PoolElem* newElem = (PoolElem*) fMemoryManager->allocate(sizeof(PoolElem));
     newElem->fId      = fCurId;
-    newElem->fString  = XMLString::replicate(newString, fMemoryManager);
+    newElem->fString  = newString;
     fHashTable->put((void*)newElem->fString, newElem);
     fIdMap[fCurId] = newElem;
 
@@ -124,6 +111,27 @@ unsigned int XMLStringPool::addNewEntry(const XMLCh* const newString)
     return newElem->fId;
 }
 
+void XMLStringPool::growMap(const unsigned int newCap)
+{
+    // Create a temp new map, and zero it
+    PoolElem** newMap = (PoolElem**) fMemoryManager->allocate
+    (
+        newCap * sizeof(PoolElem*)
+    ); //new PoolElem*[newCap];
+    memset(newMap, 0, sizeof(PoolElem*) * newCap);
+
+    //
+    //  Copy over the old elements from the old map. They are just pointers
+    //  so we can do it all at once.
+    //
+    memcpy(newMap, fIdMap, sizeof(PoolElem*) * fMapCapacity);
+
+    // Clean up the old map and store the new info
+    fMemoryManager->deallocate(fIdMap); //delete [] fIdMap;
+    fIdMap = newMap;
+    fMapCapacity = newCap;
+}
+
 /***
  * Support for Serialization/De-serialization
  ***/
@@ -157,15 +165,34 @@ void XMLStringPool::serialize(XSerializeEngine& serEng)
         serEng>>mapSize;
         assert(1 == fCurId);  //make sure empty
 
+        // The number of strings is known, so size the id map and the hash
+        // table for all of them rather than growing them while adding
+        if (mapSize > fMapCapacity)
+            growMap(mapSize);
+        const XMLSize_t hashModulus = (XMLSize_t)mapSize * 4 / 3 + 1;
+        if (hashModulus > fHashTable->getHashModulus())
+        {
+            delete fHashTable;
+            fHashTable = 0;
+            fHashTable = new (fMemoryManager) RefHashTableOf<PoolElem>(hashModulus, false, fMemoryManager);
+        }
+
+        // The strings read are kept as they are when they come from the
+        // memory manager of the pool, instead of being duplicated
+        const bool adoptStrings = (serEng.getMemoryManager() == fMemoryManager);
         for (unsigned int index = 1; index < mapSize; index++)
         {
             XMLCh* stringData;
             serEng.readString(stringData);
-            addNewEntry(stringData);
-
-            //we got to deallocate this string 
-            //since stringpool will duplicate this string in the PoolElem and own that copy
-            fMemoryManager->deallocate(stringData);
+            if (adoptStrings)
+            {
+                adoptNewEntry(stringData);
+            }
+            else
+            {
+                addNewEntry(stringData);
+                serEng.getMemoryManager()->deallocate(stringData);
+            }
         }
     }
 }
@@ -93,6 +93,8 @@ private :
     //  Private helper methods
     // -----------------------------------------------------------------------
     unsigned int addNewEntry(const XMLCh* const newString);
+    unsigned int adoptNewEntry(XMLCh* const newString);
+    void growMap(const unsigned int newCap);
 
 
     // -----------------------------------------------------------------------
@@ -1403,6 +1403,22 @@ const XMLCh XMLUni::fgXercesHandleMultipleImports[] =
     ,   chLatin_r, chLatin_t, chLatin_s, chNull
 };
 
+//Xerces: http://apache.org/xml/features/validation/schema/parallel-loading
+const XMLCh XMLUni::fgXercesParallelSchemaLoading[] =
+{
+        chLatin_h, chLatin_t, chLatin_t, chLatin_p, chColon, chForwardSlash
+    ,   chForwardSlash, chLatin_a, chLatin_p, chLatin_a, chLatin_c, chLatin_h
+    ,   chLatin_e, chPeriod, chLatin_o, chLatin_r, chLatin_g, chForwardSlash
+    ,   chLatin_x, chLatin_m, chLatin_l, chForwardSlash, chLatin_f, chLatin_e
+    ,   chLatin_a, chLatin_t, chLatin_u, chLatin_r, chLatin_e, chLatin_s
+    ,   chForwardSlash, chLatin_v, chLatin_a, chLatin_l, chLatin_i, chLatin_d
+    ,   chLatin_a, chLatin_t, chLatin_i, chLatin_o, chLatin_n, chForwardSlash
+    ,   chLatin_s, chLatin_c, chLatin_h, chLatin_e, chLatin_m, chLatin_a
+    ,   chForwardSlash, chLatin_p, chLatin_a, chLatin_r, chLatin_a, chLatin_l
+    ,   chLatin_l, chLatin_e, chLatin_l, chDash, chLatin_l, chLatin_o
+    ,   chLatin_a, chLatin_d, chLatin_i, chLatin_n, chLatin_g, chNull
+};
+
 //Property
 //Xerces: http://apache.org/xml/properties/low-water-mark
 const XMLCh XMLUni::fgXercesLowWaterMark[] =
@@ -1709,6 +1725,36 @@ const XMLCh XMLUni::fgDOMWRTXercesPrettyPrint[] =
     chLatin_t, chLatin_s, chNull
 };
 
+const XMLCh XMLUni::fgDOMWRTXercesParallelSerialization[] =
+{
+    chLatin_h, chLatin_t, chLatin_t, chLatin_p, chColon, chForwardSlash,
+    chForwardSlash, chLatin_a, chLatin_p, chLatin_a, chLatin_c, chLatin_h,
+    chLatin_e, chPeriod, chLatin_o, chLatin_r, chLatin_g, chForwardSlash,
+    chLatin_x, chLatin_m, chLatin_l, chForwardSlash, chLatin_f, chLatin_e,
+    chLatin_a, chLatin_t, chLatin_u, chLatin_r, chLatin_e, chLatin_s,
+    chForwardSlash, chLatin_d, chLatin_o, chLatin_m, chForwardSlash, chLatin_p,
+    chLatin_a, chLatin_r, chLatin_a, chLatin_l, chLatin_l, chLatin_e,
+    chLatin_l, chDash, chLatin_s, chLatin_e, chLatin_r, chLatin_i,
+    chLatin_a, chLatin_l, chLatin_i, chLatin_z, chLatin_a, chLatin_t,
+    chLatin_i, chLatin_o, chLatin_n, chNull
+};
+
+const XMLCh XMLUni::fgDOMWRTXercesParallelThreads[] =
+{
+    chLatin_h, chLatin_t, chLatin_t, chLatin_p, chColon, chForwardSlash,
+    chForwardSlash, chLatin_a, chLatin_p, chLatin_a, chLatin_c, chLatin_h,
+    chLatin_e, chPeriod, chLatin_o, chLatin_r, chLatin_g, chForwardSlash,
+    chLatin_x, chLatin_m, chLatin_l, chForwardSlash, chLatin_p, chLatin_r,
+    chLatin_o, chLatin_p, chLatin_e, chLatin_r, chLatin_t, chLatin_i,
+    chLatin_e, chLatin_s, chForwardSlash, chLatin_d, chLatin_o, chLatin_m,
+    chForwardSlash, chLatin_p, chLatin_a, chLatin_r, chLatin_a, chLatin_l,
+    chLatin_l, chLatin_e, chLatin_l, chDash, chLatin_s, chLatin_e,
+    chLatin_r, chLatin_i, chLatin_a, chLatin_l, chLatin_i, chLatin_z,
+    chLatin_a, chLatin_t, chLatin_i, chLatin_o, chLatin_n, chDash,
+    chLatin_t, chLatin_h, chLatin_r, chLatin_e, chLatin_a, chLatin_d,
+    chLatin_s, chNull
+};
+
 const XMLCh XMLUni::fgXercescInterfacePSVITypeInfo[] =
 {
     chLatin_D, chLatin_O, chLatin_M, chLatin_P, chLatin_S, chLatin_V, chLatin_I,
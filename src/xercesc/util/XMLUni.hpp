@@ -243,6 +243,7 @@ public :
     static const XMLCh fgXercesSkipDTDValidation[];
     static const XMLCh fgXercesEntityResolver[];
     static const XMLCh fgXercesHandleMultipleImports[];
+    static const XMLCh fgXercesParallelSchemaLoading[];
     static const XMLCh fgXercesDoXInclude[];
     static const XMLCh fgXercesLowWaterMark[];
 
@@ -293,6 +294,8 @@ public :
     static const XMLCh fgDOMWRTBOM[];
     static const XMLCh fgDOMXMLDeclaration[];
     static const XMLCh fgDOMWRTXercesPrettyPrint[];
+    static const XMLCh fgDOMWRTXercesParallelSerialization[];
+    static const XMLCh fgDOMWRTXercesParallelThreads[];
 
     // Private interface names
     static const XMLCh fgXercescInterfacePSVITypeInfo[];
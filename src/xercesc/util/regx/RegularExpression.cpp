@@ -1494,6 +1494,34 @@ Op* RegularExpression::compile(const Token* const token, Op* const next,
     return ret;
 }
 
+void RegularExpression::prepareForSharing()
+{
+    prepareForSharing(fTokenTree);
+    if (fFirstChar)
+        prepareForSharing(fFirstChar);
+}
+
+void RegularExpression::prepareForSharing(Token* const token)
+{
+    const Token::tokType tokenType = token->getTokenType();
+    if (tokenType == Token::T_RANGE || tokenType == Token::T_NRANGE)
+    {
+        RangeToken* rangeTok = (RangeToken*) token;
+        rangeTok->createMap();
+        // the case insensitive token is created with its map
+        if (isSet(fOptions, IGNORE_CASE))
+            rangeTok->getCaseInsensitiveToken(fTokenFactory);
+        return;
+    }
+
+    for (XMLSize_t i = 0; i < token->size(); i++)
+    {
+        Token* child = token->getChild(i);
+        if (child)
+            prepareForSharing(child);
+    }
+}
+
 /*
  * Prepares for matching. This method is called during construction.
  */
@@ -186,6 +186,13 @@ public:
     static int getOptionValue(const XMLCh ch);
     static bool isSet(const int options, const int flag);
 
+    /** Builds the character maps that matching otherwise builds the first
+      * time each character class is used. Once this has been called,
+      * matching no longer modifies the expression, so several threads can
+      * use it at the same time.
+      */
+    void prepareForSharing();
+
     //@}
 
     // -----------------------------------------------------------------------
@@ -523,6 +530,7 @@ protected:
     //  Protected Helper methods
     // -----------------------------------------------------------------------
     void prepare();
+    void prepareForSharing(Token* const token);
     int parseOptions(const XMLCh* const options);
 
     /**
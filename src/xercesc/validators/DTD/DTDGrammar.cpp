@@ -170,6 +170,18 @@ XMLElementDecl* DTDGrammar::putElemDecl (const   unsigned int    uriId
     return retVal;
 }
 
+void DTDGrammar::prepareForSharing()
+{
+    NameIdPoolEnumerator<DTDElementDecl> elemEnum = getElemEnumerator();
+    while (elemEnum.hasMoreElements())
+    {
+        DTDElementDecl& elemDecl = elemEnum.nextElement();
+        elemDecl.getContentModel();
+        elemDecl.getFormattedContentModel();
+        elemDecl.getAttDefList();
+    }
+}
+
 void DTDGrammar::reset()
 {
     //
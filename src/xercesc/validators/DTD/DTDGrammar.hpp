@@ -141,6 +141,8 @@ public:
 
     virtual void reset();
 
+    virtual void prepareForSharing();
+
     // -----------------------------------------------------------------------
     //  Getter methods
     // -----------------------------------------------------------------------
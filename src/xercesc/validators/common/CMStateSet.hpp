@@ -226,13 +226,7 @@ public :
 #endif
                         {
                             for(XMLSize_t subIndex = 0; subIndex < CMSTATE_BITFIELD_INT32_SIZE; subIndex++)
-                                if(setToOr.fDynamicBuffer->fBitArray[index][subIndex])
-                                {
-                                    if(fDynamicBuffer->fBitArray[index][subIndex])
-                                        fDynamicBuffer->fBitArray[index][subIndex] |= setToOr.fDynamicBuffer->fBitArray[index][subIndex];
-                                    else
-                                        fDynamicBuffer->fBitArray[index][subIndex] = setToOr.fDynamicBuffer->fBitArray[index][subIndex];
-                                }
+                                mine[subIndex] |= other[subIndex];
                         }
                     }
                 }
@@ -247,6 +241,14 @@ public :
 
         if(fDynamicBuffer==0)
         {
+#ifdef XERCES_HAVE_SSE2_INTRINSIC
+            if(XMLPlatformUtils::fgSSE2ok)
+            {
+                __m128i xmm1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(fBits));
+                __m128i xmm2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(setToCompare.fBits));
+                return _mm_movemask_epi8(_mm_cmpeq_epi32(xmm1, xmm2)) == 0xFFFF;
+            }
+#endif
             for (XMLSize_t index = 0; index < CMSTATE_CACHED_INT32_SIZE; index++)
             {
                 if (fBits[index] != setToCompare.fBits[index])
@@ -257,17 +259,38 @@ public :
         {
             for (XMLSize_t index = 0; index < fDynamicBuffer->fArraySize; index++)
             {
-                XMLInt32 *& other = setToCompare.fDynamicBuffer->fBitArray[index],
-                         *& mine = fDynamicBuffer->fBitArray[index];
+                const XMLInt32* other = setToCompare.fDynamicBuffer->fBitArray[index];
+                const XMLInt32* mine = fDynamicBuffer->fBitArray[index];
                 if(mine==NULL && other==NULL)
                     continue;
-                else if(mine==NULL || other==NULL) // the other should have been empty too
-                    return false;
+                // a chunk which was cleared compares equal to a missing one
+                else if(mine==NULL)
+                {
+                    if(!isZeroChunk(other))
+                        return false;
+                }
+                else if(other==NULL)
+                {
+                    if(!isZeroChunk(mine))
+                        return false;
+                }
                 else
                 {
-                    for(XMLSize_t subIndex = 0; subIndex < CMSTATE_BITFIELD_INT32_SIZE; subIndex++)
-                        if(mine[subIndex]!=other[subIndex])
-                            return false;
+#ifdef XERCES_HAVE_SSE2_INTRINSIC
+                    if(XMLPlatformUtils::fgSSE2ok)
+                    {
+                        for(XMLSize_t subIndex = 0; subIndex < CMSTATE_BITFIELD_INT32_SIZE; subIndex+=4)
+                        {
+                            __m128i xmm1 = _mm_load_si128(reinterpret_cast<const __m128i*>(&mine[subIndex]));
+                            __m128i xmm2 = _mm_load_si128(reinterpret_cast<const __m128i*>(&other[subIndex]));
+                            if(_mm_movemask_epi8(_mm_cmpeq_epi32(xmm1, xmm2)) != 0xFFFF)
+                                return false;
+                        }
+                    }
+                    else
+#endif
+                    if(memcmp(mine, other, CMSTATE_BITFIELD_INT32_SIZE * sizeof(XMLInt32))!=0)
+                        return false;
                 }
             }
         }
@@ -315,43 +338,27 @@ public :
         return *this;
     }
 
+    // Counts the bits set in the 32 bit words holding the bits from start
+    // to end, so the count may include a few bits around the range
     XMLSize_t getBitCountInRange(XMLSize_t start, XMLSize_t end) const
     {
         XMLSize_t count = 0;
-        end /= 32;
+        if (fBitCount == 0)
+            return count;
+        if (end >= fBitCount)
+            end = fBitCount - 1;
         if(fDynamicBuffer==0)
         {
-            if(end > CMSTATE_CACHED_INT32_SIZE)
-                end = CMSTATE_CACHED_INT32_SIZE;
-            for (XMLSize_t index = start / 32; index < end; index++)
-            {
-                if (fBits[index] != 0)
-                    for(int i=0;i<32;i++)
-                    {
-                        const XMLInt32 mask = 1UL << i;
-                        if(fBits[index] & mask)
-                            count++;
-                    }
-            }
+            for (XMLSize_t index = start / 32; index <= end / 32; index++)
+                count += countBits(fBits[index]);
         }
         else
         {
-            if(end > fDynamicBuffer->fArraySize)
-                end = fDynamicBuffer->fArraySize;
-            for (XMLSize_t index = start / 32; index < end; index++)
+            for (XMLSize_t index = start / 32; index <= end / 32; index++)
             {
-                if(fDynamicBuffer->fBitArray[index]==NULL)
-                    continue;
-                for(XMLSize_t subIndex=0;subIndex < CMSTATE_BITFIELD_INT32_SIZE; subIndex++)
-                {
-                    if (fDynamicBuffer->fBitArray[index][subIndex] != 0)
-                        for(int i=0;i<32;i++)
-                        {
-                            const XMLInt32 mask = 1UL << i;
-                            if(fDynamicBuffer->fBitArray[index][subIndex] & mask)
-                                count++;
-                        }
-                }
+                const XMLInt32* chunk = fDynamicBuffer->fBitArray[index / CMSTATE_BITFIELD_INT32_SIZE];
+                if(chunk!=NULL)
+                    count += countBits(chunk[index % CMSTATE_BITFIELD_INT32_SIZE]);
             }
         }
         return count;
@@ -399,13 +406,8 @@ public :
         {
             for (XMLSize_t index = 0; index < fDynamicBuffer->fArraySize; index++)
             {
-                if(fDynamicBuffer->fBitArray[index]==NULL)
-                    continue;
-                for(XMLSize_t subIndex=0;subIndex < CMSTATE_BITFIELD_INT32_SIZE; subIndex++)
-                {
-                    if (fDynamicBuffer->fBitArray[index][subIndex] != 0)
-                        return false;
-                }
+                if(fDynamicBuffer->fBitArray[index]!=NULL && !isZeroChunk(fDynamicBuffer->fBitArray[index]))
+                    return false;
             }
         }
         return true;
@@ -454,10 +456,11 @@ public :
         }
         else
         {
+            // keep the chunks, as a set which is cleared is usually filled
+            // again right away
             for (XMLSize_t index = 0; index < fDynamicBuffer->fArraySize; index++)
-                // delete this subentry
                 if(fDynamicBuffer->fBitArray[index]!=NULL)
-                    deallocateChunk(index);
+                    memset(fDynamicBuffer->fBitArray[index], 0, CMSTATE_BITFIELD_INT32_SIZE * sizeof(XMLInt32));
         }
     }
 
@@ -471,15 +474,27 @@ public :
         }
         else
         {
+            // only the words which have bits set count, along with their
+            // position, so missing and cleared chunks hash the same
             for (XMLSize_t index = 0; index<fDynamicBuffer->fArraySize; index++)
             {
-                if(fDynamicBuffer->fBitArray[index]==NULL)
-                    // simulates the iteration on the missing bits
-                    for(XMLSize_t subIndex=0;subIndex < CMSTATE_BITFIELD_INT32_SIZE; subIndex++)
-                        hash *= 31;
-                else
-                    for(XMLSize_t subIndex=0;subIndex < CMSTATE_BITFIELD_INT32_SIZE; subIndex++)
-                        hash = fDynamicBuffer->fBitArray[index][subIndex] + hash * 31;
+                const XMLInt32* chunk = fDynamicBuffer->fBitArray[index];
+                if(chunk==NULL)
+                    continue;
+                for(XMLSize_t subIndex=0;subIndex < CMSTATE_BITFIELD_INT32_SIZE; subIndex+=4)
+                {
+#ifdef XERCES_HAVE_SSE2_INTRINSIC
+                    if(XMLPlatformUtils::fgSSE2ok)
+                    {
+                        __m128i xmm1 = _mm_load_si128(reinterpret_cast<const __m128i*>(&chunk[subIndex]));
+                        if(_mm_movemask_epi8(_mm_cmpeq_epi32(xmm1, _mm_setzero_si128())) == 0xFFFF)
+                            continue;
+                    }
+#endif
+                    for(XMLSize_t word = subIndex; word < subIndex + 4; word++)
+                        if(chunk[word]!=0)
+                            hash = chunk[word] + (hash * 31 + index * CMSTATE_BITFIELD_INT32_SIZE + word) * 31;
+                }
             }
         }
         return hash;
@@ -494,6 +509,31 @@ private :
     // -----------------------------------------------------------------------
     // Helpers
     // -----------------------------------------------------------------------
+    static bool isZeroChunk(const XMLInt32* chunk)
+    {
+#ifdef XERCES_HAVE_SSE2_INTRINSIC
+        if(XMLPlatformUtils::fgSSE2ok)
+        {
+            __m128i xmm1 = _mm_setzero_si128();
+            for(XMLSize_t subIndex = 0; subIndex < CMSTATE_BITFIELD_INT32_SIZE; subIndex+=4)
+                xmm1 = _mm_or_si128(xmm1, _mm_load_si128(reinterpret_cast<const __m128i*>(&chunk[subIndex])));
+            return _mm_movemask_epi8(_mm_cmpeq_epi32(xmm1, _mm_setzero_si128())) == 0xFFFF;
+        }
+#endif
+        for(XMLSize_t subIndex = 0; subIndex < CMSTATE_BITFIELD_INT32_SIZE; subIndex++)
+            if(chunk[subIndex]!=0)
+                return false;
+        return true;
+    }
+
+    static XMLSize_t countBits(XMLInt32 word)
+    {
+        XMLUInt32 bits = (XMLUInt32) word;
+        bits = bits - ((bits >> 1) & 0x55555555);
+        bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+        return (((bits + (bits >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+    }
+
     void allocateChunk(const XMLSize_t index)
     {
 #ifdef XERCES_HAVE_SSE2_INTRINSIC
@@ -555,12 +595,11 @@ public:
         // if we found data, and fIndexCount is still pointing to the area where 'start' is located, erase the bits before 'start'
         if(hasMoreElements() && fIndexCount < start)
         {
-            for(XMLSize_t i=0;i< (start - fIndexCount);i++)
-            {
-                XMLInt32 mask=1UL << i;
-                if(fLastValue & mask)
-                    fLastValue &= ~mask;
-            }
+            const XMLSize_t skip = start - fIndexCount;
+            if(skip >= 32)
+                fLastValue = 0;
+            else
+                fLastValue &= (XMLInt32) ~((((XMLUInt32) 1) << skip) - 1);
             // in case the 32 bit area contained only bits before 'start', advance
             if(fLastValue==0)
                 findNext();
@@ -574,19 +613,17 @@ public:
 
     unsigned int nextElement()
     {
-        for(int i=0;i<32;i++)
-        {
-            XMLInt32 mask=1UL << i;
-            if(fLastValue & mask)
-            {
-                fLastValue &= ~mask;
-                unsigned int retVal=(unsigned int)fIndexCount+i;
-                if(fLastValue==0)
-                    findNext();
-                return retVal;
-            }
-        }
-        return 0;
+        if(fLastValue==0)
+            return 0;
+
+        // take the lowest bit set, whose index is the number of bits below it
+        const XMLUInt32 value = (XMLUInt32) fLastValue;
+        const XMLUInt32 lowest = value & (0 - value);
+        fLastValue = (XMLInt32) (value & ~lowest);
+        unsigned int retVal=(unsigned int)(fIndexCount + CMStateSet::countBits((XMLInt32) (lowest - 1)));
+        if(fLastValue==0)
+            findNext();
+        return retVal;
     }
 
 private:
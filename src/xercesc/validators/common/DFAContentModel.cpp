@@ -38,6 +38,7 @@
 #include <xercesc/validators/schema/SchemaSymbols.hpp>
 #include <xercesc/validators/schema/SubstitutionGroupComparator.hpp>
 #include <xercesc/validators/schema/XercesElementWildcard.hpp>
+#include <xercesc/util/Janitor.hpp>
 #include <xercesc/util/OutOfMemoryException.hpp>
 #include <xercesc/util/RefHashTableOf.hpp>
 #include <xercesc/util/XMLInteger.hpp>
@@ -82,6 +83,10 @@ DFAContentModel::DFAContentModel( const bool             dtd
     , fLeafListType(0)
     , fTransTable(0)
     , fTransTableSize(0)
+    , fElemColumn(0)
+    , fColumnCount(0)
+    , fLeafHash(0)
+    , fLeafHashMask(0)
     , fCountingStates(0)
     , fDTD(dtd)
     , fIsMixed(false)
@@ -118,6 +123,10 @@ DFAContentModel::DFAContentModel( const bool             dtd
     , fLeafListType(0)
     , fTransTable(0)
     , fTransTableSize(0)
+    , fElemColumn(0)
+    , fColumnCount(0)
+    , fLeafHash(0)
+    , fLeafHashMask(0)
     , fCountingStates(0)
     , fDTD(dtd)
     , fIsMixed(isMixed)
@@ -156,12 +165,16 @@ void DFAContentModel::cleanup()
     unsigned int index;
     if( fTransTable )
     {
-        for (index = 0; index < fTransTableSize; index++)
-            fMemoryManager->deallocate(fTransTable[index]); //delete [] fTransTable[index];
         fMemoryManager->deallocate(fTransTable); //delete [] fTransTable;
         fTransTable = NULL;
     }
 
+    fMemoryManager->deallocate(fElemColumn); //delete [] fElemColumn;
+    fElemColumn = NULL;
+
+    fMemoryManager->deallocate(fLeafHash);
+    fLeafHash = NULL;
+
     if(fCountingStates)
     {
         for (unsigned int j = 0; j < fTransTableSize; ++j)
@@ -253,55 +266,63 @@ DFAContentModel::validateContent( QName** const        children
 
         // Look up this child in our element map
         unsigned int elemIndex = 0;
-        for (; elemIndex < fElemMapSize; elemIndex++)
+        if (fLeafHash)
         {
-            const QName* inElem  = fElemMap[elemIndex];
-            if (fDTD) {
-                if (XMLString::equals(inElem->getRawName(), curElemRawName)) {
-                    nextState = fTransTable[curState][elemIndex];
-                    if (nextState != XMLContentModel::gInvalidTrans)
-                        break;
-                }
-            }
-            else {
-                ContentSpecNode::NodeTypes type = fElemMapType[elemIndex];
-                if (type == ContentSpecNode::Leaf)
-                {
-                    if ((inElem->getURI() == curElem->getURI()) &&
-                    (XMLString::equals(inElem->getLocalPart(), curElem->getLocalPart()))) {
-                        nextState = fTransTable[curState][elemIndex];
+            // Only the entries with the child's name can match it
+            nextState = findLeafTransition(curElem, curState, elemIndex);
+        }
+        else
+        {
+            for (; elemIndex < fElemMapSize; elemIndex++)
+            {
+                const QName* inElem  = fElemMap[elemIndex];
+                if (fDTD) {
+                    if (XMLString::equals(inElem->getRawName(), curElemRawName)) {
+                        nextState = getTransition(curState, elemIndex);
                         if (nextState != XMLContentModel::gInvalidTrans)
                             break;
                     }
                 }
-                else if ((type & 0x0f)== ContentSpecNode::Any)
-                {
-                    nextState = fTransTable[curState][elemIndex];
-                    if (nextState != XMLContentModel::gInvalidTrans)
-                        break;
-                }
-                else if ((type & 0x0f) == ContentSpecNode::Any_NS)
-                {
-                    if (inElem->getURI() == curElem->getURI())
+                else {
+                    ContentSpecNode::NodeTypes type = fElemMapType[elemIndex];
+                    if (type == ContentSpecNode::Leaf)
                     {
-                        nextState = fTransTable[curState][elemIndex];
-                        if (nextState != XMLContentModel::gInvalidTrans)
-                            break;
+                        if ((inElem->getURI() == curElem->getURI()) &&
+                        (XMLString::equals(inElem->getLocalPart(), curElem->getLocalPart()))) {
+                            nextState = getTransition(curState, elemIndex);
+                            if (nextState != XMLContentModel::gInvalidTrans)
+                                break;
+                        }
                     }
-                }
-                else if ((type & 0x0f) == ContentSpecNode::Any_Other)
-                {
-                    // Here we assume that empty string has id 1.
-                    //
-                    unsigned int uriId = curElem->getURI();
-                    if (uriId != 1 && uriId != inElem->getURI()) {
-                        nextState = fTransTable[curState][elemIndex];
+                    else if ((type & 0x0f)== ContentSpecNode::Any)
+                    {
+                        nextState = getTransition(curState, elemIndex);
                         if (nextState != XMLContentModel::gInvalidTrans)
                             break;
                     }
+                    else if ((type & 0x0f) == ContentSpecNode::Any_NS)
+                    {
+                        if (inElem->getURI() == curElem->getURI())
+                        {
+                            nextState = getTransition(curState, elemIndex);
+                            if (nextState != XMLContentModel::gInvalidTrans)
+                                break;
+                        }
+                    }
+                    else if ((type & 0x0f) == ContentSpecNode::Any_Other)
+                    {
+                        // Here we assume that empty string has id 1.
+                        //
+                        unsigned int uriId = curElem->getURI();
+                        if (uriId != 1 && uriId != inElem->getURI()) {
+                            nextState = getTransition(curState, elemIndex);
+                            if (nextState != XMLContentModel::gInvalidTrans)
+                                break;
+                        }
+                    }
                 }
-            }
-        }//for elemIndex
+            }//for elemIndex
+        }
 
         // If "nextState" is -1, we found a match, but the transition is invalid
         if (nextState == XMLContentModel::gInvalidTrans)
@@ -403,7 +424,7 @@ bool DFAContentModel::validateContentSpecial(QName** const            children
             {
                 if (comparator.isEquivalentTo(curElem, inElem) )
                 {
-                    nextState = fTransTable[curState][elemIndex];
+                    nextState = getTransition(curState, elemIndex);
                     if (nextState != XMLContentModel::gInvalidTrans)
                         break;
                 }
@@ -411,7 +432,7 @@ bool DFAContentModel::validateContentSpecial(QName** const            children
             }
             else if ((type & 0x0f)== ContentSpecNode::Any)
             {
-                nextState = fTransTable[curState][elemIndex];
+                nextState = getTransition(curState, elemIndex);
                 if (nextState != XMLContentModel::gInvalidTrans)
                     break;
             }
@@ -419,7 +440,7 @@ bool DFAContentModel::validateContentSpecial(QName** const            children
             {
                 if (inElem->getURI() == curElem->getURI())
                 {
-                    nextState = fTransTable[curState][elemIndex];
+                    nextState = getTransition(curState, elemIndex);
                     if (nextState != XMLContentModel::gInvalidTrans)
                         break;
                 }
@@ -431,7 +452,7 @@ bool DFAContentModel::validateContentSpecial(QName** const            children
                 unsigned int uriId = curElem->getURI();
                 if (uriId != 1 && uriId != inElem->getURI())
                 {
-                    nextState = fTransTable[curState][elemIndex];
+                    nextState = getTransition(curState, elemIndex);
                     if (nextState != XMLContentModel::gInvalidTrans)
                         break;
                 }
@@ -541,14 +562,14 @@ bool DFAContentModel::handleRepetitions(const QName* const curElem,
                             if(comparator!=0) {
                                 if (comparator->isEquivalentTo(curElem, inElem) )
                                 {
-                                    tempNextState = fTransTable[curState][elemIndex];
+                                    tempNextState = getTransition(curState, elemIndex);
                                     if (tempNextState != XMLContentModel::gInvalidTrans)
                                         break;
                                 }
                             }
                             else if (fDTD) {
                                 if (XMLString::equals(inElem->getRawName(), curElem->getRawName())) {
-                                    tempNextState = fTransTable[curState][elemIndex];
+                                    tempNextState = getTransition(curState, elemIndex);
                                     if (tempNextState != XMLContentModel::gInvalidTrans)
                                         break;
                                 }
@@ -556,7 +577,7 @@ bool DFAContentModel::handleRepetitions(const QName* const curElem,
                             else {
                                 if ((inElem->getURI() == curElem->getURI()) &&
                                 (XMLString::equals(inElem->getLocalPart(), curElem->getLocalPart()))) {
-                                    tempNextState = fTransTable[curState][elemIndex];
+                                    tempNextState = getTransition(curState, elemIndex);
                                     if (tempNextState != XMLContentModel::gInvalidTrans)
                                         break;
                                 }
@@ -564,7 +585,7 @@ bool DFAContentModel::handleRepetitions(const QName* const curElem,
                         }
                         else if ((type & 0x0f)== ContentSpecNode::Any)
                         {
-                            tempNextState = fTransTable[curState][elemIndex];
+                            tempNextState = getTransition(curState, elemIndex);
                             if (tempNextState != XMLContentModel::gInvalidTrans)
                                 break;
                         }
@@ -572,7 +593,7 @@ bool DFAContentModel::handleRepetitions(const QName* const curElem,
                         {
                             if (inElem->getURI() == curElem->getURI())
                             {
-                                tempNextState = fTransTable[curState][elemIndex];
+                                tempNextState = getTransition(curState, elemIndex);
                                 if (tempNextState != XMLContentModel::gInvalidTrans)
                                     break;
                             }
@@ -584,7 +605,7 @@ bool DFAContentModel::handleRepetitions(const QName* const curElem,
                             unsigned int uriId = curElem->getURI();
                             if (uriId != 1 && uriId != inElem->getURI())
                             {
-                                tempNextState = fTransTable[curState][elemIndex];
+                                tempNextState = getTransition(curState, elemIndex);
                                 if (tempNextState != XMLContentModel::gInvalidTrans)
                                     break;
                             }
@@ -631,6 +652,196 @@ bool DFAContentModel::handleRepetitions(const QName* const curElem,
     return true;
 }
 
+bool DFAContentModel::validateNextChild(const QName* const            child,
+                                        unsigned int&                 state,
+                                        unsigned int&                 loop,
+                                        SubstitutionGroupComparator*  comparator) const
+{
+    // If this is text in a Schema mixed content model, skip it.
+    if (fIsMixed && (child->getURI() == XMLElementDecl::fgPCDataElemId))
+        return true;
+
+    if (state == XMLContentModel::gInvalidTrans)
+        return false;
+
+    //
+    //  Like validateContent() followed by validateContentSpecial(), look for
+    //  the child by name first and only go through the substitution groups
+    //  if that fails, since the comparator has to look up the grammars.
+    //
+    unsigned int elemIndex = 0;
+    unsigned int nextLoop = 0;
+    unsigned int nextState = findTransition(child, state, elemIndex, 0);
+    if (nextState == XMLContentModel::gInvalidTrans ||
+        !handleRepetitions(child, state, loop, nextState, nextLoop, elemIndex, 0))
+    {
+        if (!comparator)
+            return false;
+
+        nextState = findTransition(child, state, elemIndex, comparator);
+        if (nextState == XMLContentModel::gInvalidTrans ||
+            !handleRepetitions(child, state, loop, nextState, nextLoop, elemIndex, comparator))
+            return false;
+    }
+
+    state = nextState;
+    loop = nextLoop;
+    return true;
+}
+
+bool DFAContentModel::validateEndOfContent(unsigned int state,
+                                           unsigned int loop) const
+{
+    if (state == XMLContentModel::gInvalidTrans || !fFinalStateFlags[state])
+        return false;
+
+    // verify if we exited before the minOccurs was satisfied
+    if (fCountingStates != 0) {
+        Occurence* o = fCountingStates[state];
+        if (o != 0 && loop < (unsigned int)o->minOccurs)
+            return false;
+    }
+
+    return true;
+}
+
+unsigned int DFAContentModel::findTransition(const QName* const           curElem,
+                                             unsigned int                 curState,
+                                             unsigned int&                elemIndex,
+                                             SubstitutionGroupComparator* comparator) const
+{
+    if (fLeafHash && !comparator)
+        return findLeafTransition(curElem, curState, elemIndex);
+
+    for (elemIndex = 0; elemIndex < fElemMapSize; elemIndex++)
+    {
+        const QName* inElem  = fElemMap[elemIndex];
+        ContentSpecNode::NodeTypes type = fElemMapType[elemIndex];
+        bool matches = false;
+        if (type == ContentSpecNode::Leaf)
+        {
+            if (comparator)
+                matches = comparator->isEquivalentTo(curElem, inElem);
+            else if (fDTD)
+                matches = XMLString::equals(inElem->getRawName(), curElem->getRawName());
+            else
+                matches = (inElem->getURI() == curElem->getURI()) &&
+                          XMLString::equals(inElem->getLocalPart(), curElem->getLocalPart());
+        }
+        else if ((type & 0x0f) == ContentSpecNode::Any)
+        {
+            matches = true;
+        }
+        else if ((type & 0x0f) == ContentSpecNode::Any_NS)
+        {
+            matches = (inElem->getURI() == curElem->getURI());
+        }
+        else if ((type & 0x0f) == ContentSpecNode::Any_Other)
+        {
+            // Here we assume that empty string has id 1.
+            //
+            unsigned int uriId = curElem->getURI();
+            matches = (uriId != 1 && uriId != inElem->getURI());
+        }
+
+        if (matches)
+        {
+            unsigned int nextState = getTransition(curState, elemIndex);
+            if (nextState != XMLContentModel::gInvalidTrans)
+                return nextState;
+        }
+    }
+
+    return XMLContentModel::gInvalidTrans;
+}
+
+void DFAContentModel::buildLeafHash()
+{
+    // A handful of names is found as fast by comparing them all
+    if (fElemMapSize < 8)
+        return;
+
+    // Keep the table at most half full
+    XMLSize_t hashSize = 16;
+    while (hashSize < (XMLSize_t) fElemMapSize * 2)
+        hashSize *= 2;
+
+    fLeafHash = (unsigned int*) fMemoryManager->allocate(hashSize * sizeof(unsigned int));
+    memset(fLeafHash, 0, hashSize * sizeof(unsigned int));
+    fLeafHashMask = (unsigned int) (hashSize - 1);
+
+    for (unsigned int elemIndex = 0; elemIndex < fElemMapSize; elemIndex++)
+    {
+        const QName* inElem = fElemMap[elemIndex];
+        XMLSize_t slot = fDTD
+            ? hashLeafName(inElem->getRawName(), 0)
+            : hashLeafName(inElem->getLocalPart(), inElem->getURI());
+
+        while (fLeafHash[slot])
+            slot = (slot + 1) & fLeafHashMask;
+        fLeafHash[slot] = elemIndex + 1;
+    }
+}
+
+XMLSize_t DFAContentModel::hashLeafName(const XMLCh* const name,
+                                        const unsigned int uriId) const
+{
+    // The low bits of XMLString::hash() differ little between similar
+    // names, so spread them before taking the slot.
+    unsigned int hashVal = (unsigned int) XMLString::hash(name, 0xFFFFFFFF) + uriId;
+    hashVal *= 2654435761U;
+    return (hashVal ^ (hashVal >> 16)) & fLeafHashMask;
+}
+
+unsigned int DFAContentModel::findLeafTransition(const QName* const curElem,
+                                                 unsigned int       curState,
+                                                 unsigned int&      elemIndex) const
+{
+    //
+    //  Entries with the same name, which a model checked for unique particle
+    //  attribution can have, are probed in the order of fElemMap, so the
+    //  first one with a transition wins as it does in the linear search.
+    //
+    unsigned int nextState = XMLContentModel::gInvalidTrans;
+    elemIndex = fElemMapSize;
+    if (fDTD)
+    {
+        const XMLCh* curElemRawName = curElem->getRawName();
+        XMLSize_t slot = hashLeafName(curElemRawName, 0);
+        for (; fLeafHash[slot]; slot = (slot + 1) & fLeafHashMask)
+        {
+            const unsigned int inIndex = fLeafHash[slot] - 1;
+            if (XMLString::equals(fElemMap[inIndex]->getRawName(), curElemRawName))
+            {
+                elemIndex = inIndex;
+                nextState = getTransition(curState, inIndex);
+                if (nextState != XMLContentModel::gInvalidTrans)
+                    break;
+            }
+        }
+    }
+    else
+    {
+        const unsigned int uriId = curElem->getURI();
+        const XMLCh* localPart = curElem->getLocalPart();
+        XMLSize_t slot = hashLeafName(localPart, uriId);
+        for (; fLeafHash[slot]; slot = (slot + 1) & fLeafHashMask)
+        {
+            const unsigned int inIndex = fLeafHash[slot] - 1;
+            const QName* inElem = fElemMap[inIndex];
+            if (inElem->getURI() == uriId && XMLString::equals(inElem->getLocalPart(), localPart))
+            {
+                elemIndex = inIndex;
+                nextState = getTransition(curState, inIndex);
+                if (nextState != XMLContentModel::gInvalidTrans)
+                    break;
+            }
+        }
+    }
+
+    return nextState;
+}
+
 // ---------------------------------------------------------------------------
 //  DFAContentModel: Private helper methods
 // ---------------------------------------------------------------------------
@@ -851,6 +1062,9 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
     if (fLeafNameTypeVector) {
         fLeafNameTypeVector->setValues(fElemMap, fElemMapType, fElemMapSize);
     }
+    else {
+        buildLeafHash();
+    }
 
     /***
      * Optimization(Jan, 2001); We sort fLeafList according to
@@ -948,7 +1162,7 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
     (
         curArraySize * sizeof(bool)
     ); //new bool[curArraySize];
-    fTransTable = (unsigned int**) fMemoryManager->allocate
+    unsigned int** transTable = (unsigned int**) fMemoryManager->allocate
     (
         curArraySize * sizeof(unsigned int*)
     ); //new unsigned int*[curArraySize];
@@ -986,7 +1200,7 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
     //  Init the first transition table entry, and put the initial state
     //  into the states to do list, then bump the current state.
     //
-    fTransTable[curState] = makeDefStateList();
+    transTable[curState] = makeDefStateList();
     statesToDo[curState] = setT;
     curState++;
 
@@ -1011,6 +1225,7 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
     //  the states to do counter.
     //
     CMStateSet* newSet = 0;
+    bool newSetFilled = false;
     while (unmarkedState < curState)
     {
         //
@@ -1018,7 +1233,7 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
         //  And get the associated transition table entry.
         //
         setT = statesToDo[unmarkedState];
-        unsigned int* transEntry = fTransTable[unmarkedState];
+        unsigned int* transEntry = transTable[unmarkedState];
 
         // Mark this one final if it contains the EOC state
         fFinalStateFlags[unmarkedState] = setT->getBit(fEOCPos);
@@ -1039,7 +1254,8 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
             //  Build up a set of states which is the union of all of the
             //  follow sets of DFA positions that are in the current state. If
             //  we gave away the new set last time through then create a new
-            //  one. Otherwise, zero out the existing one.
+            //  one. Otherwise, zero out the existing one, unless nothing was
+            //  added to it last time through.
             //
             if (!newSet)
                 newSet = new (fMemoryManager) CMStateSet
@@ -1047,8 +1263,9 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
                     fLeafCount
                     , fMemoryManager
                 );
-            else
+            else if (newSetFilled)
                 newSet->zeroBits();
+            newSetFilled = false;
 
 #ifdef OBSOLETED
 // unoptimized code
@@ -1067,12 +1284,14 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
                     if (fDTD) {
                         if (XMLString::equals(leaf->getRawName(), element->getRawName())) {
                             *newSet |= *fFollowList[leafIndex];
+                            newSetFilled = true;
                         }
                     }
                     else {
                         if ((leaf->getURI() == element->getURI()) &&
                             (XMLString::equals(leaf->getLocalPart(), element->getLocalPart()))) {
                             *newSet |= *fFollowList[leafIndex];
+                            newSetFilled = true;
                         }
                     }
                 }
@@ -1094,6 +1313,7 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
                     //  transition to from the current state.
                     //
                     *newSet |= *fFollowList[leafIndex];
+                    newSetFilled = true;
                 }
                 leafIndex = leafSorter[sorterIndex++];
             } // while (leafIndex != -1)
@@ -1112,8 +1332,9 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
                 // sorted list of places (M times log(N) testing operations Ts)
                 // Assuming that the time to test a bit is roughly the same of the time needed to compute the average of two integers,
                 // plus a couple of comparisons and additions, we compare N agains M*log(N) to decide which algorithm should be faster given
-                // the two sets
-                if(fNumItems <= setT->getBitCountInRange(fLeafIndexes[1], fLeafIndexes[fNumItems])*log((float)fNumItems))
+                // the two sets. A single place is always tested directly.
+                if(fNumItems == 1 ||
+                   fNumItems <= setT->getBitCountInRange(fLeafIndexes[1], fLeafIndexes[fNumItems])*log((float)fNumItems))
                 {
                     for(unsigned int i=1; i<=fNumItems; ++i)
                         if(setT->getBit(fLeafIndexes[i]))
@@ -1124,6 +1345,7 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
                             //  transition to from the current state.
                             //
                             *newSet |= *fFollowList[ fLeafIndexes[i] ];
+                            newSetFilled = true;
                         }
                 }
                 else
@@ -1161,6 +1383,7 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
                                 //  transition to from the current state.
                                 //
                                 *newSet |= *fFollowList[bitIndex];
+                                newSetFilled = true;
                                 break;
                             }
                         }
@@ -1172,7 +1395,7 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
             //  If this new set is not empty, then see if its in the list
             //  of states to do. If not, then add it.
             //
-            if (!newSet->isEmpty())
+            if (newSetFilled && !newSet->isEmpty())
             {
                 //
                 //  Search the 'states to do' list to see if this new
@@ -1199,7 +1422,7 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
                     //  table.
                     //
                     statesToDo[curState] = newSet;
-                    fTransTable[curState] = makeDefStateList();
+                    transTable[curState] = makeDefStateList();
                     stateTable->put
                     (
                         newSet
@@ -1253,19 +1476,19 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
                     {
                         newToDo[expIndex] = statesToDo[expIndex];
                         newFinalFlags[expIndex] = fFinalStateFlags[expIndex];
-                        newTransTable[expIndex] = fTransTable[expIndex];
+                        newTransTable[expIndex] = transTable[expIndex];
                     }
 
                     // Clean up the old stuff
                     fMemoryManager->deallocate(statesToDo); //delete [] statesToDo;
                     fMemoryManager->deallocate(fFinalStateFlags); //delete [] fFinalStateFlags;
-                    fMemoryManager->deallocate(fTransTable); //delete [] fTransTable;
+                    fMemoryManager->deallocate(transTable); //delete [] transTable;
 
                     // Store the new array size and pointers
                     curArraySize = newSize;
                     statesToDo = newToDo;
                     fFinalStateFlags = newFinalFlags;
-                    fTransTable = newTransTable;
+                    transTable = newTransTable;
                 } //if (curState == curArraySize)
             } //if (!newSet->isEmpty())
         } // for elemIndex
@@ -1274,6 +1497,10 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
     // Store the current state count in the trans table size
     fTransTableSize = curState;
 
+    // Counting states are told apart by their loops back to themselves,
+    // which merging states could create or remove
+    const bool canMinimize = (elemOccurenceMap == 0);
+
     //
     // Fill in the occurence information for each looping state
     // if we're using counters.
@@ -1282,7 +1509,7 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
         fCountingStates = (Occurence**)fMemoryManager->allocate(fTransTableSize*sizeof(Occurence*));
         memset(fCountingStates, 0, fTransTableSize*sizeof(Occurence*));
         for (unsigned int i = 0; i < fTransTableSize; ++i) {
-            unsigned int * transitions = fTransTable[i];
+            unsigned int * transitions = transTable[i];
             for (unsigned int j = 0; j < fElemMapSize; ++j) {
                 if (i == transitions[j]) {
                     Occurence* old=elemOccurenceMap[j];
@@ -1303,6 +1530,12 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
     if (newSet)
         delete newSet;
 
+    //
+    //  Merge the equivalent states and the equivalent input symbols, and
+    //  store what is left of the transition table as a single block.
+    //
+    compactDFA(transTable, canMinimize);
+
     //
     //  Now we can clean up all of the temporary data that was needed during
     //  DFA build.
@@ -1337,6 +1570,227 @@ void DFAContentModel::buildDFA(ContentSpecNode* const curNode)
     fMemoryManager->deallocate(leafSorter);
 }
 
+void DFAContentModel::compactDFA(unsigned int** transTable, const bool minimize)
+{
+    const unsigned int stateCount = fTransTableSize;
+
+    //
+    //  stateMap gives the state of the compacted DFA each state of the built
+    //  one ends up as, and stateRep one of the built states behind each
+    //  state of the compacted DFA.
+    //
+    unsigned int* stateMap = (unsigned int*) fMemoryManager->allocate
+    (
+        stateCount * sizeof(unsigned int)
+    );
+    ArrayJanitor<unsigned int> janStateMap(stateMap, fMemoryManager);
+    unsigned int* stateRep = (unsigned int*) fMemoryManager->allocate
+    (
+        stateCount * sizeof(unsigned int)
+    );
+    ArrayJanitor<unsigned int> janStateRep(stateRep, fMemoryManager);
+
+    unsigned int index;
+    unsigned int elemIndex;
+    unsigned int classCount = stateCount;
+    for (index = 0; index < stateCount; index++)
+    {
+        stateMap[index] = index;
+        stateRep[index] = index;
+    }
+
+    //
+    //  Minimize the DFA by refining a partition of its states: they start
+    //  out split into the final and the other states, and each pass splits
+    //  the states of a class which go to different classes on some input,
+    //  until a pass splits nothing. The states of a class are found through
+    //  a hash table keyed by the class of the state and those of its
+    //  targets. Classes are numbered in the order of their first state, so
+    //  the start state remains state 0.
+    //
+    if (minimize && stateCount > 1)
+    {
+        unsigned int* newMap = (unsigned int*) fMemoryManager->allocate
+        (
+            stateCount * sizeof(unsigned int)
+        );
+        ArrayJanitor<unsigned int> janNewMap(newMap, fMemoryManager);
+
+        XMLSize_t bucketCount = 2;
+        while (bucketCount < 2 * (XMLSize_t) stateCount)
+            bucketCount <<= 1;
+        unsigned int* buckets = (unsigned int*) fMemoryManager->allocate
+        (
+            bucketCount * sizeof(unsigned int)
+        );
+        ArrayJanitor<unsigned int> janBuckets(buckets, fMemoryManager);
+
+        unsigned int finalClass = XMLContentModel::gInvalidTrans;
+        unsigned int otherClass = XMLContentModel::gInvalidTrans;
+        classCount = 0;
+        for (index = 0; index < stateCount; index++)
+        {
+            unsigned int& stateClass = fFinalStateFlags[index] ? finalClass : otherClass;
+            if (stateClass == XMLContentModel::gInvalidTrans)
+                stateClass = classCount++;
+            stateMap[index] = stateClass;
+        }
+
+        while (true)
+        {
+            for (XMLSize_t bucket = 0; bucket < bucketCount; bucket++)
+                buckets[bucket] = XMLContentModel::gInvalidTrans;
+
+            unsigned int newCount = 0;
+            for (index = 0; index < stateCount; index++)
+            {
+                const unsigned int* row = transTable[index];
+                XMLSize_t hashVal = stateMap[index];
+                for (elemIndex = 0; elemIndex < fElemMapSize; elemIndex++)
+                {
+                    const unsigned int target = row[elemIndex];
+                    hashVal = hashVal * 31 + (target == XMLContentModel::gInvalidTrans ? target : stateMap[target]);
+                }
+
+                XMLSize_t bucket = hashVal & (bucketCount - 1);
+                while (buckets[bucket] != XMLContentModel::gInvalidTrans)
+                {
+                    const unsigned int rep = stateRep[buckets[bucket]];
+                    if (stateMap[rep] == stateMap[index])
+                    {
+                        const unsigned int* repRow = transTable[rep];
+                        for (elemIndex = 0; elemIndex < fElemMapSize; elemIndex++)
+                        {
+                            const unsigned int target = row[elemIndex];
+                            const unsigned int repTarget = repRow[elemIndex];
+                            if (target != repTarget
+                            &&  (target == XMLContentModel::gInvalidTrans
+                              || repTarget == XMLContentModel::gInvalidTrans
+                              || stateMap[target] != stateMap[repTarget]))
+                                break;
+                        }
+                        if (elemIndex == fElemMapSize)
+                            break;
+                    }
+                    bucket = (bucket + 1) & (bucketCount - 1);
+                }
+
+                if (buckets[bucket] == XMLContentModel::gInvalidTrans)
+                {
+                    buckets[bucket] = newCount;
+                    stateRep[newCount++] = index;
+                }
+                newMap[index] = buckets[bucket];
+            }
+
+            memcpy(stateMap, newMap, stateCount * sizeof(unsigned int));
+
+            // Passes only ever split classes, so no new one means no change
+            if (newCount == classCount)
+                break;
+            classCount = newCount;
+        }
+
+        if (classCount < stateCount)
+        {
+            bool* newFinalFlags = (bool*) fMemoryManager->allocate
+            (
+                classCount * sizeof(bool)
+            );
+            for (index = 0; index < classCount; index++)
+                newFinalFlags[index] = fFinalStateFlags[stateRep[index]];
+            fMemoryManager->deallocate(fFinalStateFlags);
+            fFinalStateFlags = newFinalFlags;
+        }
+    }
+
+    //
+    //  Then the input symbols which lead to the same state from every state
+    //  share a column of the table, like all the elements of a choice whose
+    //  branches go on the same way, found through a hash table as well.
+    //
+    fElemColumn = (unsigned int*) fMemoryManager->allocate
+    (
+        fElemMapSize * sizeof(unsigned int)
+    );
+    unsigned int* columnRep = (unsigned int*) fMemoryManager->allocate
+    (
+        fElemMapSize * sizeof(unsigned int)
+    );
+    ArrayJanitor<unsigned int> janColumnRep(columnRep, fMemoryManager);
+
+    XMLSize_t bucketCount = 2;
+    while (bucketCount < 2 * (XMLSize_t) fElemMapSize)
+        bucketCount <<= 1;
+    unsigned int* buckets = (unsigned int*) fMemoryManager->allocate
+    (
+        bucketCount * sizeof(unsigned int)
+    );
+    ArrayJanitor<unsigned int> janBuckets(buckets, fMemoryManager);
+    for (XMLSize_t bucket = 0; bucket < bucketCount; bucket++)
+        buckets[bucket] = XMLContentModel::gInvalidTrans;
+
+    fColumnCount = 0;
+    for (elemIndex = 0; elemIndex < fElemMapSize; elemIndex++)
+    {
+        XMLSize_t hashVal = 0;
+        for (index = 0; index < classCount; index++)
+        {
+            const unsigned int target = transTable[stateRep[index]][elemIndex];
+            hashVal = hashVal * 31 + (target == XMLContentModel::gInvalidTrans ? target : stateMap[target]);
+        }
+
+        XMLSize_t bucket = hashVal & (bucketCount - 1);
+        while (buckets[bucket] != XMLContentModel::gInvalidTrans)
+        {
+            const unsigned int rep = columnRep[buckets[bucket]];
+            for (index = 0; index < classCount; index++)
+            {
+                const unsigned int target = transTable[stateRep[index]][elemIndex];
+                const unsigned int repTarget = transTable[stateRep[index]][rep];
+                if (target != repTarget
+                &&  (target == XMLContentModel::gInvalidTrans
+                  || repTarget == XMLContentModel::gInvalidTrans
+                  || stateMap[target] != stateMap[repTarget]))
+                    break;
+            }
+            if (index == classCount)
+                break;
+            bucket = (bucket + 1) & (bucketCount - 1);
+        }
+
+        if (buckets[bucket] == XMLContentModel::gInvalidTrans)
+        {
+            buckets[bucket] = fColumnCount;
+            columnRep[fColumnCount++] = elemIndex;
+        }
+        fElemColumn[elemIndex] = buckets[bucket];
+    }
+
+    //
+    //  And store the rows of the remaining states one after the other.
+    //
+    fTransTable = (unsigned int*) fMemoryManager->allocate
+    (
+        (XMLSize_t) classCount * fColumnCount * sizeof(unsigned int)
+    );
+    unsigned int* transEntry = fTransTable;
+    for (index = 0; index < classCount; index++)
+    {
+        const unsigned int* row = transTable[stateRep[index]];
+        for (unsigned int column = 0; column < fColumnCount; column++)
+        {
+            const unsigned int target = row[columnRep[column]];
+            *transEntry++ = (target == XMLContentModel::gInvalidTrans ? target : stateMap[target]);
+        }
+    }
+    fTransTableSize = classCount;
+
+    for (index = 0; index < stateCount; index++)
+        fMemoryManager->deallocate(transTable[index]);
+    fMemoryManager->deallocate(transTable);
+}
+
 unsigned int DFAContentModel::countLeafNodes(ContentSpecNode* const curNode)
 {
     unsigned int count = 0;
@@ -1723,6 +2177,13 @@ void DFAContentModel::checkUniqueParticleAttribution (SchemaGrammar*    const pG
         }
     }
 
+    // The leaves have their own names again, so index them by those
+    if (fLeafHash) {
+        fMemoryManager->deallocate(fLeafHash);
+        fLeafHash = 0;
+        buildLeafHash();
+    }
+
     // Unique Particle Attribution
     // Store the conflict results between any two elements in fElemMap
     // 0 - not yet tested, 1 - conflict, (-1) - no conflict
@@ -1769,10 +2230,10 @@ void DFAContentModel::checkUniqueParticleAttribution (SchemaGrammar*    const pG
     // for each state, check whether it has overlap transitions
     for (i = 0; i < fTransTableSize; i++) {
         for (j = 0; j < fElemMapSize; j++) {
-            if (fTransTable[i][j] == XMLContentModel::gInvalidTrans)
+            if (getTransition(i, j) == XMLContentModel::gInvalidTrans)
                 continue;
             for (k = j+1; k < fElemMapSize; k++) {
-                if (fTransTable[i][k] != XMLContentModel::gInvalidTrans &&
+                if (getTransition(i, k) != XMLContentModel::gInvalidTrans &&
                     conflictTable[j][k] == 0) {
 
                     // If this is text in a Schema mixed content model, skip it.
@@ -1793,7 +2254,7 @@ void DFAContentModel::checkUniqueParticleAttribution (SchemaGrammar*    const pG
                             // loops back to "i" then the two particles do not overlap if
                             // minOccurs == maxOccurs.
                             if (o != 0 &&
-                                ((fTransTable[i][j] == i) ^ (fTransTable[i][k] == i)) &&
+                                ((getTransition(i, j) == i) ^ (getTransition(i, k) == i)) &&
                                 o->minOccurs == o->maxOccurs) {
                                 conflictTable[j][k] = -1;
                                 continue;
@@ -116,6 +116,16 @@ public:
                                     XMLSize_t elementIndex,
                                     SubstitutionGroupComparator * comparator) const;
 
+    virtual bool supportsIncrementalValidation() const;
+
+    virtual bool validateNextChild(const QName* const             child,
+                                   unsigned int&                  state,
+                                   unsigned int&                  loop,
+                                   SubstitutionGroupComparator*   comparator) const;
+
+    virtual bool validateEndOfContent(unsigned int state,
+                                      unsigned int loop) const;
+
 private :
     // -----------------------------------------------------------------------
     //  Unimplemented constructors and operators
@@ -130,6 +140,17 @@ private :
     // -----------------------------------------------------------------------
     void cleanup();
     void buildDFA(ContentSpecNode* const curNode);
+    void compactDFA(unsigned int** transTable, const bool minimize);
+    unsigned int getTransition(unsigned int state, XMLSize_t elemIndex) const;
+    void buildLeafHash();
+    XMLSize_t hashLeafName(const XMLCh* const name, const unsigned int uriId) const;
+    unsigned int findLeafTransition(const QName* const curElem,
+                                    unsigned int curState,
+                                    unsigned int& elemIndex) const;
+    unsigned int findTransition(const QName* const curElem,
+                                unsigned int curState,
+                                unsigned int& elemIndex,
+                                SubstitutionGroupComparator* comparator) const;
     CMNode* buildSyntaxTree(ContentSpecNode* const curNode, unsigned int& curIndex);
     unsigned int* makeDefStateList() const;
     unsigned int countLeafNodes(ContentSpecNode* const curNode);
@@ -202,19 +223,36 @@ private :
     //  fTransTable
     //  fTransTableSize
     //      This is the transition table that is the main by product of all
-    //      of the effort here. It is an array of arrays of ints. The first
-    //      dimension is the number of states we end up with in the DFA. The
-    //      second dimensions is the number of unique elements in the content
-    //      model (fElemMapSize). Each entry in the second dimension indicates
-    //      the new state given that input for the first dimension's start
-    //      state.
+    //      of the effort here. It holds one row of fColumnCount ints per
+    //      state of the DFA, one after the other. Each entry of a row
+    //      indicates the new state given the input of that column in the
+    //      row's start state. The DFA is minimized, unless it has counting
+    //      states, so fTransTableSize is the smallest number of states which
+    //      accepts the content model.
     //
     //      The fElemMap array handles mapping from element indexes to
-    //      positions in the second dimension of the transition table.
+    //      input symbols, and fElemColumn from those to columns.
     //
     //      fTransTableSize is the number of valid entries in the transition
     //      table, and in the other related tables such as fFinalStateFlags.
     //
+    //  fElemColumn
+    //  fColumnCount
+    //      The column of the transition table of each entry of fElemMap, and
+    //      the number of columns. Elements which lead to the same state from
+    //      every state, like the alternatives of a large choice, share a
+    //      column.
+    //
+    //  fLeafHash
+    //  fLeafHashMask
+    //      When a large model has no wildcards, a child can only match the
+    //      entries of fElemMap with its name, so they are found through this
+    //      open addressed table instead of by trying every entry. It holds
+    //      the index in fElemMap plus one, or zero for a free slot, and is
+    //      null for the other models. It is built again once
+    //      checkUniqueParticleAttribution() gives the entries back their
+    //      real URIs.
+    //
     //  fCountingStates
     //      This is the table holding the minOccurs/maxOccurs for elements
     //      that can be repeated a finite number of times.
@@ -236,8 +274,12 @@ private :
     unsigned int                fLeafCount;
     CMLeaf**                    fLeafList;
     ContentSpecNode::NodeTypes* fLeafListType;
-    unsigned int**              fTransTable;
+    unsigned int*               fTransTable;
     unsigned int                fTransTableSize;
+    unsigned int*               fElemColumn;
+    unsigned int                fColumnCount;
+    unsigned int*               fLeafHash;
+    unsigned int                fLeafHashMask;
     Occurence**                 fCountingStates;
     bool                        fDTD;
     bool                        fIsMixed;
@@ -258,7 +300,20 @@ DFAContentModel::getNextState(unsigned int currentState,
         ThrowXMLwithMemMgr(ArrayIndexOutOfBoundsException, XMLExcepts::Array_BadIndex, fMemoryManager);
     }
 
-    return fTransTable[currentState][elementIndex];
+    return getTransition(currentState, elementIndex);
+}
+
+inline bool
+DFAContentModel::supportsIncrementalValidation() const {
+
+    return true;
+}
+
+inline unsigned int
+DFAContentModel::getTransition(unsigned int state,
+                               XMLSize_t    elemIndex) const {
+
+    return fTransTable[(XMLSize_t) state * fColumnCount + fElemColumn[elemIndex]];
 }
 
 inline
@@ -172,6 +172,11 @@ public:
     // -----------------------------------------------------------------------
     virtual void reset()=0;
 
+    // Builds what validation against the grammar otherwise builds on first
+    // use, such as content models, so that the grammar is not modified
+    // anymore once several threads validate against it
+    virtual void prepareForSharing() {};
+
     virtual void                    setGrammarDescription( XMLGrammarDescription*) = 0;
     virtual XMLGrammarDescription*  getGrammarDescription() const = 0;
 
@@ -191,6 +191,18 @@ void DatatypeValidator::setTypeName(const XMLCh* const typeName)
     }
 }
 
+// ---------------------------------------------------------------------------
+//  DatatypeValidator: Validation methods
+// ---------------------------------------------------------------------------
+void DatatypeValidator::prepareForSharing()
+{
+    for (DatatypeValidator* dv = this; dv; dv = dv->fBaseValidator)
+    {
+        if (dv->fRegex)
+            dv->fRegex->prepareForSharing();
+    }
+}
+
 // ---------------------------------------------------------------------------
 //  DatatypeValidator: CleanUp methods
 // ---------------------------------------------------------------------------
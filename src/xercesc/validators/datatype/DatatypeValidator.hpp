@@ -268,6 +268,16 @@ public:
 
     virtual bool isSubstitutableBy(const DatatypeValidator* const toCheck);
 
+    /**
+      * Builds what validation otherwise builds on first use, such as the
+      * character maps of the patterns, for this validator and the ones it
+      * is derived from, so that several threads can validate with it.
+      * The item type of a list is its base validator.
+      *
+      * To be redefined in UnionDatatypeValidator
+      */
+    virtual void prepareForSharing();
+
 	 //@}
 
     // -----------------------------------------------------------------------
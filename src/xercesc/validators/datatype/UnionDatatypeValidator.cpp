@@ -223,6 +223,18 @@ void UnionDatatypeValidator::init(DatatypeValidator*            const baseValida
 
 }
 
+void UnionDatatypeValidator::prepareForSharing()
+{
+    DatatypeValidator::prepareForSharing();
+
+    RefVectorOf<DatatypeValidator>* memberDTV = getMemberTypeValidators();
+    if (memberDTV)
+    {
+        for (XMLSize_t i = 0; i < memberDTV->size(); i++)
+            memberDTV->elementAt(i)->prepareForSharing();
+    }
+}
+
 //
 // 1) the bottom level UnionDTV would check against
 //        pattern and enumeration as well
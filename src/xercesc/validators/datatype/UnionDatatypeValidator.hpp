@@ -131,6 +131,8 @@ public:
 
     virtual bool isSubstitutableBy(const DatatypeValidator* const toCheck);
 
+    virtual void prepareForSharing();
+
     //@}
 
     // -----------------------------------------------------------------------
@@ -174,6 +174,45 @@ XMLElementDecl* SchemaGrammar::putElemDecl (const   unsigned int    uriId
     return retVal;
 }
 
+void SchemaGrammar::prepareForSharing()
+{
+    // Content models are built for the anonymous types of the elements as
+    // well as for the named types
+    RefHash3KeysIdPoolEnumerator<SchemaElementDecl> elemEnum = getElemEnumerator();
+    while (elemEnum.hasMoreElements())
+    {
+        SchemaElementDecl& elemDecl = elemEnum.nextElement();
+        elemDecl.getContentModel();
+        elemDecl.getFormattedContentModel();
+        if (elemDecl.getDatatypeValidator())
+            elemDecl.getDatatypeValidator()->prepareForSharing();
+    }
+
+    if (fComplexTypeRegistry)
+    {
+        RefHashTableOfEnumerator<ComplexTypeInfo> typeEnum(fComplexTypeRegistry, false, fMemoryManager);
+        while (typeEnum.hasMoreElements())
+        {
+            ComplexTypeInfo& typeInfo = typeEnum.nextElement();
+            typeInfo.getContentModel();
+            typeInfo.getFormattedContentModel();
+        }
+    }
+
+    DVHashTable* registries[] = {
+        fDatatypeRegistry.getUserDefinedRegistry(),
+        DatatypeValidatorFactory::getBuiltInRegistry()
+    };
+    for (XMLSize_t i = 0; i < sizeof(registries) / sizeof(registries[0]); i++)
+    {
+        if (!registries[i])
+            continue;
+        RefHashTableOfEnumerator<DatatypeValidator> dvEnum(registries[i], false, fMemoryManager);
+        while (dvEnum.hasMoreElements())
+            dvEnum.nextElement().prepareForSharing();
+    }
+}
+
 void SchemaGrammar::reset()
 {
     //
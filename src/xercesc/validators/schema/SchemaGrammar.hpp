@@ -157,6 +157,8 @@ public:
 
     virtual void reset();
 
+    virtual void prepareForSharing();
+
     // -----------------------------------------------------------------------
     //  Getter methods
     // -----------------------------------------------------------------------
@@ -67,6 +67,9 @@ SchemaValidator::SchemaValidator( XMLErrorReporter* const errReporter
     , fMostRecentAttrValidator(0)
     , fErrorOccurred(false)
     , fElemIsSpecified(false)
+    , fContentStateSet(false)
+    , fContentState(0)
+    , fContentLoop(0)
 {
     fTypeStack = new (fMemoryManager) ValueStackOf<ComplexTypeInfo*>(8, fMemoryManager);
 }
@@ -91,6 +94,10 @@ bool SchemaValidator::checkContent (XMLElementDecl* const elemDecl
     fErrorOccurred = false;
     fElemIsSpecified = false;
 
+    // The state only applies to this element
+    const bool contentStateSet = fContentStateSet;
+    fContentStateSet = false;
+
     //
     //  Look up the element id in our element decl pool. This will get us
     //  the element decl in our own way of looking at them.
@@ -143,6 +150,26 @@ bool SchemaValidator::checkContent (XMLElementDecl* const elemDecl
                     ? currType->getContentModel()
                     : ((SchemaElementDecl*)elemDecl)->getContentModel();
 
+            //
+            //  If the children were checked as they were seen, only see
+            //  whether the content may end here. A bad child has been
+            //  reported at its start tag, so don't fail the content again.
+            //
+            if (contentStateSet) {
+                if (fContentState == XMLContentModel::gInvalidTrans) {
+                    fErrorOccurred = true;
+                    return true;
+                }
+
+                if (!elemCM->validateEndOfContent(fContentState, fContentLoop)) {
+                    *indexFailingChild = childCount;
+                    fErrorOccurred = true;
+                    return false;
+                }
+
+                return true;
+            }
+
             // Ask it to validate and return its return
             unsigned int emptyNS = getScanner()->getEmptyNamespaceId();
             bool result = elemCM->validateContent(children, childCount, emptyNS, indexFailingChild, getScanner()->getMemoryManager());
@@ -347,6 +374,7 @@ void SchemaValidator::reset()
     fNilFound = false;
     fDatatypeBuffer.reset();
     fErrorOccurred = false;
+    fContentStateSet = false;
 }
 
 bool SchemaValidator::requiresNamespaces() const
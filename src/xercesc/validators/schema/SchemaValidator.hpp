@@ -126,6 +126,7 @@ public:
     void setExitOnFirstFatal(const bool newValue);
     void setDatatypeBuffer(const XMLCh* const value);
     void clearDatatypeBuffer();
+    void setContentState(const unsigned int state, const unsigned int loop);
 
     // -----------------------------------------------------------------------
     //  Getter methods
@@ -290,6 +291,14 @@ private:
     //
     //  fErrorOccurred
     //      whether an error occurred in the most recent operation
+    //
+    //  fContentStateSet
+    //  fContentState
+    //  fContentLoop
+    //      Set by the scanner before checkContent() when the children of
+    //      the element were checked against its content model as they were
+    //      seen. Only the final state of the model is then left to check;
+    //      an invalid child has already been reported.
     // -----------------------------------------------------------------------
     MemoryManager*                  fMemoryManager;
     SchemaGrammar*                  fSchemaGrammar;
@@ -308,6 +317,9 @@ private:
     DatatypeValidator *             fMostRecentAttrValidator;
     bool                            fErrorOccurred;
     bool                            fElemIsSpecified;
+    bool                            fContentStateSet;
+    unsigned int                    fContentState;
+    unsigned int                    fContentLoop;
 };
 
 
@@ -351,6 +363,14 @@ inline void SchemaValidator::clearDatatypeBuffer()
     fDatatypeBuffer.reset();
 }
 
+inline void SchemaValidator::setContentState(const unsigned int state,
+                                             const unsigned int loop)
+{
+    fContentStateSet = true;
+    fContentState = state;
+    fContentLoop = loop;
+}
+
 // ---------------------------------------------------------------------------
 //  SchemaValidator: Getter methods
 // ---------------------------------------------------------------------------
@@ -19,6 +19,10 @@
  * $Id$
  */
 
+#if HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
 // ---------------------------------------------------------------------------
 //  Includes
 // ---------------------------------------------------------------------------
@@ -60,6 +64,12 @@
 #include <xercesc/framework/MemBufInputSource.hpp>
 #include <xercesc/internal/XSAXMLScanner.hpp>
 
+#if XERCES_USE_MUTEXMGR_STD
+#	include <atomic>
+#	include <system_error>
+#	include <thread>
+#endif
+
 namespace XERCES_CPP_NAMESPACE {
 
 // ---------------------------------------------------------------------------
@@ -86,6 +96,207 @@ protected:
     SchemaInfo* fSchemaInfo;
 };
 
+// ---------------------------------------------------------------------------
+//  With parallel schema loading, the locations of the documents included,
+//  imported and redefined by a schema are resolved before it is traversed,
+//  breadth first, and each round of documents found is parsed on several
+//  threads, each document by a parser of its own. Only the documents found
+//  without the help of the entity handler are parsed that way. A parse
+//  which reports an error or a warning, or which needs an entity, is given
+//  up: the document is parsed again when it is traversed, so the errors are
+//  reported in order by the calling thread.
+// ---------------------------------------------------------------------------
+
+// the fewest threads parsing a round of documents, when there are as many
+static const XMLSize_t kMinPrefetchThreads = 4;
+
+// thrown by a parse which needs an entity
+class PrefetchAbort
+{
+};
+
+// a schema document parsed ahead of the traversal
+class PrefetchedSchema : public XMemory
+                       , public XMLErrorReporter
+                       , public XMLEntityHandler
+{
+public:
+    PrefetchedSchema(InputSource* const source,
+                     const bool isImport,
+                     const XMLCh* const targetNSURIString,
+                     const bool ignoreAnnotations,
+                     MemoryManager* const manager)
+    : fSource(source)
+    , fParser(0)
+    , fIsImport(isImport)
+    , fTargetNSURIString(targetNSURIString)
+    , fIgnoreAnnotations(ignoreAnnotations)
+    , fFailed(false)
+    , fParsed(false)
+    , fTaken(false)
+    , fMemoryManager(manager)
+    {
+    }
+
+    ~PrefetchedSchema()
+    {
+        delete fParser;
+    }
+
+    void parse()
+    {
+        // nothing may escape the thread, a failure only leaves the document
+        // to the traversal
+        const bool flag = fSource->getIssueFatalErrorIfNotFound();
+        try
+        {
+            fParser = new (fMemoryManager) XSDDOMParser(0, fMemoryManager, 0);
+            fParser->setValidationScheme(XercesDOMParser::Val_Never);
+            fParser->setDoNamespaces(true);
+            fParser->setIgnoreAnnotations(fIgnoreAnnotations);
+            fParser->setUserEntityHandler(this);
+            fParser->setUserErrorReporter(this);
+
+            fSource->setIssueFatalErrorIfNotFound(false);
+            fParser->parse(*fSource);
+
+            fParsed = !fFailed && fParser->getDocument()
+                && fParser->getDocument()->getDocumentElement();
+        }
+        catch(...)
+        {
+        }
+        fSource->setIssueFatalErrorIfNotFound(flag);
+    }
+
+    // XMLErrorReporter interface
+    virtual void error(const unsigned int, const XMLCh* const,
+                       const XMLErrorReporter::ErrTypes, const XMLCh* const,
+                       const XMLCh* const, const XMLCh* const,
+                       const XMLFileLoc, const XMLFileLoc)
+    {
+        fFailed = true;
+    }
+
+    virtual void resetErrors()
+    {
+    }
+
+    // XMLEntityHandler interface
+    virtual void endInputSource(const InputSource&)
+    {
+    }
+
+    virtual bool expandSystemId(const XMLCh* const, XMLBuffer&)
+    {
+        return false;
+    }
+
+    virtual void resetEntities()
+    {
+    }
+
+    virtual InputSource* resolveEntity(XMLResourceIdentifier* const)
+    {
+        // left to the entity handler of the traversal, on the calling thread
+        throw PrefetchAbort();
+    }
+
+    virtual void startInputSource(const InputSource&)
+    {
+    }
+
+    //  fSource
+    //      the input source of the location which found the document first,
+    //      owned by its PrefetchedLocation.
+    //
+    //  fIsImport, fTargetNSURIString
+    //      whether the document is imported, and the namespace it is
+    //      imported for, or the namespace of the including schema. The
+    //      document is only searched for locations if the traversal is
+    //      going to preprocess it with that namespace.
+    //
+    //  fIgnoreAnnotations
+    //      whether the text of the annotations is left out of the document.
+    //
+    //  fParsed
+    //      true if the document was parsed without any error or warning.
+    //
+    //  fTaken
+    //      true once the traversal uses the document, which happens only
+    //      once as it may change the root element of an included document.
+    InputSource*    fSource;
+    XSDDOMParser*   fParser;
+    bool            fIsImport;
+    const XMLCh*    fTargetNSURIString;
+    bool            fIgnoreAnnotations;
+    bool            fFailed;
+    bool            fParsed;
+    bool            fTaken;
+    MemoryManager*  fMemoryManager;
+
+private:
+    PrefetchedSchema(const PrefetchedSchema&);
+    PrefetchedSchema& operator=(const PrefetchedSchema&);
+};
+
+// the input source resolved ahead of the traversal for an include, import
+// or redefine, and the document it found
+class PrefetchedLocation : public XMemory
+{
+public:
+    PrefetchedLocation(InputSource* const source, PrefetchedSchema* const schema)
+    : fSource(source)
+    , fSchema(schema)
+    , fResolved(false)
+    {
+    }
+
+    ~PrefetchedLocation()
+    {
+        delete fSource;
+    }
+
+    InputSource*        fSource;
+    PrefetchedSchema*   fSchema;
+    bool                fResolved;
+
+private:
+    PrefetchedLocation(const PrefetchedLocation&);
+    PrefetchedLocation& operator=(const PrefetchedLocation&);
+};
+
+#if XERCES_USE_MUTEXMGR_STD
+// a thread parsing schema documents
+class PrefetchThread : public XMemory
+{
+public:
+    PrefetchThread()
+    {
+    }
+
+    ~PrefetchThread()
+    {
+        if (fThread.joinable())
+            fThread.join();
+    }
+
+    static void parseSchemas(RefVectorOf<PrefetchedSchema>* const schemas,
+                             std::atomic<XMLSize_t>* const next,
+                             const XMLSize_t end)
+    {
+        for (XMLSize_t i = (*next)++; i < end; i = (*next)++)
+            schemas->elementAt(i)->parse();
+    }
+
+    std::thread fThread;
+
+private:
+    PrefetchThread(const PrefetchThread&);
+    PrefetchThread& operator=(const PrefetchThread&);
+};
+#endif
+
 // ---------------------------------------------------------------------------
 //  TraverseSchema: Static member data
 // ---------------------------------------------------------------------------
@@ -206,6 +417,8 @@ TraverseSchema::TraverseSchema( DOMElement* const    schemaRoot
     , fSchemaInfoList(schemaInfoList)
     , fCachedSchemaInfoList (cachedSchemaInfoList)
     , fParser(0)
+    , fPrefetchedLocations(0)
+    , fPrefetchedSchemas(0)
     , fLocator(0)
     , fMemoryManager(manager)
     , fGrammarPoolMemoryManager(fGrammarResolver->getGrammarPoolMemoryManager())
@@ -232,6 +445,9 @@ TraverseSchema::TraverseSchema( DOMElement* const    schemaRoot
               fValidSubstitutionGroups = fSchemaGrammar->getValidSubstitutionGroups();
             }
 
+            if (fScanner->getParallelSchemaLoading())
+                prefetchSchemaDocuments(schemaRoot, schemaURL);
+
             preprocessSchema(schemaRoot, schemaURL, multipleImport);
             doTraverseSchema(schemaRoot);
 
@@ -604,10 +820,7 @@ void TraverseSchema::preprocessInclude(const DOMElement* const elem) {
     // ------------------------------------------------------------------
     // Resolve schema location
     // ------------------------------------------------------------------
-    fLocator->setValues(fSchemaInfo->getCurrentSchemaURL(), 0,
-                        ((XSDElementNSImpl*) elem)->getLineNo(),
-                        ((XSDElementNSImpl*) elem)->getColumnNo());
-    InputSource* srcToFill = resolveSchemaLocation(schemaLocation,
+    InputSource* srcToFill = resolveSchemaLocation(elem, schemaLocation,
             XMLResourceIdentifier::SchemaInclude);
     Janitor<InputSource> janSrc(srcToFill);
 
@@ -631,30 +844,11 @@ void TraverseSchema::preprocessInclude(const DOMElement* const elem) {
     // ------------------------------------------------------------------
     // Parse input source
     // ------------------------------------------------------------------
-    if (!fParser)
-        fParser = new (fGrammarPoolMemoryManager) XSDDOMParser(0, fGrammarPoolMemoryManager, 0);
-
-    fParser->setValidationScheme(XercesDOMParser::Val_Never);
-    fParser->setDoNamespaces(true);
-    fParser->setUserEntityHandler(fEntityHandler);
-    fParser->setUserErrorReporter(fErrorReporter);
-
-    // Should just issue warning if the schema is not found
-    bool flag = srcToFill->getIssueFatalErrorIfNotFound();
-    srcToFill->setIssueFatalErrorIfNotFound(false);
-
-    fParser->parse(*srcToFill);
-
-    // Reset the InputSource
-    srcToFill->setIssueFatalErrorIfNotFound(flag);
-
-    if (fParser->getSawFatal() && fScanner->getExitOnFirstFatal())
-        reportSchemaError(elem, XMLUni::fgXMLErrDomain, XMLErrs::SchemaScanFatalError);
+    DOMDocument* document = parseSchemaDocument(elem, srcToFill);
 
     // ------------------------------------------------------------------
     // Get root element
     // ------------------------------------------------------------------
-    DOMDocument* document = fParser->getDocument();
 
     if (document) {
 
@@ -807,10 +1001,7 @@ void TraverseSchema::preprocessImport(const DOMElement* const elem) {
     // ------------------------------------------------------------------
     // Resolve schema location
     // ------------------------------------------------------------------
-    fLocator->setValues(fSchemaInfo->getCurrentSchemaURL(), 0,
-                        ((XSDElementNSImpl*) elem)->getLineNo(),
-                        ((XSDElementNSImpl*) elem)->getColumnNo());
-    InputSource* srcToFill = resolveSchemaLocation(schemaLocation,
+    InputSource* srcToFill = resolveSchemaLocation(elem, schemaLocation,
             XMLResourceIdentifier::SchemaImport, nameSpace);
 
     // Nothing to do
@@ -845,30 +1036,11 @@ void TraverseSchema::preprocessImport(const DOMElement* const elem) {
     // ------------------------------------------------------------------
     // Parse input source
     // ------------------------------------------------------------------
-    if (!fParser)
-        fParser = new (fGrammarPoolMemoryManager) XSDDOMParser(0, fGrammarPoolMemoryManager, 0);
-
-    fParser->setValidationScheme(XercesDOMParser::Val_Never);
-    fParser->setDoNamespaces(true);
-    fParser->setUserEntityHandler(fEntityHandler);
-    fParser->setUserErrorReporter(fErrorReporter);
-
-    // Should just issue warning if the schema is not found
-    bool flag = srcToFill->getIssueFatalErrorIfNotFound();
-    srcToFill->setIssueFatalErrorIfNotFound(false);
-
-    fParser->parse(*srcToFill) ;
-
-    // Reset the InputSource
-    srcToFill->setIssueFatalErrorIfNotFound(flag);
-
-    if (fParser->getSawFatal() && fScanner->getExitOnFirstFatal())
-        reportSchemaError(elem, XMLUni::fgXMLErrDomain, XMLErrs::SchemaScanFatalError);
+    DOMDocument* document = parseSchemaDocument(elem, srcToFill);
 
     // ------------------------------------------------------------------
     // Get root element
     // ------------------------------------------------------------------
-    DOMDocument* document = fParser->getDocument();
 
     if (document) {
 
@@ -4953,6 +5125,186 @@ void TraverseSchema::preprocessChildren(const DOMElement* const root) {
     }
 }
 
+void TraverseSchema::prefetchSchemaDocuments(const DOMElement* const schemaRoot,
+                                             const XMLCh* const schemaURL) {
+
+#if XERCES_USE_MUTEXMGR_STD
+    if (!schemaURL)
+        return;
+
+    fPrefetchedLocations = new (fMemoryManager) RefHashTableOf<PrefetchedLocation, PtrHasher>(29, true, fMemoryManager);
+    fPrefetchedSchemas = new (fMemoryManager) RefVectorOf<PrefetchedSchema>(8, true, fMemoryManager);
+
+    // the documents found so far, and the namespaces imported so far
+    RefHashTableOf<PrefetchedSchema> bySystemId(29, false, fMemoryManager);
+    RefHashTableOf<PrefetchedSchema> byNamespace(29, false, fMemoryManager);
+    const XMLCh* targetNSURIString = schemaRoot->getAttribute(SchemaSymbols::fgATT_TARGETNAMESPACE);
+
+    bySystemId.put((void*) schemaURL, 0);
+    byNamespace.put((void*) targetNSURIString, 0);
+    prefetchLocations(schemaRoot, schemaURL, targetNSURIString, bySystemId, byNamespace);
+
+    // at least a few threads, as fetching a remote document mostly waits
+    XMLSize_t maxThreadCount = std::thread::hardware_concurrency();
+    if (maxThreadCount < kMinPrefetchThreads)
+        maxThreadCount = kMinPrefetchThreads;
+    XMLSize_t first = 0;
+
+    while (first < fPrefetchedSchemas->size()) {
+
+        // parse a round of documents, on this thread too
+        const XMLSize_t end = fPrefetchedSchemas->size();
+        std::atomic<XMLSize_t> next(first);
+
+        {
+            XMLSize_t threadCount = end - first;
+            if (threadCount > maxThreadCount)
+                threadCount = maxThreadCount;
+
+            RefVectorOf<PrefetchThread> threads(threadCount + 1, true, fMemoryManager);
+
+            for (XMLSize_t i = 1; i < threadCount; i++) {
+
+                PrefetchThread* thread = new (fMemoryManager) PrefetchThread();
+                threads.addElement(thread);
+
+                try {
+                    thread->fThread = std::thread(&PrefetchThread::parseSchemas, fPrefetchedSchemas, &next, end);
+                }
+                catch (const std::system_error&) {
+                    break;
+                }
+            }
+
+            PrefetchThread::parseSchemas(fPrefetchedSchemas, &next, end);
+        }
+
+        // the locations of the documents which the traversal preprocesses
+        // with the namespace they were found for
+        for (XMLSize_t i = first; i < end; i++) {
+
+            PrefetchedSchema* schema = fPrefetchedSchemas->elementAt(i);
+
+            if (!schema->fParsed)
+                continue;
+
+            DOMElement* root = schema->fParser->getDocument()->getDocumentElement();
+            const XMLCh* rootNSURIString = root->getAttribute(SchemaSymbols::fgATT_TARGETNAMESPACE);
+
+            if (XMLString::equals(rootNSURIString, schema->fTargetNSURIString)
+                || (!*rootNSURIString && !schema->fIsImport)) {
+                prefetchLocations(root, schema->fSource->getSystemId(),
+                                  schema->fTargetNSURIString, bySystemId, byNamespace);
+            }
+        }
+
+        first = end;
+    }
+#else
+    (void)schemaRoot;
+    (void)schemaURL;
+#endif
+}
+
+void TraverseSchema::prefetchLocations(const DOMElement* const root,
+                                       const XMLCh* const schemaURL,
+                                       const XMLCh* const targetNSURIString,
+                                       RefHashTableOf<PrefetchedSchema>& bySystemId,
+                                       RefHashTableOf<PrefetchedSchema>& byNamespace) {
+
+    // the same <redefine>, <include> and <import> info items as
+    // preprocessChildren(), but only the ones the traversal will resolve
+    DOMElement* child = XUtil::getFirstChildElement(root);
+
+    for (; child != 0; child = XUtil::getNextSiblingElement(child)) {
+
+        const XMLCh* name = child->getLocalName();
+        XMLResourceIdentifier::ResourceIdentifierType resourceType;
+        const XMLCh* nameSpace = 0;
+        const XMLCh* schemaNSURIString = targetNSURIString;
+        bool isImport = false;
+        bool toParse = true;
+
+        if (XMLString::equals(name, SchemaSymbols::fgELT_ANNOTATION)) {
+            continue;
+        }
+        else if (XMLString::equals(name, SchemaSymbols::fgELT_INCLUDE)) {
+            resourceType = XMLResourceIdentifier::SchemaInclude;
+        }
+        else if (XMLString::equals(name, SchemaSymbols::fgELT_REDEFINE)) {
+            resourceType = XMLResourceIdentifier::SchemaRedefine;
+        }
+        else if (XMLString::equals(name, SchemaSymbols::fgELT_IMPORT)) {
+
+            resourceType = XMLResourceIdentifier::SchemaImport;
+            isImport = true;
+            nameSpace = getElementAttValue(child, SchemaSymbols::fgATT_NAMESPACE, DatatypeValidator::AnyURI);
+            schemaNSURIString = nameSpace ? nameSpace : XMLUni::fgZeroLenString;
+
+            if (XMLString::equals(schemaNSURIString, targetNSURIString))
+                continue;
+
+            // a namespace is only loaded once, unless multiple imports are
+            // handled, but its location is still resolved
+            if (!fScanner->getHandleMultipleImports()) {
+
+                Grammar* aGrammar = fGrammarResolver->getGrammar(schemaNSURIString);
+
+                toParse = !byNamespace.containsKey(schemaNSURIString)
+                    && !(aGrammar && aGrammar->getGrammarType() == Grammar::SchemaGrammarType);
+            }
+        }
+        else
+            break;
+
+        const XMLCh* schemaLocation = getElementAttValue(child, SchemaSymbols::fgATT_SCHEMALOCATION, DatatypeValidator::AnyURI);
+
+        if (!schemaLocation || !*schemaLocation)
+            continue;
+
+        // a location the traversal fails to resolve is left to it, so that
+        // it fails in order
+        InputSource* srcToFill = 0;
+        bool byEntityHandler = false;
+
+        try {
+            fLocator->setValues(schemaURL, 0,
+                                ((XSDElementNSImpl*) child)->getLineNo(),
+                                ((XSDElementNSImpl*) child)->getColumnNo());
+            srcToFill = resolveSchemaLocation(schemaLocation, resourceType, nameSpace,
+                                              schemaURL, byEntityHandler);
+        }
+        catch(const OutOfMemoryException&) {
+            throw;
+        }
+        catch(...) {
+            continue;
+        }
+
+        PrefetchedSchema* schema = 0;
+
+        if (srcToFill && !byEntityHandler && srcToFill->getSystemId()) {
+
+            const XMLCh* systemId = srcToFill->getSystemId();
+
+            if (bySystemId.containsKey(systemId)) {
+                schema = bySystemId.get(systemId);
+            }
+            else if (toParse) {
+
+                schema = new (fGrammarPoolMemoryManager) PrefetchedSchema(srcToFill, isImport, schemaNSURIString, fScanner->getIgnoreAnnotations(), fGrammarPoolMemoryManager);
+                fPrefetchedSchemas->addElement(schema);
+                bySystemId.put((void*) systemId, schema);
+
+                if (isImport)
+                    byNamespace.put((void*) schemaNSURIString, schema);
+            }
+        }
+
+        fPrefetchedLocations->put(child, new (fMemoryManager) PrefetchedLocation(srcToFill, schema));
+    }
+}
+
 DOMElement* TraverseSchema::checkContent( const DOMElement* const rootElem
                                         , DOMElement* const contentElem
                                         , const bool isEmpty
@@ -6880,10 +7232,39 @@ void TraverseSchema::defaultComplexTypeInfo(ComplexTypeInfo* const typeInfo) {
 }
 
 
-InputSource* TraverseSchema::resolveSchemaLocation(const XMLCh* const loc,
+InputSource* TraverseSchema::resolveSchemaLocation(const DOMElement* const elem,
+                                const XMLCh* const loc,
                                 const XMLResourceIdentifier::ResourceIdentifierType resourceIdentitiferType,
                                 const XMLCh* const nameSpace) {
 
+    // the entity handler is called only once per location, so use the input
+    // source resolved ahead of the traversal if any
+    PrefetchedLocation* location = fPrefetchedLocations ? fPrefetchedLocations->get(elem) : 0;
+
+    if (location && !location->fResolved) {
+
+        InputSource* srcToFill = location->fSource;
+        location->fSource = 0;
+        location->fResolved = true;
+        return srcToFill;
+    }
+
+    fLocator->setValues(fSchemaInfo->getCurrentSchemaURL(), 0,
+                        ((XSDElementNSImpl*) elem)->getLineNo(),
+                        ((XSDElementNSImpl*) elem)->getColumnNo());
+
+    bool byEntityHandler;
+    return resolveSchemaLocation(loc, resourceIdentitiferType, nameSpace,
+                                 fSchemaInfo->getCurrentSchemaURL(), byEntityHandler);
+}
+
+
+InputSource* TraverseSchema::resolveSchemaLocation(const XMLCh* const loc,
+                                const XMLResourceIdentifier::ResourceIdentifierType resourceIdentitiferType,
+                                const XMLCh* const nameSpace,
+                                const XMLCh* const baseURI,
+                                bool& byEntityHandler) {
+
     // ------------------------------------------------------------------
     // Create an input source
     // ------------------------------------------------------------------
@@ -6896,10 +7277,12 @@ InputSource* TraverseSchema::resolveSchemaLocation(const XMLCh* const loc,
 
     if (fEntityHandler){
         XMLResourceIdentifier resourceIdentifier(resourceIdentitiferType,
-                            normalizedURI, nameSpace, 0, fSchemaInfo->getCurrentSchemaURL(), fLocator);
+                            normalizedURI, nameSpace, 0, baseURI, fLocator);
         srcToFill = fEntityHandler->resolveEntity(&resourceIdentifier);
     }
 
+    byEntityHandler = (srcToFill != 0);
+
     //  If they didn't create a source via the entity resolver, then we
     //  have to create one on our own if we have the schemaLocation (with
     //  the update resolveEntity accepting nameSpace, a schemImport could
@@ -6909,7 +7292,7 @@ InputSource* TraverseSchema::resolveSchemaLocation(const XMLCh* const loc,
             return 0;
 
         XMLURL urlTmp(fMemoryManager);
-        if ((!urlTmp.setURL(fSchemaInfo->getCurrentSchemaURL(), normalizedURI, urlTmp)) ||
+        if ((!urlTmp.setURL(baseURI, normalizedURI, urlTmp)) ||
             (urlTmp.isRelative()))
         {
            if (!fScanner->getStandardUriConformant())
@@ -6919,7 +7302,7 @@ InputSource* TraverseSchema::resolveSchemaLocation(const XMLCh* const loc,
                XMLUri::normalizeURI(tempURI, fBuffer);
 
                 srcToFill = new (fMemoryManager) LocalFileInputSource
-                (   fSchemaInfo->getCurrentSchemaURL()
+                (   baseURI
                     , fBuffer.getRawBuffer()
                     , fMemoryManager
                 );
@@ -6939,6 +7322,43 @@ InputSource* TraverseSchema::resolveSchemaLocation(const XMLCh* const loc,
 }
 
 
+DOMDocument* TraverseSchema::parseSchemaDocument(const DOMElement* const elem,
+                                                 InputSource* const srcToFill) {
+
+    PrefetchedLocation* location = fPrefetchedLocations ? fPrefetchedLocations->get(elem) : 0;
+
+    if (location && location->fSchema && location->fSchema->fParsed
+        && !location->fSchema->fTaken) {
+
+        location->fSchema->fTaken = true;
+        return location->fSchema->fParser->getDocument();
+    }
+
+    if (!fParser)
+        fParser = new (fGrammarPoolMemoryManager) XSDDOMParser(0, fGrammarPoolMemoryManager, 0);
+
+    fParser->setValidationScheme(XercesDOMParser::Val_Never);
+    fParser->setDoNamespaces(true);
+    fParser->setIgnoreAnnotations(fScanner->getIgnoreAnnotations());
+    fParser->setUserEntityHandler(fEntityHandler);
+    fParser->setUserErrorReporter(fErrorReporter);
+
+    // Should just issue warning if the schema is not found
+    bool flag = srcToFill->getIssueFatalErrorIfNotFound();
+    srcToFill->setIssueFatalErrorIfNotFound(false);
+
+    fParser->parse(*srcToFill);
+
+    // Reset the InputSource
+    srcToFill->setIssueFatalErrorIfNotFound(flag);
+
+    if (fParser->getSawFatal() && fScanner->getExitOnFirstFatal())
+        reportSchemaError(elem, XMLUni::fgXMLErrDomain, XMLErrs::SchemaScanFatalError);
+
+    return fParser->getDocument();
+}
+
+
 void TraverseSchema::restoreSchemaInfo(SchemaInfo* const toRestore,
                                        SchemaInfo::ListType const aListType,
                                        const unsigned int saveScope) {
@@ -8152,10 +8572,7 @@ bool TraverseSchema::openRedefinedSchema(const DOMElement* const redefineElem) {
     // ------------------------------------------------------------------
     // Resolve schema location
     // ------------------------------------------------------------------
-    fLocator->setValues(fSchemaInfo->getCurrentSchemaURL(), 0,
-                        ((XSDElementNSImpl*) redefineElem)->getLineNo(),
-                        ((XSDElementNSImpl*) redefineElem)->getColumnNo());
-    InputSource*         srcToFill = resolveSchemaLocation(schemaLocation,
+    InputSource*         srcToFill = resolveSchemaLocation(redefineElem, schemaLocation,
                                         XMLResourceIdentifier::SchemaRedefine);
     Janitor<InputSource> janSrc(srcToFill);
 
@@ -8184,30 +8601,11 @@ bool TraverseSchema::openRedefinedSchema(const DOMElement* const redefineElem) {
     // ------------------------------------------------------------------
     // Parse input source
     // ------------------------------------------------------------------
-    if (!fParser)
-        fParser = new (fGrammarPoolMemoryManager) XSDDOMParser(0,fGrammarPoolMemoryManager, 0);
-
-    fParser->setValidationScheme(XercesDOMParser::Val_Never);
-    fParser->setDoNamespaces(true);
-    fParser->setUserEntityHandler(fEntityHandler);
-    fParser->setUserErrorReporter(fErrorReporter);
-
-    // Should just issue warning if the schema is not found
-    bool flag = srcToFill->getIssueFatalErrorIfNotFound();
-    srcToFill->setIssueFatalErrorIfNotFound(false);
-
-    fParser->parse(*srcToFill) ;
-
-    // Reset the InputSource
-    srcToFill->setIssueFatalErrorIfNotFound(flag);
-
-    if (fParser->getSawFatal() && fScanner->getExitOnFirstFatal())
-        reportSchemaError(redefineElem, XMLUni::fgXMLErrDomain, XMLErrs::SchemaScanFatalError);
+    DOMDocument* document = parseSchemaDocument(redefineElem, srcToFill);
 
     // ------------------------------------------------------------------
     // Get root element
     // ------------------------------------------------------------------
-    DOMDocument* document = fParser->getDocument();
 
     if (!document) {
         return false;
@@ -8775,6 +9173,8 @@ void TraverseSchema::cleanUp() {
     delete fPreprocessedNodes;
     delete fLocator;
     delete fParser;
+    delete fPrefetchedLocations;
+    delete fPrefetchedSchemas;
 }
 
 void TraverseSchema::processElemDeclAttrs(const DOMElement* const elem,
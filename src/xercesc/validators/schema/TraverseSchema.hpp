@@ -38,6 +38,7 @@
 #include <xercesc/validators/schema/SchemaSymbols.hpp>
 #include <xercesc/util/ValueVectorOf.hpp>
 #include <xercesc/util/RefHash2KeysTableOf.hpp>
+#include <xercesc/util/RefVectorOf.hpp>
 #include <xercesc/validators/common/ContentSpecNode.hpp>
 #include <xercesc/validators/schema/SchemaGrammar.hpp>
 #include <xercesc/validators/schema/SchemaInfo.hpp>
@@ -67,6 +68,8 @@ class IdentityConstraint;
 class XSDLocator;
 class XSDDOMParser;
 class XMLErrorReporter;
+class PrefetchedSchema;
+class PrefetchedLocation;
 
 
 class VALIDATORS_EXPORT TraverseSchema : public XMemory
@@ -257,6 +260,19 @@ private:
     void processChildren(const DOMElement* const root);
     void preprocessChildren(const DOMElement* const root);
 
+    /**
+      * Resolve the locations of the documents included, imported and
+      * redefined by a schema, recursively, and parse the documents found
+      * on several threads, ahead of the traversal.
+      */
+    void prefetchSchemaDocuments(const DOMElement* const schemaRoot,
+                                 const XMLCh* const schemaURL);
+    void prefetchLocations(const DOMElement* const root,
+                           const XMLCh* const schemaURL,
+                           const XMLCh* const targetNSURIString,
+                           RefHashTableOf<PrefetchedSchema>& bySystemId,
+                           RefHashTableOf<PrefetchedSchema>& byNamespace);
+
     void preprocessImport(const DOMElement* const elemNode);
     void preprocessInclude(const DOMElement* const elemNode);
     void preprocessRedefine(const DOMElement* const elemNode);
@@ -507,16 +523,40 @@ private:
     void defaultComplexTypeInfo(ComplexTypeInfo* const typeInfo);
 
     /**
-      * Resolve a schema location attribute value to an input source.
-      * Caller to delete the returned object.
+      * Resolve the schema location attribute value of an include, import
+      * or redefine to an input source, unless it was resolved ahead of the
+      * traversal. Caller to delete the returned object.
       */
     InputSource* resolveSchemaLocation
     (
-        const XMLCh* const loc
+        const DOMElement* const elem
+        , const XMLCh* const loc
         , const XMLResourceIdentifier::ResourceIdentifierType resourceIdentitiferType
         , const XMLCh* const nameSpace=0
     );
 
+    /**
+      * Resolve a schema location attribute value, relative to baseURI, to
+      * an input source. byEntityHandler tells whether the input source was
+      * provided by the entity handler. Caller to delete the returned object.
+      */
+    InputSource* resolveSchemaLocation
+    (
+        const XMLCh* const loc
+        , const XMLResourceIdentifier::ResourceIdentifierType resourceIdentitiferType
+        , const XMLCh* const nameSpace
+        , const XMLCh* const baseURI
+        , bool& byEntityHandler
+    );
+
+    /**
+      * Parse the document of an include, import or redefine, unless it was
+      * parsed ahead of the traversal. The document is owned by a parser of
+      * this object.
+      */
+    DOMDocument* parseSchemaDocument(const DOMElement* const elem,
+                                     InputSource* const srcToFill);
+
     void restoreSchemaInfo(SchemaInfo* const toRestore,
                            SchemaInfo::ListType const aListType = SchemaInfo::INCLUDE,
                            const unsigned int saveScope = Grammar::TOP_LEVEL_SCOPE);
@@ -774,6 +814,8 @@ private:
     RefHash2KeysTableOf<SchemaInfo>*               fSchemaInfoList;
     RefHash2KeysTableOf<SchemaInfo>*               fCachedSchemaInfoList;
     XSDDOMParser*                                  fParser;
+    RefHashTableOf<PrefetchedLocation, PtrHasher>* fPrefetchedLocations;
+    RefVectorOf<PrefetchedSchema>*                 fPrefetchedSchemas;
     XSDErrorReporter                               fXSDErrorReporter;
     XSDLocator*                                    fLocator;
     MemoryManager*                                 fMemoryManager;
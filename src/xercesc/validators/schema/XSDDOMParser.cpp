@@ -84,6 +84,12 @@ void XSDDOMParser::startAnnotation( const XMLElementDecl&       elemDecl
                                   , const RefVectorOf<XMLAttr>& attrList
                                   , const XMLSize_t             attrCount)
 {
+    // when annotations are ignored, their text is never looked at, so it
+    // is not even kept: only the annotation elements and their attributes,
+    // which are still checked, make it into the document
+    if (fScanner->getIgnoreAnnotations())
+        return;
+
     fAnnotationBuf.append(chOpenAngle);
 	fAnnotationBuf.append(elemDecl.getFullName());
     fAnnotationBuf.append(chSpace);
@@ -149,6 +155,9 @@ void XSDDOMParser::startAnnotationElement( const XMLElementDecl&       elemDecl
                                          , const RefVectorOf<XMLAttr>& attrList
                                          , const XMLSize_t             attrCount)
 {
+    if (fScanner->getIgnoreAnnotations())
+        return;
+
     fAnnotationBuf.append(chOpenAngle);
     fAnnotationBuf.append(elemDecl.getFullName());
     //fAnnotationBuf.append(chSpace);
@@ -170,6 +179,9 @@ void XSDDOMParser::startAnnotationElement( const XMLElementDecl&       elemDecl
 void XSDDOMParser::endAnnotationElement( const XMLElementDecl& elemDecl
                                        , bool complete)
 {
+    if (fScanner->getIgnoreAnnotations())
+        return;
+
     if (complete)
     {
         fAnnotationBuf.append(chLF);
@@ -431,6 +443,10 @@ void XSDDOMParser::docCharacters(  const   XMLCh* const    chars
     }
     // when it's within either of the 2 annotation subelements, characters are
     // allowed and we need to store them.
+    else if (fScanner->getIgnoreAnnotations())
+    {
+        return;
+    }
     else if (cdataSection == true)
     {
         fAnnotationBuf.append(XMLUni::fgCDataStart);
@@ -462,7 +478,7 @@ void XSDDOMParser::docCharacters(  const   XMLCh* const    chars
 
 void XSDDOMParser::docComment(const XMLCh* const comment)
 {
-    if (fAnnotationDepth > -1)
+    if (fAnnotationDepth > -1 && !fScanner->getIgnoreAnnotations())
     {
         fAnnotationBuf.append(XMLUni::fgCommentString);
         fAnnotationBuf.append(comment);
@@ -488,7 +504,7 @@ void XSDDOMParser::ignorableWhitespace( const XMLCh* const chars
     if (!fWithinElement || !fIncludeIgnorableWhitespace)
         return;
 
-    if (fAnnotationDepth > -1)
+    if (fAnnotationDepth > -1 && !fScanner->getIgnoreAnnotations())
         fAnnotationBuf.append(chars, length);
 }
 
@@ -28,6 +28,7 @@
  */
 
 #include <cstdio>
+#include <clocale>
 #include "DTest.h"
 #include <xercesc/util/PlatformUtils.hpp>
 #include <xercesc/util/XMLException.hpp>
@@ -36,11 +37,24 @@
 #include <xercesc/util/regx/Match.hpp>
 #include <xercesc/util/TransService.hpp>
 #include <xercesc/util/OutOfMemoryException.hpp>
+#include <xercesc/util/Janitor.hpp>
+#include <xercesc/util/XMLChar.hpp>
+#include <xercesc/util/TranscodingException.hpp>
 #include <xercesc/parsers/XercesDOMParser.hpp>
 #include <xercesc/dom/DOMException.hpp>
 #include <xercesc/dom/DOMLSException.hpp>
 #include <xercesc/dom/DOMLSParserFilter.hpp>
+#include <xercesc/dom/DOMMemoryManager.hpp>
+#include <xercesc/dom/DOMSnapshot.hpp>
+#include <xercesc/dom/impl/DOMDocumentCursor.hpp>
 #include <xercesc/framework/MemBufInputSource.hpp>
+#include <xercesc/framework/MemBufFormatTarget.hpp>
+#include <xercesc/framework/XMLGrammarPoolImpl.hpp>
+#include <xercesc/internal/BinMemOutputStream.hpp>
+#include <xercesc/parsers/DOMLSParserImpl.hpp>
+#include <xercesc/parsers/SAX2XPathFilter.hpp>
+#include <xercesc/sax2/DefaultHandler.hpp>
+#include <xercesc/sax2/XMLReaderFactory.hpp>
 #include <xercesc/validators/common/CMStateSet.hpp>
 
 #define UNUSED(x) { if(x!=0){} }
@@ -975,13 +989,34 @@ int main(int /*argc*/, char ** /*argv*/)
 
 		OK &= test.testWholeText(parser);
         OK &= test.testScanner(parser);
+        OK &= test.testRecordHandler(parser);
+        OK &= test.testXPathFilter();
+        OK &= test.testSerializer(parser);
+        OK &= test.testParallelSerializer(parser);
+        OK &= test.testSnapshot(parser);
+
+        OK &= test.testDocumentCursor(parser);
+
+        OK &= test.testWhitespaceScheme(parser);
         delete parser;
 
         OK &= test.testLSExceptions();
 
+        OK &= test.testStartTagFilter();
+
         OK &= test.testElementTraversal();
 
         OK &= test.testUtilFunctions();
+
+        OK &= test.testMemoryUsage();
+
+        OK &= test.testDocumentRecycling();
+
+        OK &= test.testGrammarPoolSharing();
+
+        OK &= test.testFreeze();
+
+        OK &= test.testFormatter();
     }
 
     XMLPlatformUtils::Terminate();
@@ -2780,6 +2815,63 @@ bool DOMTest::testDOMerrors(DOMDocument* document) {
         OK = false; \
     }
 
+#define TEST_XPATH_NUMBER(xpath, expected, line)   \
+    try \
+    { \
+        XMLCh xpathStr[100]; \
+        XMLString::transcode(xpath,xpathStr,99); \
+        DOMXPathResult* result=(DOMXPathResult*)document->evaluate(xpathStr, document->getDocumentElement(), NULL, DOMXPathResult::NUMBER_TYPE, NULL); \
+        if(result->getNumberValue() != expected) {  \
+            fprintf(stderr, "DOMDocument::evaluate does not work in line %i (%g instead of %g)\n", line, \
+                    result->getNumberValue(), (double)expected); \
+            OK = false; \
+        }   \
+        result->release(); \
+    }   \
+    catch(DOMException&) \
+    {   \
+        fprintf(stderr, "DOMDocument::evaluate failed at line %i\n", line); \
+        OK = false; \
+    }
+
+#define TEST_XPATH_STRING(xpath, expected, line)   \
+    try \
+    { \
+        XMLCh xpathStr[100]; \
+        XMLString::transcode(xpath,xpathStr,99); \
+        XMLCh expectedStr[100]; \
+        XMLString::transcode(expected,expectedStr,99); \
+        DOMXPathResult* result=(DOMXPathResult*)document->evaluate(xpathStr, document->getDocumentElement(), NULL, DOMXPathResult::STRING_TYPE, NULL); \
+        if(!XMLString::equals(result->getStringValue(), expectedStr)) {  \
+            fprintf(stderr, "DOMDocument::evaluate does not work in line %i (wrong string value)\n", line); \
+            OK = false; \
+        }   \
+        result->release(); \
+    }   \
+    catch(DOMException&) \
+    {   \
+        fprintf(stderr, "DOMDocument::evaluate failed at line %i\n", line); \
+        OK = false; \
+    }
+
+#define TEST_XPATH_BOOLEAN(xpath, expected, line)   \
+    try \
+    { \
+        XMLCh xpathStr[100]; \
+        XMLString::transcode(xpath,xpathStr,99); \
+        DOMXPathResult* result=(DOMXPathResult*)document->evaluate(xpathStr, document->getDocumentElement(), NULL, DOMXPathResult::BOOLEAN_TYPE, NULL); \
+        if(result->getBooleanValue() != expected) {  \
+            fprintf(stderr, "DOMDocument::evaluate does not work in line %i (wrong boolean value)\n", line); \
+            OK = false; \
+        }   \
+        result->release(); \
+    }   \
+    catch(DOMException&) \
+    {   \
+        fprintf(stderr, "DOMDocument::evaluate failed at line %i\n", line); \
+        OK = false; \
+    }
+
 #include <xercesc/framework/StdOutFormatTarget.hpp>
 
 bool DOMTest::testXPath(DOMDocument* document) {
@@ -2804,12 +2896,124 @@ bool DOMTest::testXPath(DOMDocument* document) {
     TEST_VALID_XPATH("//dBodyLevel34", 1, __LINE__);
     TEST_VALID_XPATH("/*", 1, __LINE__);
     TEST_VALID_XPATH("/dFirstElement/dTestBody/dBodyLevel24", 1, __LINE__);
-    TEST_INVALID_XPATH("/dFirstElement//dBodyLevel34", __LINE__);  // the "//" can only be at the beginning
-    TEST_INVALID_XPATH("/dFirstElement/@dFirstElementdFirstElement", __LINE__);   // cannot select attributes
+    TEST_VALID_XPATH("/dFirstElement//dBodyLevel34", 1, __LINE__);
+    TEST_VALID_XPATH("/dFirstElement/@dFirstElementdFirstElement", 1, __LINE__);
     TEST_VALID_XPATH("//*", 10, __LINE__);
     TEST_VALID_XPATH_SINGLE("//*", __LINE__);
     TEST_INVALID_XPATH("//ns:node", __LINE__);  // "ns" prefix is undefined
 
+    // axes and predicates
+    TEST_VALID_XPATH("//dBodyLevel34/ancestor::*", 3, __LINE__);
+    TEST_VALID_XPATH("//dBodyLevel34/preceding::*", 4, __LINE__);
+    TEST_VALID_XPATH("//dBodyLevel34/following::*", 2, __LINE__);
+    TEST_VALID_XPATH("//dBodyLevel21/following-sibling::*", 3, __LINE__);
+    TEST_VALID_XPATH("//dBodyLevel24/preceding-sibling::*[1]/self::dBodyLevel23", 1, __LINE__);
+    TEST_VALID_XPATH("dTestBody/*[last()]/self::dBodyLevel24", 1, __LINE__);
+    TEST_VALID_XPATH("(//*)[position() > 8]", 2, __LINE__);
+    TEST_VALID_XPATH("//*[2]", 3, __LINE__);
+    TEST_VALID_XPATH("//*[@dFirstElementdFirstElement]", 1, __LINE__);
+    TEST_VALID_XPATH("//dBodyLevel31/text()", 1, __LINE__);    // adjacent text nodes form one text node
+    TEST_VALID_XPATH("//dBodyLevel34 | //*", 10, __LINE__);
+    TEST_VALID_XPATH("..", 1, __LINE__);
+
+    // expressions and the core function library
+    TEST_XPATH_NUMBER("count(//*)", 10, __LINE__);
+    TEST_XPATH_NUMBER("1 + 2 * 3 - 10 mod 3", 6, __LINE__);
+    TEST_XPATH_NUMBER("string-length('abc')", 3, __LINE__);
+    TEST_XPATH_NUMBER("round(-2.5) + floor(1.5) + ceiling(1.5)", 1, __LINE__);
+    TEST_XPATH_STRING("name(/*)", "dFirstElement", __LINE__);
+    TEST_XPATH_STRING("concat('a', \"b\", 'c')", "abc", __LINE__);
+    TEST_XPATH_STRING("substring('12345', 1.5, 2.6)", "234", __LINE__);
+    TEST_XPATH_STRING("substring-after('1999/04/01', '/')", "04/01", __LINE__);
+    TEST_XPATH_STRING("normalize-space('  a   b ')", "a b", __LINE__);
+    TEST_XPATH_STRING("translate('--aaa--', 'abc-', 'ABC')", "AAA", __LINE__);
+    TEST_XPATH_STRING("string(1 div 0)", "Infinity", __LINE__);
+    TEST_XPATH_STRING("string(-0.05)", "-0.05", __LINE__);
+    TEST_XPATH_BOOLEAN("count(//*) = 10 and not(//dNoSuchElement)", true, __LINE__);
+    TEST_XPATH_BOOLEAN("//* = 'no such value'", false, __LINE__);
+    TEST_XPATH_BOOLEAN("'2' > 1 or 0 div 0 = 0 div 0", true, __LINE__);
+
+    // number conversions use a period whatever the decimal point of the C
+    // locale is; the check only runs where a suitable locale is installed
+    {
+        static const char* const commaLocales[] = { "de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "fr_FR.utf8", "fr_FR", "German", 0 };
+        char savedLocale[256];
+        const char* current = setlocale(LC_NUMERIC, 0);
+        strncpy(savedLocale, current ? current : "C", sizeof(savedLocale) - 1);
+        savedLocale[sizeof(savedLocale) - 1] = 0;
+
+        bool haveLocale = false;
+        for (int i = 0; commaLocales[i] && !haveLocale; i++)
+            haveLocale = setlocale(LC_NUMERIC, commaLocales[i]) != 0 && *localeconv()->decimal_point == ',';
+        if (haveLocale)
+        {
+            TEST_XPATH_NUMBER("number('2.5') * 2", 5, __LINE__);
+            TEST_XPATH_NUMBER("1.25 + 1.25", 2.5, __LINE__);
+            TEST_XPATH_STRING("string(-0.05)", "-0.05", __LINE__);
+            TEST_XPATH_STRING("string(1 div 3)", "0.3333333333333333", __LINE__);
+            TEST_XPATH_BOOLEAN("number('1,5') != number('1,5')", true, __LINE__);
+        }
+        setlocale(LC_NUMERIC, savedLocale);
+    }
+
+    // syntax and type errors
+    TEST_INVALID_XPATH("//*[", __LINE__);
+    TEST_INVALID_XPATH("dNoSuchFunction()", __LINE__);
+    TEST_INVALID_XPATH("$variable", __LINE__);
+    TEST_INVALID_XPATH("count(//*)", __LINE__);   // not a node-set
+
+    try
+    {
+        XMLCh xpathStr[100];
+        XMLString::transcode("//*", xpathStr, 99);
+        DOMXPathResult* result=document->evaluate(xpathStr, document->getDocumentElement(), NULL, DOMXPathResult::ORDERED_NODE_ITERATOR_TYPE, NULL);
+        int count = 0;
+        while(result->iterateNext() && result->getNodeValue())
+            count++;
+        if(count != 10) {
+            fprintf(stderr, "DOMXPathResult::iterateNext does not work in line %i (%d nodes instead of 10)\n", __LINE__, count);
+            OK = false;
+        }
+        result->release();
+    }
+    catch(DOMException&)
+    {
+        fprintf(stderr, "DOMDocument::evaluate failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    {
+        // an iterator becomes invalid when the document changes
+        XMLCh xpathStr[100];
+        XMLString::transcode("//*", xpathStr, 99);
+        DOMXPathResult* result=document->evaluate(xpathStr, document->getDocumentElement(), NULL, DOMXPathResult::ORDERED_NODE_ITERATOR_TYPE, NULL);
+        result->iterateNext();
+        if(result->getInvalidIteratorState()) {
+            fprintf(stderr, "DOMXPathResult::getInvalidIteratorState does not work in line %i\n", __LINE__);
+            OK = false;
+        }
+        DOMNode* comment = document->getDocumentElement()->appendChild(document->createComment(xpathStr));
+        if(!result->getInvalidIteratorState()) {
+            fprintf(stderr, "DOMXPathResult::getInvalidIteratorState does not work in line %i\n", __LINE__);
+            OK = false;
+        }
+        try
+        {
+            result->iterateNext();
+            fprintf(stderr, "DOMXPathResult::iterateNext does not work in line %i (no exception)\n", __LINE__);
+            OK = false;
+        }
+        catch(DOMException& e)
+        {
+            if(e.code != DOMException::INVALID_STATE_ERR) {
+                fprintf(stderr, "DOMXPathResult::iterateNext does not work in line %i (wrong exception)\n", __LINE__);
+                OK = false;
+            }
+        }
+        document->getDocumentElement()->removeChild(comment)->release();
+        result->release();
+    }
+
     XMLCh tempStr[100];
     XMLString::transcode("xmlns:ns",tempStr,99);
     DOMAttr* attr=document->createAttributeNS(XMLUni::fgXMLNSURIName, tempStr);
@@ -2817,6 +3021,35 @@ bool DOMTest::testXPath(DOMDocument* document) {
     document->getDocumentElement()->setAttributeNodeNS(attr);
     const DOMXPathNSResolver* resolver=document->createNSResolver(document->getDocumentElement());
     TEST_VALID_XPATH_NS("//ns:node", resolver, 0, __LINE__);
+
+    // namespace nodes: xml and ns are in scope, each element gets its own
+    // nodes, and a union finds the same node twice
+    TEST_VALID_XPATH("namespace::*", 2, __LINE__);
+    TEST_VALID_XPATH("namespace::* | namespace::ns", 2, __LINE__);
+    TEST_VALID_XPATH("//namespace::ns", 10, __LINE__);
+    TEST_VALID_XPATH("namespace::ns/..", 1, __LINE__);
+    try
+    {
+        // A result reused with one of its own namespace nodes as the
+        // context node keeps that node alive.
+        XMLString::transcode("namespace::ns", tempStr, 99);
+        DOMXPathResult* result=document->evaluate(tempStr, document->getDocumentElement(), NULL, DOMXPathResult::FIRST_ORDERED_NODE_TYPE, NULL);
+        DOMNode* nsNode = result->getNodeValue();
+        XMLString::transcode("self::node()", tempStr, 99);
+        document->evaluate(tempStr, nsNode, NULL, DOMXPathResult::ORDERED_NODE_SNAPSHOT_TYPE, result);
+        XMLString::transcode("ns", tempStr, 99);
+        if(result->getSnapshotLength() != 1 || !result->snapshotItem(0) ||
+           result->getNodeValue() != nsNode || !XMLString::equals(result->getNodeValue()->getPrefix(), tempStr)) {
+            fprintf(stderr, "DOMXPathResult reuse does not work in line %i\n", __LINE__);
+            OK = false;
+        }
+        result->release();
+    }
+    catch(DOMException&)
+    {
+        fprintf(stderr, "DOMDocument::evaluate failed at line %i\n", __LINE__);
+        OK = false;
+    }
     document->getDocumentElement()->removeAttributeNode(attr);
 
     return OK;
@@ -3545,6 +3778,46 @@ bool DOMTest::testElement(DOMDocument* document)
     testElementNode->removeAttributeNode(idAtt);
     idAtt->release();
 
+    // Wide elements: past a small number of attributes the namespace lookups
+    // go through a hash index, make sure it stays in sync with the list.
+    {
+        XMLString::transcode("wide", tempStr, 3999);
+        DOMElement* wideEl = document->createElementNS(tempStr4, tempStr);
+        const int nAttrs = 200;
+        char buf[64];
+        int i;
+        for (i = 0; i < nAttrs; i++) {
+            sprintf(buf, "p%d:a%d", i % 3, i);
+            XMLString::transcode(buf, tempStr2, 3999);
+            sprintf(buf, "v%d", i);
+            XMLString::transcode(buf, tempStr3, 3999);
+            wideEl->setAttributeNS(tempStr4, tempStr2, tempStr3);
+        }
+        for (i = 0; i < nAttrs; i += 2) {
+            sprintf(buf, "a%d", i);
+            XMLString::transcode(buf, tempStr2, 3999);
+            wideEl->removeAttributeNS(tempStr4, tempStr2);
+        }
+        for (i = 0; i < nAttrs; i++) {
+            sprintf(buf, "a%d", i);
+            XMLString::transcode(buf, tempStr2, 3999);
+            sprintf(buf, "v%d", i);
+            XMLString::transcode(buf, tempStr3, 3999);
+            DOMAttr* wideAttr = wideEl->getAttributeNodeNS(tempStr4, tempStr2);
+            if ((i % 2 == 0) != (wideAttr == 0) ||
+                (wideAttr && !XMLString::equals(wideAttr->getValue(), tempStr3))) {
+                fprintf(stderr, "attribute hash lookup failed in line %i for attribute %d\n", __LINE__, i);
+                OK = false;
+                break;
+            }
+        }
+        if (wideEl->getAttributes()->getLength() != nAttrs / 2) {
+            fprintf(stderr, "attribute hash lookup failed in line %i\n", __LINE__);
+            OK = false;
+        }
+        wideEl->release();
+    }
+
     if (!OK)
         printf("\n*****The DOMElement* method calls listed above failed, all others worked correctly.*****\n");
     return OK;
@@ -5695,6 +5968,1588 @@ bool DOMTest::testScanner(XercesDOMParser* parser) {
     return OK;
 }
 
+class RecordCollector : public DOMRecordHandler
+{
+public:
+    RecordCollector(AbstractDOMParser* parser) : fParser(parser), fCount(0), fOK(true)
+    {
+        XMLString::transcode("urn:batch", fURI, 63);
+        XMLString::transcode("item", fItem, 63);
+    }
+
+    virtual bool isRecordRoot(const XMLCh* const namespaceURI,
+                              const XMLCh* const localName,
+                              const XMLSize_t    depth)
+    {
+        return depth == 2 && XMLString::equals(namespaceURI, fURI) && XMLString::equals(localName, fItem);
+    }
+
+    virtual void handleRecord(DOMDocument* const record)
+    {
+        fCount++;
+        DOMElement* root = record->getDocumentElement();
+        if (root == NULL || !XMLString::equals(root->getLocalName(), fItem) ||
+            record == fParser->getDocument() || root->getNextSibling() != NULL)
+        {
+            fprintf(stderr, "record %i has the wrong root\n", (int)fCount);
+            fOK = false;
+            return;
+        }
+
+        char expected[2][32] = { "Hello World", "Bye" };
+        XMLCh tempStr[64];
+        XMLString::transcode(expected[(fCount - 1) % 2], tempStr, 63);
+        if (!XMLString::equals(root->getTextContent(), tempStr))
+        {
+            fprintf(stderr, "record %i has the wrong content\n", (int)fCount);
+            fOK = false;
+        }
+    }
+
+    AbstractDOMParser* fParser;
+    XMLSize_t          fCount;
+    bool               fOK;
+    XMLCh              fURI[64];
+    XMLCh              fItem[64];
+};
+
+// Rejects the record whose root has id='2' and checks that it is only
+// ever shown nodes of records
+class RecordFilter : public DOMLSParserFilter
+{
+public:
+    RecordFilter() : fCalls(0), fOK(true) { XMLString::transcode("id", fId, 15); }
+
+    virtual FilterAction acceptNode(DOMNode* node)
+    {
+        fCalls++;
+        if (node->getNodeType() == DOMNode::DOCUMENT_NODE)
+            fOK = false;
+        return DOMLSParserFilter::FILTER_ACCEPT;
+    }
+
+    virtual FilterAction startElement(DOMElement* node)
+    {
+        fCalls++;
+        if (node->getNodeType() != DOMNode::ELEMENT_NODE)
+        {
+            fOK = false;
+            return DOMLSParserFilter::FILTER_ACCEPT;
+        }
+        const XMLCh* id = node->getAttribute(fId);
+        return (id[0] == chDigit_2) ? DOMLSParserFilter::FILTER_REJECT : DOMLSParserFilter::FILTER_ACCEPT;
+    }
+
+    virtual DOMNodeFilter::ShowType getWhatToShow() const { return DOMNodeFilter::SHOW_ALL; }
+
+    XMLSize_t fCalls;
+    bool      fOK;
+    XMLCh     fId[16];
+};
+
+bool DOMTest::testRecordHandler(XercesDOMParser* parser) {
+    bool OK = true;
+
+    const char sampleDoc[] =
+        "<?xml version='1.0'?>"
+        "<!DOCTYPE batch [<!ENTITY who 'World'>]>"
+        "<!-- head -->"
+        "<batch xmlns='urn:batch'>"
+        "  <!-- skipped -->"
+        "  <header>skipped<item/></header>"
+        "  <item id='1'>Hello &who;</item>"
+        "  <?skipped?>"
+        "  <item id='2'><note/>Bye</item>"
+        "</batch>";
+    MemBufInputSource is((XMLByte*)sampleDoc, strlen(sampleDoc), "bufId");
+
+    bool doNamespaces = parser->getDoNamespaces();
+    parser->setDoNamespaces(true);
+
+    RecordCollector collector(parser);
+    parser->setRecordHandler(&collector);
+    parser->parse(is);
+    parser->setRecordHandler(0);
+    parser->setDoNamespaces(doNamespaces);
+
+    if (!collector.fOK || collector.fCount != 2)
+    {
+        fprintf(stderr, "Record handler failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    // Only what lies outside of the root element is built
+    DOMDocument* doc = parser->getDocument();
+    if (doc == NULL || doc->getDocumentElement() != NULL || doc->getDoctype() == NULL ||
+        doc->getLastChild() == NULL || doc->getLastChild()->getNodeType() != DOMNode::COMMENT_NODE)
+    {
+        fprintf(stderr, "Record handler failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    // A DOMLSParser filter only sees the content of the records, and
+    // rejecting the root of a record drops the record
+    static const XMLCh gLS[] = { chLatin_L, chLatin_S, chNull };
+    DOMImplementationLS* impl = (DOMImplementationLS*)DOMImplementationRegistry::getDOMImplementation(gLS);
+    DOMLSParser* lsParser = impl->createLSParser(DOMImplementationLS::MODE_SYNCHRONOUS, 0);
+    AbstractDOMParser* lsParserImpl = (DOMLSParserImpl*)lsParser;
+    DOMLSInput* input = impl->createLSInput();
+    XMLString::transcode(sampleDoc, tempStr, 3999);
+    input->setStringData(tempStr);
+
+    RecordCollector lsCollector(lsParserImpl);
+    RecordFilter filter;
+    lsParserImpl->setRecordHandler(&lsCollector);
+    lsParser->setFilter(&filter);
+    try
+    {
+        lsParser->parse(input);
+        if (!lsCollector.fOK || lsCollector.fCount != 1 || !filter.fOK || filter.fCalls == 0)
+        {
+            fprintf(stderr, "Record handler failed at line %i\n", __LINE__);
+            OK = false;
+        }
+    }
+    catch (...)
+    {
+        fprintf(stderr, "Record handler failed at line %i\n", __LINE__);
+        OK = false;
+    }
+    input->release();
+    lsParser->release();
+
+    return OK;
+}
+
+// Logs the content events it receives as markup, prefix mappings as
+// [prefix=uri] and [/prefix]
+class FilterRecorder : public DefaultHandler
+{
+public:
+    FilterRecorder() : fLog(1023) {}
+
+    void startElement(const XMLCh* const, const XMLCh* const, const XMLCh* const qname, const Attributes&)
+    {
+        fLog.append(chOpenAngle);
+        fLog.append(qname);
+        fLog.append(chCloseAngle);
+    }
+
+    void endElement(const XMLCh* const, const XMLCh* const, const XMLCh* const qname)
+    {
+        fLog.append(chOpenAngle);
+        fLog.append(chForwardSlash);
+        fLog.append(qname);
+        fLog.append(chCloseAngle);
+    }
+
+    void characters(const XMLCh* const chars, const XMLSize_t length)
+    {
+        fLog.append(chars, length);
+    }
+
+    void startPrefixMapping(const XMLCh* const prefix, const XMLCh* const uri)
+    {
+        fLog.append(chOpenSquare);
+        fLog.append(prefix);
+        fLog.append(chEqual);
+        fLog.append(uri);
+        fLog.append(chCloseSquare);
+    }
+
+    void endPrefixMapping(const XMLCh* const prefix)
+    {
+        fLog.append(chOpenSquare);
+        fLog.append(chForwardSlash);
+        fLog.append(prefix);
+        fLog.append(chCloseSquare);
+    }
+
+    XMLBuffer fLog;
+};
+
+static bool checkFilterLog(FilterRecorder& recorder, const char* expected, int line)
+{
+    XMLCh* expectedStr = XMLString::transcode(expected);
+    bool OK = XMLString::equals(recorder.fLog.getRawBuffer(), expectedStr);
+    XMLString::release(&expectedStr);
+    if (!OK)
+    {
+        char* log = XMLString::transcode(recorder.fLog.getRawBuffer());
+        fprintf(stderr, "SAX2XPathFilter failed at line %i:\n  got      %s\n  expected %s\n", line, log, expected);
+        XMLString::release(&log);
+    }
+    recorder.fLog.reset();
+    return OK;
+}
+
+bool DOMTest::testXPathFilter() {
+    bool OK = true;
+
+    // Nested matches, prefixes declared above, on and below the matched
+    // elements, an undeclared default namespace and an unmatched sibling
+    // with its own declaration
+    const char sampleDoc[] =
+        "<r xmlns:a='urn:a' xmlns='urn:d'>"
+        "<x xmlns:b='urn:b'><rec a:k='1'>one<rec>nested</rec></rec></x>"
+        "<skip xmlns:s='urn:s'><s:other>skipped</s:other></skip>"
+        "<x xmlns:a='urn:a2'><rec xmlns:c='urn:c'>two<c:n/></rec></x>"
+        "<x xmlns=''><rec>three</rec></x>"
+        "</r>";
+
+    SAX2XMLReader* reader = XMLReaderFactory::createXMLReader();
+    SAX2XPathFilter* filter = new SAX2XPathFilter(reader);
+    FilterRecorder recorder;
+    filter->setContentHandler(&recorder);
+
+    XMLString::transcode("d", tempStr, 3999);
+    XMLString::transcode("urn:d", tempStr2, 3999);
+    filter->addNamespaceBinding(tempStr, tempStr2);
+    XMLString::transcode("//d:rec | //rec", tempStr, 3999);
+    filter->addExpression(tempStr);
+
+    try
+    {
+        MemBufInputSource is((XMLByte*)sampleDoc, strlen(sampleDoc), "bufId");
+        filter->parse(is);
+        OK &= checkFilterLog(recorder,
+            "[b=urn:b][=urn:d][a=urn:a]<rec>one<rec>nested</rec></rec>[/b][/][/a]"
+            "[a=urn:a2][=urn:d][c=urn:c]<rec>two<c:n></c:n></rec>[/a][/][/c]"
+            "[a=urn:a]<rec>three</rec>[/a]", __LINE__);
+
+        // Only the innermost binding of a prefix is reported, and the
+        // declarations inside a subtree are forwarded where they occur
+        delete filter;
+        filter = new SAX2XPathFilter(reader);
+        filter->setContentHandler(&recorder);
+        XMLString::transcode("d", tempStr, 3999);
+        filter->addNamespaceBinding(tempStr, tempStr2);
+        XMLString::transcode("//d:x | //x", tempStr, 3999);
+        filter->addExpression(tempStr);
+        MemBufInputSource is2((XMLByte*)sampleDoc, strlen(sampleDoc), "bufId");
+        filter->parse(is2);
+        OK &= checkFilterLog(recorder,
+            "[=urn:d][a=urn:a][b=urn:b]<x><rec>one<rec>nested</rec></rec></x>[/][/a][/b]"
+            "[=urn:d][a=urn:a2]<x>[c=urn:c]<rec>two<c:n></c:n></rec>[/c]</x>[/][/a]"
+            "[a=urn:a][=]<x><rec>three</rec></x>[/a][/]", __LINE__);
+    }
+    catch (...)
+    {
+        fprintf(stderr, "SAX2XPathFilter failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    delete filter;
+    delete reader;
+    return OK;
+}
+
+// Keeps the output of a formatter and how it was handed over
+class FormatRecorder : public MemBufFormatTarget
+{
+public:
+    FormatRecorder() : fCalls(0), fLargest(0) {}
+
+    virtual void writeChars(const XMLByte* const toWrite, const XMLSize_t count, XMLFormatter* const formatter)
+    {
+        fCalls++;
+        if (count > fLargest)
+            fLargest = count;
+        MemBufFormatTarget::writeChars(toWrite, count, formatter);
+    }
+
+    XMLSize_t fCalls;
+    XMLSize_t fLargest;
+};
+
+// What formatBuf() has to produce, worked out char by char for UTF-8 output
+static void formatReference(const XMLCh* toFormat, XMLSize_t count, bool xml11, XMLFormatter::EscapeFlags escapes, MemBufFormatTarget& target)
+{
+    static const char* const escapeChars[XMLFormatter::EscapeFlags_Count] = { "", "&>\"<'", "&<\"\n\r\t", "&<>\r" };
+    for (XMLSize_t i = 0; i < count; i++)
+    {
+        const XMLCh ch = toFormat[i];
+        char buf[16];
+        XMLSize_t len = 0;
+        if (ch < 0x80 && ch != 0 && escapes != XMLFormatter::DefaultEscape && strchr(escapeChars[escapes], (char)ch) != NULL)
+        {
+            const char* ref = ch == chAmpersand ? "&amp;" : ch == chOpenAngle ? "&lt;" : ch == chCloseAngle ? "&gt;" :
+                              ch == chDoubleQuote ? "&quot;" : ch == chSingleQuote ? "&apos;" : NULL;
+            len = ref ? (XMLSize_t)sprintf(buf, "%s", ref) : (XMLSize_t)sprintf(buf, "&#x%X;", (unsigned int)ch);
+        }
+        else if (xml11 && escapes != XMLFormatter::NoEscapes && XMLChar1_1::isControlChar(ch) && !XMLChar1_1::isWhitespace(ch))
+            len = (XMLSize_t)sprintf(buf, "&#x%X;", (unsigned int)ch);
+        else if (ch < 0x80)
+            buf[len++] = (char)ch;
+        else if (ch < 0x800)
+        {
+            buf[len++] = (char)(0xC0 | (ch >> 6));
+            buf[len++] = (char)(0x80 | (ch & 0x3F));
+        }
+        else
+        {
+            buf[len++] = (char)(0xE0 | (ch >> 12));
+            buf[len++] = (char)(0x80 | ((ch >> 6) & 0x3F));
+            buf[len++] = (char)(0x80 | (ch & 0x3F));
+        }
+        target.writeChars((const XMLByte*)buf, len, 0);
+    }
+}
+
+// Formats the chars and compares the output with the expected bytes, with
+// and without the SSE2 escape scan
+static bool checkFormat(const XMLCh* toFormat, XMLSize_t count, const char* encoding, const char* version,
+                        XMLFormatter::EscapeFlags escapes, XMLFormatter::UnRepFlags unrep,
+                        const XMLByte* expected, XMLSize_t expectedLen, int line)
+{
+    bool OK = true;
+    const bool sse2ok = XMLPlatformUtils::fgSSE2ok;
+    for (int sse2 = 0; sse2 < 2; sse2++)
+    {
+        XMLPlatformUtils::fgSSE2ok = sse2 && sse2ok;
+
+        FormatRecorder output;
+        XMLFormatter formatter(encoding, version, &output, escapes, unrep);
+        formatter.formatBuf(toFormat, count);
+
+        // The output goes out in pieces as large as the temp buffer allows,
+        // char refs for unrepresentable chars break it up though
+        if (output.getLen() != expectedLen || memcmp(output.getRawBuffer(), expected, expectedLen) != 0 ||
+            (unrep != XMLFormatter::UnRep_CharRef && output.fCalls > expectedLen / 8192 + 1) ||
+            output.fLargest > 16 * 1024)
+        {
+            fprintf(stderr, "XMLFormatter failed at line %i (%s, %u chars%s) [%.*s]\n", line, encoding,
+                    (unsigned int)count, sse2 ? "" : ", no SSE2", (int)output.getLen(), (const char*)output.getRawBuffer());
+            OK = false;
+        }
+    }
+    XMLPlatformUtils::fgSSE2ok = sse2ok;
+    return OK;
+}
+
+static bool checkFormat(const XMLCh* toFormat, XMLSize_t count, const char* version, XMLFormatter::EscapeFlags escapes, int line)
+{
+    MemBufFormatTarget expected;
+    formatReference(toFormat, count, XMLString::equals(version, "1.1"), escapes, expected);
+    return checkFormat(toFormat, count, "UTF-8", version, escapes, XMLFormatter::UnRep_Fail,
+                       expected.getRawBuffer(), expected.getLen(), line);
+}
+
+bool DOMTest::testFormatter()
+{
+    bool OK = true;
+    XMLCh chars[64];
+
+    // One or two escapes anywhere in the 8 char blocks and in the tail
+    for (XMLSize_t len = 1; len < 40; len++)
+    {
+        for (XMLSize_t pos = 0; pos < len; pos++)
+        {
+            for (XMLSize_t i = 0; i < len; i++)
+                chars[i] = chLatin_a + (XMLCh)(i % 26);
+            chars[pos] = chOpenAngle;
+            OK &= checkFormat(chars, len, "1.0", XMLFormatter::StdEscapes, __LINE__);
+            if (pos + 1 < len)
+                chars[pos + 1] = chAmpersand;
+            OK &= checkFormat(chars, len, "1.0", XMLFormatter::StdEscapes, __LINE__);
+
+            // which are no escapes in other styles
+            chars[pos] = chDoubleQuote;
+            OK &= checkFormat(chars, len, "1.0", XMLFormatter::CharEscapes, __LINE__);
+            OK &= checkFormat(chars, len, "1.0", XMLFormatter::AttrEscapes, __LINE__);
+            OK &= checkFormat(chars, len, "1.0", XMLFormatter::NoEscapes, __LINE__);
+        }
+    }
+
+    // XML 1.1 refers to the control chars but for whitespace, XML 1.0 does not
+    XMLCh controls[0x40 + 0x28];
+    XMLSize_t count = 0;
+    for (XMLCh ch = 0x01; ch <= 0x40; ch++)
+        controls[count++] = ch;
+    for (XMLCh ch = 0x78; ch <= 0x9F; ch++)
+        controls[count++] = ch;
+    for (XMLSize_t start = 0; start < 17; start++)
+    {
+        OK &= checkFormat(controls + start, count - start, "1.1", XMLFormatter::NoEscapes, __LINE__);
+        OK &= checkFormat(controls + start, count - start, "1.1", XMLFormatter::StdEscapes, __LINE__);
+        OK &= checkFormat(controls + start, count - start, "1.1", XMLFormatter::AttrEscapes, __LINE__);
+        OK &= checkFormat(controls + start, count - start, "1.0", XMLFormatter::StdEscapes, __LINE__);
+    }
+    // and on their own, so that each one has to be found by the block scan
+    for (XMLSize_t i = 0; i < count; i++)
+    {
+        for (XMLSize_t pos = 5; pos < 24; pos += 6)
+        {
+            for (XMLSize_t j = 0; j < 24; j++)
+                chars[j] = chLatin_a;
+            chars[pos] = controls[i];
+            OK &= checkFormat(chars, 24, "1.1", XMLFormatter::StdEscapes, __LINE__);
+        }
+    }
+    const XMLCh nel[] = { chLatin_a, 0x85, 0x2028, 0x7F, 0xA0, 0x9F, chLatin_b, chNull };
+    OK &= checkFormat(nel, XMLString::stringLen(nel), "1.1", XMLFormatter::StdEscapes, __LINE__);
+
+    // Unrepresentable chars, surrogate pairs included, as char refs behind
+    // and in front of escapes
+    const XMLCh unrep[] = { chLatin_a, 0xE9, chOpenAngle, 0xD83D, 0xDE00, chAmpersand, 0x20AC, chLatin_b, chNull };
+    for (XMLSize_t start = 0; start < 17; start++)
+    {
+        for (XMLSize_t i = 0; i < start; i++)
+            chars[i] = chLatin_x;
+        XMLString::copyString(chars + start, unrep);
+
+        char expected[64];
+        memset(expected, 'x', start);
+        strcpy(expected + start, "a&#xE9;&lt;&#x1F600;&amp;&#x20AC;b");
+        OK &= checkFormat(chars, XMLString::stringLen(chars), "US-ASCII", "1.0", XMLFormatter::StdEscapes,
+                          XMLFormatter::UnRep_CharRef, (const XMLByte*)expected, strlen(expected), __LINE__);
+
+        // é can be written as is in Latin-1
+        strcpy(expected + start, "a\xE9&lt;&#x1F600;&amp;&#x20AC;b");
+        OK &= checkFormat(chars, XMLString::stringLen(chars), "ISO-8859-1", "1.0", XMLFormatter::StdEscapes,
+                          XMLFormatter::UnRep_CharRef, (const XMLByte*)expected, strlen(expected), __LINE__);
+
+        // Failing on them still writes what came before
+        FormatRecorder output;
+        XMLFormatter formatter("US-ASCII", "1.0", &output, XMLFormatter::StdEscapes, XMLFormatter::UnRep_Fail);
+        const XMLCh failing[] = { chOpenAngle, chOpenAngle, 0xE9, chNull };
+        XMLString::copyString(chars + start, failing);
+        bool thrown = false;
+        try
+        {
+            formatter.formatBuf(chars, XMLString::stringLen(chars));
+        }
+        catch (const TranscodingException&)
+        {
+            thrown = true;
+        }
+        memset(expected, 'x', start);
+        strcpy(expected + start, "&lt;&lt;");
+        if (!thrown || output.getLen() != strlen(expected) || memcmp(output.getRawBuffer(), expected, strlen(expected)) != 0)
+        {
+            fprintf(stderr, "XMLFormatter failed at line %i\n", __LINE__);
+            OK = false;
+        }
+    }
+
+    // Output larger than the temp buffer, with and without escapes near
+    // its end and with char refs that need more than one byte per char
+    const XMLSize_t largeLen = 40000;
+    XMLCh* large = new XMLCh[largeLen + 1];
+    ArrayJanitor<XMLCh> janLarge(large);
+    for (XMLSize_t i = 0; i < largeLen; i++)
+        large[i] = (i % 997 == 0) ? chAmpersand : (i % 1499 == 0) ? (XMLCh)0x86 : (i % 3 == 0) ? (XMLCh)0x20AC : chLatin_a;
+    large[largeLen] = chNull;
+    OK &= checkFormat(large, largeLen, "1.0", XMLFormatter::NoEscapes, __LINE__);
+    OK &= checkFormat(large, largeLen, "1.0", XMLFormatter::StdEscapes, __LINE__);
+    OK &= checkFormat(large, largeLen, "1.1", XMLFormatter::StdEscapes, __LINE__);
+    for (XMLSize_t i = 0; i < largeLen; i++)
+        large[i] = (i % 5 == 0) ? chOpenAngle : chLatin_a;
+    OK &= checkFormat(large, largeLen, "1.0", XMLFormatter::StdEscapes, __LINE__);
+
+    return OK;
+}
+
+// Accepts everything, but makes the serializer take its general path
+class SerializerPassThrough : public DOMLSSerializerFilter
+{
+public:
+    virtual FilterAction acceptNode(const DOMNode*) const { return FILTER_ACCEPT; }
+    virtual ShowType getWhatToShow() const { return DOMNodeFilter::SHOW_ALL; }
+};
+
+static XMLSize_t serializeToBuffer(DOMNode* node, DOMLSSerializerFilter* filter, bool entities, MemBufFormatTarget& target, bool parallel = false, XMLSize_t threads = 0, bool* written = 0)
+{
+    static const XMLCh gLS[] = { chLatin_L, chLatin_S, chNull };
+    static const XMLCh gUTF8[] = { chLatin_U, chLatin_T, chLatin_F, chDash, chDigit_8, chNull };
+    DOMImplementationLS *impl = (DOMImplementationLS*)DOMImplementationRegistry::getDOMImplementation(gLS);
+
+    DOMLSSerializer* writer = impl->createLSSerializer();
+    writer->setFilter(filter);
+    writer->getDomConfig()->setParameter(XMLUni::fgDOMWRTEntities, entities);
+    writer->getDomConfig()->setParameter(XMLUni::fgDOMWRTXercesParallelSerialization, parallel);
+    writer->getDomConfig()->setParameter(XMLUni::fgDOMWRTXercesParallelThreads, &threads);
+    DOMLSOutput* output = impl->createLSOutput();
+    output->setByteStream(&target);
+    output->setEncoding(gUTF8);
+    // fatal errors abort serialization with an exception
+    bool result = false;
+    try
+    {
+        result = writer->write(node, output);
+    }
+    catch (const DOMLSException&)
+    {
+    }
+    if (written)
+        *written = result;
+    output->release();
+    writer->release();
+
+    return target.getLen();
+}
+
+bool DOMTest::testSerializer(XercesDOMParser* parser) {
+    bool OK = true;
+
+    const char sampleDoc[] =
+        "<?xml version='1.0'?>"
+        "<!DOCTYPE root [<!ENTITY who 'World'><!ENTITY all 'all &amp; <b>every</b>one'>]>"
+        "<!-- head -->"
+        "<root xmlns='urn:root' xmlns:p='urn:p' a='&quot;1&quot; &lt; &amp;&#9;&#10;&#13;'>"
+        "<?pi data?>"
+        "<p:item p:id='1' xmlns:q='urn:q' q:b='&who;'>Hello &who; and &all;! &lt;&gt;&amp;&#13;"
+        "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80</p:item>"
+        "<![CDATA[<raw>]]><![CDATA[a]]]]><![CDATA[>b]]>"
+        "<empty xmlns=''><inner/></empty>"
+        "</root>";
+    MemBufInputSource is((XMLByte*)sampleDoc, strlen(sampleDoc), "bufId");
+
+    bool doNamespaces = parser->getDoNamespaces();
+    bool createEntityRefs = parser->getCreateEntityReferenceNodes();
+    parser->setDoNamespaces(true);
+    parser->setCreateEntityReferenceNodes(true);
+    parser->parse(is);
+    parser->setDoNamespaces(doNamespaces);
+    parser->setCreateEntityReferenceNodes(createEntityRefs);
+
+    DOMDocument* doc = parser->getDocument();
+    if (parser->getErrorCount() != 0 || doc == NULL || doc->getDocumentElement() == NULL)
+    {
+        fprintf(stderr, "Serializer failed at line %i\n", __LINE__);
+        return false;
+    }
+
+    // Plain UTF-8 output is streamed, it has to match the general path
+    SerializerPassThrough passThrough;
+    DOMNode* nodes[] = { doc, doc->getDocumentElement(), doc->getDocumentElement()->getFirstChild()->getNextSibling() };
+    for (unsigned int i = 0; i < sizeof(nodes) / sizeof(nodes[0]); i++)
+    {
+        for (int entities = 0; entities < 2; entities++)
+        {
+            MemBufFormatTarget streamed, general, parallel;
+            XMLSize_t len = serializeToBuffer(nodes[i], 0, entities != 0, streamed);
+            if (len == 0 || len != serializeToBuffer(nodes[i], &passThrough, entities != 0, general) ||
+                memcmp(streamed.getRawBuffer(), general.getRawBuffer(), len) != 0)
+            {
+                fprintf(stderr, "Serializer failed at line %i\n", __LINE__);
+                OK = false;
+            }
+
+            // and so has parallel output
+            if (len != serializeToBuffer(nodes[i], 0, entities != 0, parallel, true) ||
+                memcmp(streamed.getRawBuffer(), parallel.getRawBuffer(), len) != 0)
+            {
+                fprintf(stderr, "Serializer failed at line %i\n", __LINE__);
+                OK = false;
+            }
+        }
+    }
+
+    const char expected[] =
+        "<p:item xmlns:p=\"urn:p\" p:id=\"1\" xmlns:q=\"urn:q\" q:b=\"World\">Hello &who; and &all;! &lt;&gt;&amp;&#xD;"
+        "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80</p:item>";
+    MemBufFormatTarget item;
+    serializeToBuffer(nodes[2], 0, true, item);
+    const char* itemText = (const char*)item.getRawBuffer();
+    const char* itemStart = strstr(itemText, "<p:item");
+    if (itemStart == NULL || strcmp(itemStart, expected) != 0)
+    {
+        fprintf(stderr, "Serializer failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    return OK;
+}
+
+bool DOMTest::testParallelSerializer(XercesDOMParser* parser) {
+    bool OK = true;
+
+    // more children than fit in a run, below a single child element so
+    // that the split has to look for them
+    char* doc = new char[3000 * 100];
+    ArrayJanitor<char> janDoc(doc);
+    int len = sprintf(doc,
+        "<?xml version='1.0'?>"
+        "<!DOCTYPE root [<!ENTITY who 'World'>]>"
+        "<root xmlns='urn:root' xmlns:p='urn:p'><wrap>");
+    for (int i = 0; i < 3000; i++)
+    {
+        if (i % 10 == 3)
+            len += sprintf(doc + len, "<x xmlns='urn:x' p:n='%d'><y xmlns=''/></x>", i);
+        else if (i % 10 == 7)
+            len += sprintf(doc + len, "<p:rec p:id='%d' q='&who;'>Hello &who; &lt;%d&gt;</p:rec>", i, i);
+        else
+            len += sprintf(doc + len, "<p:rec p:id='%d'>text \xC3\xA9 &amp; %d<?pi %d?></p:rec>", i, i, i);
+    }
+    len += sprintf(doc + len, "</wrap></root>");
+    MemBufInputSource is((const XMLByte*)doc, len, "bufId");
+
+    bool doNamespaces = parser->getDoNamespaces();
+    bool createEntityRefs = parser->getCreateEntityReferenceNodes();
+    parser->setDoNamespaces(true);
+    parser->setCreateEntityReferenceNodes(true);
+    parser->parse(is);
+    parser->setDoNamespaces(doNamespaces);
+    parser->setCreateEntityReferenceNodes(createEntityRefs);
+
+    DOMDocument* document = parser->getDocument();
+    if (parser->getErrorCount() != 0 || document == NULL || document->getDocumentElement() == NULL)
+    {
+        fprintf(stderr, "Parallel serializer failed at line %i\n", __LINE__);
+        return false;
+    }
+
+    // Runs holding an attribute made of an entity reference are written
+    // again sequentially when entities are expanded, so are the ones after
+    // an invalid comment, which stops serialization.
+    DOMNode* wrap = document->getDocumentElement()->getFirstChild();
+    for (int pass = 0; pass < 2; pass++)
+    {
+        if (pass == 1)
+        {
+            XMLString::transcode("bad \x01 comment", tempStr, 3999);
+            wrap->insertBefore(document->createComment(tempStr), wrap->getLastChild()->getPreviousSibling());
+        }
+
+        for (int entities = 0; entities < 2; entities++)
+        {
+            for (XMLSize_t threads = 2; threads <= 5; threads += 3)
+            {
+                MemBufFormatTarget sequential, parallel;
+                bool seqWritten, parWritten;
+                XMLSize_t outLen = serializeToBuffer(document, 0, entities != 0, sequential, false, 0, &seqWritten);
+                if (outLen == 0 || seqWritten != (pass == 0) ||
+                    outLen != serializeToBuffer(document, 0, entities != 0, parallel, true, threads, &parWritten) ||
+                    seqWritten != parWritten ||
+                    memcmp(sequential.getRawBuffer(), parallel.getRawBuffer(), outLen) != 0)
+                {
+                    fprintf(stderr, "Parallel serializer failed at line %i\n", __LINE__);
+                    OK = false;
+                }
+            }
+        }
+    }
+
+    return OK;
+}
+
+bool DOMTest::testSnapshot(XercesDOMParser* parser)
+{
+    bool OK = true;
+
+    const char* xml =
+        "<?xml version='1.0' encoding='UTF-8' standalone='yes'?>"
+        "<!DOCTYPE root ["
+        "<!ELEMENT root ANY>"
+        "<!ATTLIST item id ID #IMPLIED kind CDATA 'plain'>"
+        "<!ENTITY who 'World'>"
+        "<!ENTITY logo SYSTEM 'logo.gif' NDATA gif>"
+        "<!NOTATION gif PUBLIC 'image/gif'>"
+        "]>"
+        "<!-- head -->"
+        "<root xmlns='urn:root' xmlns:p='urn:p'>"
+        "<item id='a1' p:n='1'>Hello &who;!</item>"
+        "<p:item><![CDATA[<raw>]]><?pi some data?></p:item>"
+        "<item id='a2' kind='special'>\xC3\xA9t\xC3\xA9</item>"
+        "</root>";
+    MemBufInputSource is((const XMLByte*)xml, strlen(xml), "bufId");
+
+    bool doNamespaces = parser->getDoNamespaces();
+    bool createEntityRefs = parser->getCreateEntityReferenceNodes();
+    parser->setDoNamespaces(true);
+    parser->setCreateEntityReferenceNodes(true);
+    parser->parse(is);
+    parser->setDoNamespaces(doNamespaces);
+    parser->setCreateEntityReferenceNodes(createEntityRefs);
+
+    DOMDocument* document = parser->getDocument();
+    if (parser->getErrorCount() != 0 || document == NULL || document->getDocumentElement() == NULL)
+    {
+        fprintf(stderr, "Snapshot failed at line %i\n", __LINE__);
+        return false;
+    }
+
+    MemBufFormatTarget image;
+    DOMSnapshot::write(document, &image);
+    DOMDocument* copy = DOMSnapshot::read(image.getRawBuffer(), image.getLen());
+
+    // The copy serializes to the same XML
+    MemBufFormatTarget original, copied;
+    XMLSize_t outLen = serializeToBuffer(document, 0, false, original);
+    if (outLen == 0 || outLen != serializeToBuffer(copy, 0, false, copied) ||
+        memcmp(original.getRawBuffer(), copied.getRawBuffer(), outLen) != 0)
+    {
+        fprintf(stderr, "Snapshot failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    // So do the parts the serializer doesn't show
+    XMLString::transcode("a2", tempStr, 3999);
+    DOMElement* item = copy->getElementById(tempStr);
+    XMLString::transcode("kind", tempStr2, 3999);
+    DOMAttr* special = item ? item->getAttributeNode(tempStr2) : 0;
+    XMLString::transcode("urn:p", tempStr, 3999);
+    XMLString::transcode("item", tempStr2, 3999);
+    DOMNodeList* pItems = copy->getElementsByTagNameNS(tempStr, tempStr2);
+    XMLString::transcode("logo", tempStr, 3999);
+    DOMEntity* logo = (DOMEntity*)copy->getDoctype()->getEntities()->getNamedItem(tempStr);
+    XMLString::transcode("who", tempStr, 3999);
+    DOMNode* who = copy->getDoctype()->getEntities()->getNamedItem(tempStr);
+    XMLString::transcode("World", tempStr2, 3999);
+    if (item == 0 || special == 0 || !special->getSpecified() ||
+        pItems->getLength() != 1 || pItems->item(0)->getPrefix() == 0 ||
+        logo == 0 || logo->getNotationName() == 0 ||
+        copy->getDoctype()->getNotations()->getLength() != 1 ||
+        who == 0 || !XMLString::equals(who->getTextContent(), tempStr2) ||
+        !copy->getXmlStandalone() || copy->getXmlEncoding() == 0)
+    {
+        fprintf(stderr, "Snapshot failed at line %i\n", __LINE__);
+        OK = false;
+    }
+    if (copy)
+    {
+        // Defaulted attributes are still not specified, and the content of
+        // entity references is read only
+        XMLString::transcode("a1", tempStr, 3999);
+        XMLString::transcode("kind", tempStr2, 3999);
+        DOMElement* first = copy->getElementById(tempStr);
+        DOMAttr* kind = first ? first->getAttributeNode(tempStr2) : 0;
+        DOMNode* ref = first ? first->getFirstChild()->getNextSibling() : 0;
+        if (kind == 0 || kind->getSpecified() || ref == 0 ||
+            ref->getNodeType() != DOMNode::ENTITY_REFERENCE_NODE)
+        {
+            fprintf(stderr, "Snapshot failed at line %i\n", __LINE__);
+            OK = false;
+        }
+        else
+        {
+            try
+            {
+                ref->getFirstChild()->setNodeValue(tempStr);
+                fprintf(stderr, "Snapshot failed at line %i\n", __LINE__);
+                OK = false;
+            }
+            catch (DOMException& e)
+            {
+                if (e.code != DOMException::NO_MODIFICATION_ALLOWED_ERR)
+                {
+                    fprintf(stderr, "Snapshot failed at line %i\n", __LINE__);
+                    OK = false;
+                }
+            }
+        }
+        copy->release();
+    }
+
+    // Damaged or cut off snapshots are refused
+    XMLByte* damaged = new XMLByte[image.getLen() + sizeof(XMLSize_t)];
+    ArrayJanitor<XMLByte> janDamaged(damaged);
+    for (int pass = 0; pass < 4; pass++)
+    {
+        memcpy(damaged, image.getRawBuffer(), image.getLen());
+        XMLSize_t size = image.getLen();
+        switch (pass)
+        {
+        case 0: damaged[0] = 'x'; break;
+        case 1: size -= 2; break;
+        case 2: ((XMLUInt32*)damaged)[12 + 9 + 1] = 100; break; // the parent of the record after the document
+        case 3: damaged[size - 2] = 'x'; break;                 // the terminator of the last string
+        }
+        try
+        {
+            DOMDocument* bad = DOMSnapshot::read(damaged, size);
+            bad->release();
+            fprintf(stderr, "Snapshot failed at line %i, pass %d\n", __LINE__, pass);
+            OK = false;
+        }
+        catch (DOMLSException& e)
+        {
+            if (e.code != DOMLSException::PARSE_ERR)
+            {
+                fprintf(stderr, "Snapshot failed at line %i, pass %d\n", __LINE__, pass);
+                OK = false;
+            }
+        }
+    }
+
+    return OK;
+}
+
+bool DOMTest::testMemoryUsage()
+{
+    bool OK = true;
+
+    static const XMLCh gCore[] = { chLatin_C, chLatin_o, chLatin_r, chLatin_e, chNull };
+    DOMImplementation* impl = DOMImplementationRegistry::getDOMImplementation(gCore);
+    DOMDocument* doc = impl->createDocument();
+    DOMMemoryManager* mgr = (DOMMemoryManager*)doc->getFeature(XMLUni::fgXercescInterfaceDOMMemoryManager, 0);
+
+    DOMMemoryManager::MemoryUsage before, after;
+    mgr->getMemoryUsage(before);
+
+    XMLString::transcode("root", tempStr, 3999);
+    DOMElement* root = doc->createElement(tempStr);
+    doc->appendChild(root);
+    for (int i = 0; i < 10; i++)
+    {
+        XMLString::transcode("child", tempStr, 3999);
+        DOMElement* child = doc->createElement(tempStr);
+        XMLString::transcode("hello", tempStr, 3999);
+        child->appendChild(doc->createTextNode(tempStr));
+        XMLString::transcode("id", tempStr, 3999);
+        XMLString::transcode("abc", tempStr2, 3999);
+        child->setAttribute(tempStr, tempStr2);
+        root->appendChild(child);
+    }
+
+    // The live nodes of each type are counted, strings are only looked at
+    // when asked for
+    mgr->getMemoryUsage(after);
+    if (after.fNodeCount[DOMMemoryManager::ELEMENT_OBJECT] != before.fNodeCount[DOMMemoryManager::ELEMENT_OBJECT] + 11 ||
+        after.fNodeCount[DOMMemoryManager::ATTR_OBJECT] != before.fNodeCount[DOMMemoryManager::ATTR_OBJECT] + 10 ||
+        after.fNodeBytes[DOMMemoryManager::ELEMENT_OBJECT] < 11 * sizeof(DOMElement) ||
+        after.fAllocatedBytes <= before.fAllocatedBytes ||
+        after.fBlockBytes < after.fAllocatedBytes || after.fBlockCount == 0 ||
+        after.fWastedBytes != 0 || after.fStringBytes[DOMMemoryManager::TEXT_OBJECT] != 0 || after.fPooledStringCount != 0)
+    {
+        fprintf(stderr, "getMemoryUsage failed at line %i\n", __LINE__);
+        OK = false;
+    }
+    const XMLSize_t textCount = after.fNodeCount[DOMMemoryManager::TEXT_OBJECT];
+
+    mgr->getMemoryUsage(after, true);
+    if (after.fStringBytes[DOMMemoryManager::TEXT_OBJECT] != 10 * 6 * sizeof(XMLCh) ||
+        after.fStringBytes[DOMMemoryManager::ATTR_OBJECT] != 10 * 4 * sizeof(XMLCh) ||
+        after.fStringBytes[DOMMemoryManager::COMMENT_OBJECT] != 0 ||
+        after.fPooledStringCount < 3 || after.fPooledStringBytes < 3 * sizeof(XMLCh))
+    {
+        fprintf(stderr, "getMemoryUsage failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    // Released nodes are wasted until they are reused; the attribute value
+    // is a text node as well
+    DOMNode* removed = root->removeChild(root->getFirstChild());
+    removed->release();
+    mgr->getMemoryUsage(after);
+    if (after.fNodeCount[DOMMemoryManager::ELEMENT_OBJECT] != before.fNodeCount[DOMMemoryManager::ELEMENT_OBJECT] + 10 ||
+        after.fNodeCount[DOMMemoryManager::TEXT_OBJECT] != textCount - 2 ||
+        after.fWastedBytes < after.fNodeBytes[DOMMemoryManager::ELEMENT_OBJECT] / 10)
+    {
+        fprintf(stderr, "getMemoryUsage failed at line %i\n", __LINE__);
+        OK = false;
+    }
+    const XMLSize_t wasted = after.fWastedBytes;
+    XMLString::transcode("child", tempStr, 3999);
+    root->appendChild(doc->createElement(tempStr));
+    mgr->getMemoryUsage(after);
+    if (after.fNodeCount[DOMMemoryManager::ELEMENT_OBJECT] != before.fNodeCount[DOMMemoryManager::ELEMENT_OBJECT] + 11 ||
+        after.fWastedBytes != wasted - after.fNodeBytes[DOMMemoryManager::ELEMENT_OBJECT] / 11)
+    {
+        fprintf(stderr, "getMemoryUsage failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    // Large allocations get a block of their own
+    mgr->getMemoryUsage(before);
+    mgr->allocate(100000);
+    mgr->getMemoryUsage(after);
+    if (after.fBlockCount != before.fBlockCount + 1 || after.fBlockBytes < before.fBlockBytes + 100000 ||
+        after.fAllocatedBytes < before.fAllocatedBytes + 100000)
+    {
+        fprintf(stderr, "getMemoryUsage failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    doc->release();
+
+    // Text allocated last grows where it is, without leaving copies behind
+    doc = impl->createDocument();
+    mgr = (DOMMemoryManager*)doc->getFeature(XMLUni::fgXercescInterfaceDOMMemoryManager, 0);
+    XMLString::transcode("0123456789", tempStr, 3999);
+    DOMText* text = doc->createTextNode(tempStr);
+    mgr->getMemoryUsage(before);
+    for (int i = 0; i < 100; i++)
+        text->appendData(tempStr);
+    mgr->getMemoryUsage(after);
+    if (XMLString::stringLen(text->getData()) != 1010 || text->getData()[1009] != chDigit_9 ||
+        after.fBlockCount != before.fBlockCount ||
+        after.fAllocatedBytes > before.fAllocatedBytes + 1000 * sizeof(XMLCh))
+    {
+        fprintf(stderr, "getMemoryUsage failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    // Once something else is allocated, it moves
+    doc->createComment(tempStr);
+    text->appendData(tempStr);
+    XMLString::transcode("90", tempStr2, 3999);
+    if (XMLString::stringLen(text->getData()) != 1020 ||
+        XMLString::compareNString(text->getData() + 1009, tempStr2, 2) != 0)
+    {
+        fprintf(stderr, "getMemoryUsage failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    doc->release();
+    return OK;
+}
+
+// Counts all allocations, and those of the size of the first heap block of
+// a document
+class CountingMemoryManager : public MemoryManager
+{
+public:
+    CountingMemoryManager() : fAllocationCount(0), fBlockCount(0) { }
+
+    virtual MemoryManager* getExceptionMemoryManager() { return XMLPlatformUtils::fgMemoryManager; }
+    virtual void* allocate(XMLSize_t size)
+    {
+        fAllocationCount++;
+        if (size == 0x4000)
+            fBlockCount++;
+        return XMLPlatformUtils::fgMemoryManager->allocate(size);
+    }
+    virtual void deallocate(void* p) { XMLPlatformUtils::fgMemoryManager->deallocate(p); }
+
+    unsigned int fAllocationCount;
+    unsigned int fBlockCount;
+};
+
+bool DOMTest::testDocumentRecycling()
+{
+    bool OK = true;
+
+    // An empty document takes no memory of its own
+    static const XMLCh gCore[] = { chLatin_C, chLatin_o, chLatin_r, chLatin_e, chNull };
+    DOMImplementation* impl = DOMImplementationRegistry::getDOMImplementation(gCore);
+    DOMDocument* doc = impl->createDocument();
+    DOMMemoryManager* mgr = (DOMMemoryManager*)doc->getFeature(XMLUni::fgXercescInterfaceDOMMemoryManager, 0);
+    DOMMemoryManager::MemoryUsage usage;
+    mgr->getMemoryUsage(usage, true);
+    if (usage.fBlockCount != 0 || usage.fAllocatedBytes != 0 || usage.fPooledStringCount != 0)
+    {
+        fprintf(stderr, "testDocumentRecycling failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    // The pool of names grows with the number of names
+    XMLString::transcode("root", tempStr, 3999);
+    DOMElement* root = doc->createElement(tempStr);
+    doc->appendChild(root);
+    for (int i = 0; i < 1000; i++)
+    {
+        char name[16];
+        sprintf(name, "e%d", i % 500);
+        XMLString::transcode(name, tempStr, 3999);
+        root->appendChild(doc->createElement(tempStr));
+    }
+    mgr->getMemoryUsage(usage, true);
+    XMLString::transcode("e499", tempStr, 3999);
+    if (usage.fPooledStringCount != 501 || root->getElementsByTagName(tempStr)->getLength() != 2 ||
+        !XMLString::equals(root->getLastChild()->getNodeName(), tempStr) ||
+        root->getLastChild()->getNodeName() != root->getChildNodes()->item(499)->getNodeName())
+    {
+        fprintf(stderr, "testDocumentRecycling failed at line %i\n", __LINE__);
+        OK = false;
+    }
+    doc->release();
+
+    // A recycled document gives its memory to the next one
+    const char* sXml = "<message id='1'><to>a</to><from>b</from><body>Hello</body></message>";
+    CountingMemoryManager counter;
+    {
+        XercesDOMParser parser(0, &counter);
+        MemBufInputSource is((const XMLByte*)sXml, strlen(sXml), "message", false);
+
+        parser.parse(is);
+        DOMDocument* first = parser.adoptDocument();
+        const unsigned int blocks = counter.fBlockCount;
+        parser.recycleDocument(first);
+
+        for (int i = 0; i < 10; i++)
+        {
+            parser.parse(is);
+            DOMDocument* next = parser.adoptDocument();
+            if (next == 0 || next->getDocumentElement()->getChildElementCount() != 3)
+            {
+                fprintf(stderr, "testDocumentRecycling failed at line %i\n", __LINE__);
+                OK = false;
+            }
+            parser.recycleDocument(next);
+        }
+        if (blocks == 0 || counter.fBlockCount != blocks)
+        {
+            fprintf(stderr, "testDocumentRecycling failed at line %i\n", __LINE__);
+            OK = false;
+        }
+    }
+
+    return OK;
+}
+
+bool DOMTest::testGrammarPoolSharing()
+{
+    bool OK = true;
+
+    const char* sSchema =
+        "<xs:schema xmlns:xs='http://www.w3.org/2001/XMLSchema'>"
+        "<xs:simpleType name='code'>"
+          "<xs:restriction base='xs:string'><xs:pattern value='[A-Z]{2}[0-9]+'/></xs:restriction>"
+        "</xs:simpleType>"
+        "<xs:complexType name='item'>"
+          "<xs:sequence>"
+            "<xs:element name='code' type='code'/>"
+            "<xs:element name='note' type='xs:string' minOccurs='0' maxOccurs='unbounded'/>"
+          "</xs:sequence>"
+        "</xs:complexType>"
+        "<xs:element name='order'>"
+          "<xs:complexType><xs:sequence><xs:element name='item' type='item' maxOccurs='unbounded'/></xs:sequence></xs:complexType>"
+        "</xs:element>"
+        "</xs:schema>";
+    const char* sValid = "<order><item><code>AB12</code><note>x</note></item><item><code>CD3</code></item></order>";
+    const char* sInvalid = "<order><item><note>x</note></item><item><code>c</code></item></order>";
+
+    CountingMemoryManager poolManager;
+    {
+        XMLGrammarPoolImpl pool(&poolManager);
+        {
+            XercesDOMParser loader(0, XMLPlatformUtils::fgMemoryManager, &pool);
+            loader.setDoNamespaces(true);
+            loader.setDoSchema(true);
+            MemBufInputSource is((const XMLByte*)sSchema, strlen(sSchema), "order.xsd", false);
+            loader.loadGrammar(is, Grammar::SchemaGrammarType, true);
+        }
+        pool.lockPool();
+
+        // A pool loaded from the image of a locked pool is locked as well
+        BinMemOutputStream image(1024, &poolManager);
+        pool.serializeGrammars(&image);
+        XMLGrammarPoolImpl imagePool(&poolManager);
+        imagePool.deserializeGrammars(image.getRawBuffer(), (XMLSize_t)image.getSize());
+
+        XMLGrammarPoolImpl* pools[] = { &pool, &imagePool };
+        for (int p = 0; p < 2; p++)
+        {
+            // The first parse adds the names the scanner needs to the string
+            // pool of the locked pool, without validating anything
+            {
+                XercesDOMParser parser(0, XMLPlatformUtils::fgMemoryManager, pools[p]);
+                parser.setDoNamespaces(true);
+                parser.useCachedGrammarInParse(true);
+                MemBufInputSource is((const XMLByte*)sValid, strlen(sValid), "order", false);
+                parser.parse(is);
+            }
+
+            // Validating against the locked pool leaves the grammar alone, even
+            // the first time and for invalid documents, so parsing a document
+            // again takes as much of the pool's memory as the first time
+            const char* docs[] = { sInvalid, sValid };
+            const XMLSize_t errors[] = { 2, 0 };
+            for (int i = 0; i < 2; i++)
+            {
+                unsigned int allocations[2];
+                for (int pass = 0; pass < 2; pass++)
+                {
+                    const unsigned int before = poolManager.fAllocationCount;
+                    XercesDOMParser parser(0, XMLPlatformUtils::fgMemoryManager, pools[p]);
+                    parser.setDoNamespaces(true);
+                    parser.setDoSchema(true);
+                    parser.setValidationScheme(XercesDOMParser::Val_Always);
+                    parser.useCachedGrammarInParse(true);
+                    MemBufInputSource is((const XMLByte*)docs[i], strlen(docs[i]), "order", false);
+                    parser.parse(is);
+                    if (parser.getErrorCount() != errors[i])
+                    {
+                        fprintf(stderr, "testGrammarPoolSharing failed at line %i\n", __LINE__);
+                        OK = false;
+                    }
+                    allocations[pass] = poolManager.fAllocationCount - before;
+                }
+                if (allocations[0] != allocations[1])
+                {
+                    fprintf(stderr, "testGrammarPoolSharing failed at line %i\n", __LINE__);
+                    OK = false;
+                }
+            }
+        }
+    }
+
+    return OK;
+}
+
+bool DOMTest::testFreeze()
+{
+    bool OK = true;
+
+    static const XMLCh gCore[] = { chLatin_C, chLatin_o, chLatin_r, chLatin_e, chNull };
+    DOMImplementation* impl = DOMImplementationRegistry::getDOMImplementation(gCore);
+    DOMDocument* doc = impl->createDocument();
+
+    XMLString::transcode("root", tempStr, 3999);
+    DOMElement* root = doc->createElement(tempStr);
+    doc->appendChild(root);
+    for (int i = 0; i < 5; i++)
+    {
+        XMLString::transcode("child", tempStr, 3999);
+        DOMElement* child = doc->createElement(tempStr);
+        XMLString::transcode("grandchild", tempStr, 3999);
+        child->appendChild(doc->createElement(tempStr));
+        root->appendChild(child);
+    }
+    // an attribute value made of several nodes
+    XMLString::transcode("attr", tempStr, 3999);
+    DOMAttr* attr = doc->createAttribute(tempStr);
+    XMLString::transcode("ab", tempStr, 3999);
+    attr->appendChild(doc->createTextNode(tempStr));
+    XMLString::transcode("cd", tempStr, 3999);
+    attr->appendChild(doc->createTextNode(tempStr));
+    root->setAttributeNode(attr);
+
+    XMLString::transcode("child", tempStr, 3999);
+    DOMNodeList* children = doc->getElementsByTagName(tempStr);
+    if (doc->isFrozen() || children->getLength() != 5)
+    {
+        fprintf(stderr, "freeze failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    doc->freeze();
+    doc->freeze();
+
+    // Lists requested before and after freezing see the same elements, and
+    // asking again gives the same list
+    XMLString::transcode("grandchild", tempStr, 3999);
+    DOMNodeList* grandchildren = doc->getElementsByTagName(tempStr);
+    XMLString::transcode("*", tempStr2, 3999);
+    DOMNodeList* all = doc->getElementsByTagNameNS(tempStr2, tempStr2);
+    if (!doc->isFrozen() || children->getLength() != 5 || grandchildren->getLength() != 5 ||
+        all->getLength() != 11 || all->item(0) != root || all->item(11) != 0 ||
+        grandchildren->item(4) != root->getLastChild()->getFirstChild() ||
+        children->item(2)->getParentNode() != root ||
+        doc->getElementsByTagName(tempStr) != grandchildren ||
+        doc->getElementsByTagNameNS(tempStr2, tempStr2) != all)
+    {
+        fprintf(stderr, "freeze failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    XMLString::transcode("abcd", tempStr, 3999);
+    if (!XMLString::equals(attr->getValue(), tempStr))
+    {
+        fprintf(stderr, "freeze failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    // Nothing in the tree can change anymore
+    const int mutators = 5;
+    for (int i = 0; i < mutators; i++)
+    {
+        try
+        {
+            XMLString::transcode("other", tempStr, 3999);
+            switch (i)
+            {
+            case 0: root->appendChild(doc->createElement(tempStr)); break;
+            case 1: root->getFirstChild()->setUserData(tempStr, root, 0); break;
+            case 2: root->setAttribute(tempStr, tempStr); break;
+            case 3: doc->renameNode(root, 0, tempStr); break;
+            case 4: doc->normalizeDocument(); break;
+            }
+            fprintf(stderr, "freeze failed at line %i, mutator %d\n", __LINE__, i);
+            OK = false;
+        }
+        catch (DOMException& e)
+        {
+            if (e.code != DOMException::NO_MODIFICATION_ALLOWED_ERR)
+            {
+                fprintf(stderr, "freeze failed at line %i, mutator %d\n", __LINE__, i);
+                OK = false;
+            }
+        }
+    }
+
+    // New nodes are not frozen, and don't change the lists
+    XMLString::transcode("child", tempStr, 3999);
+    DOMElement* fresh = doc->createElement(tempStr);
+    fresh->appendChild(doc->createElement(tempStr));
+    if (fresh->isEqualNode(root) || children->getLength() != 5 ||
+        fresh->getElementsByTagName(tempStr)->getLength() != 1)
+    {
+        fprintf(stderr, "freeze failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    doc->release();
+    return OK;
+}
+
+// Rejects the elements named "item", and with them their content
+struct DOMTestRejectItems
+{
+    DOMNodeFilter::FilterAction operator()(const DOMDocumentCursorBase& at) const
+    {
+        static const XMLCh gItem[] = { chLatin_i, chLatin_t, chLatin_e, chLatin_m, chNull };
+        if (at.getNodeType() == DOMNode::ELEMENT_NODE && XMLString::equals(at.getNodeName(), gItem))
+            return DOMNodeFilter::FILTER_REJECT;
+        return DOMNodeFilter::FILTER_ACCEPT;
+    }
+};
+
+// Skips everything but text
+struct DOMTestTextOnly
+{
+    DOMNodeFilter::FilterAction operator()(const DOMDocumentCursorBase& at) const
+    {
+        return at.getNodeType() == DOMNode::TEXT_NODE ? DOMNodeFilter::FILTER_ACCEPT
+                                                      : DOMNodeFilter::FILTER_SKIP;
+    }
+};
+
+bool DOMTest::testDocumentCursor(XercesDOMParser* parser)
+{
+    bool OK = true;
+
+    const char* xml =
+        "<?xml version='1.0'?>"
+        "<!DOCTYPE root ["
+        "<!ENTITY who '<b>World</b>'>"
+        "]>"
+        "<!-- head -->"
+        "<root a='1'>"
+        "<item>Hello &who;!</item>"
+        "<other><![CDATA[<raw>]]><?pi some data?><item><deep/></item>tail</other>"
+        "</root>"
+        "<?after?>";
+    MemBufInputSource is((const XMLByte*)xml, strlen(xml), "bufId");
+
+    bool createEntityRefs = parser->getCreateEntityReferenceNodes();
+    parser->setCreateEntityReferenceNodes(true);
+    parser->parse(is);
+    parser->setCreateEntityReferenceNodes(createEntityRefs);
+
+    DOMDocument* document = parser->getDocument();
+    if (parser->getErrorCount() != 0 || document == NULL || document->getDocumentElement() == NULL)
+    {
+        fprintf(stderr, "DocumentCursor failed at line %i\n", __LINE__);
+        return false;
+    }
+
+    // The cursor visits the same nodes as an iterator, and reports the same
+    // names and values as the nodes themselves
+    DOMNodeIterator* iterator = document->createNodeIterator(document, DOMNodeFilter::SHOW_ALL, 0, true);
+    DOMDocumentCursor<> cursor(document);
+    XMLSize_t count = 0;
+    while (cursor.nextNode())
+    {
+        DOMNode* node = cursor.getNode();
+        XMLSize_t depth = 0;
+        for (DOMNode* parent = node->getParentNode(); parent != 0; parent = parent->getParentNode())
+            depth++;
+        if (node != iterator->nextNode() || cursor.getNodeType() != node->getNodeType() ||
+            cursor.getDepth() != depth ||
+            !XMLString::equals(cursor.getNodeName(), node->getNodeName()) ||
+            !XMLString::equals(cursor.getNodeValue(), node->getNodeValue()))
+        {
+            fprintf(stderr, "DocumentCursor failed at line %i\n", __LINE__);
+            OK = false;
+            break;
+        }
+        count++;
+    }
+    if (iterator->nextNode() != 0 || cursor.getNode() != 0 || cursor.nextNode() || count != 17)
+    {
+        fprintf(stderr, "DocumentCursor failed at line %i\n", __LINE__);
+        OK = false;
+    }
+    iterator->release();
+
+    cursor.reset();
+    if (!cursor.nextNode() || cursor.getNode() != document)
+    {
+        fprintf(stderr, "DocumentCursor failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    // A rejected node is passed over with its content, a skipped one without
+    DOMElement* root = document->getDocumentElement();
+    DOMDocumentCursor<DOMTestRejectItems> rejecting(root);
+    count = 0;
+    while (rejecting.nextNode())
+    {
+        if (rejecting.getNodeType() == DOMNode::TEXT_NODE || rejecting.getNodeType() == DOMNode::ELEMENT_NODE)
+            count++;
+    }
+    // root, other and tail
+    if (count != 3)
+    {
+        fprintf(stderr, "DocumentCursor failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    DOMDocumentCursor<DOMTestTextOnly> text(root);
+    XMLString::transcode("Hello World!tail", tempStr2, 3999);
+    tempStr[0] = chNull;
+    while (text.nextNode())
+        XMLString::catString(tempStr, text.getNodeValue());
+    if (!XMLString::equals(tempStr, tempStr2))
+    {
+        fprintf(stderr, "DocumentCursor failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    // A walk stays below its root, which can be an attribute
+    DOMNode* item = root->getFirstChild();
+    DOMDocumentCursor<> subtree(item);
+    count = 0;
+    while (subtree.nextNode())
+    {
+        if (subtree.getNode() != item && !item->isSameNode(subtree.getNode()) &&
+            (item->compareDocumentPosition(subtree.getNode()) & DOMNode::DOCUMENT_POSITION_CONTAINED_BY) == 0)
+        {
+            fprintf(stderr, "DocumentCursor failed at line %i\n", __LINE__);
+            OK = false;
+        }
+        count++;
+    }
+    // item, Hello, &who;, b, World and !
+    if (count != 6)
+    {
+        fprintf(stderr, "DocumentCursor failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    DOMAttr* attr = root->getAttributeNode(root->getAttributes()->item(0)->getNodeName());
+    DOMDocumentCursor<> attribute(attr);
+    XMLString::transcode("1", tempStr, 3999);
+    if (!attribute.nextNode() || attribute.getNode() != attr ||
+        !attribute.nextNode() || attribute.getNodeType() != DOMNode::TEXT_NODE ||
+        !XMLString::equals(attribute.getNodeValue(), tempStr) || attribute.getDepth() != 1 ||
+        attribute.nextNode())
+    {
+        fprintf(stderr, "DocumentCursor failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    DOMDocumentCursor<> empty(0);
+    if (empty.nextNode())
+    {
+        fprintf(stderr, "DocumentCursor failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    return OK;
+}
+
+bool DOMTest::testWhitespaceScheme(XercesDOMParser* parser)
+{
+    bool OK = true;
+
+    const char* xml =
+        "<root>\n"
+        "  <a>  x  </a>\n"
+        "  <b>\n"
+        "    <c/>\n"
+        "  </b>\n"
+        "  <!-- comment -->\n"
+        "  <d>  &amp;<![CDATA[ ]]></d>\n"
+        "  <m>one <i>two</i> <i>three</i>\n</m>\n"
+        "  <n>\n<i/>\n<i>  <j/>  </i>end</n>\n"
+        "</root>";
+    MemBufInputSource is((const XMLByte*)xml, strlen(xml), "bufId");
+
+    // The number of children of root, b, m and n, and the text of a and d
+    // under each scheme
+    const AbstractDOMParser::WhitespaceSchemes schemes[] =
+    {
+        AbstractDOMParser::WS_Keep, AbstractDOMParser::WS_Strip, AbstractDOMParser::WS_StripElementContent
+    };
+    const XMLSize_t rootChildren[] = { 13, 6, 6 };
+    const XMLSize_t bChildren[] = { 3, 1, 1 };
+    const XMLSize_t mChildren[] = { 5, 3, 5 };
+    const XMLSize_t nChildren[] = { 5, 3, 5 };
+    const XMLSize_t iChildren[] = { 3, 1, 1 };
+
+    AbstractDOMParser::WhitespaceSchemes scheme = parser->getWhitespaceScheme();
+    for (int i = 0; i < 3; i++)
+    {
+        parser->setWhitespaceScheme(schemes[i]);
+        parser->parse(is);
+        parser->setWhitespaceScheme(scheme);
+
+        DOMDocument* document = parser->getDocument();
+        if (parser->getErrorCount() != 0 || document == NULL || document->getDocumentElement() == NULL)
+        {
+            fprintf(stderr, "WhitespaceScheme failed at line %i\n", __LINE__);
+            return false;
+        }
+
+        DOMElement* root = document->getDocumentElement();
+        XMLString::transcode("a", tempStr, 3999);
+        DOMNode* a = root->getElementsByTagName(tempStr)->item(0);
+        XMLString::transcode("b", tempStr, 3999);
+        DOMNode* b = root->getElementsByTagName(tempStr)->item(0);
+        XMLString::transcode("d", tempStr, 3999);
+        DOMNode* d = root->getElementsByTagName(tempStr)->item(0);
+        XMLString::transcode("m", tempStr, 3999);
+        DOMNode* m = root->getElementsByTagName(tempStr)->item(0);
+        XMLString::transcode("n", tempStr, 3999);
+        DOMNode* n = root->getElementsByTagName(tempStr)->item(0);
+        if (root->getChildNodes()->getLength() != rootChildren[i] ||
+            b->getChildNodes()->getLength() != bChildren[i] ||
+            m->getChildNodes()->getLength() != mChildren[i] ||
+            n->getChildNodes()->getLength() != nChildren[i] ||
+            n->getLastChild()->getPreviousSibling()->getChildNodes()->getLength() != iChildren[i])
+        {
+            fprintf(stderr, "WhitespaceScheme failed at line %i\n", __LINE__);
+            OK = false;
+        }
+
+        // Whitespace before other characters is kept, in the same node
+        XMLString::transcode("  x  ", tempStr, 3999);
+        XMLString::transcode("  &", tempStr2, 3999);
+        if (a->getChildNodes()->getLength() != 1 || !XMLString::equals(a->getTextContent(), tempStr) ||
+            d->getChildNodes()->getLength() != 2 || !XMLString::equals(d->getFirstChild()->getNodeValue(), tempStr2) ||
+            d->getLastChild()->getNodeType() != DOMNode::CDATA_SECTION_NODE)
+        {
+            fprintf(stderr, "WhitespaceScheme failed at line %i\n", __LINE__);
+            OK = false;
+        }
+
+        // Mixed content keeps its whitespace where it was
+        if (schemes[i] != AbstractDOMParser::WS_Strip)
+        {
+            XMLString::transcode("one two three\n", tempStr, 3999);
+            XMLString::transcode(schemes[i] == AbstractDOMParser::WS_Keep ? "\n\n    end" : "\n\nend", tempStr2, 3999);
+            if (!XMLString::equals(m->getTextContent(), tempStr) ||
+                !XMLString::equals(n->getTextContent(), tempStr2) ||
+                n->getFirstChild()->getNodeType() != DOMNode::TEXT_NODE ||
+                n->getFirstChild()->getNextSibling()->getNodeType() != DOMNode::ELEMENT_NODE)
+            {
+                fprintf(stderr, "WhitespaceScheme failed at line %i\n", __LINE__);
+                OK = false;
+            }
+        }
+    }
+
+    return OK;
+}
+
+class StartTagFilter : public DOMLSParserFilter
+{
+public:
+    StartTagFilter() : fStartTagCalls(0), fStartElementCalls(0), fAcceptNodeCalls(0), fRootAttributes(0), fPrefixedSeen(false) { }
+
+    virtual FilterAction acceptStartTag(const XMLCh* const uri, const XMLCh* const localName,
+                                        const XMLCh* const qName, const Attributes& attributes)
+    {
+        static const XMLCh secret[] = { chLatin_s, chLatin_e, chLatin_c, chLatin_r, chLatin_e, chLatin_t, chNull };
+        static const XMLCh b[] = { chLatin_b, chNull };
+        static const XMLCh root[] = { chLatin_r, chLatin_o, chLatin_o, chLatin_t, chNull };
+        static const XMLCh drop[] = { chLatin_d, chLatin_r, chLatin_o, chLatin_p, chNull };
+        static const XMLCh urn[] = { chLatin_u, chLatin_r, chLatin_n, chColon, chLatin_x, chNull };
+        static const XMLCh xc[] = { chLatin_x, chColon, chLatin_c, chNull };
+
+        fStartTagCalls++;
+        if (XMLString::equals(localName, root))
+            fRootAttributes = attributes.getLength();
+        if (XMLString::equals(uri, urn) && XMLString::equals(qName, xc))
+            fPrefixedSeen = true;
+
+        if (XMLString::equals(localName, secret) || attributes.getValue(drop) != 0)
+            return DOMLSParserFilter::FILTER_REJECT;
+        if (XMLString::equals(localName, b))
+            return DOMLSParserFilter::FILTER_SKIP;
+        return DOMLSParserFilter::FILTER_ACCEPT;
+    }
+    virtual FilterAction acceptNode(DOMNode* ) { fAcceptNodeCalls++; return DOMLSParserFilter::FILTER_ACCEPT; }
+    virtual FilterAction startElement(DOMElement* ) { fStartElementCalls++; return DOMLSParserFilter::FILTER_ACCEPT; }
+    virtual DOMNodeFilter::ShowType getWhatToShow() const { return DOMNodeFilter::SHOW_ALL; }
+
+    unsigned int fStartTagCalls;
+    unsigned int fStartElementCalls;
+    unsigned int fAcceptNodeCalls;
+    XMLSize_t fRootAttributes;
+    bool fPrefixedSeen;
+};
+
+bool DOMTest::testStartTagFilter()
+{
+    bool OK = true;
+
+    const char* sXml = "<root xmlns:x='urn:x'>one"
+                       "<secret><a>1</a><a>2</a></secret>two"
+                       "<p>a<b>b<i>c</i></b>d</p>"
+                       "<x:c drop='yes'><a/></x:c>"
+                       "<e/>"
+                       "</root>";
+
+    static const XMLCh gLS[] = { chLatin_L, chLatin_S, chNull };
+    DOMImplementationLS* impl = (DOMImplementationLS*)DOMImplementationRegistry::getDOMImplementation(gLS);
+    DOMLSParser* domBuilder = impl->createLSParser(DOMImplementationLS::MODE_SYNCHRONOUS, 0);
+    DOMLSInput* input = impl->createLSInput();
+    XMLString::transcode(sXml, tempStr, 3999);
+    input->setStringData(tempStr);
+
+    StartTagFilter filter;
+    domBuilder->setFilter(&filter);
+    try
+    {
+        DOMDocument* doc = domBuilder->parse(input);
+        DOMElement* root = doc ? doc->getDocumentElement() : 0;
+
+        // Nothing inside a rejected element is looked at
+        if (root == 0 || filter.fStartTagCalls != 7 || filter.fRootAttributes != 1 || !filter.fPrefixedSeen)
+        {
+            fprintf(stderr, "testStartTagFilter failed at line %i\n", __LINE__);
+            OK = false;
+        }
+
+        // Only built nodes reach the other callbacks: root, p, i and e, and
+        // the six text nodes
+        if (filter.fStartElementCalls != 4 || filter.fAcceptNodeCalls != 10)
+        {
+            fprintf(stderr, "testStartTagFilter failed at line %i\n", __LINE__);
+            OK = false;
+        }
+
+        // The content of a skipped element is in its place, text around
+        // elements that weren't built is not merged
+        XMLString::transcode("onetwoabcd", tempStr, 3999);
+        DOMNode* p = root ? root->getFirstElementChild() : 0;
+        if (root == 0 || !XMLString::equals(root->getTextContent(), tempStr) ||
+            root->getChildNodes()->getLength() != 4 || root->getChildElementCount() != 2 ||
+            p == 0 || p->getChildNodes()->getLength() != 4 ||
+            p->getFirstChild()->getNextSibling()->getNodeType() != DOMNode::TEXT_NODE)
+        {
+            fprintf(stderr, "testStartTagFilter failed at line %i\n", __LINE__);
+            OK = false;
+        }
+
+        // No memory is spent on what was dropped
+        DOMMemoryManager::MemoryUsage usage;
+        ((DOMMemoryManager*)doc->getFeature(XMLUni::fgXercescInterfaceDOMMemoryManager, 0))->getMemoryUsage(usage);
+        if (usage.fNodeCount[DOMMemoryManager::ELEMENT_OBJECT] + usage.fNodeCount[DOMMemoryManager::ELEMENT_NS_OBJECT] != 4 ||
+            usage.fNodeCount[DOMMemoryManager::ATTR_OBJECT] + usage.fNodeCount[DOMMemoryManager::ATTR_NS_OBJECT] != 1)
+        {
+            fprintf(stderr, "testStartTagFilter failed at line %i\n", __LINE__);
+            OK = false;
+        }
+    }
+    catch(DOMException&)
+    {
+        fprintf(stderr, "testStartTagFilter failed at line %i\n", __LINE__);
+        OK = false;
+    }
+
+    domBuilder->setFilter(0);
+    input->release();
+    domBuilder->release();
+
+    return OK;
+}
+
 #define TEST_BOOLEAN(x) \
     if(!x)  \
     {       \
@@ -108,11 +108,24 @@ bool treeCompare(DOMNode* node, DOMNode* node2);
 bool testBaseURI(XercesDOMParser* parser);
 bool testWholeText(XercesDOMParser* parser);
 bool testLSExceptions();
+bool testStartTagFilter();
 bool testElementTraversal();
 
 bool testRegex();
 bool testScanner(XercesDOMParser* parser);
+bool testRecordHandler(XercesDOMParser* parser);
+bool testXPathFilter();
+bool testSerializer(XercesDOMParser* parser);
+bool testParallelSerializer(XercesDOMParser* parser);
 bool testUtilFunctions();
+bool testMemoryUsage();
+bool testDocumentRecycling();
+bool testGrammarPoolSharing();
+bool testFreeze();
+bool testSnapshot(XercesDOMParser* parser);
+bool testDocumentCursor(XercesDOMParser* parser);
+bool testWhitespaceScheme(XercesDOMParser* parser);
+bool testFormatter();
 
 };
 
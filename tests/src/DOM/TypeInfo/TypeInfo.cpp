@@ -23,6 +23,7 @@
 #include <xercesc/parsers/XercesDOMParser.hpp>
 #include <xercesc/dom/DOMException.hpp>
 #include <xercesc/dom/DOM.hpp>
+#include <xercesc/validators/schema/SchemaGrammar.hpp>
 #include <xercesc/validators/schema/SchemaSymbols.hpp>
 
 #include <iostream>
@@ -895,6 +896,86 @@ int main(int /*argc*/, char ** /*argv*/)
 
     delete ti.parser;
 
+    //and with the documents of the schema parsed on several threads
+    try {
+        ti.parser = new XercesDOMParser;
+        ti.parser->setValidationScheme(XercesDOMParser::Val_Auto);
+        ti.parser->setCreateSchemaInfo(true);
+        ti.parser->setDoNamespaces(true);
+        ti.parser->setDoSchema(true);
+        ti.parser->setParallelSchemaLoading(true);
+        SchemaGrammar* grammar = (SchemaGrammar*) ti.parser->loadGrammar("data/ParallelLoading.xsd", Grammar::SchemaGrammarType, true);
+        if (!grammar || ti.parser->getErrorCount() != 0 || grammar->getAnnotations()->isEmpty()) {
+            std::cerr << "loading data/ParallelLoading.xsd failed at line" <<  __LINE__ << std::endl;
+            passed = false;
+        }
+        ti.parser->useCachedGrammarInParse(true);
+        ti.parser->parse("data/TypeInfoNoDTD.xml");
+        ti.doc = ti.parser->getDocument();
+    }
+    catch (...) {
+        std::cerr << "parsing data/TypeInfoNoDTD.xml failed at line" <<  __LINE__ << std::endl;
+        delete ti.parser;
+        return false;
+    }
+
+    // test only if we got a doc
+    if (ti.doc) {
+        passed &= ti.testInBuiltTypesOnAttributes(false);
+        passed &= ti.testInBuiltTypesOnElements();
+        passed &= ti.testSimpleDerived();
+        passed &= ti.testComplexTypes();
+        passed &= ti.testUnions();
+        passed &= ti.testAnonymous();
+        passed &= ti.testXsiTypes();
+        passed &= ti.testAnys();
+        passed &= ti.testInvaild();
+    }
+    else
+        std::cout << "DOMTypeInfo test at line " << __LINE__ << "was not carried out" << std::endl;
+
+    delete ti.parser;
+
+    //and with the annotations of the schema ignored
+    try {
+        ti.parser = new XercesDOMParser;
+        ti.parser->setValidationScheme(XercesDOMParser::Val_Auto);
+        ti.parser->setCreateSchemaInfo(true);
+        ti.parser->setDoNamespaces(true);
+        ti.parser->setDoSchema(true);
+        ti.parser->setIgnoreAnnotations(true);
+        SchemaGrammar* grammar = (SchemaGrammar*) ti.parser->loadGrammar("data/ParallelLoading.xsd", Grammar::SchemaGrammarType, true);
+        if (!grammar || ti.parser->getErrorCount() != 0 || !grammar->getAnnotations()->isEmpty()) {
+            std::cerr << "loading data/ParallelLoading.xsd failed at line" <<  __LINE__ << std::endl;
+            passed = false;
+        }
+        ti.parser->useCachedGrammarInParse(true);
+        ti.parser->parse("data/TypeInfoNoDTD.xml");
+        ti.doc = ti.parser->getDocument();
+    }
+    catch (...) {
+        std::cerr << "parsing data/TypeInfoNoDTD.xml failed at line" <<  __LINE__ << std::endl;
+        delete ti.parser;
+        return false;
+    }
+
+    // test only if we got a doc
+    if (ti.doc) {
+        passed &= ti.testInBuiltTypesOnAttributes(false);
+        passed &= ti.testInBuiltTypesOnElements();
+        passed &= ti.testSimpleDerived();
+        passed &= ti.testComplexTypes();
+        passed &= ti.testUnions();
+        passed &= ti.testAnonymous();
+        passed &= ti.testXsiTypes();
+        passed &= ti.testAnys();
+        passed &= ti.testInvaild();
+    }
+    else
+        std::cout << "DOMTypeInfo test at line " << __LINE__ << "was not carried out" << std::endl;
+
+    delete ti.parser;
+
 
     //now default for DTD
     try {
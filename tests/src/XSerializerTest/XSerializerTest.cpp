@@ -46,6 +46,7 @@ static bool                         doList             = false;
 static bool                         namespacePrefixes  = false;
 static bool                         errorOccurred      = false;
 static bool                         recognizeNEL       = false;
+static bool                         loadFromMemory     = false;
 
 static char                         localeStr[64];
 
@@ -63,7 +64,8 @@ static XSerializerHandlers*     handler     = 0;
 *   . parses the file
 *   . caches the grammar without issuing any error message with regards to the parsing
 *   . serializes(store) the grammar cached to a BinOutputStream
-*   . deserialize(load) the grammar from the BinInputStream
+*   . deserialize(load) the grammar from the BinInputStream, or straight
+*     from the bytes in memory
 *   . parses the instance document a second time
 *   . validates the instance against the deserialized grammar if validation is on.
 *
@@ -80,6 +82,8 @@ bool parseOne(BinOutputStream*    outStream
 
 static
 void parseTwo(BinInputStream*     inStream
+            , const XMLByte*      image
+            , XMLSize_t           imageSize
             , const char* const  xmlFile);
 
 static
@@ -105,6 +109,8 @@ void usage()
             "                Default to off (Input file is an XML file).\n"
             "    -v=xxx      Validation scheme [always | never | auto*].\n"
             "    -f          Enable full schema constraint checking processing. Defaults to off.\n"
+            "    -m          Load the grammars from the serialized bytes in memory\n"
+            "                instead of through a stream. Defaults to off.\n"
             "    -p          Enable namespace-prefixes feature. Defaults to off.\n"
             "    -n          Disable namespace processing. Defaults to on.\n"
             "                NOTE: THIS IS OPPOSITE FROM OTHER SAMPLES.\n"
@@ -175,6 +181,11 @@ int main(int argC, char* argV[])
               ||  !strcmp(argV[argInd], "-F"))
         {
             schemaFullChecking = true;
+        }
+         else if (!strcmp(argV[argInd], "-m")
+              ||  !strcmp(argV[argInd], "-M"))
+        {
+            loadFromMemory = true;
         }
          else if (!strcmp(argV[argInd], "-l")
               ||  !strcmp(argV[argInd], "-L"))
@@ -325,7 +336,10 @@ static void parseCase(const char* const xmlFile)
                                                   );
     Janitor<BinInputStream> janIn(myIn);
 
-    parseTwo(myIn, xmlFile);
+    parseTwo(myIn
+           , ((BinMemOutputStream*)myOut)->getRawBuffer()
+           , (XMLSize_t)((BinMemOutputStream*)myOut)->getSize()
+           , xmlFile);
 
 }
 
@@ -383,17 +397,22 @@ bool parseOne(BinOutputStream*    outStream
 
 static
 void parseTwo(BinInputStream*     inStream
+            , const XMLByte*      image
+            , XMLSize_t           imageSize
             , const char* const   xmlFile)
 {
     //we don't use janitor here
-    MemoryManager*  theMemMgr   = new MemoryManagerImpl();
-    XMLGrammarPool* theGramPool = new XMLGrammarPoolImpl(theMemMgr);
-    bool            errorSeen   = false;
+    MemoryManager*      theMemMgr   = new MemoryManagerImpl();
+    XMLGrammarPoolImpl* theGramPool = new XMLGrammarPoolImpl(theMemMgr);
+    bool                errorSeen   = false;
 
     //de-serialize grammar pool
     try
     {
-        theGramPool->deserializeGrammars(inStream);
+        if (loadFromMemory)
+            theGramPool->deserializeGrammars(image, imageSize);
+        else
+            theGramPool->deserializeGrammars(inStream);
     }
 
     catch(const XSerializationException& e)